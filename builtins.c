@@ -1,6 +1,14 @@
 #include "builtins.h"
+#include "lmem_ops.h"
 #include "lval_ops.h"
 #include "lenv_ops.h"
+#include "lbin_ops.h"
+#include "lload_ops.h"
+#include "lfuture_ops.h"
+#include "lpool_ops.h"
+#include "lclosure_ops.h"
+#include <stdlib.h>
+#include <string.h>
 
 lval* builtin_op(lenv* e, lval* a, char* op)
 {
@@ -178,12 +186,552 @@ lval* builtin_def(lenv* e, lval* a)
             "Function 'def' cannot define incorrect "
             "number of values to symbols");
 
-    /* Assign copies of values to symbols */
+    /* Assign copies of values to symbols, globally even inside a call */
     for (int i = 0; i < syms->count; i++)
     {
-        lenv_put(e, syms->cell[i], a->cell[i+1]);
+        lenv_put(lenv_root(e), syms->cell[i], a->cell[i+1]);
     }
     
     lval_del(a);
     return lval_sexpr();
 }
+
+/* a function of the symbols in the first list evaluating the second, with
+   the free variables bound by the calls it is made in captured */
+lval* builtin_lambda(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 2,
+            "Function '\\' passed incorrect number of arguments. "
+            "Got %i, Expected %i.",
+            a->count, 2);
+    for (int i = 0; i < 2; i++)
+        LASSERT(a, a->cell[i]->type == LVAL_QEXPR,
+                "Function '\\' passed incorrect types for argument %i. "
+                "Got %s, Exprected %s.",
+                i, ltype_name(a->cell[i]->type), ltype_name(LVAL_QEXPR));
+
+    lval* formals = a->cell[0];
+    for (int i = 0; i < formals->count; i++)
+    {
+        LASSERT(a, formals->cell[i]->type == LVAL_SYM,
+                "Function '\\' cannot take non-symbol. Got %s, Expected %s.",
+                ltype_name(formals->cell[i]->type), ltype_name(LVAL_SYM));
+        for (int j = 0; j < i; j++)
+            LASSERT(a, strcmp(formals->cell[i]->sym, formals->cell[j]->sym) != 0,
+                    "Function '\\' takes '%s' more than once.", formals->cell[i]->sym);
+    }
+
+    formals = lval_pop(a, 0);
+    lval* body = lval_take(a, 0);
+    return lval_lambda(lclosure_capture(e, formals, body));
+}
+
+/* whether a symbol names a file in the current directory, nothing that
+   could reach one anywhere else */
+static int builtin_file_name(lval* name)
+{
+    return strchr(name->sym, '/') == NULL && strchr(name->sym, '\\') == NULL;
+}
+
+/* file names are given as a single symbol, {data} names data.lbin or data.lspy */
+static char* builtin_path(lval* name, char* ext)
+{
+    char* path = lmem_malloc(strlen(name->sym) + strlen(ext) + 1);
+    strcpy(path, name->sym);
+    strcat(path, ext);
+    return path;
+}
+
+lval* builtin_save(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 2,
+            "Function 'save' passed incorrect number of arguments. "
+            "Got %i, Expected %i.",
+            a->count, 2);
+    LASSERT(a, a->cell[0]->type == LVAL_QEXPR,
+            "Function 'save' passed incorrect types for argument 0. "
+            "Got %s, Exprected %s.",
+            ltype_name(a->cell[0]->type), ltype_name(LVAL_QEXPR));
+    LASSERT(a, a->cell[0]->count == 1 && a->cell[0]->cell[0]->type == LVAL_SYM,
+            "Function 'save' expects a file name like {data}");
+    LASSERT(a, lenv_root(e)->files,
+            "Function 'save' cannot use files here");
+    LASSERT(a, builtin_file_name(a->cell[0]->cell[0]),
+            "Function 'save' cannot use '%s', a file name has no directory in it",
+            a->cell[0]->cell[0]->sym);
+
+    char* path = builtin_path(a->cell[0]->cell[0], LBIN_EXT);
+    lval* x = lbin_save(path, a->cell[1]);
+    lmem_free(path);
+
+    lval_del(a);
+    return x;
+}
+
+lval* builtin_load(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 1,
+            "Function 'load' passed too many arguments."
+            "Got %i, Expected %i.",
+            a->count, 1);
+    LASSERT(a, a->cell[0]->type == LVAL_QEXPR,
+            "Function 'load' passed incorrect types for argument 0. "
+            "Got %s, Exprected %s.",
+            ltype_name(a->cell[0]->type), ltype_name(LVAL_QEXPR));
+    LASSERT(a, a->cell[0]->count == 1 && a->cell[0]->cell[0]->type == LVAL_SYM,
+            "Function 'load' expects a file name like {data}");
+    LASSERT(a, lenv_root(e)->files,
+            "Function 'load' cannot use files here");
+    LASSERT(a, builtin_file_name(a->cell[0]->cell[0]),
+            "Function 'load' cannot use '%s', a file name has no directory in it",
+            a->cell[0]->cell[0]->sym);
+
+    char* path = builtin_path(a->cell[0]->cell[0], LBIN_EXT);
+    lval* x = lbin_load(path);
+    lmem_free(path);
+
+    lval_del(a);
+    return x;
+}
+
+lval* builtin_snapshot(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 1,
+            "Function 'snapshot' passed too many arguments."
+            "Got %i, Expected %i.",
+            a->count, 1);
+    LASSERT(a, a->cell[0]->type == LVAL_QEXPR,
+            "Function 'snapshot' passed incorrect types for argument 0. "
+            "Got %s, Exprected %s.",
+            ltype_name(a->cell[0]->type), ltype_name(LVAL_QEXPR));
+    LASSERT(a, a->cell[0]->count == 1 && a->cell[0]->cell[0]->type == LVAL_SYM,
+            "Function 'snapshot' expects a file name like {image}");
+    LASSERT(a, lenv_root(e)->files,
+            "Function 'snapshot' cannot use files here");
+    LASSERT(a, builtin_file_name(a->cell[0]->cell[0]),
+            "Function 'snapshot' cannot use '%s', a file name has no directory in it",
+            a->cell[0]->cell[0]->sym);
+
+    char* path = builtin_path(a->cell[0]->cell[0], LBIN_EXT);
+    lval* x = lbin_save_image(path, lenv_root(e));
+    lmem_free(path);
+
+    lval_del(a);
+    return x;
+}
+
+lval* builtin_read(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 1,
+            "Function 'read' passed too many arguments."
+            "Got %i, Expected %i.",
+            a->count, 1);
+    LASSERT(a, a->cell[0]->type == LVAL_QEXPR,
+            "Function 'read' passed incorrect types for argument 0. "
+            "Got %s, Exprected %s.",
+            ltype_name(a->cell[0]->type), ltype_name(LVAL_QEXPR));
+    LASSERT(a, a->cell[0]->count == 1 && a->cell[0]->cell[0]->type == LVAL_SYM,
+            "Function 'read' expects a file name like {data}");
+    LASSERT(a, lenv_root(e)->files,
+            "Function 'read' cannot use files here");
+    LASSERT(a, builtin_file_name(a->cell[0]->cell[0]),
+            "Function 'read' cannot use '%s', a file name has no directory in it",
+            a->cell[0]->cell[0]->sym);
+
+    char* path = builtin_path(a->cell[0]->cell[0], LLOAD_EXT);
+    lval* x = lload_file(path, 0);
+    lmem_free(path);
+
+    lval_del(a);
+    return x;
+}
+
+/* evaluate a Q-Expression alongside whatever comes next, on the pool if
+   there is one. It sees copies of the definitions it uses, as they were */
+lval* builtin_spawn(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 1,
+            "Function 'spawn' passed too many arguments."
+            "Got %i, Expected %i.",
+            a->count, 1);
+    LASSERT(a, a->cell[0]->type == LVAL_QEXPR,
+            "Function 'spawn' passed incorrect types for argument 0. "
+            "Got %s, Exprected %s.",
+            ltype_name(a->cell[0]->type), ltype_name(LVAL_QEXPR));
+
+    lval* x = lval_take(a, 0);
+    x->type = LVAL_SEXPR;
+    return lval_fut(lfuture_new(e, x));
+}
+
+lval* builtin_await(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 1,
+            "Function 'await' passed too many arguments."
+            "Got %i, Expected %i.",
+            a->count, 1);
+    LASSERT(a, a->cell[0]->type == LVAL_FUT,
+            "Function 'await' passed incorrect types for argument 0. "
+            "Got %s, Exprected %s.",
+            ltype_name(a->cell[0]->type), ltype_name(LVAL_FUT));
+
+    lval* x = lval_copy(lfuture_wait(a->cell[0]->fut));
+    lval_del(a);
+    return x;
+}
+
+/* what map, filter and fold apply: a function, or a Q-Expression of one and
+   the first arguments to give it, like {* 2}. Evaluated once, up front, into
+   an S-Expression of the function and those arguments. Takes f */
+static lval* builtin_callee(lenv* e, char* name, lval* f)
+{
+    if (f->type == LVAL_FUN)
+        return lval_add(lval_sexpr(), f);
+
+    if (f->type != LVAL_QEXPR || f->count == 0)
+    {
+        lval* err = lval_err("Function '%s' passed incorrect types for argument 0. "
+                             "Got %s, Exprected %s.",
+                             name, ltype_name(f->type), ltype_name(LVAL_FUN));
+        lval_del(f);
+        return err;
+    }
+
+    for (int i = 0; i < f->count; i++)
+    {
+        f->cell[i] = lval_eval(e, f->cell[i]);
+        if (f->cell[i]->type == LVAL_ERR)
+            return lval_take(f, i);
+    }
+
+    LASSERT(f, f->cell[0]->type == LVAL_FUN,
+            "Function '%s' needs a function first in argument 0. Got %s.",
+            name, ltype_name(f->cell[0]->type));
+    f->type = LVAL_SEXPR;
+    return f;
+}
+
+/* the callee given x, then y unless it is NULL, after its own arguments */
+static lval* builtin_apply(lenv* e, lval* callee, lval* x, lval* y)
+{
+    lval* a = lval_copy(callee);
+    lval* f = lval_pop(a, 0);
+    lval_add(a, x);
+    if (y)
+        lval_add(a, y);
+    return lval_call(e, f, a);
+}
+
+/* the chunks below are given the callee followed by a run of items, which
+   they work on where they are. Each takes what it is given */
+
+static lval* builtin_map_chunk(lenv* e, lval* v)
+{
+    lval* callee = lval_pop(v, 0);
+    v->type = LVAL_QEXPR;
+    for (int i = 0; i < v->count; i++)
+    {
+        v->cell[i] = builtin_apply(e, callee, v->cell[i], NULL);
+        if (v->cell[i]->type == LVAL_ERR)
+        {
+            lval_del(callee);
+            return lval_take(v, i);
+        }
+    }
+    lval_del(callee);
+    return v;
+}
+
+static lval* builtin_filter_chunk(lenv* e, lval* v)
+{
+    lval* callee = lval_pop(v, 0);
+    v->type = LVAL_QEXPR;
+    int kept = 0;
+    for (int i = 0; i < v->count; i++)
+    {
+        lval* x = builtin_apply(e, callee, lval_copy(v->cell[i]), NULL);
+        if (x->type != LVAL_NUM)
+        {
+            if (x->type != LVAL_ERR)
+            {
+                lval* err = lval_err("Function 'filter' needs a Number from its predicate. "
+                                     "Got %s.", ltype_name(x->type));
+                lval_del(x);
+                x = err;
+            }
+
+            // those kept are in front, between them and i is nothing
+            for (int j = i; j < v->count; j++)
+                lval_del(v->cell[j]);
+            v->count = kept;
+            lval_del(callee);
+            lval_del(v);
+            return x;
+        }
+
+        if (x->num)
+            v->cell[kept++] = v->cell[i];
+        else
+            lval_del(v->cell[i]);
+        lval_del(x);
+    }
+    v->count = kept;
+    lval_del(callee);
+    return v;
+}
+
+/* the items folded from the first, there is at least one */
+static lval* builtin_fold_chunk(lenv* e, lval* v)
+{
+    lval* acc = v->cell[1];
+    int i = 2;
+    for (; i < v->count && acc->type != LVAL_ERR; i++)
+        acc = builtin_apply(e, v->cell[0], acc, v->cell[i]);
+
+    for (; i < v->count; i++)
+        lval_del(v->cell[i]);
+    v->count = 1;
+    lval_del(v);
+    return acc;
+}
+
+/* the items of one Q-Expression after another, or the first error among
+   them. Takes parts */
+static lval* builtin_concat(lval* parts)
+{
+    int count = 0;
+    for (int i = 0; i < parts->count; i++)
+    {
+        if (parts->cell[i]->type == LVAL_ERR)
+            return lval_take(parts, i);
+        count += parts->cell[i]->count;
+    }
+
+    lval* x = lval_qexpr();
+    x->count = count;
+    x->cell = lmem_malloc(sizeof(lval*) * (count ? count : 1));
+    int n = 0;
+    for (int i = 0; i < parts->count; i++)
+    {
+        lval* p = parts->cell[i];
+        memcpy(x->cell + n, p->cell, sizeof(lval*) * p->count);
+        n += p->count;
+        p->count = 0;
+    }
+    lval_del(parts);
+    return x;
+}
+
+/* func given the callee and the items, as one chunk on this thread or,
+   for long lists with a pool and nothing that could reach a barrier, as
+   runs of them on the pool. The results of the chunks in order. Takes
+   callee and items */
+static lval* builtin_chunks(lenv* e, lval* callee, lval* items, lval* (*func)(lenv*, lval*))
+{
+    int chunks = 1;
+    if (e->pool && items->count >= 2 * LPOOL_ITEMS
+        && !lval_barrier(e, callee, 0) && !lval_barrier(e, items, 0))
+    {
+        chunks = e->pool->count * 4;
+        if (chunks > items->count / LPOOL_ITEMS)
+            chunks = items->count / LPOOL_ITEMS;
+    }
+
+    lval* parts = lval_qexpr();
+    lpool_task* tasks = lmem_malloc(sizeof(lpool_task) * chunks);
+    for (int i = 0; i < chunks; i++)
+    {
+        // even runs, in order, the item pointers moved rather than copied
+        int from = (int)((long)items->count * i / chunks);
+        int to = (int)((long)items->count * (i + 1) / chunks);
+        lval* v = lval_sexpr();
+        v->count = to - from + 1;
+        v->cell = lmem_malloc(sizeof(lval*) * v->count);
+        v->cell[0] = i == chunks - 1 ? callee : lval_copy(callee);
+        memcpy(v->cell + 1, items->cell + from, sizeof(lval*) * (to - from));
+
+        if (i == chunks - 1)
+            lval_add(parts, func(e, v));
+        else
+        {
+            lpool_apply(e->pool, &tasks[i], func, e, v);
+            lval_add(parts, NULL);
+        }
+    }
+    items->count = 0;
+    lval_del(items);
+
+    // newest first, those are the ones still in our own deque
+    for (int i = chunks - 2; i >= 0; i--)
+        parts->cell[i] = lpool_wait(e->pool, &tasks[i]);
+    lmem_free(tasks);
+    return parts;
+}
+
+static lval* builtin_list_arg(lval* a, char* name, int i)
+{
+    LASSERT(a, a->cell[i]->type == LVAL_QEXPR,
+            "Function '%s' passed incorrect types for argument %i. "
+            "Got %s, Exprected %s.",
+            name, i, ltype_name(a->cell[i]->type), ltype_name(LVAL_QEXPR));
+    return NULL;
+}
+
+/* a new list of f applied to every item of a list, the first error if any */
+lval* builtin_map(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 2,
+            "Function 'map' passed incorrect number of arguments. "
+            "Got %i, Expected %i.",
+            a->count, 2);
+    lval* err = builtin_list_arg(a, "map", 1);
+    if (err)
+        return err;
+
+    lval* items = lval_pop(a, 1);
+    lval* callee = builtin_callee(e, "map", lval_take(a, 0));
+    if (callee->type == LVAL_ERR)
+    {
+        lval_del(items);
+        return callee;
+    }
+    return builtin_concat(builtin_chunks(e, callee, items, builtin_map_chunk));
+}
+
+/* the items of a list for which f gives a Number other than 0 */
+lval* builtin_filter(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 2,
+            "Function 'filter' passed incorrect number of arguments. "
+            "Got %i, Expected %i.",
+            a->count, 2);
+    lval* err = builtin_list_arg(a, "filter", 1);
+    if (err)
+        return err;
+
+    lval* items = lval_pop(a, 1);
+    lval* callee = builtin_callee(e, "filter", lval_take(a, 0));
+    if (callee->type == LVAL_ERR)
+    {
+        lval_del(items);
+        return callee;
+    }
+    return builtin_concat(builtin_chunks(e, callee, items, builtin_filter_chunk));
+}
+
+/* f applied to the first value and each item in turn, from the left. Only
+   + and * of Numbers are split into runs, they come to the same whatever
+   the grouping */
+lval* builtin_fold(lenv* e, lval* a)
+{
+    LASSERT(a, a->count == 3,
+            "Function 'fold' passed incorrect number of arguments. "
+            "Got %i, Expected %i.",
+            a->count, 3);
+    lval* err = builtin_list_arg(a, "fold", 2);
+    if (err)
+        return err;
+
+    lval* items = lval_pop(a, 2);
+    lval* acc = lval_pop(a, 1);
+    lval* callee = builtin_callee(e, "fold", lval_take(a, 0));
+    if (callee->type == LVAL_ERR)
+    {
+        lval_del(items);
+        lval_del(acc);
+        return callee;
+    }
+
+    int split = e->pool && items->count >= 2 * LPOOL_ITEMS && callee->count == 1
+        && (callee->cell[0]->fun == builtin_add || callee->cell[0]->fun == builtin_mul);
+    for (int i = 0; split && i < items->count; i++)
+        split = items->cell[i]->type == LVAL_NUM;
+
+    if (!split)
+    {
+        for (int i = 0; i < items->count; i++)
+        {
+            if (acc->type == LVAL_ERR)
+            {
+                lval_del(items->cell[i]);
+                continue;
+            }
+            acc = builtin_apply(e, callee, acc, items->cell[i]);
+        }
+        items->count = 0;
+        lval_del(items);
+        lval_del(callee);
+        return acc;
+    }
+
+    lval* parts = builtin_chunks(e, lval_copy(callee), items, builtin_fold_chunk);
+    while (parts->count > 0 && acc->type != LVAL_ERR)
+        acc = builtin_apply(e, callee, acc, lval_pop(parts, 0));
+    lval_del(parts);
+    lval_del(callee);
+    return acc;
+}
+
+/* every builtin by name, also used to write functions out and read them back.
+   Barriers change the environment or files, or return code that is only known
+   once they run, nothing is evaluated alongside them.
+   Never written to, so every thread shares it */
+static const struct { char* name; lbuiltin func; int barrier; } builtin_table[] = {
+    { "list", builtin_list, 0 },
+    { "head", builtin_head, 0 },
+    { "tail", builtin_tail, 0 },
+    { "eval", builtin_eval, 0 },
+    { "join", builtin_join, 0 },
+
+    { "+", builtin_add, 0 },
+    { "-", builtin_sub, 0 },
+    { "*", builtin_mul, 0 },
+    { "/", builtin_div, 0 },
+
+    { "def", builtin_def, 1 },
+    { "\\", builtin_lambda, 0 },
+
+    { "save", builtin_save, 1 },
+    { "load", builtin_load, 1 },
+    { "snapshot", builtin_snapshot, 1 },
+    { "read", builtin_read, 1 },
+
+    { "spawn", builtin_spawn, 0 },
+    { "await", builtin_await, 0 },
+
+    { "map", builtin_map, 0 },
+    { "filter", builtin_filter, 0 },
+    { "fold", builtin_fold, 0 },
+};
+
+#define BUILTIN_COUNT (sizeof(builtin_table) / sizeof(builtin_table[0]))
+
+void lenv_add_builtins(lenv* e)
+{
+    for (size_t i = 0; i < BUILTIN_COUNT; i++)
+        lenv_add_builtin(e, builtin_table[i].name, builtin_table[i].func);
+}
+
+char* builtin_name(lbuiltin func)
+{
+    for (size_t i = 0; i < BUILTIN_COUNT; i++)
+        if (builtin_table[i].func == func)
+            return builtin_table[i].name;
+    return NULL;
+}
+
+lbuiltin builtin_find(const char* name, size_t len)
+{
+    for (size_t i = 0; i < BUILTIN_COUNT; i++)
+        if (strncmp(builtin_table[i].name, name, len) == 0 && builtin_table[i].name[len] == '\0')
+            return builtin_table[i].func;
+    return NULL;
+}
+
+int builtin_barrier(lbuiltin func)
+{
+    for (size_t i = 0; i < BUILTIN_COUNT; i++)
+        if (builtin_table[i].func == func)
+            return builtin_table[i].barrier;
+    return 1;
+}
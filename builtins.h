@@ -1,6 +1,7 @@
 #ifndef BUILTINS_H
 #define BUILTINS_H
 
+#include <stddef.h>
 #include "lval.h"
 #include "lenv.h"
 
@@ -31,4 +32,33 @@ lval* builtin_mul(lenv* e, lval* a);
 lval* builtin_div(lenv* e, lval* a);
 
 lval* builtin_def(lenv* e, lval* a);
+
+lval* builtin_lambda(lenv* e, lval* a);
+
+lval* builtin_save(lenv* e, lval* a);
+
+lval* builtin_load(lenv* e, lval* a);
+
+lval* builtin_snapshot(lenv* e, lval* a);
+
+lval* builtin_read(lenv* e, lval* a);
+
+lval* builtin_spawn(lenv* e, lval* a);
+
+lval* builtin_await(lenv* e, lval* a);
+
+lval* builtin_map(lenv* e, lval* a);
+
+lval* builtin_filter(lenv* e, lval* a);
+
+lval* builtin_fold(lenv* e, lval* a);
+
+
+void lenv_add_builtins(lenv* e);
+
+char* builtin_name(lbuiltin func);
+
+lbuiltin builtin_find(const char* name, size_t len);
+
+int builtin_barrier(lbuiltin func);
 #endif 
@@ -0,0 +1,44 @@
+#ifndef LBIN_H
+#define LBIN_H
+
+/*
+ * Binary lval format:
+ *
+ *     magic     "LSPB" and a version byte
+ *     symbols   varint count, then a varint length and the bytes of each
+ *     value     a tag byte followed by
+ *                   LBIN_NUM    zigzag varint
+ *                   LBIN_ERR    varint length and the message bytes
+ *                   LBIN_SYM    varint index into the symbol table
+ *                   LBIN_FUN    varint index of the builtin's name, empty
+ *                               for functions registered by an embedding host
+ *                   LBIN_LAMBDA varint count of parameters, varint count of
+ *                               names, the symbol index of each name, a value
+ *                               for each name past the parameters and then
+ *                               the body
+ *                   LBIN_SEXPR,
+ *                   LBIN_QEXPR  varint count and that many values
+ *
+ * Every symbol and builtin name is written once, however often it is used.
+ *
+ * An image of a whole environment has its own magic, and in place of the
+ * value a varint count of bindings, each a symbol index and a value.
+ *
+ * Version 2 added LBIN_LAMBDA. Version 1 files are still read, they are
+ * the same without it.
+ */
+
+#define LBIN_MAGIC "LSPB"
+#define LBIN_IMAGE_MAGIC "LSPI"
+#define LBIN_VERSION 2
+
+/* values nested deeper than this are taken as malformed rather than read
+   until the stack runs out */
+#define LBIN_DEPTH 4096
+
+/* files saved and loaded by the builtins get this appended to their name */
+#define LBIN_EXT ".lbin"
+
+enum { LBIN_NUM, LBIN_ERR, LBIN_SYM, LBIN_FUN, LBIN_SEXPR, LBIN_QEXPR, LBIN_LAMBDA };
+
+#endif
@@ -0,0 +1,604 @@
+#include "lbin_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lenv_ops.h"
+#include "builtins.h"
+#include "lfuture_ops.h"
+#include "lclosure_ops.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <stdio.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* symbols met while writing, hashed so each one is numbered only once */
+typedef struct
+{
+    int count;
+    char** names;
+
+    int size;
+    int* slots;
+} lbin_syms;
+
+static uint32_t lbin_hash(const char* s)
+{
+    uint32_t h = 2166136261u;
+    while (*s)
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h;
+}
+
+static int lbin_intern(lbin_syms* t, char* name)
+{
+    // keep the table at most half full, slots hold index + 1 so 0 is empty
+    if ((t->count + 1) * 2 > t->size)
+    {
+        int size = t->size ? t->size * 2 : 64;
+        int* slots = lmem_calloc(size, sizeof(int));
+        for (int i = 0; i < t->count; i++)
+        {
+            uint32_t j = lbin_hash(t->names[i]) & (size - 1);
+            while (slots[j])
+                j = (j + 1) & (size - 1);
+            slots[j] = i + 1;
+        }
+        lmem_free(t->slots);
+        t->slots = slots;
+        t->size = size;
+        t->names = lmem_realloc(t->names, sizeof(char*) * (size / 2));
+    }
+
+    uint32_t j = lbin_hash(name) & (t->size - 1);
+    while (t->slots[j])
+    {
+        if (strcmp(t->names[t->slots[j] - 1], name) == 0)
+            return t->slots[j] - 1;
+        j = (j + 1) & (t->size - 1);
+    }
+
+    t->names[t->count] = name;
+    t->slots[j] = ++t->count;
+    return t->count - 1;
+}
+
+/* functions the host registered are not in the builtin table, they go by
+   the empty name and cannot be read back as functions */
+static char* lbin_fun_name(lbuiltin func)
+{
+    char* name = builtin_name(func);
+    return name ? name : "";
+}
+
+static void lbin_collect(lbin_syms* t, lval* v)
+{
+    switch (v->type)
+    {
+        case LVAL_SYM: lbin_intern(t, v->sym); break;
+        case LVAL_FUN:
+             if (v->closure == NULL)
+             {
+                 lbin_intern(t, lbin_fun_name(v->fun));
+                 break;
+             }
+             for (int i = 0; i < v->closure->count; i++)
+                 lbin_intern(t, v->closure->names[i]);
+             for (int i = 0; i < v->closure->count - v->closure->arity; i++)
+                 lbin_collect(t, v->closure->captured[i]);
+             lbin_collect(t, v->closure->body);
+             break;
+        case LVAL_FUT: lbin_collect(t, lfuture_wait(v->fut)); break;
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+             for (int i = 0; i < v->count; i++)
+                 lbin_collect(t, v->cell[i]);
+             break;
+    }
+}
+
+static void lbin_write_varint(lsink* s, uint64_t x)
+{
+    char buf[10];
+    int n = 0;
+    while (x >= 0x80)
+    {
+        buf[n++] = (char)(x | 0x80);
+        x >>= 7;
+    }
+    buf[n++] = (char)x;
+    lsink_write(s, buf, n);
+}
+
+static void lbin_write_value(lsink* s, lbin_syms* t, lval* v)
+{
+    switch (v->type)
+    {
+        case LVAL_NUM:
+            // zigzag so small negative numbers stay short too
+            lsink_putc(s, LBIN_NUM);
+            lbin_write_varint(s, ((uint64_t)v->num << 1) ^ -(uint64_t)(v->num < 0));
+            break;
+        case LVAL_ERR:
+            lsink_putc(s, LBIN_ERR);
+            lbin_write_varint(s, strlen(v->err));
+            lsink_puts(s, v->err);
+            break;
+        case LVAL_SYM:
+            lsink_putc(s, LBIN_SYM);
+            lbin_write_varint(s, lbin_intern(t, v->sym));
+            break;
+        case LVAL_FUN:
+            if (v->closure == NULL)
+            {
+                lsink_putc(s, LBIN_FUN);
+                lbin_write_varint(s, lbin_intern(t, lbin_fun_name(v->fun)));
+                break;
+            }
+            lsink_putc(s, LBIN_LAMBDA);
+            lbin_write_varint(s, v->closure->arity);
+            lbin_write_varint(s, v->closure->count);
+            for (int i = 0; i < v->closure->count; i++)
+                lbin_write_varint(s, lbin_intern(t, v->closure->names[i]));
+            for (int i = 0; i < v->closure->count - v->closure->arity; i++)
+                lbin_write_value(s, t, v->closure->captured[i]);
+            lbin_write_value(s, t, v->closure->body);
+            break;
+        case LVAL_FUT:
+            // saved as what it came to
+            lbin_write_value(s, t, lfuture_wait(v->fut));
+            break;
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            lsink_putc(s, v->type == LVAL_SEXPR ? LBIN_SEXPR : LBIN_QEXPR);
+            lbin_write_varint(s, v->count);
+            for (int i = 0; i < v->count; i++)
+                lbin_write_value(s, t, v->cell[i]);
+            break;
+    }
+}
+
+static void lbin_write_header(lsink* s, lbin_syms* t, const char* magic)
+{
+    lsink_write(s, magic, strlen(magic));
+    lsink_putc(s, LBIN_VERSION);
+
+    lbin_write_varint(s, t->count);
+    for (int i = 0; i < t->count; i++)
+    {
+        lbin_write_varint(s, strlen(t->names[i]));
+        lsink_puts(s, t->names[i]);
+    }
+}
+
+void lbin_write(lsink* s, lval* v)
+{
+    lbin_syms t = { 0, NULL, 0, NULL };
+    lbin_collect(&t, v);
+
+    lbin_write_header(s, &t, LBIN_MAGIC);
+    lbin_write_value(s, &t, v);
+
+    lmem_free(t.names);
+    lmem_free(t.slots);
+}
+
+void lbin_write_env(lsink* s, lenv* e)
+{
+    lbin_syms t = { 0, NULL, 0, NULL };
+    for (int i = 0; i < e->count; i++)
+    {
+        lbin_intern(&t, e->syms[i]);
+        lbin_collect(&t, e->vals[i]);
+    }
+
+    lbin_write_header(s, &t, LBIN_IMAGE_MAGIC);
+
+    lbin_write_varint(s, e->count);
+    for (int i = 0; i < e->count; i++)
+    {
+        lbin_write_varint(s, lbin_intern(&t, e->syms[i]));
+        lbin_write_value(s, &t, e->vals[i]);
+    }
+
+    lmem_free(t.names);
+    lmem_free(t.slots);
+}
+
+/* symbols point straight into the buffer being read, nothing is copied
+   until a value needs its own string */
+typedef struct
+{
+    const unsigned char* p;
+    const unsigned char* end;
+
+    uint64_t count;
+    const char** names;
+    size_t* lens;
+    int version;
+
+    // values being read around the current one
+    int depth;
+} lbin_reader;
+
+static int lbin_read_varint(lbin_reader* r, uint64_t* x)
+{
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (r->p == r->end)
+            return 0;
+        unsigned char b = *r->p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            *x = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static char* lbin_strndup(const char* s, size_t n)
+{
+    char* x = lmem_malloc(n + 1);
+    memcpy(x, s, n);
+    x[n] = '\0';
+    return x;
+}
+
+/* returns NULL when the data is malformed */
+static lval* lbin_read_value(lbin_reader* r)
+{
+    uint64_t x;
+    lval* v;
+
+    if (r->p == r->end)
+        return NULL;
+
+    switch (*r->p++)
+    {
+        case LBIN_NUM:
+            if (!lbin_read_varint(r, &x))
+                return NULL;
+            return lval_num((long)((x >> 1) ^ -(x & 1)));
+
+        case LBIN_ERR:
+            if (!lbin_read_varint(r, &x) || x > (uint64_t)(r->end - r->p))
+                return NULL;
+            v = lmem_malloc(sizeof(lval));
+            v->type = LVAL_ERR;
+            v->err = lbin_strndup((const char*)r->p, x);
+            r->p += x;
+            return v;
+
+        case LBIN_SYM:
+            if (!lbin_read_varint(r, &x) || x >= r->count)
+                return NULL;
+            v = lmem_malloc(sizeof(lval));
+            v->type = LVAL_SYM;
+            v->sym = lbin_strndup(r->names[x], r->lens[x]);
+            return v;
+
+        case LBIN_FUN:
+        {
+            if (!lbin_read_varint(r, &x) || x >= r->count)
+                return NULL;
+            if (r->lens[x] == 0)
+                return lval_err("Function was registered by the host and not saved");
+            lbuiltin func = builtin_find(r->names[x], r->lens[x]);
+            return func ? lval_fun(func) : NULL;
+        }
+
+        case LBIN_LAMBDA:
+        {
+            // every name takes at least one byte
+            uint64_t arity;
+            if (!lbin_read_varint(r, &arity) || !lbin_read_varint(r, &x)
+                || arity > x || x > (uint64_t)(r->end - r->p))
+                return NULL;
+
+            if (r->version < 2 || r->depth >= LBIN_DEPTH)
+                return NULL;
+
+            lclosure* c = lclosure_new((int)arity, (int)x, NULL);
+            int ok = 1;
+            for (int i = 0; ok && i < c->count; i++)
+            {
+                uint64_t k;
+                ok = lbin_read_varint(r, &k) && k < r->count;
+                if (ok)
+                    c->names[i] = lbin_strndup(r->names[k], r->lens[k]);
+            }
+            r->depth++;
+            for (int i = 0; ok && i < c->count - c->arity; i++)
+                ok = (c->captured[i] = lbin_read_value(r)) != NULL;
+            if (ok)
+                c->body = lbin_read_value(r);
+            r->depth--;
+
+            if (c->body == NULL || c->body->type != LVAL_QEXPR)
+            {
+                lclosure_unref(c);
+                return NULL;
+            }
+            return lval_lambda(c);
+        }
+
+        case LBIN_SEXPR:
+        case LBIN_QEXPR:
+        {
+            int type = r->p[-1] == LBIN_SEXPR ? LVAL_SEXPR : LVAL_QEXPR;
+
+            // every element takes at least one byte
+            if (!lbin_read_varint(r, &x) || x > (uint64_t)(r->end - r->p)
+                || r->depth >= LBIN_DEPTH)
+                return NULL;
+
+            v = lval_sexpr();
+            v->type = type;
+            if (x)
+                v->cell = lmem_malloc(sizeof(lval*) * x);
+
+            r->depth++;
+            while (v->count < (int)x)
+            {
+                lval* y = lbin_read_value(r);
+                if (y == NULL)
+                {
+                    lval_del(v);
+                    return NULL;
+                }
+                v->cell[v->count++] = y;
+            }
+            r->depth--;
+            return v;
+        }
+
+        default:
+            return NULL;
+    }
+}
+
+/* check the magic and point the reader at the symbol table */
+static int lbin_read_header(lbin_reader* r, const char* buf, size_t len, const char* magic)
+{
+    size_t n = strlen(magic);
+    r->names = NULL;
+    r->lens = NULL;
+    r->depth = 0;
+
+    if (len <= n || memcmp(buf, magic, n) != 0 || buf[n] < 1 || buf[n] > LBIN_VERSION)
+        return 0;
+
+    r->version = buf[n];
+    r->p = (const unsigned char*)buf + n + 1;
+    r->end = (const unsigned char*)buf + len;
+
+    // each name takes at least its length byte
+    if (!lbin_read_varint(r, &r->count) || r->count > (uint64_t)(r->end - r->p))
+        return 0;
+
+    r->names = lmem_malloc(sizeof(char*) * (r->count + 1));
+    r->lens = lmem_malloc(sizeof(size_t) * (r->count + 1));
+
+    for (uint64_t i = 0; i < r->count; i++)
+    {
+        uint64_t l;
+        if (!lbin_read_varint(r, &l) || l > (uint64_t)(r->end - r->p))
+            return 0;
+        r->names[i] = (const char*)r->p;
+        r->lens[i] = l;
+        r->p += l;
+    }
+
+    return 1;
+}
+
+lval* lbin_read(const char* buf, size_t len)
+{
+    lbin_reader r;
+    lval* v = NULL;
+
+    if (lbin_read_header(&r, buf, len, LBIN_MAGIC))
+        v = lbin_read_value(&r);
+
+    // anything left over means the data is not what we wrote
+    if (v && r.p != r.end)
+    {
+        lval_del(v);
+        v = NULL;
+    }
+
+    lmem_free(r.names);
+    lmem_free(r.lens);
+    return v;
+}
+
+int lbin_read_env(lenv* e, const char* buf, size_t len)
+{
+    lbin_reader r;
+    uint64_t n;
+    int ok = 0;
+
+    // every binding takes at least two bytes
+    if (lbin_read_header(&r, buf, len, LBIN_IMAGE_MAGIC)
+            && lbin_read_varint(&r, &n) && n <= (uint64_t)(r.end - r.p) / 2)
+    {
+        int count = e->count;
+        e->syms = lmem_realloc(e->syms, sizeof(char*) * (count + n));
+        e->vals = lmem_realloc(e->vals, sizeof(lval*) * (count + n));
+
+        /* a name already bound is rebound, as def would. The image was
+           written from an environment so its own names are unique, only
+           those bound before it was read are searched */
+        ok = 1;
+        for (uint64_t i = 0; i < n; i++)
+        {
+            uint64_t k;
+            lval* v = NULL;
+            if (lbin_read_varint(&r, &k) && k < r.count)
+                v = lbin_read_value(&r);
+
+            if (v == NULL)
+            {
+                ok = 0;
+                break;
+            }
+
+            int j = 0;
+            while (j < count && (strncmp(e->syms[j], r.names[k], r.lens[k]) != 0
+                                 || e->syms[j][r.lens[k]] != '\0'))
+                j++;
+
+            if (j < count)
+            {
+                lval_del(e->vals[j]);
+                e->vals[j] = v;
+                continue;
+            }
+
+            e->syms[e->count] = lbin_strndup(r.names[k], r.lens[k]);
+            e->vals[e->count] = v;
+            e->count++;
+        }
+
+        ok = ok && r.p == r.end;
+    }
+
+    lmem_free(r.names);
+    lmem_free(r.lens);
+    return ok;
+}
+
+lval* lbin_save(char* path, lval* v)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL)
+        return lval_err("Could not open file '%s'", path);
+
+    lsink* s = lsink_file(f);
+    lbin_write(s, v);
+    lsink_del(s);
+
+    int failed = ferror(f);
+    if (fclose(f) != 0 || failed)
+        return lval_err("Could not write file '%s'", path);
+
+    return lval_sexpr();
+}
+
+/* map the whole of path, or read it in where there is no mmap */
+char* lbin_map(char* path, size_t* len)
+{
+#ifdef _WIN32
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char* buf = lmem_malloc(size > 0 ? size : 1);
+    *len = fread(buf, 1, size > 0 ? size : 0, f);
+    fclose(f);
+    return buf;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    void* buf = MAP_FAILED;
+
+    if (fstat(fd, &st) == 0)
+    {
+        // an empty file cannot be mapped, it gets a buffer of its own
+        if (st.st_size == 0)
+        {
+            close(fd);
+            *len = 0;
+            return lmem_malloc(1);
+        }
+        buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (buf == MAP_FAILED)
+        return NULL;
+
+#ifdef MADV_SEQUENTIAL
+    madvise(buf, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    *len = st.st_size;
+    return buf;
+#endif
+}
+
+void lbin_unmap(char* buf, size_t len)
+{
+#ifdef _WIN32
+    lmem_free(buf);
+#else
+    if (len == 0)
+        lmem_free(buf);
+    else
+        munmap(buf, len);
+#endif
+}
+
+lval* lbin_load(char* path)
+{
+    size_t len;
+    char* buf = lbin_map(path, &len);
+    if (buf == NULL)
+        return lval_err("Could not open file '%s'", path);
+
+    // decode straight out of the mapping
+    lval* v = lbin_read(buf, len);
+    lbin_unmap(buf, len);
+
+    if (v == NULL)
+        return lval_err("File '%s' is not a Lispy binary", path);
+    return v;
+}
+
+lval* lbin_save_image(char* path, lenv* e)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL)
+        return lval_err("Could not open file '%s'", path);
+
+    lsink* s = lsink_file(f);
+    lbin_write_env(s, e);
+    lsink_del(s);
+
+    int failed = ferror(f);
+    if (fclose(f) != 0 || failed)
+        return lval_err("Could not write file '%s'", path);
+
+    return lval_sexpr();
+}
+
+lval* lbin_load_image(char* path, lenv* e)
+{
+    size_t len;
+    char* buf = lbin_map(path, &len);
+    if (buf == NULL)
+        return lval_err("Could not open file '%s'", path);
+
+    int ok = lbin_read_env(e, buf, len);
+    lbin_unmap(buf, len);
+
+    if (!ok)
+        return lval_err("File '%s' is not a Lispy image", path);
+    return lval_sexpr();
+}
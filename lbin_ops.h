@@ -0,0 +1,32 @@
+#ifndef LBIN_OPS_H
+#define LBIN_OPS_H
+
+#include "lbin.h"
+#include "lval.h"
+#include "lenv.h"
+#include "lsink_ops.h"
+
+
+void lbin_write(lsink* s, lval* v);
+
+lval* lbin_read(const char* buf, size_t len);
+
+void lbin_write_env(lsink* s, lenv* e);
+
+int lbin_read_env(lenv* e, const char* buf, size_t len);
+
+
+char* lbin_map(char* path, size_t* len);
+
+void lbin_unmap(char* buf, size_t len);
+
+
+lval* lbin_save(char* path, lval* v);
+
+lval* lbin_load(char* path);
+
+lval* lbin_save_image(char* path, lenv* e);
+
+lval* lbin_load_image(char* path, lenv* e);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef LCLOSURE_H
+#define LCLOSURE_H
+
+#include <stdatomic.h>
+#include <limits.h>
+
+struct lval;
+typedef struct lval lval;
+
+struct lclosure;
+typedef struct lclosure lclosure;
+
+/* parameters and captured values a call binds without allocating */
+#define LCLOSURE_SLOTS 8
+
+/* refs of a closure that is never freed, see lclosure_pin */
+#define LCLOSURE_PINNED INT_MAX
+
+/* a function made with \. A call binds names to the arguments followed
+   by the values captured when it was made, the free variables of the body
+   that were bound by the calls it was made in. Any other name is looked
+   up in the global environment at the time of the call. Never changed
+   once made, so copies share it and it is freed with the last of them */
+struct lclosure
+{
+    atomic_int refs;
+    int arity;
+    int count;
+    char** names;
+    lval** captured;
+    lval* body;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "lclosure_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lenv_ops.h"
+#include <string.h>
+
+/* a closure over body, which it takes, with room for count names of which
+   the first arity are parameters. The names and captured values are left
+   for the caller to fill in */
+lclosure* lclosure_new(int arity, int count, lval* body)
+{
+    lclosure* c = lmem_malloc(sizeof(lclosure));
+    atomic_init(&c->refs, 1);
+    c->arity = arity;
+    c->count = count;
+    c->names = lmem_calloc(count ? count : 1, sizeof(char*));
+    c->captured = lmem_calloc(count - arity ? count - arity : 1, sizeof(lval*));
+    c->body = body;
+    return c;
+}
+
+static int lclosure_named(char** names, int count, char* sym)
+{
+    for (int i = 0; i < count; i++)
+        if (strcmp(names[i], sym) == 0)
+            return 1;
+    return 0;
+}
+
+/* the names in v bound by a call e is in, and not yet in names, appended */
+static void lclosure_free_vars(lenv* e, lval* v, char*** names, int* count)
+{
+    switch (v->type)
+    {
+        case LVAL_SYM:
+        {
+            if (lclosure_named(*names, *count, v->sym))
+                return;
+            // frames only, the global environment is the last one
+            for (lenv* f = e; f->parent; f = f->parent)
+            {
+                if (lclosure_named(f->syms, f->count, v->sym))
+                {
+                    *names = lmem_realloc(*names, sizeof(char*) * (*count + 1));
+                    (*names)[(*count)++] = v->sym;
+                    return;
+                }
+            }
+            return;
+        }
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            for (int i = 0; i < v->count; i++)
+                lclosure_free_vars(e, v->cell[i], names, count);
+            return;
+    }
+}
+
+/* a closure taking the symbols in formals, made in e. Takes formals and
+   body, which are checked already */
+lclosure* lclosure_capture(lenv* e, lval* formals, lval* body)
+{
+    // parameters first, then the captured names after them
+    char** names = lmem_malloc(sizeof(char*) * (formals->count ? formals->count : 1));
+    int count = 0;
+    for (int i = 0; i < formals->count; i++)
+        names[count++] = formals->cell[i]->sym;
+    lclosure_free_vars(e, body, &names, &count);
+
+    lclosure* c = lclosure_new(formals->count, count, body);
+    for (int i = 0; i < count; i++)
+    {
+        c->names[i] = lmem_malloc(strlen(names[i]) + 1);
+        strcpy(c->names[i], names[i]);
+        if (i >= c->arity)
+            c->captured[i - c->arity] = lval_copy(lenv_find(e, names[i]));
+    }
+
+    lmem_free(names);
+    lval_del(formals);
+    return c;
+}
+
+lclosure* lclosure_ref(lclosure* c)
+{
+    if (atomic_load_explicit(&c->refs, memory_order_relaxed) != LCLOSURE_PINNED)
+        atomic_fetch_add_explicit(&c->refs, 1, memory_order_relaxed);
+    return c;
+}
+
+/* the last reference frees it, whatever of it was filled in */
+void lclosure_unref(lclosure* c)
+{
+    if (atomic_load_explicit(&c->refs, memory_order_relaxed) == LCLOSURE_PINNED)
+        return;
+    if (atomic_fetch_sub_explicit(&c->refs, 1, memory_order_acq_rel) != 1)
+        return;
+
+    for (int i = 0; i < c->count; i++)
+    {
+        lmem_free(c->names[i]);
+        if (i >= c->arity && c->captured[i - c->arity])
+            lval_del(c->captured[i - c->arity]);
+    }
+    lmem_free(c->names);
+    lmem_free(c->captured);
+    if (c->body)
+        lval_del(c->body);
+    lmem_free(c);
+}
+
+/* never free c or what it captured, references to it are no longer
+   counted from here on. Only while no other thread holds one */
+void lclosure_pin(lclosure* c)
+{
+    if (atomic_load_explicit(&c->refs, memory_order_relaxed) == LCLOSURE_PINNED)
+        return;
+
+    atomic_store_explicit(&c->refs, LCLOSURE_PINNED, memory_order_relaxed);
+    for (int i = 0; i < c->count - c->arity; i++)
+        lval_pin(c->captured[i]);
+    lval_pin(c->body);
+}
+
+/* evaluate the body with the arguments in a, which is taken. The frame
+   lives on the stack and its values are the arguments themselves and the
+   captured values, which lookups copy as they would from any environment */
+lval* lclosure_call(lenv* e, lclosure* c, lval* a)
+{
+    if (a->count != c->arity)
+    {
+        lval* err = lval_err("Function passed incorrect number of arguments. "
+                             "Got %i, Expected %i.", a->count, c->arity);
+        lval_del(a);
+        return err;
+    }
+
+    lval* slots[LCLOSURE_SLOTS];
+    lval** vals = c->count <= LCLOSURE_SLOTS ? slots : lmem_malloc(sizeof(lval*) * c->count);
+    memcpy(vals, a->cell, sizeof(lval*) * c->arity);
+    memcpy(vals + c->arity, c->captured, sizeof(lval*) * (c->count - c->arity));
+
+    lenv frame;
+    frame.count = c->count;
+    frame.syms = c->names;
+    frame.vals = vals;
+    frame.pool = e->pool;
+    frame.cost = e->cost;
+    frame.parent = lenv_root(e);
+    frame.files = frame.parent->files;
+
+    lval* body = lval_copy(c->body);
+    body->type = LVAL_SEXPR;
+    lval* x = lval_eval(&frame, body);
+
+    // the arguments were only lent to the frame
+    a->count = 0;
+    lval_del(a);
+    for (int i = 0; i < c->arity; i++)
+        lval_del(vals[i]);
+    if (vals != slots)
+        lmem_free(vals);
+    return x;
+}
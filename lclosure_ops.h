@@ -0,0 +1,20 @@
+#ifndef LCLOSURE_OPS_H
+#define LCLOSURE_OPS_H
+
+#include "lclosure.h"
+#include "lenv.h"
+
+
+lclosure* lclosure_new(int arity, int count, lval* body);
+
+lclosure* lclosure_capture(lenv* e, lval* formals, lval* body);
+
+lclosure* lclosure_ref(lclosure* c);
+
+void lclosure_unref(lclosure* c);
+
+void lclosure_pin(lclosure* c);
+
+lval* lclosure_call(lenv* e, lclosure* c, lval* a);
+
+#endif
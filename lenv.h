@@ -5,6 +5,9 @@
 struct lval;
 typedef struct lval lval;
 
+struct lpool;
+typedef struct lpool lpool;
+
 struct lenv;
 typedef struct lenv lenv;
 
@@ -13,6 +16,18 @@ struct lenv
     int count;
     char** syms;
     lval** vals;
+
+    /* evaluating with this pool, see lval_eval_parallel */
+    lpool* pool;
+    long cost;
+
+    /* a call's frame is looked up first, then the global environment
+       it was called from, which has none */
+    lenv* parent;
+
+    /* whether save, load, snapshot and read may touch files, looked at
+       in the global environment only */
+    int files;
 };
 
 #endif
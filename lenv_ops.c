@@ -1,13 +1,18 @@
 #include "lenv_ops.h"
+#include "lmem_ops.h"
 #include "lval_ops.h"
 #include <stdlib.h>
 
 lenv* lenv_new(void)
 {
-    lenv* e = malloc(sizeof(lenv));
+    lenv* e = lmem_malloc(sizeof(lenv));
     e->count = 0;
     e->syms = NULL;
     e->vals = NULL;
+    e->pool = NULL;
+    e->cost = 0;
+    e->parent = NULL;
+    e->files = 1;
     return e;
 }
 
@@ -15,25 +20,45 @@ void lenv_del(lenv* e)
 {
     for (int i = 0; i < e->count; i++)
     {
-        free(e->syms[i]);
+        lmem_free(e->syms[i]);
         lval_del(e->vals[i]);
     }
-    free(e->syms);
-    free(e->vals);
-    free(e);
+    lmem_free(e->syms);
+    lmem_free(e->vals);
+    lmem_free(e);
 }
 
-lval* lenv_get(lenv* e, lval* k)
+/* the value bound to sym itself, not a copy, NULL if there is none */
+lval* lenv_find(lenv* e, char* sym)
 {
-
-    for (int i = 0; i < e->count; i++)
+    for (; e; e = e->parent)
     {
-        if (strcmp(e->syms[i], k->sym) == 0)
+        for (int i = 0; i < e->count; i++)
         {
-            return lval_copy(e->vals[i]);
+            if (strcmp(e->syms[i], sym) == 0)
+            {
+                return e->vals[i];
+            }
         }
     }
 
+    return NULL;
+}
+
+/* the global environment, where definitions go */
+lenv* lenv_root(lenv* e)
+{
+    while (e->parent)
+        e = e->parent;
+    return e;
+}
+
+lval* lenv_get(lenv* e, lval* k)
+{
+    lval* v = lenv_find(e, k->sym);
+    if (v)
+        return lval_copy(v);
+
     return lval_err("Unbound symbol '%s'", k->sym);
 }
 
@@ -56,12 +81,12 @@ void lenv_put(lenv* e, lval* k, lval* v)
 
     /* If no eisting entry found allocate space for new entry */
     e->count++;
-    e->vals = realloc(e->vals, sizeof(lval*) * e->count);
-    e->syms = realloc(e->syms, sizeof(char*) * e->count);
+    e->vals = lmem_realloc(e->vals, sizeof(lval*) * e->count);
+    e->syms = lmem_realloc(e->syms, sizeof(char*) * e->count);
 
     /* Copy contents of lval and symbol string int new location */
     e->vals[e->count-1] = lval_copy(v);
-    e->syms[e->count-1] = malloc(strlen(k->sym)+1);
+    e->syms[e->count-1] = lmem_malloc(strlen(k->sym)+1);
     strcpy(e->syms[e->count-1], k->sym);
 }
 
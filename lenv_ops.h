@@ -10,6 +10,10 @@ lenv* lenv_new(void);
 
 void lenv_del(lenv* e);
 
+lval* lenv_find(lenv* e, char* sym);
+
+lenv* lenv_root(lenv* e);
+
 lval* lenv_get(lenv* e, lval* k);
 
 void lenv_put(lenv* e, lval* k, lval* v);
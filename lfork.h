@@ -0,0 +1,81 @@
+#ifndef LFORK_H
+#define LFORK_H
+
+#include <stddef.h>
+#include <signal.h>
+#include <sys/types.h>
+
+struct lisolate;
+typedef struct lisolate lisolate;
+
+struct lfork_heap;
+typedef struct lfork_heap lfork_heap;
+
+struct lfork_child;
+typedef struct lfork_child lfork_child;
+
+struct lfork;
+typedef struct lfork lfork;
+
+/* address space set aside for what the master sets up before forking,
+   pages are only used as it fills */
+#ifndef LFORK_HEAP_SIZE
+#define LFORK_HEAP_SIZE ((size_t)256 << 20)
+#endif
+
+/* blocks in the heap are this aligned, each after a header of this size
+   holding its capacity */
+#define LFORK_ALIGN 16
+
+/* freed blocks up to this size are kept for reuse, one list per size */
+#define LFORK_SMALL 1024
+
+/* a worker exiting within this many milliseconds of being forked has
+   failed quickly, a place that fails quickly this many times in a row is
+   left empty rather than forked into again */
+#define LFORK_QUICK 1000
+#define LFORK_FAILURES 5
+
+/* everything the master allocates before forking is laid out here, one
+   block after another. Nothing allocated afterwards goes here, and the
+   closures and futures in it are pinned before forking so copies of them
+   are not counted. So a worker only ever writes to these pages when it
+   changes a definition made before the fork, and the rest stay shared */
+struct lfork_heap
+{
+    char* base;
+    char* next;
+    char* end;
+    void* free[LFORK_SMALL / LFORK_ALIGN + 1];
+};
+
+/* a forked worker and the socket its connections are sent over, with
+   when it was forked and how many before it failed quickly */
+struct lfork_child
+{
+    pid_t pid;
+    int channel;
+    long started;
+    int failures;
+};
+
+/* the master accepts connections and passes each to a worker process in
+   turn, forking a new one from its own warmed interpreter whenever one
+   exits */
+struct lfork
+{
+    char* path;
+    int listen_fd;
+    int epoll_fd;
+    int signal_fd;
+    sigset_t old_mask;
+
+    lisolate* iso;
+    int threads;
+
+    int count;
+    lfork_child* children;
+    int next;
+};
+
+#endif
@@ -0,0 +1,525 @@
+#define _GNU_SOURCE
+
+#include "lfork_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lbin_ops.h"
+#include "lisolate_ops.h"
+#include "lserver_ops.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+
+/* there is one heap, whatever allocator was set before lfork_new takes
+   everything that does not fit in it or comes after. Files read by the
+   prelude are parsed on threads of their own, so it is only changed
+   holding the lock */
+static lfork_heap lfork_warm;
+static lmem lfork_outer;
+static pthread_mutex_t lfork_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int lfork_owns(void* p)
+{
+    return (char*)p >= lfork_warm.base && (char*)p < lfork_warm.end;
+}
+
+/* how much the block can hold, at least what it was asked for */
+static size_t lfork_size(void* p)
+{
+    return *(size_t*)((char*)p - LFORK_ALIGN);
+}
+
+static size_t lfork_round(size_t n)
+{
+    return (n + LFORK_ALIGN - 1) & ~(size_t)(LFORK_ALIGN - 1);
+}
+
+/* a block of cap bytes from the heap, NULL if it is full. With the lock
+   held, as for lfork_heap_put */
+static void* lfork_heap_take(size_t cap)
+{
+    if (cap <= LFORK_SMALL && lfork_warm.free[cap / LFORK_ALIGN])
+    {
+        void* p = lfork_warm.free[cap / LFORK_ALIGN];
+        lfork_warm.free[cap / LFORK_ALIGN] = *(void**)p;
+        return p;
+    }
+
+    if ((size_t)(lfork_warm.end - lfork_warm.next) < LFORK_ALIGN + cap)
+        return NULL;
+
+    char* p = lfork_warm.next + LFORK_ALIGN;
+    *(size_t*)(p - LFORK_ALIGN) = cap;
+    lfork_warm.next += LFORK_ALIGN + cap;
+    return p;
+}
+
+/* blocks that are not the last are freed to be reused by one of the same
+   size, or left where they are if too large */
+static void lfork_heap_put(void* p)
+{
+    size_t cap = lfork_size(p);
+    if ((char*)p + cap == lfork_warm.next)
+        lfork_warm.next = (char*)p - LFORK_ALIGN;
+    else if (cap <= LFORK_SMALL)
+    {
+        *(void**)p = lfork_warm.free[cap / LFORK_ALIGN];
+        lfork_warm.free[cap / LFORK_ALIGN] = p;
+    }
+}
+
+static void* lfork_heap_malloc(size_t n)
+{
+    pthread_mutex_lock(&lfork_lock);
+    void* p = lfork_heap_take(lfork_round(n ? n : 1));
+    pthread_mutex_unlock(&lfork_lock);
+    return p ? p : lfork_outer.malloc(n);
+}
+
+static void lfork_heap_free(void* p)
+{
+    if (!lfork_owns(p))
+    {
+        lfork_outer.free(p);
+        return;
+    }
+
+    pthread_mutex_lock(&lfork_lock);
+    lfork_heap_put(p);
+    pthread_mutex_unlock(&lfork_lock);
+}
+
+static void* lfork_heap_realloc(void* p, size_t n)
+{
+    if (p == NULL)
+        return lfork_heap_malloc(n);
+    if (!lfork_owns(p))
+        return lfork_outer.realloc(p, n);
+
+    size_t cap = lfork_size(p);
+    if (n <= cap)
+        return p;
+
+    pthread_mutex_lock(&lfork_lock);
+
+    // the last block grows where it is
+    if ((char*)p + cap == lfork_warm.next && (size_t)(lfork_warm.end - (char*)p) >= lfork_round(n))
+    {
+        lfork_warm.next = (char*)p + lfork_round(n);
+        *(size_t*)((char*)p - LFORK_ALIGN) = lfork_round(n);
+        pthread_mutex_unlock(&lfork_lock);
+        return p;
+    }
+
+    // others move to twice the room, lists are built one item at a time
+    size_t grow = lfork_round(n) > 2 * cap ? lfork_round(n) : 2 * cap;
+    void* q = lfork_heap_take(grow);
+    if (q == NULL)
+        q = lfork_outer.malloc(n);
+    if (q)
+    {
+        memcpy(q, p, cap);
+        lfork_heap_put(p);
+    }
+
+    pthread_mutex_unlock(&lfork_lock);
+    return q;
+}
+
+static void* lfork_cold_malloc(size_t n)
+{
+    return lfork_outer.malloc(n);
+}
+
+/* once forked the heap is left alone, freeing into it would write to
+   its pages */
+static void lfork_cold_free(void* p)
+{
+    if (!lfork_owns(p))
+        lfork_outer.free(p);
+}
+
+/* a block from the heap that has to grow moves out of it */
+static void* lfork_cold_realloc(void* p, size_t n)
+{
+    if (p == NULL || !lfork_owns(p))
+        return lfork_outer.realloc(p, n);
+
+    size_t cap = lfork_size(p);
+    if (n <= cap)
+        return p;
+
+    void* q = lfork_outer.malloc(n);
+    if (q)
+        memcpy(q, p, cap);
+    return q;
+}
+
+static const lmem lfork_heap_mem = { lfork_heap_malloc, lfork_heap_realloc, lfork_heap_free };
+static const lmem lfork_cold_mem = { lfork_cold_malloc, lfork_cold_realloc, lfork_cold_free };
+
+/* a master listening on path that will fork procs workers, 0 for one per
+   core, each with threads threads for large arguments. Until lfork_run
+   everything allocated goes in the heap. NULL if the socket could not be
+   set up, the reason is in errno */
+lfork* lfork_new(const char* path, int procs, int threads)
+{
+    int fd = lserver_listen(path);
+    if (fd < 0)
+        return NULL;
+
+    if (procs <= 0)
+        procs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    lfork* f = lmem_malloc(sizeof(lfork));
+    f->path = lmem_malloc(strlen(path) + 1);
+    strcpy(f->path, path);
+    f->listen_fd = fd;
+    f->epoll_fd = -1;
+    f->signal_fd = -1;
+    f->threads = threads;
+    f->count = procs < 1 ? 1 : procs;
+    f->children = lmem_malloc(sizeof(lfork_child) * f->count);
+    f->next = 0;
+    for (int i = 0; i < f->count; i++)
+    {
+        f->children[i].pid = -1;
+        f->children[i].channel = -1;
+        f->children[i].failures = 0;
+    }
+
+    // reserved only, pages are taken as the heap reaches them
+    void* base = mmap(NULL, LFORK_HEAP_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED)
+        base = NULL;
+    memset(&lfork_warm, 0, sizeof(lfork_warm));
+    lfork_warm.base = lfork_warm.next = base;
+    lfork_warm.end = base ? (char*)base + LFORK_HEAP_SIZE : NULL;
+
+    lmem_get(&lfork_outer);
+    lmem_set(&lfork_heap_mem);
+
+    // no pool until forked, its threads would not survive it
+    f->iso = lisolate_new(1);
+    return f;
+}
+
+/* only after lfork_run has returned, or if it was never called */
+void lfork_del(lfork* f)
+{
+    lisolate_del(f->iso);
+    lmem_set(&lfork_outer);
+    if (lfork_warm.base)
+        munmap(lfork_warm.base, LFORK_HEAP_SIZE);
+    memset(&lfork_warm, 0, sizeof(lfork_warm));
+
+    close(f->listen_fd);
+    unlink(f->path);
+    lmem_free(f->children);
+    lmem_free(f->path);
+    lmem_free(f);
+}
+
+/* run a script in the master before any worker is forked, so every worker
+   starts with its definitions. The result of its last form */
+lval* lfork_prelude(lfork* f, const char* filename)
+{
+    size_t len;
+    char* buf = lbin_map((char*)filename, &len);
+    if (buf == NULL)
+        return lval_err("Could not open file '%s'", filename);
+
+    lval* x = lisolate_eval(f->iso, filename, buf, len);
+    lbin_unmap(buf, len);
+    return x;
+}
+
+/* what a forked worker does with its life, serve connections from channel
+   until the master is gone or it is told to stop */
+static int lfork_serve(lfork* f, int channel)
+{
+    close(f->listen_fd);
+    close(f->epoll_fd);
+    close(f->signal_fd);
+    for (int i = 0; i < f->count; i++)
+        if (f->children[i].channel >= 0)
+            close(f->children[i].channel);
+    pthread_sigmask(SIG_SETMASK, &f->old_mask, NULL);
+    fcntl(channel, F_SETFL, fcntl(channel, F_GETFL) | O_NONBLOCK);
+
+    lisolate_threads(f->iso, f->threads);
+    lserver* s = lserver_channel(channel, f->iso);
+    int failed = lserver_run(s);
+    lserver_del(s);
+    return failed;
+}
+
+/* milliseconds on a clock that only moves forward */
+static long lfork_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+/* fork the worker in slot k, leaving the slot empty if it could not be */
+static void lfork_spawn(lfork* f, int k)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sv) < 0)
+        return;
+
+    // nothing buffered is written twice
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(sv[0]);
+        _exit(lfork_serve(f, sv[1]));
+    }
+
+    close(sv[1]);
+    if (pid < 0)
+    {
+        close(sv[0]);
+        return;
+    }
+    f->children[k].pid = pid;
+    f->children[k].channel = sv[0];
+    f->children[k].started = lfork_now();
+}
+
+/* pass a connection over a channel, 0 if the worker cannot take it now */
+static int lfork_send(int channel, int fd)
+{
+    char byte = 0;
+    struct iovec iov = { &byte, 1 };
+    union
+    {
+        struct cmsghdr h;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* h = CMSG_FIRSTHDR(&msg);
+    h->cmsg_level = SOL_SOCKET;
+    h->cmsg_type = SCM_RIGHTS;
+    h->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(h), &fd, sizeof(int));
+
+    ssize_t n;
+    while ((n = sendmsg(channel, &msg, MSG_DONTWAIT | MSG_NOSIGNAL)) < 0 && errno == EINTR);
+    return n == 1;
+}
+
+/* hand each new connection to the next worker that will take it. One no
+   worker can take is closed */
+static void lfork_accept(lfork* f)
+{
+    while (1)
+    {
+        int fd = accept4(f->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;
+        }
+
+        for (int tries = 0; tries < f->count; tries++)
+        {
+            lfork_child* c = &f->children[f->next];
+            f->next = (f->next + 1) % f->count;
+            if (c->channel >= 0 && lfork_send(c->channel, fd))
+                break;
+        }
+        close(fd);
+    }
+}
+
+/* collect the workers that have exited, forking another in each place
+   unless the master is stopping or the place keeps failing quickly.
+   Returns how many workers are left */
+static int lfork_reap(lfork* f, int restart)
+{
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        for (int k = 0; k < f->count; k++)
+        {
+            lfork_child* c = &f->children[k];
+            if (c->pid != pid)
+                continue;
+
+            close(c->channel);
+            c->pid = -1;
+            c->channel = -1;
+            if (!restart)
+                continue;
+
+            if (lfork_now() - c->started < LFORK_QUICK)
+                c->failures++;
+            else
+                c->failures = 0;
+
+            if (WIFSIGNALED(status))
+                fprintf(stderr, "Worker %d killed by signal %d", (int)pid, WTERMSIG(status));
+            else
+                fprintf(stderr, "Worker %d exited with %d", (int)pid, WEXITSTATUS(status));
+
+            if (c->failures >= LFORK_FAILURES)
+            {
+                fprintf(stderr, ", failed %d times in a row, not starting another\n", c->failures);
+                continue;
+            }
+            fprintf(stderr, ", starting another\n");
+            lfork_spawn(f, k);
+        }
+    }
+
+    int left = 0;
+    for (int k = 0; k < f->count; k++)
+        left += f->children[k].pid > 0;
+    return left;
+}
+
+/* fork the workers and pass them connections until SIGINT or SIGTERM,
+   then stop them and wait for them to finish. 1 if the master could not
+   be started or every worker kept failing */
+int lfork_run(lfork* f)
+{
+    // requests may not touch files, cleared here so no worker writes it
+    f->iso->env->files = 0;
+
+    // copies of what the files defined are not counted, so using one
+    // leaves the page it is on alone
+    for (int i = 0; i < f->iso->env->count; i++)
+        lval_pin(f->iso->env->vals[i]);
+
+    // the heap is done, what the workers allocate is theirs alone
+    lmem_set(&lfork_cold_mem);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, &f->old_mask);
+    f->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    f->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = f->listen_fd;
+    int failed = f->signal_fd < 0 || f->epoll_fd < 0
+              || epoll_ctl(f->epoll_fd, EPOLL_CTL_ADD, f->listen_fd, &ev) < 0;
+    ev.data.fd = f->signal_fd;
+    failed = failed || epoll_ctl(f->epoll_fd, EPOLL_CTL_ADD, f->signal_fd, &ev) < 0;
+
+    for (int k = 0; !failed && k < f->count; k++)
+        lfork_spawn(f, k);
+
+    struct epoll_event events[LSERVER_EVENTS];
+    int stop = failed;
+    while (!stop)
+    {
+        int n = epoll_wait(f->epoll_fd, events, LSERVER_EVENTS, -1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == f->listen_fd)
+            {
+                lfork_accept(f);
+                continue;
+            }
+
+            struct signalfd_siginfo info;
+            while (read(f->signal_fd, &info, sizeof(info)) == sizeof(info))
+            {
+                if (info.ssi_signo != SIGCHLD)
+                    stop = 1;
+                else if (lfork_reap(f, 1) == 0)
+                {
+                    // nothing left to pass connections to
+                    fprintf(stderr, "Every worker has failed, stopping\n");
+                    failed = stop = 1;
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < f->count; k++)
+        if (f->children[k].pid > 0)
+            kill(f->children[k].pid, SIGTERM);
+    for (int k = 0; k < f->count; k++)
+    {
+        if (f->children[k].pid > 0)
+        {
+            while (waitpid(f->children[k].pid, NULL, 0) < 0 && errno == EINTR);
+            close(f->children[k].channel);
+            f->children[k].pid = -1;
+            f->children[k].channel = -1;
+        }
+    }
+
+    if (f->signal_fd >= 0)
+        close(f->signal_fd);
+    if (f->epoll_fd >= 0)
+        close(f->epoll_fd);
+    f->signal_fd = f->epoll_fd = -1;
+    pthread_sigmask(SIG_SETMASK, &f->old_mask, NULL);
+    return failed;
+}
+
+#else
+
+lfork* lfork_new(const char* path, int procs, int threads)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+
+void lfork_del(lfork* f)
+{
+}
+
+lval* lfork_prelude(lfork* f, const char* filename)
+{
+    return lval_err("Forked workers need Linux");
+}
+
+int lfork_run(lfork* f)
+{
+    return 1;
+}
+
+#endif
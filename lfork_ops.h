@@ -0,0 +1,16 @@
+#ifndef LFORK_OPS_H
+#define LFORK_OPS_H
+
+#include "lfork.h"
+#include "lval.h"
+
+
+lfork* lfork_new(const char* path, int procs, int threads);
+
+void lfork_del(lfork* f);
+
+lval* lfork_prelude(lfork* f, const char* filename);
+
+int lfork_run(lfork* f);
+
+#endif
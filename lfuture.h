@@ -0,0 +1,26 @@
+#ifndef LFUTURE_H
+#define LFUTURE_H
+
+#include <stdatomic.h>
+#include <limits.h>
+#include "lpool.h"
+
+struct lfuture;
+typedef struct lfuture lfuture;
+
+/* an expression being evaluated on a pool. It gets an environment of its
+   own, copied from the one it was spawned in, so nothing it reaches is
+   shared with the thread that spawned it. Every copy of a future value
+   holds a reference, the last one to go waits for the result and frees it */
+struct lfuture
+{
+    atomic_int refs;
+    lpool* pool;
+    lenv* env;
+    lpool_task task;
+};
+
+/* refs of a future that is never freed, see lfuture_pin */
+#define LFUTURE_PINNED INT_MAX
+
+#endif
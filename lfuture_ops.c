@@ -0,0 +1,107 @@
+#include "lfuture_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lenv_ops.h"
+#include "lpool_ops.h"
+
+/* bind in to every name v could look up in from, and everything the values
+   bound to them could look up in turn */
+static void lfuture_capture(lenv* to, lenv* from, lval* v)
+{
+    switch (v->type)
+    {
+        case LVAL_SYM:
+        {
+            if (lenv_find(to, v->sym))
+                return;
+            lval* x = lenv_find(from, v->sym);
+            if (x == NULL)
+                return;
+            lenv_put(to, v, x);
+            lfuture_capture(to, from, x);
+            return;
+        }
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            for (int i = 0; i < v->count; i++)
+                lfuture_capture(to, from, v->cell[i]);
+            return;
+    }
+}
+
+/* start evaluating v, which is taken, in a copy of what it needs from e.
+   Functions are all copied, they cost next to nothing, so names built up
+   while evaluating still find them. Without a pool it is evaluated now */
+lfuture* lfuture_new(lenv* e, lval* v)
+{
+    lfuture* f = lmem_malloc(sizeof(lfuture));
+    atomic_init(&f->refs, 1);
+    f->pool = e->pool;
+    f->env = lenv_new();
+    f->env->files = lenv_root(e)->files;
+    lval_eval_parallel(f->env, e->pool, e->cost);
+
+    // a call's frame before the environment it was called from
+    for (lenv* p = e; p; p = p->parent)
+    {
+        for (int i = 0; i < p->count; i++)
+        {
+            if (p->vals[i]->type == LVAL_FUN && lenv_find(f->env, p->syms[i]) == NULL)
+            {
+                lval* k = lval_sym(p->syms[i]);
+                lenv_put(f->env, k, p->vals[i]);
+                lval_del(k);
+            }
+        }
+    }
+    lfuture_capture(f->env, e, v);
+
+    if (f->pool)
+        lpool_spawn(f->pool, &f->task, f->env, v);
+    else
+    {
+        f->task.result = lval_eval(f->env, v);
+        atomic_init(&f->task.done, 1);
+    }
+    return f;
+}
+
+lfuture* lfuture_ref(lfuture* f)
+{
+    if (atomic_load_explicit(&f->refs, memory_order_relaxed) != LFUTURE_PINNED)
+        atomic_fetch_add_explicit(&f->refs, 1, memory_order_relaxed);
+    return f;
+}
+
+void lfuture_unref(lfuture* f)
+{
+    if (atomic_load_explicit(&f->refs, memory_order_relaxed) == LFUTURE_PINNED)
+        return;
+    if (atomic_fetch_sub_explicit(&f->refs, 1, memory_order_acq_rel) != 1)
+        return;
+
+    lval_del(lfuture_wait(f));
+    lenv_del(f->env);
+    lmem_free(f);
+}
+
+/* never free f or its result, references to it are no longer counted
+   from here on. Only once its result is there and while no other thread
+   holds one */
+void lfuture_pin(lfuture* f)
+{
+    if (atomic_load_explicit(&f->refs, memory_order_relaxed) == LFUTURE_PINNED)
+        return;
+
+    atomic_store_explicit(&f->refs, LFUTURE_PINNED, memory_order_relaxed);
+    lval_pin(lfuture_wait(f));
+}
+
+/* the result, still owned by the future, once it is there. Only on a
+   thread that may use the pool it was spawned on */
+lval* lfuture_wait(lfuture* f)
+{
+    if (f->pool)
+        return lpool_wait(f->pool, &f->task);
+    return f->task.result;
+}
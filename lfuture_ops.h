@@ -0,0 +1,18 @@
+#ifndef LFUTURE_OPS_H
+#define LFUTURE_OPS_H
+
+#include "lfuture.h"
+#include "lval.h"
+
+
+lfuture* lfuture_new(lenv* e, lval* v);
+
+lfuture* lfuture_ref(lfuture* f);
+
+void lfuture_unref(lfuture* f);
+
+void lfuture_pin(lfuture* f);
+
+lval* lfuture_wait(lfuture* f);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef LINDEX_H
+#define LINDEX_H
+
+#include <stdint.h>
+
+/* bytes classified at a time */
+#define LINDEX_BLOCK 64
+
+struct lindex;
+typedef struct lindex lindex;
+
+/* what each byte of a block is, one bit per byte with the first byte in
+   the lowest bit. A start is the first byte of an atom, so whether the
+   last block ended inside one is carried over */
+struct lindex
+{
+    uint64_t open;
+    uint64_t close;
+    uint64_t space;
+    uint64_t newline;
+    uint64_t start;
+
+    uint64_t carry;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "lindex_ops.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void lindex_reset(lindex* x)
+{
+    memset(x, 0, sizeof(lindex));
+}
+
+#if defined(__SSE2__)
+
+/* gather the top bit of each byte of four vectors into one mask */
+static uint64_t lindex_mask(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    return (uint64_t)(unsigned)_mm_movemask_epi8(a)
+        | (uint64_t)(unsigned)_mm_movemask_epi8(b) << 16
+        | (uint64_t)(unsigned)_mm_movemask_epi8(c) << 32
+        | (uint64_t)(unsigned)_mm_movemask_epi8(d) << 48;
+}
+
+static void lindex_classify(lindex* x, const char* s)
+{
+    __m128i open[4], close[4], space[4], newline[4];
+
+    for (int k = 0; k < 4; k++)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + 16 * k));
+
+        open[k] = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('(')), _mm_cmpeq_epi8(v, _mm_set1_epi8('{')));
+        close[k] = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(')')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+        newline[k] = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+
+        // '\t' to '\r' is one unsigned range, checked with a saturating min
+        __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+        space[k] = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8('\r' - '\t')), d),
+                                _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    }
+
+    x->open = lindex_mask(open[0], open[1], open[2], open[3]);
+    x->close = lindex_mask(close[0], close[1], close[2], close[3]);
+    x->space = lindex_mask(space[0], space[1], space[2], space[3]);
+    x->newline = lindex_mask(newline[0], newline[1], newline[2], newline[3]);
+}
+
+#else
+
+static void lindex_classify(lindex* x, const char* s)
+{
+    x->open = x->close = x->space = x->newline = 0;
+    for (int i = 0; i < LINDEX_BLOCK; i++)
+    {
+        unsigned char c = (unsigned char)s[i];
+        uint64_t bit = (uint64_t)1 << i;
+        if (c == '(' || c == '{') x->open |= bit;
+        if (c == ')' || c == '}') x->close |= bit;
+        if (c == ' ' || (c >= '\t' && c <= '\r')) x->space |= bit;
+        if (c == '\n') x->newline |= bit;
+    }
+}
+
+#endif
+
+/* classify the LINDEX_BLOCK bytes at s */
+void lindex_block(lindex* x, const char* s)
+{
+    lindex_classify(x, s);
+
+    // an atom starts wherever an atom byte follows anything else
+    uint64_t atom = ~(x->open | x->close | x->space);
+    x->start = atom & ~(atom << 1 | x->carry);
+    x->carry = atom >> 63;
+}
+
+/* classify the last n < LINDEX_BLOCK bytes, the rest read as whitespace */
+void lindex_tail(lindex* x, const char* s, size_t n)
+{
+    char buf[LINDEX_BLOCK];
+    memcpy(buf, s, n);
+    memset(buf + n, ' ', LINDEX_BLOCK - n);
+    lindex_block(x, buf);
+}
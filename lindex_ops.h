@@ -0,0 +1,50 @@
+#ifndef LINDEX_OPS_H
+#define LINDEX_OPS_H
+
+#include <stddef.h>
+#include "lindex.h"
+
+
+void lindex_reset(lindex* x);
+
+void lindex_block(lindex* x, const char* s);
+
+void lindex_tail(lindex* x, const char* s, size_t n);
+
+
+/* positions of the lowest and highest set bit and how many are set,
+   m must not be 0 */
+
+#if defined(__GNUC__)
+
+static inline int lindex_first(uint64_t m) { return __builtin_ctzll(m); }
+static inline int lindex_last(uint64_t m) { return 63 - __builtin_clzll(m); }
+static inline int lindex_count(uint64_t m) { return __builtin_popcountll(m); }
+
+#else
+
+static inline int lindex_first(uint64_t m)
+{
+    int i = 0;
+    while (!(m & 1)) { m >>= 1; i++; }
+    return i;
+}
+
+static inline int lindex_last(uint64_t m)
+{
+    int i = 0;
+    while (m >>= 1) i++;
+    return i;
+}
+
+static inline int lindex_count(uint64_t m)
+{
+    m = m - ((m >> 1) & 0x5555555555555555ULL);
+    m = (m & 0x3333333333333333ULL) + ((m >> 2) & 0x3333333333333333ULL);
+    m = (m + (m >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((m * 0x0101010101010101ULL) >> 56);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef LISOLATE_H
+#define LISOLATE_H
+
+struct lenv;
+typedef struct lenv lenv;
+
+struct lpool;
+typedef struct lpool lpool;
+
+struct lisolate;
+typedef struct lisolate lisolate;
+
+/* an interpreter of its own. Nothing it holds is reachable from any other
+   isolate, the only things they share are the builtin table and the parser,
+   which are never written to. So each thread can drive an isolate of its
+   own without any locking, though one isolate is only used by one thread
+   at a time */
+struct lisolate
+{
+    lenv* env;
+    lpool* pool;
+};
+
+#endif
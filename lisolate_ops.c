@@ -0,0 +1,70 @@
+#include "lisolate_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lenv_ops.h"
+#include "lpool_ops.h"
+#include "lload_ops.h"
+#include "builtins.h"
+#include <stdlib.h>
+
+/* an isolate starting from the builtins. With more than one thread it
+   evaluates large arguments side by side on a pool of its own */
+lisolate* lisolate_new(int threads)
+{
+    lisolate* i = lmem_malloc(sizeof(lisolate));
+    i->env = lenv_new();
+    i->pool = NULL;
+    lenv_add_builtins(i->env);
+    lisolate_threads(i, threads);
+    return i;
+}
+
+/* evaluate large arguments on a pool of threads from now on, none for one
+   or less. Threads do not survive a fork, an isolate made before one gets
+   its pool in the process that uses it. Not while anything is spawned */
+void lisolate_threads(lisolate* i, int threads)
+{
+    if (i->pool)
+    {
+        lval_eval_parallel(i->env, NULL, LPOOL_COST);
+        lpool_del(i->pool);
+        i->pool = NULL;
+    }
+
+    if (threads > 1)
+    {
+        i->pool = lpool_new(threads, 0);
+        lval_eval_parallel(i->env, i->pool, LPOOL_COST);
+    }
+}
+
+/* the environment goes first, futures in it wait on the pool */
+void lisolate_del(lisolate* i)
+{
+    lenv_del(i->env);
+    if (i->pool)
+        lpool_del(i->pool);
+    lmem_free(i);
+}
+
+/* evaluate every top level form of the text in order, as a script would.
+   The result is the last form's value or the first error, parse errors
+   included, and belongs to the caller. An empty text gives () */
+lval* lisolate_eval(lisolate* i, const char* filename, const char* s, size_t len)
+{
+    lval* forms = lload_text(filename, s, len, 1);
+    if (forms->type == LVAL_ERR)
+        return forms;
+
+    lval* x = lval_sexpr();
+    while (forms->count > 0)
+    {
+        lval_del(x);
+        x = lval_eval(i->env, lval_pop(forms, 0));
+        if (x->type == LVAL_ERR)
+            break;
+    }
+
+    lval_del(forms);
+    return x;
+}
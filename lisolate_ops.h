@@ -0,0 +1,17 @@
+#ifndef LISOLATE_OPS_H
+#define LISOLATE_OPS_H
+
+#include <stddef.h>
+#include "lisolate.h"
+#include "lval.h"
+
+
+lisolate* lisolate_new(int threads);
+
+void lisolate_del(lisolate* i);
+
+void lisolate_threads(lisolate* i, int threads);
+
+lval* lisolate_eval(lisolate* i, const char* filename, const char* s, size_t len);
+
+#endif
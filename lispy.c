@@ -0,0 +1,181 @@
+#include "lispy.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lenv_ops.h"
+#include "lsink_ops.h"
+#include "lload_ops.h"
+#include "lisolate_ops.h"
+#include <string.h>
+#include <stdatomic.h>
+
+struct lispy
+{
+    lisolate* iso;
+    lsink* out;
+};
+
+/* set once a lispy exists, the allocator would be asked to free or grow
+   memory it never handed out */
+static atomic_int lispy_made;
+
+/* for the whole process, before the first lispy is made */
+int lispy_set_allocator(const lispy_allocator* a)
+{
+    if (atomic_load(&lispy_made))
+        return 0;
+    lmem_set(a);
+    return 1;
+}
+
+/* starts from the builtins, with more than one thread large arguments are
+   evaluated side by side. Output from lispy_run goes to stdout until
+   lispy_output says otherwise */
+lispy* lispy_new(int threads)
+{
+    atomic_store(&lispy_made, 1);
+    lispy* l = lmem_malloc(sizeof(lispy));
+    l->iso = lisolate_new(threads);
+    l->out = lsink_file(stdout);
+    return l;
+}
+
+void lispy_del(lispy* l)
+{
+    lsink_del(l->out);
+    lisolate_del(l->iso);
+    lmem_free(l);
+}
+
+/* bind name to a C function, replacing whatever it was bound to. Such
+   functions are evaluated in order, never alongside other arguments */
+void lispy_register(lispy* l, const char* name, lispy_builtin func)
+{
+    lenv_add_builtin(l->iso->env, (char*)name, func);
+}
+
+/* send lispy_run output to func, it is buffered and handed over in pieces */
+void lispy_output(lispy* l, lispy_write_fn func, void* ctx)
+{
+    lsink_del(l->out);
+    l->out = lsink_func(func, ctx);
+}
+
+/* the value of the last top level form, or the first error */
+lispy_value* lispy_eval(lispy* l, const char* s)
+{
+    return lispy_eval_buffer(l, "<string>", s, strlen(s));
+}
+
+lispy_value* lispy_eval_buffer(lispy* l, const char* name, const char* buf, size_t len)
+{
+    return lisolate_eval(l->iso, name, buf, len);
+}
+
+/* evaluate every top level form and write each result on a line of its
+   own, as a script given to the interpreter would. Errors are written
+   like any other result, 1 if there were any */
+int lispy_run(lispy* l, const char* name, const char* buf, size_t len)
+{
+    lval* forms = lload_text(name, buf, len, 1);
+    int failed = 0;
+
+    if (forms->type == LVAL_ERR)
+    {
+        lval_write(l->out, forms);
+        lsink_putc(l->out, '\n');
+        lsink_flush(l->out);
+        lval_del(forms);
+        return 1;
+    }
+
+    while (forms->count > 0)
+    {
+        lval* x = lval_eval(l->iso->env, lval_pop(forms, 0));
+        failed |= x->type == LVAL_ERR;
+        lval_write(l->out, x);
+        lsink_putc(l->out, '\n');
+        lval_del(x);
+    }
+
+    lsink_flush(l->out);
+    lval_del(forms);
+    return failed;
+}
+
+int lispy_type(const lispy_value* v)
+{
+    switch (v->type)
+    {
+        case LVAL_NUM: return LISPY_NUMBER;
+        case LVAL_ERR: return LISPY_ERROR;
+        case LVAL_SYM: return LISPY_SYMBOL;
+        case LVAL_FUN: return LISPY_FUNCTION;
+        case LVAL_SEXPR: return LISPY_SEXPR;
+        case LVAL_FUT: return LISPY_FUTURE;
+    }
+    return LISPY_QEXPR;
+}
+
+long lispy_number(const lispy_value* v)
+{
+    return v->type == LVAL_NUM ? v->num : 0;
+}
+
+/* the message of an error or the name of a symbol, NULL for anything else */
+const char* lispy_text(const lispy_value* v)
+{
+    if (v->type == LVAL_ERR)
+        return v->err;
+    if (v->type == LVAL_SYM)
+        return v->sym;
+    return NULL;
+}
+
+int lispy_count(const lispy_value* v)
+{
+    return v->type == LVAL_SEXPR || v->type == LVAL_QEXPR ? v->count : 0;
+}
+
+lispy_value* lispy_item(const lispy_value* v, int i)
+{
+    return i >= 0 && i < lispy_count(v) ? v->cell[i] : NULL;
+}
+
+/* the value as it would be printed, straight into func with no string in between */
+void lispy_write(const lispy_value* v, lispy_write_fn func, void* ctx)
+{
+    lsink* s = lsink_func(func, ctx);
+    lval_write(s, (lval*)v);
+    lsink_del(s);
+}
+
+void lispy_free(lispy_value* v)
+{
+    lval_del(v);
+}
+
+lispy_value* lispy_make_number(long x)
+{
+    return lval_num(x);
+}
+
+lispy_value* lispy_make_error(const char* msg)
+{
+    return lval_err("%s", msg);
+}
+
+lispy_value* lispy_make_symbol(const char* name)
+{
+    return lval_sym((char*)name);
+}
+
+/* an empty Q-Expression to append to */
+lispy_value* lispy_make_list(void)
+{
+    return lval_qexpr();
+}
+
+lispy_value* lispy_append(lispy_value* list, lispy_value* x)
+{
+    return lval_add(list, x);
+}
@@ -0,0 +1,82 @@
+#ifndef LISPY_H
+#define LISPY_H
+
+#include <stddef.h>
+#include "lmem.h"
+
+/*
+ * The interpreter as a library. Each lispy is an interpreter of its own
+ * with nothing shared with any other, so a host can keep one per thread.
+ * A single lispy is only ever used by one thread at a time.
+ *
+ * Values handed back belong to the caller, who frees them with lispy_free.
+ * Items of a list stay owned by the list.
+ */
+
+struct lispy;
+typedef struct lispy lispy;
+
+struct lval;
+typedef struct lval lispy_value;
+
+struct lenv;
+typedef struct lenv lispy_env;
+
+enum { LISPY_NUMBER, LISPY_ERROR, LISPY_SYMBOL,
+       LISPY_FUNCTION, LISPY_SEXPR, LISPY_QEXPR, LISPY_FUTURE };
+
+/* a builtin gets its arguments as an S-Expression it owns and returns a new value */
+typedef lispy_value* (*lispy_builtin)(lispy_env* env, lispy_value* args);
+
+/* takes n bytes of output at p */
+typedef void (*lispy_write_fn)(void* ctx, const char* p, size_t n);
+
+typedef lmem lispy_allocator;
+
+
+/* the allocator is one for the whole process, not one per lispy. It can
+   only be set before the first lispy_new and returns 0 when it is too late */
+int lispy_set_allocator(const lispy_allocator* a);
+
+lispy* lispy_new(int threads);
+
+void lispy_del(lispy* l);
+
+void lispy_register(lispy* l, const char* name, lispy_builtin func);
+
+void lispy_output(lispy* l, lispy_write_fn func, void* ctx);
+
+
+lispy_value* lispy_eval(lispy* l, const char* s);
+
+lispy_value* lispy_eval_buffer(lispy* l, const char* name, const char* buf, size_t len);
+
+int lispy_run(lispy* l, const char* name, const char* buf, size_t len);
+
+
+int lispy_type(const lispy_value* v);
+
+long lispy_number(const lispy_value* v);
+
+const char* lispy_text(const lispy_value* v);
+
+int lispy_count(const lispy_value* v);
+
+lispy_value* lispy_item(const lispy_value* v, int i);
+
+void lispy_write(const lispy_value* v, lispy_write_fn func, void* ctx);
+
+void lispy_free(lispy_value* v);
+
+
+lispy_value* lispy_make_number(long x);
+
+lispy_value* lispy_make_error(const char* msg);
+
+lispy_value* lispy_make_symbol(const char* name);
+
+lispy_value* lispy_make_list(void);
+
+lispy_value* lispy_append(lispy_value* list, lispy_value* x);
+
+#endif
@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpc.h"
+
+/*
+ * Writes the Lispy grammar out as C so the interpreter does not have to
+ * build it at startup. Run it again whenever the grammar changes:
+ *
+ *     cc -std=c99 -o lispy_gen lispy_gen.c mpc.c -lm
+ *     ./lispy_gen lispy_parser.c lispy_parser.h
+ */
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <source.c> <header.h>\n", argv[0]);
+        return 1;
+    }
+
+    mpc_parser_t* Number = mpc_new("number");
+    mpc_parser_t* Symbol = mpc_new("symbol");
+    mpc_parser_t* Sexpr = mpc_new("sexpr");
+    mpc_parser_t* Qexpr = mpc_new("qexpr");
+    mpc_parser_t* Expr = mpc_new("expr");
+    mpc_parser_t* Lispy = mpc_new("lispy");
+
+    mpc_err_t* err = mpca_lang(MPCA_LANG_DEFAULT,
+            "\
+             number : /-?[0-9]+/ ; \
+             symbol: /[a-zA-Z0-9_+\\-*\\/\\\\=<>!&]+/ ; \
+             sexpr: '(' <expr>* ')';\
+             qexpr: '{' <expr>* '}';\
+             expr : <number> | <symbol> | <sexpr> | <qexpr> ; \
+             lispy : /^/ <expr>* /$/ ; \
+             ",
+             Number, Symbol, Sexpr, Qexpr, Expr, Lispy);
+
+    if (err == NULL)
+    {
+        FILE* source = fopen(argv[1], "w");
+        FILE* header = fopen(argv[2], "w");
+
+        if (source == NULL || header == NULL)
+        {
+            perror("lispy_gen");
+            return 1;
+        }
+
+        err = mpc_codegen(source, header, "lispy", 6, Number, Symbol, Sexpr, Qexpr, Expr, Lispy);
+
+        fclose(source);
+        fclose(header);
+    }
+
+    mpc_cleanup(6, Number, Symbol, Sexpr, Qexpr, Expr, Lispy);
+
+    if (err)
+    {
+        mpc_err_print(err);
+        mpc_err_delete(err);
+        return 1;
+    }
+
+    return 0;
+}
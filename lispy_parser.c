@@ -0,0 +1,910 @@
+/*
+** Generated by mpc_codegen. Do not edit.
+*/
+
+#include "mpc.h"
+
+static int lispy_rule_number(mpc_gen_t *g, mpc_val_t **x);
+static int lispy_rule_symbol(mpc_gen_t *g, mpc_val_t **x);
+static int lispy_rule_sexpr(mpc_gen_t *g, mpc_val_t **x);
+static int lispy_rule_qexpr(mpc_gen_t *g, mpc_val_t **x);
+static int lispy_rule_expr(mpc_gen_t *g, mpc_val_t **x);
+static int lispy_rule_lispy(mpc_gen_t *g, mpc_val_t **x);
+
+static const unsigned char lispy_class0[32] = {
+  1, 0, 0, 0, 0, 0, 255, 3, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const unsigned char lispy_class1[32] = {
+  1, 62, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const unsigned char lispy_class2[32] = {
+  1, 0, 0, 0, 66, 172, 255, 115, 254, 255, 255, 151, 254, 255, 255, 7,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const short lispy_dfa0[768] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, -1, -1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 2, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static const char lispy_dfa0_accept[3] = {
+  0, 0, 1
+};
+
+static const unsigned long lispy_dfa0_reports[3] = {
+  3UL, 2UL, 2UL
+};
+
+static const char *lispy_dfa0_expected[2] = {
+  "'-'",
+  "one of '0123456789'"
+};
+
+static const short lispy_dfa1[512] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, 1, -1, -1, -1, -1, 1, -1, -1, -1, 1, 1, -1, 1, -1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, 1, 1, 1, -1,
+  -1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, 1, -1, -1, 1,
+  -1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, 1, -1, -1, -1, -1, 1, -1, -1, -1, 1, 1, -1, 1, -1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, 1, 1, 1, -1,
+  -1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, 1, -1, -1, 1,
+  -1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static const char lispy_dfa1_accept[2] = {
+  0, 1
+};
+
+static const unsigned long lispy_dfa1_reports[2] = {
+  1UL, 1UL
+};
+
+static const char *lispy_dfa1_expected[1] = {
+  "one of 'abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_+-*/\\=<>!&'"
+};
+
+static int lispy_rule_number(mpc_gen_t *g, mpc_val_t **x) {
+  {
+    mpc_state_t s2 = g->state;
+    {
+      long a5, b5;
+      {
+        mpc_state_t s6 = g->state;
+        a5 = g->state.pos;
+        {
+          const unsigned char *s8 = (const unsigned char*)g->string + g->state.pos;
+          long j8 = 0, k8 = -1, n8 = g->length - g->state.pos;
+          int st8 = 0, fin8 = 0;
+          while (j8 < n8) {
+            st8 = lispy_dfa0[st8 * 256 + s8[j8]];
+            if (st8 < 0) { break; }
+            j8++;
+            if (lispy_dfa0_accept[st8]) { k8 = j8; fin8 = st8; }
+          }
+          if (k8 >= 0) {
+            g->state.pos += k8;
+            g->state.col += k8;
+            if (lispy_dfa0_reports[fin8]) { mpc_gen_report(g, lispy_dfa0_expected, lispy_dfa0_reports[fin8]); }
+            goto e8;
+          }
+          if (!mpc_gen_reaches(g, g->state.pos + j8)) { g->err = 0; goto f7; }
+          {
+            mpc_state_t s9 = g->state;
+            if (g->state.pos >= g->length || g->string[g->state.pos] != '-') { g->err = 0; goto f14; }
+            g->state.col++;
+            g->state.pos++;
+            goto e13;
+            f14:
+              mpc_gen_expect(g, "'-'");
+              goto f12;
+            e13: ;
+            goto e11;
+            f12: ;
+            if (g->err) { mpc_gen_record(g); }
+            e11: ;
+            {
+              int j16;
+              j16 = 0;
+              while (1) {
+                if (g->state.pos >= g->length || !(lispy_class0[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f19; }
+                g->state.col++;
+                g->state.pos++;
+                goto e18;
+                f19:
+                  mpc_gen_expect(g, "one of '0123456789'");
+                  goto f17;
+                e18: ;
+                j16++;
+              }
+              f17: ;
+              if (j16 == 0) {
+                if (g->err) { mpc_gen_many1(g); }
+                goto f15;
+              }
+              if (g->err) { mpc_gen_record(g); }
+            }
+            goto e9;
+            f15: ;
+            g->state = s9;
+            goto f7;
+            e9: ;
+          }
+        }
+        e8: ;
+        b5 = g->state.pos;
+        {
+          while (1) {
+            if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f30; }
+            if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+            g->state.pos++;
+            goto e29;
+            f30:
+              g->err = 0;
+              goto f28;
+            e29: ;
+            goto e27;
+            f28:
+              g->err = 0;
+              goto f26;
+            e27: ;
+          }
+          f26: ;
+        }
+        goto e6;
+        f7: ;
+        g->state = s6;
+        goto f4;
+        e6: ;
+      }
+      *x = mpc_gen_str_ast(g, a5, b5);
+    }
+    *x = mpc_gen_tag(g, *x, "regex");
+    *x = mpc_ast_token(*x, 1);
+    if (*x) { ((mpc_ast_t*)*x)->state = s2; }
+    goto e2;
+    f4: ;
+    g->state = s2;
+    goto f1;
+    e2: ;
+  }
+  *x = mpc_ast_rule(*x, 1);
+  return 1;
+  f1:
+    return 0;
+}
+
+static int lispy_rule_symbol(mpc_gen_t *g, mpc_val_t **x) {
+  {
+    mpc_state_t s32 = g->state;
+    {
+      long a35, b35;
+      {
+        mpc_state_t s36 = g->state;
+        a35 = g->state.pos;
+        {
+          const unsigned char *s38 = (const unsigned char*)g->string + g->state.pos;
+          long j38 = 0, k38 = -1, n38 = g->length - g->state.pos;
+          int st38 = 0, fin38 = 0;
+          while (j38 < n38) {
+            st38 = lispy_dfa1[st38 * 256 + s38[j38]];
+            if (st38 < 0) { break; }
+            j38++;
+            if (lispy_dfa1_accept[st38]) { k38 = j38; fin38 = st38; }
+          }
+          if (k38 >= 0) {
+            g->state.pos += k38;
+            g->state.col += k38;
+            if (lispy_dfa1_reports[fin38]) { mpc_gen_report(g, lispy_dfa1_expected, lispy_dfa1_reports[fin38]); }
+            goto e38;
+          }
+          if (!mpc_gen_reaches(g, g->state.pos + j38)) { g->err = 0; goto f37; }
+          {
+            int j39;
+            j39 = 0;
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class2[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f42; }
+              g->state.col++;
+              g->state.pos++;
+              goto e41;
+              f42:
+                mpc_gen_expect(g, "one of 'abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_+-*/\\=<>!&'");
+                goto f40;
+              e41: ;
+              j39++;
+            }
+            f40: ;
+            if (j39 == 0) {
+              if (g->err) { mpc_gen_many1(g); }
+              goto f37;
+            }
+            if (g->err) { mpc_gen_record(g); }
+          }
+        }
+        e38: ;
+        b35 = g->state.pos;
+        {
+          while (1) {
+            if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f53; }
+            if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+            g->state.pos++;
+            goto e52;
+            f53:
+              g->err = 0;
+              goto f51;
+            e52: ;
+            goto e50;
+            f51:
+              g->err = 0;
+              goto f49;
+            e50: ;
+          }
+          f49: ;
+        }
+        goto e36;
+        f37: ;
+        g->state = s36;
+        goto f34;
+        e36: ;
+      }
+      *x = mpc_gen_str_ast(g, a35, b35);
+    }
+    *x = mpc_gen_tag(g, *x, "regex");
+    *x = mpc_ast_token(*x, 1);
+    if (*x) { ((mpc_ast_t*)*x)->state = s32; }
+    goto e32;
+    f34: ;
+    g->state = s32;
+    goto f31;
+    e32: ;
+  }
+  *x = mpc_ast_rule(*x, 2);
+  return 1;
+  f31:
+    return 0;
+}
+
+static int lispy_rule_sexpr(mpc_gen_t *g, mpc_val_t **x) {
+  {
+    mpc_state_t s55 = g->state;
+    mpc_val_t *xs55[3];
+    {
+      mpc_state_t s57 = g->state;
+      {
+        long a60, b60;
+        {
+          mpc_state_t s61 = g->state;
+          a60 = g->state.pos;
+          if (g->state.pos >= g->length || g->string[g->state.pos] != '(') { g->err = 0; goto f64; }
+          g->state.col++;
+          g->state.pos++;
+          goto e63;
+          f64:
+            mpc_gen_expect(g, "'('");
+            goto f62;
+          e63: ;
+          b60 = g->state.pos;
+          {
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f75; }
+              if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+              g->state.pos++;
+              goto e74;
+              f75:
+                g->err = 0;
+                goto f73;
+              e74: ;
+              goto e72;
+              f73:
+                g->err = 0;
+                goto f71;
+              e72: ;
+            }
+            f71: ;
+          }
+          goto e61;
+          f62: ;
+          g->state = s61;
+          goto f59;
+          e61: ;
+        }
+        xs55[0] = mpc_gen_str_ast(g, a60, b60);
+      }
+      xs55[0] = mpc_gen_tag(g, xs55[0], "char");
+      xs55[0] = mpc_ast_token(xs55[0], 3);
+      if (xs55[0]) { ((mpc_ast_t*)xs55[0])->state = s57; }
+      goto e57;
+      f59: ;
+      g->state = s57;
+      goto f56;
+      e57: ;
+    }
+    {
+      int b77 = g->stack_num;
+      mpc_val_t *t77;
+      while (1) {
+        {
+          mpc_state_t s79 = g->state;
+          if (!lispy_rule_expr(g, &t77)) { goto f81; }
+          t77 = mpc_gen_add_tag(g, t77, "expr");
+          t77 = mpc_gen_add_root(g, t77);
+          if (t77) { ((mpc_ast_t*)t77)->state = s79; }
+          goto e79;
+          f81: ;
+          g->state = s79;
+          goto f78;
+          e79: ;
+        }
+        mpc_gen_push(g, t77);
+      }
+      f78: ;
+      if (g->err) { mpc_gen_record(g); }
+      xs55[1] = mpc_gen_fold_stack(g, b77);
+    }
+    {
+      mpc_state_t s83 = g->state;
+      {
+        long a86, b86;
+        {
+          mpc_state_t s87 = g->state;
+          a86 = g->state.pos;
+          if (g->state.pos >= g->length || g->string[g->state.pos] != ')') { g->err = 0; goto f90; }
+          g->state.col++;
+          g->state.pos++;
+          goto e89;
+          f90:
+            mpc_gen_expect(g, "')'");
+            goto f88;
+          e89: ;
+          b86 = g->state.pos;
+          {
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f101; }
+              if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+              g->state.pos++;
+              goto e100;
+              f101:
+                g->err = 0;
+                goto f99;
+              e100: ;
+              goto e98;
+              f99:
+                g->err = 0;
+                goto f97;
+              e98: ;
+            }
+            f97: ;
+          }
+          goto e87;
+          f88: ;
+          g->state = s87;
+          goto f85;
+          e87: ;
+        }
+        xs55[2] = mpc_gen_str_ast(g, a86, b86);
+      }
+      xs55[2] = mpc_gen_tag(g, xs55[2], "char");
+      xs55[2] = mpc_ast_token(xs55[2], 3);
+      if (xs55[2]) { ((mpc_ast_t*)xs55[2])->state = s83; }
+      goto e83;
+      f85: ;
+      g->state = s83;
+      goto f82;
+      e83: ;
+    }
+    *x = mpc_gen_fold(g, 3, xs55);
+    goto e55;
+    f82: ;
+    mpc_gen_delete(g, xs55[1]);
+    mpc_gen_delete(g, xs55[0]);
+    f56: ;
+    g->state = s55;
+    goto f54;
+    e55: ;
+  }
+  *x = mpc_ast_rule(*x, 3);
+  return 1;
+  f54:
+    return 0;
+}
+
+static int lispy_rule_qexpr(mpc_gen_t *g, mpc_val_t **x) {
+  {
+    mpc_state_t s103 = g->state;
+    mpc_val_t *xs103[3];
+    {
+      mpc_state_t s105 = g->state;
+      {
+        long a108, b108;
+        {
+          mpc_state_t s109 = g->state;
+          a108 = g->state.pos;
+          if (g->state.pos >= g->length || g->string[g->state.pos] != '{') { g->err = 0; goto f112; }
+          g->state.col++;
+          g->state.pos++;
+          goto e111;
+          f112:
+            mpc_gen_expect(g, "'{'");
+            goto f110;
+          e111: ;
+          b108 = g->state.pos;
+          {
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f123; }
+              if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+              g->state.pos++;
+              goto e122;
+              f123:
+                g->err = 0;
+                goto f121;
+              e122: ;
+              goto e120;
+              f121:
+                g->err = 0;
+                goto f119;
+              e120: ;
+            }
+            f119: ;
+          }
+          goto e109;
+          f110: ;
+          g->state = s109;
+          goto f107;
+          e109: ;
+        }
+        xs103[0] = mpc_gen_str_ast(g, a108, b108);
+      }
+      xs103[0] = mpc_gen_tag(g, xs103[0], "char");
+      xs103[0] = mpc_ast_token(xs103[0], 3);
+      if (xs103[0]) { ((mpc_ast_t*)xs103[0])->state = s105; }
+      goto e105;
+      f107: ;
+      g->state = s105;
+      goto f104;
+      e105: ;
+    }
+    {
+      int b125 = g->stack_num;
+      mpc_val_t *t125;
+      while (1) {
+        {
+          mpc_state_t s127 = g->state;
+          if (!lispy_rule_expr(g, &t125)) { goto f129; }
+          t125 = mpc_gen_add_tag(g, t125, "expr");
+          t125 = mpc_gen_add_root(g, t125);
+          if (t125) { ((mpc_ast_t*)t125)->state = s127; }
+          goto e127;
+          f129: ;
+          g->state = s127;
+          goto f126;
+          e127: ;
+        }
+        mpc_gen_push(g, t125);
+      }
+      f126: ;
+      if (g->err) { mpc_gen_record(g); }
+      xs103[1] = mpc_gen_fold_stack(g, b125);
+    }
+    {
+      mpc_state_t s131 = g->state;
+      {
+        long a134, b134;
+        {
+          mpc_state_t s135 = g->state;
+          a134 = g->state.pos;
+          if (g->state.pos >= g->length || g->string[g->state.pos] != '}') { g->err = 0; goto f138; }
+          g->state.col++;
+          g->state.pos++;
+          goto e137;
+          f138:
+            mpc_gen_expect(g, "'}'");
+            goto f136;
+          e137: ;
+          b134 = g->state.pos;
+          {
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f149; }
+              if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+              g->state.pos++;
+              goto e148;
+              f149:
+                g->err = 0;
+                goto f147;
+              e148: ;
+              goto e146;
+              f147:
+                g->err = 0;
+                goto f145;
+              e146: ;
+            }
+            f145: ;
+          }
+          goto e135;
+          f136: ;
+          g->state = s135;
+          goto f133;
+          e135: ;
+        }
+        xs103[2] = mpc_gen_str_ast(g, a134, b134);
+      }
+      xs103[2] = mpc_gen_tag(g, xs103[2], "char");
+      xs103[2] = mpc_ast_token(xs103[2], 3);
+      if (xs103[2]) { ((mpc_ast_t*)xs103[2])->state = s131; }
+      goto e131;
+      f133: ;
+      g->state = s131;
+      goto f130;
+      e131: ;
+    }
+    *x = mpc_gen_fold(g, 3, xs103);
+    goto e103;
+    f130: ;
+    mpc_gen_delete(g, xs103[1]);
+    mpc_gen_delete(g, xs103[0]);
+    f104: ;
+    g->state = s103;
+    goto f102;
+    e103: ;
+  }
+  *x = mpc_ast_rule(*x, 4);
+  return 1;
+  f102:
+    return 0;
+}
+
+static int lispy_rule_expr(mpc_gen_t *g, mpc_val_t **x) {
+  {
+    mpc_state_t s153 = g->state;
+    if (!lispy_rule_number(g, &*x)) { goto f155; }
+    *x = mpc_gen_add_tag(g, *x, "number");
+    *x = mpc_gen_add_root(g, *x);
+    if (*x) { ((mpc_ast_t*)*x)->state = s153; }
+    goto e153;
+    f155: ;
+    g->state = s153;
+    goto f152;
+    e153: ;
+  }
+  goto e151;
+  f152: ;
+  if (g->err) { mpc_gen_record(g); }
+  {
+    mpc_state_t s157 = g->state;
+    if (!lispy_rule_symbol(g, &*x)) { goto f159; }
+    *x = mpc_gen_add_tag(g, *x, "symbol");
+    *x = mpc_gen_add_root(g, *x);
+    if (*x) { ((mpc_ast_t*)*x)->state = s157; }
+    goto e157;
+    f159: ;
+    g->state = s157;
+    goto f156;
+    e157: ;
+  }
+  goto e151;
+  f156: ;
+  if (g->err) { mpc_gen_record(g); }
+  {
+    mpc_state_t s161 = g->state;
+    if (!lispy_rule_sexpr(g, &*x)) { goto f163; }
+    *x = mpc_gen_add_tag(g, *x, "sexpr");
+    *x = mpc_gen_add_root(g, *x);
+    if (*x) { ((mpc_ast_t*)*x)->state = s161; }
+    goto e161;
+    f163: ;
+    g->state = s161;
+    goto f160;
+    e161: ;
+  }
+  goto e151;
+  f160: ;
+  if (g->err) { mpc_gen_record(g); }
+  {
+    mpc_state_t s165 = g->state;
+    if (!lispy_rule_qexpr(g, &*x)) { goto f167; }
+    *x = mpc_gen_add_tag(g, *x, "qexpr");
+    *x = mpc_gen_add_root(g, *x);
+    if (*x) { ((mpc_ast_t*)*x)->state = s165; }
+    goto e165;
+    f167: ;
+    g->state = s165;
+    goto f164;
+    e165: ;
+  }
+  goto e151;
+  f164: ;
+  if (g->err) { mpc_gen_record(g); }
+  g->err = 0; goto f150;
+  e151: ;
+  *x = mpc_ast_rule(*x, 5);
+  return 1;
+  f150:
+    return 0;
+}
+
+static int lispy_rule_lispy(mpc_gen_t *g, mpc_val_t **x) {
+  {
+    mpc_state_t s169 = g->state;
+    mpc_val_t *xs169[3];
+    {
+      mpc_state_t s171 = g->state;
+      {
+        long a174, b174;
+        {
+          mpc_state_t s175 = g->state;
+          a174 = g->state.pos;
+          {
+            mpc_state_t s177 = g->state;
+            if (g->state.pos != 0) { g->err = 0; goto f182; }
+            goto e181;
+            f182:
+              g->err = 0;
+              goto f180;
+            e181: ;
+            goto e179;
+            f180:
+              mpc_gen_expect(g, "start of input");
+              goto f178;
+            e179: ;
+            goto e177;
+            f178: ;
+            g->state = s177;
+            goto f176;
+            e177: ;
+          }
+          b174 = g->state.pos;
+          {
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f194; }
+              if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+              g->state.pos++;
+              goto e193;
+              f194:
+                g->err = 0;
+                goto f192;
+              e193: ;
+              goto e191;
+              f192:
+                g->err = 0;
+                goto f190;
+              e191: ;
+            }
+            f190: ;
+          }
+          goto e175;
+          f176: ;
+          g->state = s175;
+          goto f173;
+          e175: ;
+        }
+        xs169[0] = mpc_gen_str_ast(g, a174, b174);
+      }
+      xs169[0] = mpc_gen_tag(g, xs169[0], "regex");
+      xs169[0] = mpc_ast_token(xs169[0], 1);
+      if (xs169[0]) { ((mpc_ast_t*)xs169[0])->state = s171; }
+      goto e171;
+      f173: ;
+      g->state = s171;
+      goto f170;
+      e171: ;
+    }
+    {
+      int b196 = g->stack_num;
+      mpc_val_t *t196;
+      while (1) {
+        {
+          mpc_state_t s198 = g->state;
+          if (!lispy_rule_expr(g, &t196)) { goto f200; }
+          t196 = mpc_gen_add_tag(g, t196, "expr");
+          t196 = mpc_gen_add_root(g, t196);
+          if (t196) { ((mpc_ast_t*)t196)->state = s198; }
+          goto e198;
+          f200: ;
+          g->state = s198;
+          goto f197;
+          e198: ;
+        }
+        mpc_gen_push(g, t196);
+      }
+      f197: ;
+      if (g->err) { mpc_gen_record(g); }
+      xs169[1] = mpc_gen_fold_stack(g, b196);
+    }
+    {
+      mpc_state_t s202 = g->state;
+      {
+        long a205, b205;
+        {
+          mpc_state_t s206 = g->state;
+          a205 = g->state.pos;
+          {
+            mpc_state_t s208 = g->state;
+            if (g->state.pos < g->length) { g->err = 0; goto f213; }
+            goto e212;
+            f213:
+              g->err = 0;
+              goto f211;
+            e212: ;
+            goto e210;
+            f211:
+              mpc_gen_expect(g, "end of input");
+              goto f209;
+            e210: ;
+            goto e208;
+            f209: ;
+            g->state = s208;
+            goto f207;
+            e208: ;
+          }
+          b205 = g->state.pos;
+          {
+            while (1) {
+              if (g->state.pos >= g->length || !(lispy_class1[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f225; }
+              if (g->string[g->state.pos] == '\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }
+              g->state.pos++;
+              goto e224;
+              f225:
+                g->err = 0;
+                goto f223;
+              e224: ;
+              goto e222;
+              f223:
+                g->err = 0;
+                goto f221;
+              e222: ;
+            }
+            f221: ;
+          }
+          goto e206;
+          f207: ;
+          g->state = s206;
+          goto f204;
+          e206: ;
+        }
+        xs169[2] = mpc_gen_str_ast(g, a205, b205);
+      }
+      xs169[2] = mpc_gen_tag(g, xs169[2], "regex");
+      xs169[2] = mpc_ast_token(xs169[2], 1);
+      if (xs169[2]) { ((mpc_ast_t*)xs169[2])->state = s202; }
+      goto e202;
+      f204: ;
+      g->state = s202;
+      goto f201;
+      e202: ;
+    }
+    *x = mpc_gen_fold(g, 3, xs169);
+    goto e169;
+    f201: ;
+    mpc_gen_delete(g, xs169[1]);
+    mpc_gen_delete(g, xs169[0]);
+    f170: ;
+    g->state = s169;
+    goto f168;
+    e169: ;
+  }
+  *x = mpc_ast_rule(*x, 6);
+  return 1;
+  f168:
+    return 0;
+}
+
+int lispy_parse_number(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {
+  return mpc_gen_parse(c, filename, string, lispy_rule_number, r);
+}
+
+int lispy_nparse_number(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, length, lispy_rule_number, r);
+}
+
+int lispy_parse_symbol(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {
+  return mpc_gen_parse(c, filename, string, lispy_rule_symbol, r);
+}
+
+int lispy_nparse_symbol(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, length, lispy_rule_symbol, r);
+}
+
+int lispy_parse_sexpr(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {
+  return mpc_gen_parse(c, filename, string, lispy_rule_sexpr, r);
+}
+
+int lispy_nparse_sexpr(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, length, lispy_rule_sexpr, r);
+}
+
+int lispy_parse_qexpr(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {
+  return mpc_gen_parse(c, filename, string, lispy_rule_qexpr, r);
+}
+
+int lispy_nparse_qexpr(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, length, lispy_rule_qexpr, r);
+}
+
+int lispy_parse_expr(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {
+  return mpc_gen_parse(c, filename, string, lispy_rule_expr, r);
+}
+
+int lispy_nparse_expr(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, length, lispy_rule_expr, r);
+}
+
+int lispy_parse_lispy(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {
+  return mpc_gen_parse(c, filename, string, lispy_rule_lispy, r);
+}
+
+int lispy_nparse_lispy(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, length, lispy_rule_lispy, r);
+}
+
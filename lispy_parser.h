@@ -0,0 +1,32 @@
+/*
+** Generated by mpc_codegen. Do not edit.
+*/
+
+#ifndef lispy_parser_h
+#define lispy_parser_h
+
+#include "mpc.h"
+
+enum {
+  LISPY_RULE_NUMBER = 1,
+  LISPY_RULE_SYMBOL = 2,
+  LISPY_RULE_SEXPR = 3,
+  LISPY_RULE_QEXPR = 4,
+  LISPY_RULE_EXPR = 5,
+  LISPY_RULE_LISPY = 6
+};
+
+int lispy_parse_number(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);
+int lispy_nparse_number(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);
+int lispy_parse_symbol(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);
+int lispy_nparse_symbol(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);
+int lispy_parse_sexpr(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);
+int lispy_nparse_sexpr(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);
+int lispy_parse_qexpr(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);
+int lispy_nparse_qexpr(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);
+int lispy_parse_expr(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);
+int lispy_nparse_expr(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);
+int lispy_parse_lispy(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);
+int lispy_nparse_lispy(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);
+
+#endif
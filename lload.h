@@ -0,0 +1,35 @@
+#ifndef LLOAD_H
+#define LLOAD_H
+
+#include <stddef.h>
+#include "mpc.h"
+
+struct lval;
+typedef struct lval lval;
+
+/* text files read by the builtins get this appended to their name */
+#define LLOAD_EXT ".lspy"
+
+/* text smaller than this per thread is not worth splitting further */
+#ifndef LLOAD_CHUNK_MIN
+#define LLOAD_CHUNK_MIN (1 << 20)
+#endif
+
+struct lload_chunk;
+typedef struct lload_chunk lload_chunk;
+
+/* a piece of the text cut at a top level boundary, parsed on its own
+   with the row and column it starts at */
+struct lload_chunk
+{
+    const char* filename;
+    const char* start;
+    size_t length;
+    long row;
+    long col;
+
+    lval* forms;
+    mpc_err_t* error;
+};
+
+#endif
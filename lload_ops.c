@@ -0,0 +1,197 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lload_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lbin_ops.h"
+#include "lindex_ops.h"
+#include "lispy_parser.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* cut s into at most n chunks of about the same size. A cut is only made
+   before a bracket or atom at depth 0, where no form can be split, so the
+   chunks parse to exactly the forms the whole text does. The text is
+   walked a block at a time through its structural index, so only the
+   brackets, and the starts of atoms once a cut is due, are looked at */
+static int lload_split(const char* filename, const char* s, size_t len, lload_chunk* chunks, int n)
+{
+    size_t target = len / n;
+    size_t begin = 0;
+    size_t line = 0;
+    long row = 0;
+    int depth = 0;
+    int count = 0;
+
+    chunks[0].row = 0;
+    chunks[0].col = 0;
+
+    lindex x;
+    lindex_reset(&x);
+
+    for (size_t off = 0; off < len && count + 1 < n; off += LINDEX_BLOCK)
+    {
+        if (len - off >= LINDEX_BLOCK)
+            lindex_block(&x, s + off);
+        else
+            lindex_tail(&x, s + off, len - off);
+
+        uint64_t events = x.open | x.close;
+        if (off + LINDEX_BLOCK > begin + target)
+            events |= x.start;
+
+        while (events && count + 1 < n)
+        {
+            int i = lindex_first(events);
+            uint64_t bit = (uint64_t)1 << i;
+            events &= events - 1;
+
+            size_t p = off + i;
+            if (depth == 0 && (x.start | x.open) & bit && p > begin && p - begin >= target)
+            {
+                chunks[count].start = s + begin;
+                chunks[count].length = p - begin;
+                count++;
+
+                // the row and column of the cut from the newlines before it
+                uint64_t before = x.newline & (bit - 1);
+                begin = p;
+                chunks[count].row = row + lindex_count(before);
+                chunks[count].col = (long)(p - (before ? off + lindex_last(before) + 1 : line));
+            }
+
+            if (x.open & bit)
+                depth++;
+            // a stray close stays at depth 0, the parser reports it
+            else if (x.close & bit && depth > 0)
+                depth--;
+        }
+
+        if (x.newline)
+        {
+            row += lindex_count(x.newline);
+            line = off + lindex_last(x.newline) + 1;
+        }
+    }
+
+    chunks[count].start = s + begin;
+    chunks[count].length = len - begin;
+    count++;
+
+    for (int i = 0; i < count; i++)
+    {
+        chunks[i].filename = filename;
+        chunks[i].forms = NULL;
+        chunks[i].error = NULL;
+    }
+    return count;
+}
+
+static void* lload_parse(void* arg)
+{
+    lload_chunk* c = arg;
+    mpc_context_t* ctx = mpc_context_new(MPC_CONTEXT_AST_ARENA);
+    mpc_context_origin(ctx, c->row, c->col);
+
+    mpc_result_t r;
+    if (lispy_nparse_lispy(ctx, c->filename, c->start, c->length, &r))
+        c->forms = lval_read(r.output);
+    else
+        c->error = r.error;
+
+    mpc_context_delete(ctx);
+    return NULL;
+}
+
+/* read every top level form of s into a Q-Expression, parsing pieces of it
+   on up to threads threads, 0 for one per core */
+lval* lload_text(const char* filename, const char* s, size_t len, int threads)
+{
+    // parsing stops at a terminator, so the pieces must too
+    const char* end = memchr(s, '\0', len);
+    if (end)
+        len = end - s;
+
+    if (threads <= 0)
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if ((size_t)threads > len / LLOAD_CHUNK_MIN + 1)
+        threads = (int)(len / LLOAD_CHUNK_MIN + 1);
+    if (threads < 1)
+        threads = 1;
+
+    lload_chunk* chunks = lmem_malloc(sizeof(lload_chunk) * threads);
+    pthread_t* workers = lmem_malloc(sizeof(pthread_t) * threads);
+    int* started = lmem_calloc(threads, sizeof(int));
+    int n = lload_split(filename, s, len, chunks, threads);
+
+    // the first chunk is parsed here while the rest are on their own threads
+    for (int i = 1; i < n; i++)
+        started[i] = pthread_create(&workers[i], NULL, lload_parse, &chunks[i]) == 0;
+    lload_parse(&chunks[0]);
+
+    for (int i = 1; i < n; i++)
+    {
+        if (started[i])
+            pthread_join(workers[i], NULL);
+        else
+            lload_parse(&chunks[i]);
+    }
+
+    // stitch the pieces back together in order, the first error wins
+    lval* x = NULL;
+    int count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (chunks[i].error && x == NULL)
+        {
+            char* msg = mpc_err_string(chunks[i].error);
+            msg[strcspn(msg, "\n")] = '\0';
+            x = lval_err("%s", msg);
+            free(msg);
+        }
+        if (chunks[i].forms)
+            count += chunks[i].forms->count;
+    }
+
+    if (x == NULL)
+    {
+        x = lval_sexpr();
+        x->type = LVAL_QEXPR;
+        x->cell = lmem_malloc(sizeof(lval*) * (count ? count : 1));
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        if (chunks[i].error)
+            mpc_err_delete(chunks[i].error);
+        if (chunks[i].forms == NULL)
+            continue;
+
+        if (x->type == LVAL_QEXPR && chunks[i].forms->count)
+        {
+            memcpy(x->cell + x->count, chunks[i].forms->cell, sizeof(lval*) * chunks[i].forms->count);
+            x->count += chunks[i].forms->count;
+            chunks[i].forms->count = 0;
+        }
+        lval_del(chunks[i].forms);
+    }
+
+    lmem_free(chunks);
+    lmem_free(workers);
+    lmem_free(started);
+    return x;
+}
+
+lval* lload_file(char* path, int threads)
+{
+    size_t len;
+    char* buf = lbin_map(path, &len);
+    if (buf == NULL)
+        return lval_err("Could not open file '%s'", path);
+
+    lval* x = lload_text(path, buf, len, threads);
+    lbin_unmap(buf, len);
+    return x;
+}
@@ -0,0 +1,12 @@
+#ifndef LLOAD_OPS_H
+#define LLOAD_OPS_H
+
+#include "lload.h"
+#include "lval.h"
+
+
+lval* lload_text(const char* filename, const char* s, size_t len, int threads);
+
+lval* lload_file(char* path, int threads);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef LMEM_H
+#define LMEM_H
+
+#include <stddef.h>
+
+struct lmem;
+typedef struct lmem lmem;
+
+/* where the interpreter gets its memory. Every value, environment and
+   buffer is allocated and freed through these, only memory handed over
+   by mpc or readline is freed with free directly. realloc is given NULL
+   to allocate but never a size of 0 */
+struct lmem
+{
+    void* (*malloc)(size_t n);
+    void* (*realloc)(void* p, size_t n);
+    void (*free)(void* p);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "lmem_ops.h"
+#include <stdlib.h>
+#include <string.h>
+
+static lmem lmem_current = { malloc, realloc, free };
+
+/* replace the allocator. Only before anything has been allocated and
+   before any other thread uses the interpreter, it is read without locks.
+   One that can free what the old one allocated may take over later */
+void lmem_set(const lmem* m)
+{
+    lmem_current = *m;
+}
+
+void lmem_get(lmem* m)
+{
+    *m = lmem_current;
+}
+
+void* lmem_malloc(size_t n)
+{
+    return lmem_current.malloc(n);
+}
+
+void* lmem_calloc(size_t count, size_t n)
+{
+    void* p = lmem_current.malloc(count * n);
+    if (p)
+        memset(p, 0, count * n);
+    return p;
+}
+
+/* a size of 0 frees p, whatever the allocator set would make of it */
+void* lmem_realloc(void* p, size_t n)
+{
+    if (n == 0)
+    {
+        lmem_current.free(p);
+        return NULL;
+    }
+    return lmem_current.realloc(p, n);
+}
+
+void lmem_free(void* p)
+{
+    lmem_current.free(p);
+}
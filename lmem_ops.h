@@ -0,0 +1,19 @@
+#ifndef LMEM_OPS_H
+#define LMEM_OPS_H
+
+#include "lmem.h"
+
+
+void lmem_set(const lmem* m);
+
+void lmem_get(lmem* m);
+
+void* lmem_malloc(size_t n);
+
+void* lmem_calloc(size_t count, size_t n);
+
+void* lmem_realloc(void* p, size_t n);
+
+void lmem_free(void* p);
+
+#endif
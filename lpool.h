@@ -0,0 +1,81 @@
+#ifndef LPOOL_H
+#define LPOOL_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+struct lval;
+typedef struct lval lval;
+
+struct lenv;
+typedef struct lenv lenv;
+
+struct lpool_task;
+typedef struct lpool_task lpool_task;
+
+struct lpool_deque;
+typedef struct lpool_deque lpool_deque;
+
+struct lpool;
+typedef struct lpool lpool;
+
+/* tasks a deque holds unless told otherwise, past that they are run where
+   they are made. A power of two */
+#ifndef LPOOL_DEQUE_SIZE
+#define LPOOL_DEQUE_SIZE 1024
+#endif
+_Static_assert((LPOOL_DEQUE_SIZE & (LPOOL_DEQUE_SIZE - 1)) == 0, "LPOOL_DEQUE_SIZE must be a power of two");
+
+/* nodes an s-expression needs before it is evaluated as a task of its own */
+#ifndef LPOOL_COST
+#define LPOOL_COST 256
+#endif
+
+/* how many bound names deep to look for barriers before assuming one */
+#define LPOOL_DEPTH 4
+
+/* items a list needs before map, filter and fold split it between tasks,
+   which each get at least as many */
+#ifndef LPOOL_ITEMS
+#define LPOOL_ITEMS 512
+#endif
+
+/* func applied to v in e, result is filled in before done is set */
+struct lpool_task
+{
+    lval* (*func)(lenv* e, lval* v);
+    lenv* e;
+    lval* v;
+    lval* result;
+    atomic_int done;
+};
+
+/* a Chase-Lev deque. The thread owning it pushes and pops at the bottom,
+   every other thread steals from the top */
+struct lpool_deque
+{
+    atomic_long top;
+    char pad0[64];
+    atomic_long bottom;
+    char pad1[64];
+    long size;
+    _Atomic(lpool_task*)* slots;
+    pthread_t thread;
+    lpool* pool;
+};
+
+/* deque 0 belongs to the one thread outside the pool that hands it work,
+   the others to the worker threads. Threads with nothing to do park on
+   wake, counted in sleepers so pushing a task only locks when there are */
+struct lpool
+{
+    int count;
+    lpool_deque* deques;
+    atomic_int stop;
+
+    atomic_int sleepers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+#endif
@@ -0,0 +1,266 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lpool_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include <stdlib.h>
+#include <sched.h>
+
+/* the deque of the thread running, NULL outside any pool */
+static _Thread_local lpool_deque* lpool_self = NULL;
+
+/* wake one thread parked in lpool_idle, or all of them. The fence pairs
+   with the one in lpool_idle, so either it is seen sleeping here or it
+   sees the task or result there */
+static void lpool_wake(lpool* p, int all)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&p->sleepers, memory_order_relaxed) == 0)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    if (all)
+        pthread_cond_broadcast(&p->wake);
+    else
+        pthread_cond_signal(&p->wake);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static int lpool_push(lpool_deque* d, lpool_task* t)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - top >= d->size)
+        return 0;
+
+    // thieves that see the new bottom see the task as well
+    atomic_store_explicit(&d->slots[b & (d->size - 1)], t, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+    lpool_wake(d->pool, 0);
+    return 1;
+}
+
+static lpool_task* lpool_pop(lpool_deque* d)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    lpool_task* t = NULL;
+    if (top <= b)
+    {
+        t = atomic_load_explicit(&d->slots[b & (d->size - 1)], memory_order_relaxed);
+
+        // the last task, race the thieves for it
+        if (top == b)
+        {
+            if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                        memory_order_seq_cst, memory_order_relaxed))
+                t = NULL;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    }
+    else
+    {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return t;
+}
+
+static lpool_task* lpool_steal(lpool_deque* d)
+{
+    long top = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    if (top >= b)
+        return NULL;
+
+    lpool_task* t = atomic_load_explicit(&d->slots[top & (d->size - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &top, top + 1,
+                memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return t;
+}
+
+static void lpool_run(lpool_task* t)
+{
+    t->result = t->func(t->e, t->v);
+    atomic_store_explicit(&t->done, 1, memory_order_release);
+}
+
+/* run one task from our own deque or anyone else's, 0 if there was none */
+static int lpool_work(lpool* p, lpool_deque* self, unsigned* seed)
+{
+    lpool_task* t = lpool_pop(self);
+
+    // start stealing at a different victim each time
+    for (int i = 0; t == NULL && i < p->count; i++)
+    {
+        *seed = *seed * 1103515245 + 12345;
+        lpool_deque* d = &p->deques[(*seed >> 16) % p->count];
+        if (d != self)
+            t = lpool_steal(d);
+    }
+
+    if (t == NULL)
+        return 0;
+    lpool_run(t);
+
+    // whoever spawned it may be parked waiting for it
+    lpool_wake(p, 1);
+    return 1;
+}
+
+/* whether there is anything for a thread waiting on t, or on nothing for
+   NULL, to do */
+static int lpool_ready(lpool* p, lpool_task* t)
+{
+    if (atomic_load(&p->stop) || (t && atomic_load(&t->done)))
+        return 1;
+    for (int i = 0; i < p->count; i++)
+        if (atomic_load(&p->deques[i].top) < atomic_load(&p->deques[i].bottom))
+            return 1;
+    return 0;
+}
+
+/* spin briefly, then give the core away, then park until a task is pushed,
+   one is done or the pool is stopped */
+static void lpool_idle(lpool* p, lpool_task* t, int* spins)
+{
+    if (++*spins < 64)
+        return;
+
+    if (*spins < 128)
+    {
+        sched_yield();
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    atomic_fetch_add(&p->sleepers, 1);
+    if (!lpool_ready(p, t))
+        pthread_cond_wait(&p->wake, &p->lock);
+    atomic_fetch_sub(&p->sleepers, 1);
+    pthread_mutex_unlock(&p->lock);
+    *spins = 0;
+}
+
+static void* lpool_worker(void* arg)
+{
+    lpool_deque* self = arg;
+    lpool* p = self->pool;
+    unsigned seed = (unsigned)(self - p->deques);
+    lpool_self = self;
+
+    int spins = 0;
+    while (!atomic_load_explicit(&p->stop, memory_order_acquire))
+    {
+        if (lpool_work(p, self, &seed))
+            spins = 0;
+        else
+            lpool_idle(p, NULL, &spins);
+    }
+    return NULL;
+}
+
+/* a pool of threads in all, the calling thread counts as one of them. Each
+   deque holds size tasks, rounded up to a power of two, LPOOL_DEQUE_SIZE
+   for 0 or less */
+lpool* lpool_new(int threads, int size)
+{
+    long n = 1;
+    while (n < size)
+        n *= 2;
+    if (size <= 0)
+        n = LPOOL_DEQUE_SIZE;
+
+    lpool* p = lmem_malloc(sizeof(lpool));
+    p->count = threads < 1 ? 1 : threads;
+    p->deques = lmem_malloc(sizeof(lpool_deque) * p->count);
+    atomic_init(&p->stop, 0);
+    atomic_init(&p->sleepers, 0);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->wake, NULL);
+
+    for (int i = 0; i < p->count; i++)
+    {
+        atomic_init(&p->deques[i].top, 0);
+        atomic_init(&p->deques[i].bottom, 0);
+        p->deques[i].size = n;
+        p->deques[i].slots = lmem_malloc(sizeof(lpool_task*) * n);
+        p->deques[i].pool = p;
+    }
+
+    for (int i = 1; i < p->count; i++)
+    {
+        // without a thread the deque is never stolen from, run with fewer
+        if (pthread_create(&p->deques[i].thread, NULL, lpool_worker, &p->deques[i]) != 0)
+        {
+            for (int j = i; j < p->count; j++)
+                lmem_free(p->deques[j].slots);
+            p->count = i;
+            break;
+        }
+    }
+    return p;
+}
+
+/* only once no task is waiting */
+void lpool_del(lpool* p)
+{
+    atomic_store_explicit(&p->stop, 1, memory_order_release);
+    lpool_wake(p, 1);
+    for (int i = 1; i < p->count; i++)
+        pthread_join(p->deques[i].thread, NULL);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->wake);
+    for (int i = 0; i < p->count; i++)
+        lmem_free(p->deques[i].slots);
+    lmem_free(p->deques);
+    lmem_free(p);
+}
+
+static lpool_deque* lpool_deque_of(lpool* p)
+{
+    return lpool_self && lpool_self->pool == p ? lpool_self : &p->deques[0];
+}
+
+/* start evaluating v in e, possibly on another thread, the task must stay
+   alive until lpool_wait returns */
+void lpool_spawn(lpool* p, lpool_task* t, lenv* e, lval* v)
+{
+    lpool_apply(p, t, lval_eval, e, v);
+}
+
+/* as lpool_spawn, with func in place of lval_eval. It takes v and returns
+   a new value, as lval_eval does */
+void lpool_apply(lpool* p, lpool_task* t, lval* (*func)(lenv*, lval*), lenv* e, lval* v)
+{
+    t->func = func;
+    t->e = e;
+    t->v = v;
+    t->result = NULL;
+    atomic_init(&t->done, 0);
+
+    if (!lpool_push(lpool_deque_of(p), t))
+        lpool_run(t);
+}
+
+/* the result of a spawned task, working on other tasks until it is done */
+lval* lpool_wait(lpool* p, lpool_task* t)
+{
+    lpool_deque* self = lpool_deque_of(p);
+    unsigned seed = (unsigned)(size_t)t;
+
+    int spins = 0;
+    while (!atomic_load_explicit(&t->done, memory_order_acquire))
+    {
+        if (lpool_work(p, self, &seed))
+            spins = 0;
+        else
+            lpool_idle(p, t, &spins);
+    }
+    return t->result;
+}
@@ -0,0 +1,17 @@
+#ifndef LPOOL_OPS_H
+#define LPOOL_OPS_H
+
+#include "lpool.h"
+
+
+lpool* lpool_new(int threads, int size);
+
+void lpool_del(lpool* p);
+
+void lpool_spawn(lpool* p, lpool_task* t, lenv* e, lval* v);
+
+void lpool_apply(lpool* p, lpool_task* t, lval* (*func)(lenv*, lval*), lenv* e, lval* v);
+
+lval* lpool_wait(lpool* p, lpool_task* t);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef LQUEUE_H
+#define LQUEUE_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+struct lval;
+typedef struct lval lval;
+
+struct lqueue;
+typedef struct lqueue lqueue;
+
+/* a bounded queue between exactly one producer and one consumer. head and
+   tail only ever grow, each is written by one side and sits on its own
+   cache line next to that side's last look at the other one */
+struct lqueue
+{
+    size_t size;
+    lval** slots;
+
+    char pad0[64];
+    atomic_size_t head;
+    size_t tail_seen;
+
+    char pad1[64];
+    atomic_size_t tail;
+    size_t head_seen;
+
+    char pad2[64];
+};
+
+#endif
@@ -0,0 +1,91 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lqueue_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+lqueue* lqueue_new(size_t size)
+{
+    lqueue* q = lmem_malloc(sizeof(lqueue));
+
+    // a power of two so positions wrap with a mask
+    q->size = 1;
+    while (q->size < size)
+        q->size *= 2;
+    q->slots = lmem_malloc(sizeof(lval*) * q->size);
+
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->tail_seen = 0;
+    q->head_seen = 0;
+    return q;
+}
+
+/* only once both sides are done with it */
+void lqueue_del(lqueue* q)
+{
+    size_t head = atomic_load(&q->head);
+    size_t tail = atomic_load(&q->tail);
+    for (; head != tail; head++)
+    {
+        lval* v = q->slots[head & (q->size - 1)];
+        if (v)
+            lval_del(v);
+    }
+    lmem_free(q->slots);
+    lmem_free(q);
+}
+
+/* spin briefly, then give the core away, then sleep, so a side that is
+   waiting on a slow stream does not keep a core busy */
+static void lqueue_wait(int* spins)
+{
+    if (++*spins < 64)
+        return;
+
+    if (*spins < 128)
+    {
+        sched_yield();
+        return;
+    }
+
+    struct timespec ts = { 0, 50000 };
+    nanosleep(&ts, NULL);
+}
+
+void lqueue_push(lqueue* q, lval* v)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // only look at the consumer's position again when it seemed full
+    int spins = 0;
+    while (tail - q->head_seen == q->size)
+    {
+        q->head_seen = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->head_seen == q->size)
+            lqueue_wait(&spins);
+    }
+
+    q->slots[tail & (q->size - 1)] = v;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+}
+
+lval* lqueue_pop(lqueue* q)
+{
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    int spins = 0;
+    while (head == q->tail_seen)
+    {
+        q->tail_seen = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->tail_seen)
+            lqueue_wait(&spins);
+    }
+
+    lval* v = q->slots[head & (q->size - 1)];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return v;
+}
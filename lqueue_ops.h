@@ -0,0 +1,15 @@
+#ifndef LQUEUE_OPS_H
+#define LQUEUE_OPS_H
+
+#include "lqueue.h"
+
+
+lqueue* lqueue_new(size_t size);
+
+void lqueue_del(lqueue* q);
+
+void lqueue_push(lqueue* q, lval* v);
+
+lval* lqueue_pop(lqueue* q);
+
+#endif
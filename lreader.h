@@ -0,0 +1,45 @@
+#ifndef LREADER_H
+#define LREADER_H
+
+#include <stdio.h>
+#include "mpc.h"
+
+struct lval;
+typedef struct lval lval;
+
+struct lreader;
+typedef struct lreader lreader;
+
+/* unread input is buf[start..len), scanning for the end of the next
+   top level form has got as far as scan */
+struct lreader
+{
+    FILE* file;
+    char* filename;
+    mpc_context_t* ctx;
+
+    char* buf;
+    size_t start;
+    size_t len;
+    size_t cap;
+
+    size_t scan;
+    int depth;
+    int atom;
+
+    /* where buf[start] is in the stream */
+    long row;
+    long col;
+
+    /* forms read but not handed out yet */
+    lval* forms;
+    int next;
+
+    /* a batch of forms failed to parse, they are parsed one at a time
+       from then on so the ones before the error are still read */
+    int single;
+
+    mpc_err_t* error;
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include "lreader_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lispy_parser.h"
+#include "lindex_ops.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LREADER_SIZE 65536
+
+lreader* lreader_new(FILE* f, const char* filename)
+{
+    lreader* r = lmem_malloc(sizeof(lreader));
+    r->file = f;
+    r->filename = lmem_malloc(strlen(filename) + 1);
+    strcpy(r->filename, filename);
+    r->ctx = mpc_context_new(MPC_CONTEXT_AST_ARENA);
+
+    r->cap = LREADER_SIZE;
+    r->buf = lmem_malloc(r->cap);
+    r->buf[0] = '\0';
+    r->start = 0;
+    r->len = 0;
+
+    r->scan = 0;
+    r->depth = 0;
+    r->atom = 0;
+    r->row = 0;
+    r->col = 0;
+
+    r->forms = NULL;
+    r->next = 0;
+    r->single = 0;
+    r->error = NULL;
+    return r;
+}
+
+static void lreader_drop_forms(lreader* r)
+{
+    if (r->forms == NULL)
+        return;
+
+    // the forms up to next have been handed out and belong to the caller
+    for (int i = r->next; i < r->forms->count; i++)
+        lval_del(r->forms->cell[i]);
+    r->forms->count = 0;
+    lval_del(r->forms);
+    r->forms = NULL;
+}
+
+void lreader_del(lreader* r)
+{
+    lreader_drop_forms(r);
+    if (r->error)
+        mpc_err_delete(r->error);
+    mpc_context_delete(r->ctx);
+    lmem_free(r->filename);
+    lmem_free(r->buf);
+    lmem_free(r);
+}
+
+/* find where the next form ends without parsing it. An atom ends at
+   whitespace or a bracket, a list at its closing bracket. The input is
+   looked at through its structural index, so inside a list only the
+   brackets are visited. Returns 0 if more input is needed to tell */
+static int lreader_scan(lreader* r, size_t* end)
+{
+    lindex x;
+    lindex_reset(&x);
+
+    while (r->scan < r->len)
+    {
+        size_t base = r->scan;
+        size_t n = r->len - base;
+        uint64_t valid = ~(uint64_t)0;
+
+        if (n >= LINDEX_BLOCK)
+        {
+            n = LINDEX_BLOCK;
+            lindex_block(&x, r->buf + base);
+        }
+        else
+        {
+            lindex_tail(&x, r->buf + base, n);
+            valid = ((uint64_t)1 << n) - 1;
+        }
+
+        uint64_t brackets = x.open | x.close;
+
+        while (r->scan < base + n)
+        {
+            // the bytes that matter in the current state
+            uint64_t events;
+            if (r->depth > 0)
+                events = brackets;
+            else if (r->atom)
+                events = brackets | x.space;
+            else
+                events = ~x.space;
+            events &= valid & (~(uint64_t)0 << (r->scan - base));
+
+            if (events == 0)
+            {
+                r->scan = base + n;
+                break;
+            }
+
+            int i = lindex_first(events);
+            uint64_t bit = (uint64_t)1 << i;
+            r->scan = base + i;
+
+            if (r->depth == 0 && r->atom)
+            {
+                // whitespace or a bracket ends the atom and is left for later
+                r->atom = 0;
+                *end = r->scan;
+                return 1;
+            }
+
+            if (x.open & bit)
+            {
+                r->depth++;
+            }
+            else if (x.close & bit)
+            {
+                // a stray close is a form of its own, the parser reports it
+                if (r->depth <= 1)
+                {
+                    r->depth = 0;
+                    *end = ++r->scan;
+                    return 1;
+                }
+                r->depth--;
+            }
+            else
+            {
+                r->atom = 1;
+            }
+            r->scan++;
+        }
+    }
+    return 0;
+}
+
+/* read what is available, at most a line, returns 0 at the end of input */
+static int lreader_fill(lreader* r)
+{
+    // move the unread input down before growing the buffer
+    if (r->start > 0)
+    {
+        memmove(r->buf, r->buf + r->start, r->len - r->start + 1);
+        r->len -= r->start;
+        r->scan -= r->start;
+        r->start = 0;
+    }
+
+    if (r->cap - r->len < LREADER_SIZE / 2)
+    {
+        r->cap *= 2;
+        r->buf = lmem_realloc(r->buf, r->cap);
+    }
+
+    if (fgets(r->buf + r->len, r->cap - r->len, r->file) == NULL)
+        return 0;
+
+    r->len += strlen(r->buf + r->len);
+    return 1;
+}
+
+/* parse buf[start..end) and move past it, scanning carries on from where
+   it was. Nothing is moved past if it fails */
+static int lreader_parse(lreader* r, size_t end)
+{
+    char* s = r->buf + r->start;
+
+    // cut the form out in place for the parser
+    char c = r->buf[end];
+    r->buf[end] = '\0';
+
+    mpc_result_t res;
+    mpc_context_origin(r->ctx, r->row, r->col);
+    int ok = lispy_parse_lispy(r->ctx, r->filename, s, &res);
+    if (ok)
+    {
+        r->forms = lval_read(res.output);
+        r->next = 0;
+    }
+    else
+    {
+        r->error = res.error;
+    }
+
+    r->buf[end] = c;
+    if (!ok)
+        return 0;
+
+    for (; r->start < end; r->start++)
+    {
+        if (r->buf[r->start] == '\n') { r->row++; r->col = 0; }
+        else { r->col++; }
+    }
+    return 1;
+}
+
+/* the next top level form, or NULL once the input is used up or cannot
+   be parsed, in which case error is set */
+lval* lreader_next(lreader* r)
+{
+    while (r->forms == NULL || r->next == r->forms->count)
+    {
+        lreader_drop_forms(r);
+        if (r->error)
+            return NULL;
+
+        size_t end;
+        while (!lreader_scan(r, &end))
+        {
+            if (!lreader_fill(r))
+            {
+                // whatever is left is the last form, if it is anything
+                end = r->scan = r->len;
+                r->depth = 0;
+                r->atom = 0;
+                break;
+            }
+        }
+
+        // parse every other form that has already arrived along with it
+        size_t first = end;
+        size_t more;
+        while (!r->single && lreader_scan(r, &more))
+            end = more;
+
+        if (end == r->start)
+            return NULL;
+        if (lreader_parse(r, end))
+            continue;
+        if (end == first)
+            return NULL;
+
+        // scan again from the end of the first form, which left no list or
+        // atom open, and find out which of them is broken
+        mpc_err_delete(r->error);
+        r->error = NULL;
+        r->single = 1;
+        r->scan = first;
+        r->depth = 0;
+        r->atom = 0;
+        if (!lreader_parse(r, first))
+            return NULL;
+    }
+
+    return r->forms->cell[r->next++];
+}
@@ -0,0 +1,14 @@
+#ifndef LREADER_OPS_H
+#define LREADER_OPS_H
+
+#include "lreader.h"
+#include "lval.h"
+
+
+lreader* lreader_new(FILE* f, const char* filename);
+
+void lreader_del(lreader* r);
+
+lval* lreader_next(lreader* r);
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef LSERVER_H
+#define LSERVER_H
+
+#include <stddef.h>
+#include <signal.h>
+#include <pthread.h>
+
+struct lsink;
+typedef struct lsink lsink;
+
+struct lisolate;
+typedef struct lisolate lisolate;
+
+struct lserver_job;
+typedef struct lserver_job lserver_job;
+
+struct lserver_worker;
+typedef struct lserver_worker lserver_worker;
+
+struct lserver_conn;
+typedef struct lserver_conn lserver_conn;
+
+struct lserver;
+typedef struct lserver lserver;
+
+/*
+ * Requests and replies are framed the same way, a 4 byte big endian length
+ * and then that many bytes of text. A request holds top level forms, its
+ * reply the value of the last one, or the first error, as it would be
+ * printed. A client may send any number of requests before reading
+ * replies, they come back in the order the requests were sent.
+ */
+
+/* connections sending a longer frame than this are closed */
+#define LSERVER_FRAME_MAX (16 << 20)
+
+/* bytes read from a connection before its frames are handed on and the
+   other connections get a turn, the rest is read on the next event */
+#define LSERVER_READ (256 << 10)
+
+/* events taken from epoll at a time */
+#define LSERVER_EVENTS 64
+
+/* one request on its way to a worker and its reply on the way back. fd and
+   gen name the connection, a reply for one that has since closed is dropped */
+struct lserver_job
+{
+    lserver_job* next;
+    int fd;
+    unsigned gen;
+
+    char* text;
+    size_t len;
+
+    char* reply;
+    size_t reply_len;
+};
+
+/* a thread with an interpreter of its own, taking jobs off its list */
+struct lserver_worker
+{
+    pthread_t thread;
+    lserver* server;
+    lisolate* iso;
+
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    lserver_job* head;
+    lserver_job* tail;
+    int stop;
+};
+
+/* every request on a connection goes to the same worker, so they are
+   evaluated in order and see each other's definitions. Once the client
+   is done sending it is closed as soon as every reply is written */
+struct lserver_conn
+{
+    int open;
+    unsigned gen;
+    int worker;
+    int pending;
+    int eof;
+    unsigned events;
+
+    char* in;
+    size_t in_len;
+    size_t in_cap;
+
+    lsink* out;
+    size_t out_sent;
+};
+
+/* one thread waits on epoll for connections, requests and finished jobs,
+   the workers only ever evaluate. SIGINT and SIGTERM are blocked for as
+   long as the server exists and taken through signal_fd instead.
+   Connections are either accepted on listen_fd or, in a process forked
+   from a master, received over channel_fd, the other one is -1 */
+struct lserver
+{
+    char* path;
+    int listen_fd;
+    int channel_fd;
+    int epoll_fd;
+    int event_fd;
+    int signal_fd;
+    sigset_t old_mask;
+
+    int count;
+    lserver_worker* workers;
+    int next_worker;
+
+    pthread_mutex_t done_lock;
+    lserver_job* done_head;
+    lserver_job* done_tail;
+
+    lserver_conn* conns;
+    int conns_cap;
+    unsigned gen;
+};
+
+#endif
@@ -0,0 +1,242 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Load generator for parsing -S. Each connection is a thread of its own
+ * that keeps depth requests in flight until it has had count replies,
+ * then the request rate and latencies over all of them are reported:
+ *
+ *     cc -std=c11 -o lserver_client lserver_client.c -lpthread
+ *     ./lserver_client -c 8 -n 10000 -d 16 /tmp/lispy.sock "(+ 1 2)"
+ */
+
+typedef struct
+{
+    const char* path;
+    const char* expr;
+    int count;
+    int depth;
+
+    double* latency;
+    char* reply;
+    int failed;
+} client_job;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int write_all(int fd, const char* p, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t k = write(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p += k;
+        n -= k;
+    }
+    return 1;
+}
+
+static int read_all(int fd, char* p, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t k = read(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return 0;
+        p += k;
+        n -= k;
+    }
+    return 1;
+}
+
+static int connect_to(const char* path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static void* run_client(void* arg)
+{
+    client_job* job = arg;
+    int fd = connect_to(job->path);
+    if (fd < 0)
+    {
+        perror(job->path);
+        job->failed = 1;
+        return NULL;
+    }
+
+    // every request is the same frame
+    size_t len = strlen(job->expr);
+    char* frame = malloc(len + 4);
+    frame[0] = (char)(len >> 24);
+    frame[1] = (char)(len >> 16);
+    frame[2] = (char)(len >> 8);
+    frame[3] = (char)len;
+    memcpy(frame + 4, job->expr, len);
+
+    // when each request in flight was sent, replies come back in order
+    double* sent = malloc(sizeof(double) * job->count);
+    int requested = 0;
+    int replied = 0;
+    char* buf = NULL;
+
+    while (replied < job->count)
+    {
+        while (requested < job->count && requested - replied < job->depth)
+        {
+            sent[requested++] = now();
+            if (!write_all(fd, frame, len + 4))
+            {
+                job->failed = 1;
+                goto done;
+            }
+        }
+
+        unsigned char head[4];
+        if (!read_all(fd, (char*)head, 4))
+        {
+            job->failed = 1;
+            goto done;
+        }
+        uint32_t n = (uint32_t)head[0] << 24 | (uint32_t)head[1] << 16 | (uint32_t)head[2] << 8 | head[3];
+        buf = realloc(buf, n + 1);
+        if (!read_all(fd, buf, n))
+        {
+            job->failed = 1;
+            goto done;
+        }
+        buf[n] = '\0';
+
+        job->latency[replied] = now() - sent[replied];
+        replied++;
+    }
+
+    job->reply = buf;
+    buf = NULL;
+
+done:
+    free(buf);
+    free(sent);
+    free(frame);
+    close(fd);
+    return NULL;
+}
+
+static int by_value(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [-c connections] [-n requests] [-d depth] socket [expression]\n"
+            "  -c n  connections, each on a thread of its own, 1 by default\n"
+            "  -n n  requests per connection, 10000 by default\n"
+            "  -d n  requests in flight per connection, 1 by default\n",
+            prog);
+}
+
+int main(int argc, char** argv)
+{
+    int conns = 1;
+    int count = 10000;
+    int depth = 1;
+
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) conns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) depth = atoi(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (i == argc || conns < 1 || count < 1 || depth < 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[i];
+    const char* expr = i + 1 < argc ? argv[i + 1] : "(+ 1 2)";
+
+    client_job* jobs = calloc(conns, sizeof(client_job));
+    pthread_t* threads = malloc(sizeof(pthread_t) * conns);
+    double* latency = malloc(sizeof(double) * conns * count);
+
+    double start = now();
+    for (int k = 0; k < conns; k++)
+    {
+        jobs[k].path = path;
+        jobs[k].expr = expr;
+        jobs[k].count = count;
+        jobs[k].depth = depth;
+        jobs[k].latency = latency + (size_t)k * count;
+        pthread_create(&threads[k], NULL, run_client, &jobs[k]);
+    }
+
+    int failed = 0;
+    for (int k = 0; k < conns; k++)
+    {
+        pthread_join(threads[k], NULL);
+        failed |= jobs[k].failed;
+    }
+    double elapsed = now() - start;
+
+    if (!failed)
+    {
+        size_t total = (size_t)conns * count;
+        qsort(latency, total, sizeof(double), by_value);
+
+        printf("reply     %s\n", jobs[0].reply);
+        printf("requests  %zu in %.3f s\n", total, elapsed);
+        printf("rate      %.0f requests/s\n", total / elapsed);
+        printf("p50       %.1f us\n", latency[total / 2] * 1e6);
+        printf("p99       %.1f us\n", latency[total * 99 / 100] * 1e6);
+    }
+
+    for (int k = 0; k < conns; k++)
+        free(jobs[k].reply);
+    free(jobs);
+    free(threads);
+    free(latency);
+    return failed;
+}
@@ -0,0 +1,685 @@
+#define _GNU_SOURCE
+
+#include "lserver_ops.h"
+#include "lmem_ops.h"
+#include "lval_ops.h"
+#include "lsink_ops.h"
+#include "lbin_ops.h"
+#include "lisolate_ops.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static void lserver_put32(char* p, uint32_t n)
+{
+    p[0] = (char)(n >> 24);
+    p[1] = (char)(n >> 16);
+    p[2] = (char)(n >> 8);
+    p[3] = (char)n;
+}
+
+static uint32_t lserver_get32(const char* p)
+{
+    const unsigned char* u = (const unsigned char*)p;
+    return (uint32_t)u[0] << 24 | (uint32_t)u[1] << 16 | (uint32_t)u[2] << 8 | u[3];
+}
+
+/* hand a finished job back, waking the epoll thread only if it has not
+   been woken already for jobs it has yet to collect */
+static void lserver_done(lserver* s, lserver_job* job)
+{
+    job->next = NULL;
+
+    pthread_mutex_lock(&s->done_lock);
+    int wake = s->done_head == NULL;
+    if (s->done_tail)
+        s->done_tail->next = job;
+    else
+        s->done_head = job;
+    s->done_tail = job;
+    pthread_mutex_unlock(&s->done_lock);
+
+    if (wake)
+    {
+        uint64_t one = 1;
+        while (write(s->event_fd, &one, sizeof(one)) < 0 && errno == EINTR);
+    }
+}
+
+static void lserver_eval(lserver_worker* w, lserver_job* job)
+{
+    lval* x = lisolate_eval(w->iso, "<request>", job->text, job->len);
+
+    // room for the length first, filled in once the value is written
+    lsink* out = lsink_string();
+    lsink_write(out, "\0\0\0\0", 4);
+    lval_write(out, x);
+    lserver_put32(out->buf, (uint32_t)(out->len - 4));
+
+    job->reply_len = out->len;
+    job->reply = lsink_take(out);
+    lsink_del(out);
+    lval_del(x);
+
+    lmem_free(job->text);
+    job->text = NULL;
+}
+
+static void* lserver_work(void* arg)
+{
+    lserver_worker* w = arg;
+
+    while (1)
+    {
+        // take every job waiting at once
+        pthread_mutex_lock(&w->lock);
+        while (w->head == NULL && !w->stop)
+            pthread_cond_wait(&w->ready, &w->lock);
+        lserver_job* job = w->head;
+        w->head = w->tail = NULL;
+        pthread_mutex_unlock(&w->lock);
+
+        // stopping only once nothing is left to do
+        if (job == NULL)
+            break;
+
+        while (job)
+        {
+            lserver_job* next = job->next;
+            lserver_eval(w, job);
+            lserver_done(w->server, job);
+            job = next;
+        }
+    }
+    return NULL;
+}
+
+static void lserver_send(lserver_worker* w, lserver_job* head, lserver_job* tail)
+{
+    pthread_mutex_lock(&w->lock);
+    if (w->tail)
+        w->tail->next = head;
+    else
+        w->head = head;
+    w->tail = tail;
+    pthread_cond_signal(&w->ready);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static int lserver_watch(lserver* s, int op, int fd, uint32_t events)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(s->epoll_fd, op, fd, &ev);
+}
+
+/* everything but the interpreters, which are left to the caller */
+static lserver* lserver_make(const char* path, int listen_fd, int channel_fd, int workers)
+{
+    lserver* s = lmem_malloc(sizeof(lserver));
+    s->path = NULL;
+    if (path)
+    {
+        s->path = lmem_malloc(strlen(path) + 1);
+        strcpy(s->path, path);
+    }
+    s->listen_fd = listen_fd;
+    s->channel_fd = channel_fd;
+    s->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    s->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // before any thread is started, they all inherit the mask
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, &s->old_mask);
+    s->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    s->count = workers < 1 ? 1 : workers;
+    s->workers = lmem_malloc(sizeof(lserver_worker) * s->count);
+    s->next_worker = 0;
+    for (int i = 0; i < s->count; i++)
+    {
+        lserver_worker* w = &s->workers[i];
+        w->server = s;
+        w->iso = NULL;
+        pthread_mutex_init(&w->lock, NULL);
+        pthread_cond_init(&w->ready, NULL);
+        w->head = w->tail = NULL;
+        w->stop = 0;
+    }
+
+    pthread_mutex_init(&s->done_lock, NULL);
+    s->done_head = s->done_tail = NULL;
+
+    s->conns = NULL;
+    s->conns_cap = 0;
+    s->gen = 0;
+
+    lserver_watch(s, EPOLL_CTL_ADD, listen_fd >= 0 ? listen_fd : channel_fd, EPOLLIN);
+    lserver_watch(s, EPOLL_CTL_ADD, s->event_fd, EPOLLIN);
+    lserver_watch(s, EPOLL_CTL_ADD, s->signal_fd, EPOLLIN);
+    return s;
+}
+
+/* a socket listening on path, -1 if it could not be set up with the
+   reason in errno. One left behind by an earlier server is replaced */
+int lserver_listen(const char* path)
+{
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+/* a server listening on path with workers threads evaluating, 0 for one
+   per core, each with threads threads of its own for large arguments.
+   NULL if the socket could not be set up, the reason is in errno */
+lserver* lserver_new(const char* path, int workers, int threads)
+{
+    int fd = lserver_listen(path);
+    if (fd < 0)
+        return NULL;
+
+    if (workers <= 0)
+        workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    lserver* s = lserver_make(path, fd, -1, workers);
+    for (int i = 0; i < s->count; i++)
+        s->workers[i].iso = lisolate_new(threads);
+    return s;
+}
+
+/* a server in a process forked from a master, taking connections the
+   master sends over channel and evaluating them with iso on one worker */
+lserver* lserver_channel(int channel, lisolate* iso)
+{
+    lserver* s = lserver_make(NULL, -1, channel, 1);
+    s->workers[0].iso = iso;
+    return s;
+}
+
+static void lserver_close(lserver* s, int fd)
+{
+    lserver_conn* c = &s->conns[fd];
+    epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+    lmem_free(c->in);
+    lsink_del(c->out);
+    c->open = 0;
+}
+
+/* only after lserver_run has returned, or if it was never called */
+void lserver_del(lserver* s)
+{
+    for (int i = 0; i < s->conns_cap; i++)
+        if (s->conns[i].open)
+            lserver_close(s, i);
+    lmem_free(s->conns);
+
+    for (int i = 0; i < s->count; i++)
+    {
+        lisolate_del(s->workers[i].iso);
+        pthread_mutex_destroy(&s->workers[i].lock);
+        pthread_cond_destroy(&s->workers[i].ready);
+    }
+    lmem_free(s->workers);
+
+    pthread_mutex_destroy(&s->done_lock);
+    close(s->event_fd);
+    close(s->signal_fd);
+    close(s->epoll_fd);
+    pthread_sigmask(SIG_SETMASK, &s->old_mask, NULL);
+    if (s->listen_fd >= 0)
+    {
+        close(s->listen_fd);
+        unlink(s->path);
+    }
+    if (s->channel_fd >= 0)
+        close(s->channel_fd);
+    lmem_free(s->path);
+    lmem_free(s);
+}
+
+/* run a script in every worker before any request arrives. The result of
+   its last form, the same in each of them */
+lval* lserver_prelude(lserver* s, const char* filename)
+{
+    size_t len;
+    char* buf = lbin_map((char*)filename, &len);
+    if (buf == NULL)
+        return lval_err("Could not open file '%s'", filename);
+
+    lval* x = NULL;
+    for (int i = 0; i < s->count; i++)
+    {
+        lval* y = lisolate_eval(s->workers[i].iso, filename, buf, len);
+        if (x == NULL)
+            x = y;
+        else
+            lval_del(y);
+    }
+
+    lbin_unmap(buf, len);
+    return x;
+}
+
+/* start reading requests from a connection, handing it to the next worker */
+static void lserver_open(lserver* s, int fd)
+{
+    if (fd >= s->conns_cap)
+    {
+        int cap = s->conns_cap ? s->conns_cap : 64;
+        while (cap <= fd)
+            cap *= 2;
+        s->conns = lmem_realloc(s->conns, sizeof(lserver_conn) * cap);
+        memset(s->conns + s->conns_cap, 0, sizeof(lserver_conn) * (cap - s->conns_cap));
+        s->conns_cap = cap;
+    }
+
+    lserver_conn* c = &s->conns[fd];
+    c->open = 1;
+    c->gen = ++s->gen;
+    c->worker = s->next_worker;
+    s->next_worker = (s->next_worker + 1) % s->count;
+    c->in_cap = 4096;
+    c->in = lmem_malloc(c->in_cap);
+    c->in_len = 0;
+    c->out = lsink_string();
+    c->out_sent = 0;
+    c->pending = 0;
+    c->eof = 0;
+    c->events = EPOLLIN;
+
+    lserver_watch(s, EPOLL_CTL_ADD, fd, EPOLLIN);
+}
+
+static void lserver_accept(lserver* s)
+{
+    while (1)
+    {
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return;
+        }
+        lserver_open(s, fd);
+    }
+}
+
+/* take the connections the master has sent, each a message of its own
+   carrying one descriptor. 0 once the master has gone */
+static int lserver_receive(lserver* s)
+{
+    while (1)
+    {
+        char byte;
+        struct iovec iov = { &byte, 1 };
+        union
+        {
+            struct cmsghdr h;
+            char buf[CMSG_SPACE(sizeof(int))];
+        } control;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        ssize_t n = recvmsg(s->channel_fd, &msg, MSG_CMSG_CLOEXEC);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 1;
+        if (n <= 0)
+            return 0;
+
+        struct cmsghdr* h = CMSG_FIRSTHDR(&msg);
+        if (h && h->cmsg_level == SOL_SOCKET && h->cmsg_type == SCM_RIGHTS)
+        {
+            int fd;
+            memcpy(&fd, CMSG_DATA(h), sizeof(int));
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            lserver_open(s, fd);
+        }
+    }
+}
+
+/* watch for requests until the client is done sending and for room to
+   write while replies are waiting, closing once there is nothing left */
+static void lserver_update(lserver* s, int fd)
+{
+    lserver_conn* c = &s->conns[fd];
+    if (c->eof && c->pending == 0 && c->out->len == 0)
+    {
+        lserver_close(s, fd);
+        return;
+    }
+
+    unsigned events = (c->eof ? 0 : EPOLLIN) | (c->out->len > 0 ? EPOLLOUT : 0);
+    if (events != c->events)
+    {
+        lserver_watch(s, EPOLL_CTL_MOD, fd, events);
+        c->events = events;
+    }
+}
+
+/* write out as much of the replies waiting as the socket takes */
+static void lserver_flush(lserver* s, int fd)
+{
+    lserver_conn* c = &s->conns[fd];
+    while (c->out_sent < c->out->len)
+    {
+        ssize_t n = send(fd, c->out->buf + c->out_sent, c->out->len - c->out_sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            lserver_close(s, fd);
+            return;
+        }
+        c->out_sent += n;
+    }
+
+    if (c->out_sent == c->out->len)
+    {
+        c->out->len = 0;
+        c->out_sent = 0;
+    }
+
+    lserver_update(s, fd);
+}
+
+/* read what has arrived, up to LSERVER_READ, and send every complete
+   request on to the connection's worker in one go. What is held back is
+   then at most one frame short of its end and one read */
+static void lserver_read(lserver* s, int fd)
+{
+    lserver_conn* c = &s->conns[fd];
+
+    size_t budget = LSERVER_READ;
+    while (budget > 0)
+    {
+        if (c->in_len == c->in_cap)
+        {
+            c->in_cap *= 2;
+            c->in = lmem_realloc(c->in, c->in_cap);
+        }
+
+        size_t room = c->in_cap - c->in_len;
+        ssize_t n = read(fd, c->in + c->in_len, room < budget ? room : budget);
+        if (n > 0)
+        {
+            c->in_len += n;
+            budget -= n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        // failed, replies still on their way are dropped
+        if (n < 0)
+        {
+            lserver_close(s, fd);
+            return;
+        }
+
+        // the client is done sending but may still be reading
+        c->eof = 1;
+        break;
+    }
+
+    lserver_job* head = NULL;
+    lserver_job* tail = NULL;
+    size_t at = 0;
+    int bad = 0;
+
+    while (c->in_len - at >= 4)
+    {
+        uint32_t len = lserver_get32(c->in + at);
+        if (len > LSERVER_FRAME_MAX)
+        {
+            bad = 1;
+            break;
+        }
+        if (c->in_len - at - 4 < len)
+            break;
+
+        lserver_job* job = lmem_malloc(sizeof(lserver_job));
+        job->next = NULL;
+        job->fd = fd;
+        job->gen = c->gen;
+        job->text = lmem_malloc(len + 1);
+        memcpy(job->text, c->in + at + 4, len);
+        job->text[len] = '\0';
+        job->len = len;
+        job->reply = NULL;
+        job->reply_len = 0;
+
+        if (tail)
+            tail->next = job;
+        else
+            head = job;
+        tail = job;
+        c->pending++;
+        at += 4 + len;
+    }
+
+    memmove(c->in, c->in + at, c->in_len - at);
+    c->in_len -= at;
+
+    if (head)
+        lserver_send(&s->workers[c->worker], head, tail);
+
+    // a request cut short by the end of input never gets a reply
+    if (bad)
+        lserver_close(s, fd);
+    else
+        lserver_update(s, fd);
+}
+
+/* take every finished job, queue the replies on their connections and
+   then write each connection out once */
+static void lserver_collect(lserver* s)
+{
+    uint64_t count;
+    while (read(s->event_fd, &count, sizeof(count)) < 0 && errno == EINTR);
+
+    pthread_mutex_lock(&s->done_lock);
+    lserver_job* jobs = s->done_head;
+    s->done_head = s->done_tail = NULL;
+    pthread_mutex_unlock(&s->done_lock);
+
+    for (lserver_job* job = jobs; job; job = job->next)
+    {
+        lserver_conn* c = &s->conns[job->fd];
+        if (c->open && c->gen == job->gen)
+        {
+            lsink_write(c->out, job->reply, job->reply_len);
+            c->pending--;
+        }
+    }
+
+    // a connection already waiting for room is written when there is some
+    for (lserver_job* job = jobs; job; job = job->next)
+    {
+        lserver_conn* c = &s->conns[job->fd];
+        if (c->open && c->gen == job->gen && !(c->events & EPOLLOUT))
+            lserver_flush(s, job->fd);
+    }
+
+    while (jobs)
+    {
+        lserver_job* next = jobs->next;
+        lmem_free(jobs->reply);
+        lmem_free(jobs);
+        jobs = next;
+    }
+}
+
+static void lserver_stop(lserver* s)
+{
+    for (int i = 0; i < s->count; i++)
+    {
+        pthread_mutex_lock(&s->workers[i].lock);
+        s->workers[i].stop = 1;
+        pthread_cond_signal(&s->workers[i].ready);
+        pthread_mutex_unlock(&s->workers[i].lock);
+    }
+}
+
+/* serve until SIGINT or SIGTERM, then let the workers finish what they
+   have and return. 1 if the server could not be started */
+int lserver_run(lserver* s)
+{
+    // the files given have run, requests come from anyone who can reach
+    // the socket. Left alone once cleared, it may be on a shared page
+    for (int i = 0; i < s->count; i++)
+        if (s->workers[i].iso->env->files)
+            s->workers[i].iso->env->files = 0;
+
+    int started = 0;
+    for (; started < s->count; started++)
+        if (pthread_create(&s->workers[started].thread, NULL, lserver_work, &s->workers[started]) != 0)
+            break;
+
+    int failed = started < s->count;
+    struct epoll_event events[LSERVER_EVENTS];
+
+    while (!failed)
+    {
+        int n = epoll_wait(s->epoll_fd, events, LSERVER_EVENTS, -1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+
+        int stop = 0;
+        for (int i = 0; i < n; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == s->listen_fd)
+                lserver_accept(s);
+            else if (fd == s->channel_fd)
+                stop |= !lserver_receive(s);
+            else if (fd == s->event_fd)
+                lserver_collect(s);
+            else if (fd == s->signal_fd)
+            {
+                // taken off so it is not delivered once unblocked again
+                struct signalfd_siginfo info;
+                while (read(s->signal_fd, &info, sizeof(info)) < 0 && errno == EINTR);
+                stop = 1;
+            }
+            else
+            {
+                // the connection may have been closed by an earlier event
+                if (!s->conns[fd].open)
+                    continue;
+
+                /* gone both ways, so nothing can be written back and the hang
+                   up would be reported again on every wait. Replies still
+                   on their way are dropped as theirs is an older gen */
+                if (events[i].events & (EPOLLHUP | EPOLLERR))
+                {
+                    lserver_close(s, fd);
+                    continue;
+                }
+
+                if (events[i].events & EPOLLIN)
+                    lserver_read(s, fd);
+                if (s->conns[fd].open && (events[i].events & EPOLLOUT))
+                    lserver_flush(s, fd);
+            }
+        }
+        if (stop)
+            break;
+    }
+
+    lserver_stop(s);
+    for (int i = 0; i < started; i++)
+        pthread_join(s->workers[i].thread, NULL);
+
+    // replies nobody is left to wait for
+    lserver_collect(s);
+    return failed;
+}
+
+#else
+
+int lserver_listen(const char* path)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+lserver* lserver_new(const char* path, int workers, int threads)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+
+lserver* lserver_channel(int channel, lisolate* iso)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+
+void lserver_del(lserver* s)
+{
+}
+
+lval* lserver_prelude(lserver* s, const char* filename)
+{
+    return lval_err("The server needs Linux");
+}
+
+int lserver_run(lserver* s)
+{
+    return 1;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef LSERVER_OPS_H
+#define LSERVER_OPS_H
+
+#include "lserver.h"
+#include "lval.h"
+#include "lisolate.h"
+
+
+int lserver_listen(const char* path);
+
+lserver* lserver_new(const char* path, int workers, int threads);
+
+lserver* lserver_channel(int channel, lisolate* iso);
+
+void lserver_del(lserver* s);
+
+lval* lserver_prelude(lserver* s, const char* filename);
+
+int lserver_run(lserver* s);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef LSINK_H
+#define LSINK_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+struct lsink;
+typedef struct lsink lsink;
+
+/* takes n bytes of output at p, whatever ctx was given with it */
+typedef void (*lsink_fn)(void* ctx, const char* p, size_t n);
+
+/* output is collected in buf and either flushed to file or handed to func
+   when it fills up, or, when there is neither, grown so the whole output
+   stays in memory */
+struct lsink
+{
+    FILE* file;
+    lsink_fn func;
+    void* ctx;
+
+    char* buf;
+    size_t len;
+    size_t cap;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "lsink_ops.h"
+#include "lmem_ops.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* file sinks are flushed whenever this much output is waiting */
+#define LSINK_FILE_SIZE 65536
+#define LSINK_STRING_SIZE 256
+
+lsink* lsink_file(FILE* f)
+{
+    lsink* s = lmem_malloc(sizeof(lsink));
+    s->file = f;
+    s->func = NULL;
+    s->ctx = NULL;
+    s->cap = LSINK_FILE_SIZE;
+    s->buf = lmem_malloc(s->cap);
+    s->len = 0;
+    return s;
+}
+
+/* buffered like a file, but flushed by calling func */
+lsink* lsink_func(lsink_fn func, void* ctx)
+{
+    lsink* s = lmem_malloc(sizeof(lsink));
+    s->file = NULL;
+    s->func = func;
+    s->ctx = ctx;
+    s->cap = LSINK_FILE_SIZE;
+    s->buf = lmem_malloc(s->cap);
+    s->len = 0;
+    return s;
+}
+
+lsink* lsink_string(void)
+{
+    lsink* s = lmem_malloc(sizeof(lsink));
+    s->file = NULL;
+    s->func = NULL;
+    s->ctx = NULL;
+    s->cap = LSINK_STRING_SIZE;
+    s->buf = lmem_malloc(s->cap);
+    s->len = 0;
+    return s;
+}
+
+void lsink_del(lsink* s)
+{
+    lsink_flush(s);
+    lmem_free(s->buf);
+    lmem_free(s);
+}
+
+/* pass n bytes on to wherever the sink drains to */
+static void lsink_drain(lsink* s, const char* p, size_t n)
+{
+    if (s->file)
+        fwrite(p, 1, n, s->file);
+    else
+        s->func(s->ctx, p, n);
+}
+
+void lsink_flush(lsink* s)
+{
+    if ((s->file == NULL && s->func == NULL) || s->len == 0)
+        return;
+
+    lsink_drain(s, s->buf, s->len);
+    if (s->file)
+        fflush(s->file);
+    s->len = 0;
+}
+
+/* hand back everything written so far as a string the caller frees with lmem_free,
+   the sink starts out empty again */
+char* lsink_take(lsink* s)
+{
+    char* str = lmem_malloc(s->len + 1);
+    memcpy(str, s->buf, s->len);
+    str[s->len] = '\0';
+    s->len = 0;
+    return str;
+}
+
+/* make room for n more bytes, only called when they do not fit already */
+static void lsink_grow(lsink* s, size_t n)
+{
+    if (s->file || s->func)
+    {
+        lsink_drain(s, s->buf, s->len);
+        s->len = 0;
+        return;
+    }
+
+    while (s->cap - s->len < n)
+        s->cap *= 2;
+    s->buf = lmem_realloc(s->buf, s->cap);
+}
+
+void lsink_write(lsink* s, const char* p, size_t n)
+{
+    if (s->cap - s->len < n)
+    {
+        lsink_grow(s, n);
+
+        // too big to be worth copying into the file buffer
+        if (s->cap < n)
+        {
+            lsink_drain(s, p, n);
+            return;
+        }
+    }
+
+    memcpy(s->buf + s->len, p, n);
+    s->len += n;
+}
+
+void lsink_putc(lsink* s, char c)
+{
+    if (s->len == s->cap)
+        lsink_grow(s, 1);
+    s->buf[s->len++] = c;
+}
+
+void lsink_puts(lsink* s, const char* str)
+{
+    lsink_write(s, str, strlen(str));
+}
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+void lsink_long(lsink* s, long x)
+{
+    /* 20 digits and a sign cover any 64 bit long */
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+
+    // work on the magnitude unsigned so LONG_MIN does not overflow
+    unsigned long u = x < 0 ? 0UL - (unsigned long)x : (unsigned long)x;
+
+    // two digits at a time from the lookup table
+    while (u >= 100)
+    {
+        unsigned long i = (u % 100) * 2;
+        u /= 100;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+
+    if (u >= 10)
+    {
+        *--p = digit_pairs[u * 2 + 1];
+        *--p = digit_pairs[u * 2];
+    }
+    else
+    {
+        *--p = (char)('0' + u);
+    }
+
+    if (x < 0)
+        *--p = '-';
+
+    lsink_write(s, p, (size_t)(end - p));
+}
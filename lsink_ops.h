@@ -0,0 +1,28 @@
+#ifndef LSINK_OPS_H
+#define LSINK_OPS_H
+
+#include "lsink.h"
+
+
+lsink* lsink_file(FILE* f);
+
+lsink* lsink_func(lsink_fn func, void* ctx);
+
+lsink* lsink_string(void);
+
+void lsink_del(lsink* s);
+
+void lsink_flush(lsink* s);
+
+char* lsink_take(lsink* s);
+
+
+void lsink_write(lsink* s, const char* p, size_t n);
+
+void lsink_putc(lsink* s, char c);
+
+void lsink_puts(lsink* s, const char* str);
+
+void lsink_long(lsink* s, long x);
+
+#endif
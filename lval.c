@@ -11,6 +11,7 @@ char* ltype_name(int t)
         case LVAL_SYM: return "Symbol";
         case LVAL_SEXPR: return "S-Expression";
         case LVAL_QEXPR: return "Q-Expression";
+        case LVAL_FUT: return "Future";
         default: return "Unknown";
     }
 }
@@ -6,8 +6,15 @@ typedef struct lval lval;
 
 struct lenv;
 typedef struct lenv lenv;
+
+struct lfuture;
+typedef struct lfuture lfuture;
+
+struct lclosure;
+typedef struct lclosure lclosure;
+
 enum { LVAL_NUM, LVAL_ERR, LVAL_SYM,
-       LVAL_FUN, LVAL_SEXPR, LVAL_QEXPR };
+       LVAL_FUN, LVAL_SEXPR, LVAL_QEXPR, LVAL_FUT };
 
 enum { LERR_DIV_ZERO, LERR_BAD_OP, LERR_BAD_NUM };
 
@@ -25,6 +32,8 @@ struct lval{
     char* err;
     char* sym;
     lbuiltin fun;
+    lclosure* closure;
+    lfuture* fut;
 
     int count;
     lval** cell;
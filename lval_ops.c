@@ -1,19 +1,37 @@
 #include "lval_ops.h"
+#include "lmem_ops.h"
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 #include "lenv_ops.h"
+#include "lpool_ops.h"
+#include "lfuture_ops.h"
+#include "lclosure_ops.h"
+#include "lispy_parser.h"
 
 lval* lval_fun(lbuiltin func)
 {
-    lval* v = malloc(sizeof(lval));
+    lval* v = lmem_malloc(sizeof(lval));
     v->type = LVAL_FUN;
     v->fun = func;
+    v->closure = NULL;
+    return v;
+}
+
+/* a function made with \, takes the reference to c */
+lval* lval_lambda(lclosure* c)
+{
+    lval* v = lmem_malloc(sizeof(lval));
+    v->type = LVAL_FUN;
+    v->fun = NULL;
+    v->closure = c;
     return v;
 }
 
 
 lval* lval_num(long x)
 {
-    lval* v = malloc(sizeof(lval));
+    lval* v = lmem_malloc(sizeof(lval));
     v->type = LVAL_NUM;
     v->num = x;
     return v;
@@ -22,7 +40,7 @@ lval* lval_num(long x)
 
 lval* lval_err(char* fmt, ...)
 {
-    lval* v = malloc(sizeof(lval));
+    lval* v = lmem_malloc(sizeof(lval));
     v->type = LVAL_ERR;
    
     /* Create a va list and initialize it*/
@@ -30,7 +48,7 @@ lval* lval_err(char* fmt, ...)
     va_start(va, fmt);
 
     /* Allocate 512 bytes of space */
-    v->err = malloc(512);
+    v->err = lmem_malloc(512);
 
     /* printf the error string with a maximum of 511 chars */
     vsnprintf(v->err, 511, fmt, va);
@@ -44,24 +62,87 @@ lval* lval_err(char* fmt, ...)
 
 lval* lval_sym(char* s)
 {
-    lval* v = malloc(sizeof(lval));
+    lval* v = lmem_malloc(sizeof(lval));
     v->type = LVAL_SYM;
-    v->sym = malloc(strlen(s) + 1);
+    v->sym = lmem_malloc(strlen(s) + 1);
     strcpy(v->sym, s);
     return v;
 }
 
+/* load 8 bytes with the first in the lowest byte whatever the byte order */
+static uint64_t load8(const char* s)
+{
+    const unsigned char* u = (const unsigned char*)s;
+    return (uint64_t)u[0]       | (uint64_t)u[1] << 8  |
+           (uint64_t)u[2] << 16 | (uint64_t)u[3] << 24 |
+           (uint64_t)u[4] << 32 | (uint64_t)u[5] << 40 |
+           (uint64_t)u[6] << 48 | (uint64_t)u[7] << 56;
+}
+
+/* whether all 8 bytes are ascii digits */
+static int digits8(uint64_t v)
+{
+    return (v & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL &&
+           ((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL;
+}
+
+/* the value of 8 digits, combining neighbours into pairs, fours then eights */
+static uint64_t value8(uint64_t v)
+{
+    v -= 0x3030303030303030ULL;
+    v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+    return (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+}
+
 lval* lval_read_num(mpc_ast_t* t)
 {
-    errno = 0;
-    long x = strtol(t->contents, NULL, 10);
-    return errno != ERANGE ?
-        lval_num(x) : lval_err("invalid number");
+    const char* s = t->contents;
+    int neg = (*s == '-');
+    s += neg;
+
+    /* the most a long can hold in either sign, as strtol allows */
+    unsigned long long limit = neg ?
+        (unsigned long long)LONG_MAX + 1 : (unsigned long long)LONG_MAX;
+    unsigned long long x = 0;
+
+    /* eight digits at a time while they last */
+    while (s[0] && s[1] && s[2] && s[3] && s[4] && s[5] && s[6] && s[7])
+    {
+        uint64_t v = load8(s);
+        if (!digits8(v))
+            break;
+        uint64_t d = value8(v);
+        if (x > (limit - d) / 100000000ULL)
+            return lval_err("invalid number");
+        x = x * 100000000ULL + d;
+        s += 8;
+    }
+
+    for (; *s >= '0' && *s <= '9'; s++)
+    {
+        unsigned d = (unsigned)(*s - '0');
+        if (x > (limit - d) / 10)
+            return lval_err("invalid number");
+        x = x * 10 + d;
+    }
+
+    /* negate without overflowing on the smallest long */
+    return lval_num(neg && x ? -(long)(x - 1) - 1 : (long)x);
+}
+
+/* takes the reference to f */
+lval* lval_fut(lfuture* f)
+{
+    lval* v = lmem_malloc(sizeof(lval));
+    v->type = LVAL_FUT;
+    v->fut = f;
+    return v;
 }
 
 lval* lval_sexpr(void)
 {
-    lval* v = malloc(sizeof(lval));
+    lval* v = lmem_malloc(sizeof(lval));
     v->type = LVAL_SEXPR;
     v->count = 0;
     v->cell = NULL;
@@ -70,7 +151,7 @@ lval* lval_sexpr(void)
 
 lval* lval_qexpr(void)
 {
-    lval* v = malloc(sizeof(lval));
+    lval* v = lmem_malloc(sizeof(lval));
     v->type = LVAL_QEXPR;
     v->count = 0;
     v->cell = NULL;
@@ -82,44 +163,52 @@ void lval_del(lval* v)
     switch(v->type)
     {
         case LVAL_NUM: break;
-        case LVAL_ERR: free(v->err); break;
-        case LVAL_SYM: free(v->sym); break;
-        case LVAL_FUN: break;
+        case LVAL_ERR: lmem_free(v->err); break;
+        case LVAL_SYM: lmem_free(v->sym); break;
+        case LVAL_FUN:
+             if (v->closure)
+                 lclosure_unref(v->closure);
+             break;
+        case LVAL_FUT: lfuture_unref(v->fut); break;
         case LVAL_QEXPR:
         case LVAL_SEXPR:
              for( int i = 0; i < v->count; i++)
              {
                  lval_del(v->cell[i]);
              }
-             free(v->cell);
+             lmem_free(v->cell);
              break;
     }
-    free(v);
+    lmem_free(v);
 }
 
 lval* lval_copy(lval* v)
 {
-    lval* x = malloc(sizeof(lval));
+    lval* x = lmem_malloc(sizeof(lval));
     x->type = v->type;
 
     switch (v->type)
     {
-        case LVAL_FUN: x->fun = v->fun; break;
+        case LVAL_FUN:
+                       x->fun = v->fun;
+                       x->closure = v->closure ? lclosure_ref(v->closure) : NULL;
+                       break;
+        case LVAL_FUT: x->fut = lfuture_ref(v->fut); break;
         case LVAL_NUM: x->num = v->num; break;
         case LVAL_ERR:
-                       x->err = malloc(strlen(v->err) + 1);
+                       x->err = lmem_malloc(strlen(v->err) + 1);
                        strcpy(x->err, v->err); 
                        break;
 
         case LVAL_SYM:
-                       x->sym = malloc(strlen(v->sym) + 1);
+                       x->sym = lmem_malloc(strlen(v->sym) + 1);
                        strcpy(x->sym, v->sym);
                        break;
 
         case LVAL_SEXPR:
         case LVAL_QEXPR:
                        x->count = v->count;
-                       x->cell = malloc(sizeof(lval*) * x->count);
+                       x->cell = lmem_malloc(sizeof(lval*) * x->count);
                        for (int i = 0; i < x->count; i++)
                        {
                            x->cell[i] = lval_copy(v->cell[i]);
@@ -130,10 +219,29 @@ lval* lval_copy(lval* v)
 
 }
 
+/* make every closure and future v reaches live for good. Copies of them
+   are no longer counted, so nothing is written to where they are */
+void lval_pin(lval* v)
+{
+    switch (v->type)
+    {
+        case LVAL_FUN:
+            if (v->closure)
+                lclosure_pin(v->closure);
+            break;
+        case LVAL_FUT: lfuture_pin(v->fut); break;
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            for (int i = 0; i < v->count; i++)
+                lval_pin(v->cell[i]);
+            break;
+    }
+}
+
 lval* lval_add(lval* v, lval* x)
 {
     v->count++;
-    v->cell = realloc(v->cell, sizeof(lval*) * v->count);
+    v->cell = lmem_realloc(v->cell, sizeof(lval*) * v->count);
     v->cell[v->count - 1] = x;
     return v;
 }
@@ -150,7 +258,7 @@ lval* lval_pop(lval* v, int i)
     v->count--;
 
     // reallocate the memory used
-    v->cell = realloc(v->cell, sizeof(lval*) * v->count);
+    v->cell = lmem_realloc(v->cell, sizeof(lval*) * v->count);
     return x;
 }
 
@@ -172,41 +280,205 @@ lval* lval_take(lval* v, int i)
     return x;
 }
 
-void lval_expr_print(lval* v, char open, char close)
+void lval_expr_write(lsink* s, lval* v, char open, char close)
 {
-    putchar(open);
+    lsink_putc(s, open);
     for (int i = 0; i < v->count; i++)
     {
-        // print value contained within
-        lval_print(v->cell[i]);
+        // write value contained within
+        lval_write(s, v->cell[i]);
 
-        // Dont print trailing space if last element
+        // Dont write trailing space if last element
         if( i != (v->count - 1))
-            putchar(' ');
+            lsink_putc(s, ' ');
     }
-    putchar(close);
+    lsink_putc(s, close);
 }
 
-void lval_print(lval* v)
+/* a function made with \ is written as it was made */
+static void lval_fun_write(lsink* s, lval* v)
+{
+    if (v->closure == NULL)
+    {
+        lsink_puts(s, "<function>");
+        return;
+    }
+
+    lsink_puts(s, "(\\ {");
+    for (int i = 0; i < v->closure->arity; i++)
+    {
+        if (i > 0)
+            lsink_putc(s, ' ');
+        lsink_puts(s, v->closure->names[i]);
+    }
+    lsink_puts(s, "} ");
+    lval_write(s, v->closure->body);
+    lsink_putc(s, ')');
+}
+
+void lval_write(lsink* s, lval* v)
 {
     switch (v->type){
-        case LVAL_NUM : printf("%li", v->num); break;
-        case LVAL_ERR: printf("Error: %s", v->err); break;
-        case LVAL_SYM: printf("%s", v->sym); break;
-        case LVAL_SEXPR: lval_expr_print(v, '(', ')'); break;
-        case LVAL_QEXPR: lval_expr_print(v, '{', '}'); break;
-        case LVAL_FUN: printf("<function>"); break;
+        case LVAL_NUM : lsink_long(s, v->num); break;
+        case LVAL_ERR: lsink_puts(s, "Error: "); lsink_puts(s, v->err); break;
+        case LVAL_SYM: lsink_puts(s, v->sym); break;
+        case LVAL_SEXPR: lval_expr_write(s, v, '(', ')'); break;
+        case LVAL_QEXPR: lval_expr_write(s, v, '{', '}'); break;
+        case LVAL_FUN: lval_fun_write(s, v); break;
+        case LVAL_FUT: lsink_puts(s, "<future>"); break;
     }
 }
 
-void lval_println(lval* v) { lval_print(v); putchar('\n'); }
+/* the value is built up in memory and written to stdout in one go. No
+   buffer is kept between prints, so threads can print without sharing one */
+static void lval_print_end(lval* v, const char* end)
+{
+    lsink* s = lsink_string();
+    lval_write(s, v);
+    lsink_puts(s, end);
+    fwrite(s->buf, 1, s->len, stdout);
+    fflush(stdout);
+    lsink_del(s);
+}
+
+void lval_print(lval* v)
+{
+    lval_print_end(v, "");
+}
+
+void lval_println(lval* v)
+{
+    lval_print_end(v, "\n");
+}
+
+char* lval_to_str(lval* v)
+{
+    lsink* s = lsink_string();
+    lval_write(s, v);
+    char* str = lsink_take(s);
+    lsink_del(s);
+    return str;
+}
+
+/* with a pool, children of at least cost nodes are evaluated side by side
+   in e. NULL goes back to evaluating everything in order on the calling
+   thread. A pool is only ever used by one thread outside it, so
+   environments evaluated on different threads need one each */
+void lval_eval_parallel(lenv* e, lpool* p, long cost)
+{
+    e->pool = p;
+    e->cost = cost;
+}
+
+/* nodes in v, counting stops once limit is reached */
+static long lval_cost(lval* v, long limit)
+{
+    long n = 1;
+    if (v->type == LVAL_SEXPR || v->type == LVAL_QEXPR)
+        for (int i = 0; i < v->count && n < limit; i++)
+            n += lval_cost(v->cell[i], limit - n);
+    return n;
+}
+
+/* whether evaluating v could reach a barrier builtin. A name counts as what
+   it is bound to, as q-expressions bound to names may be evaluated later */
+int lval_barrier(lenv* e, lval* v, int depth)
+{
+    switch (v->type)
+    {
+        case LVAL_FUN:
+        {
+            if (v->closure == NULL)
+                return builtin_barrier(v->fun);
+
+            // what a call evaluates, its captured values included
+            lclosure* c = v->closure;
+            if (depth >= LPOOL_DEPTH || lval_barrier(e, c->body, depth + 1))
+                return 1;
+            for (int i = 0; i < c->count - c->arity; i++)
+                if (lval_barrier(e, c->captured[i], depth + 1))
+                    return 1;
+            return 0;
+        }
+        case LVAL_SYM:
+        {
+            lval* x = lenv_find(e, v->sym);
+            if (x == NULL)
+                return 0;
+            return depth >= LPOOL_DEPTH || lval_barrier(e, x, depth + 1);
+        }
+        case LVAL_SEXPR:
+        case LVAL_QEXPR:
+            for (int i = 0; i < v->count; i++)
+                if (lval_barrier(e, v->cell[i], depth))
+                    return 1;
+            return 0;
+        // awaiting one waits on work the scan cannot see into
+        case LVAL_FUT:
+            return 1;
+    }
+    return 0;
+}
+
+/* evaluate the heavy children of v as tasks on the pool, all but the last
+   one, which is left to this thread along with the light ones. Only when
+   there are two or more of them and no child could reach a barrier */
+static int lval_eval_children(lenv* e, lval* v)
+{
+    char* heavy = lmem_malloc(v->count);
+    int n = 0;
+    for (int i = 0; i < v->count; i++)
+    {
+        // only s-expressions do any work when evaluated
+        heavy[i] = v->cell[i]->type == LVAL_SEXPR
+            && lval_cost(v->cell[i], e->cost) >= e->cost;
+        n += heavy[i];
+    }
+
+    for (int i = 0; n > 1 && i < v->count; i++)
+        if (v->cell[i]->type == LVAL_SEXPR && lval_barrier(e, v->cell[i], 0))
+            n = 0;
+
+    if (n < 2)
+    {
+        lmem_free(heavy);
+        return 0;
+    }
+
+    lpool_task* tasks = lmem_malloc(sizeof(lpool_task) * v->count);
+    for (int i = 0; i < v->count && n > 1; i++)
+    {
+        if (heavy[i])
+        {
+            lpool_spawn(e->pool, &tasks[i], e, v->cell[i]);
+            heavy[i] = 2;
+            n--;
+        }
+    }
+
+    for (int i = 0; i < v->count; i++)
+        if (heavy[i] != 2)
+            v->cell[i] = lval_eval(e, v->cell[i]);
+
+    // newest first, those are the ones still in our own deque
+    for (int i = v->count - 1; i >= 0; i--)
+        if (heavy[i] == 2)
+            v->cell[i] = lpool_wait(e->pool, &tasks[i]);
+
+    lmem_free(tasks);
+    lmem_free(heavy);
+    return 1;
+}
 
 lval* lval_eval_sexpr(lenv* e, lval* v)
 {
     // evaluate children
-    for (int i = 0; i < v->count; i++)
+    if (e->pool == NULL || v->count < 2 || !lval_eval_children(e, v))
     {
-        v->cell[i] = lval_eval(e, v->cell[i]);
+        for (int i = 0; i < v->count; i++)
+        {
+            v->cell[i] = lval_eval(e, v->cell[i]);
+        }
     }
 
     // error checking
@@ -223,14 +495,20 @@ lval* lval_eval_sexpr(lenv* e, lval* v)
 
     // ensure first element is symbol
     lval* f = lval_pop(v,0);
+    return lval_call(e, f, v);
+}
+
+/* call f with the arguments in a, taking both */
+lval* lval_call(lenv* e, lval* f, lval* a)
+{
     if (f->type !=  LVAL_FUN)
     {
-        lval_del(f); lval_del(v);
+        lval_del(f); lval_del(a);
         return lval_err("first element is not a function");
     }
 
     // call builtin with operator
-    lval* result = f->fun(e, v);
+    lval* result = f->closure ? lclosure_call(e, f->closure, a) : f->fun(e, a);
     lval_del(f);
     return result;
 }
@@ -251,39 +529,27 @@ lval* lval_eval(lenv* e, lval* v)
     return v;
 }
 
-lval* lval_read(mpc_ast_t* t) {
-      
-   if (strstr(t->tag, "number")) 
-      return lval_read_num(t); 
-
-   if (strstr(t->tag, "symbol")) 
-      return lval_sym(t->contents); 
-          
-   lval* x = NULL;
-   if (strcmp(t->tag, ">") == 0) 
-       x = lval_sexpr();
-
-   if (strstr(t->tag, "sexpr"))  
-       x = lval_sexpr(); 
-   if (strstr(t->tag, "qexpr"))
-       x = lval_qexpr(); 
-                  
-   for (int i = 0; i < t->children_num; i++) {
-       if (strcmp(t->children[i]->contents, "(") == 0) 
-           continue;
-       if (strcmp(t->children[i]->contents, ")") == 0) 
-           continue;
-
-       if (strcmp(t->children[i]->contents, "}") == 0) 
-           continue;
-       if (strcmp(t->children[i]->contents, "{") == 0) 
-           continue;
-       if (strcmp(t->children[i]->tag,  "regex") == 0) 
-           continue;
-       x = lval_add(x, lval_read(t->children[i]));
-    
-   }
-                   
-return x;
+lval* lval_read(mpc_ast_t* t)
+{
+    lval* x = NULL;
+
+    switch (t->rule)
+    {
+        case LISPY_RULE_NUMBER: return lval_read_num(t);
+        case LISPY_RULE_SYMBOL: return lval_sym(t->contents);
+        case LISPY_RULE_QEXPR: x = lval_qexpr(); break;
+        case LISPY_RULE_SEXPR:
+        case LISPY_RULE_LISPY: x = lval_sexpr(); break;
+    }
+
+    for (int i = 0; i < t->children_num; i++)
+    {
+        /* brackets and the start and end of input belong to no rule */
+        if (t->children[i]->rule == 0 && t->children[i]->token != MPC_AST_TOKEN_NONE)
+            continue;
+        x = lval_add(x, lval_read(t->children[i]));
+    }
+
+    return x;
 }
 
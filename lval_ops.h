@@ -3,11 +3,15 @@
 
 #include "mpc.h"
 #include "lval.h"
+#include "lsink_ops.h"
+#include "lpool.h"
 
 
 
 lval* lval_fun(lbuiltin func);
 
+lval* lval_lambda(lclosure* c);
+
 
 lval* lval_num(long x);
 
@@ -16,10 +20,15 @@ lval* lval_err(char* fmt, ...);
 lval* lval_sym(char* s);
 
 
+lval* lval_fut(lfuture* f);
+
+
 lval* lval_read_num(mpc_ast_t* t);
 
 lval* lval_sexpr(void);
 
+lval* lval_qexpr(void);
+
 
 
 lval* lval_read(mpc_ast_t* t);
@@ -29,6 +38,8 @@ void lval_del(lval* v);
 
 lval* lval_copy(lval* v);
 
+void lval_pin(lval* v);
+
 
 lval* lval_add(lval* v, lval* x);
 
@@ -40,7 +51,9 @@ lval* lval_join(lval* x, lval* y);
 
 lval* lval_take(lval* v, int i);
 
-void lval_expr_print(lval* v, char open, char close);
+void lval_expr_write(lsink* s, lval* v, char open, char close);
+
+void lval_write(lsink* s, lval* v);
 
 
 
@@ -51,8 +64,16 @@ void lval_print(lval* v);
 
 void lval_println(lval* v); 
 
+char* lval_to_str(lval* v);
+
+void lval_eval_parallel(lenv* e, lpool* p, long cost);
+
+int lval_barrier(lenv* e, lval* v, int depth);
+
 lval* lval_eval_sexpr(lenv* e, lval* v);
 
+lval* lval_call(lenv* e, lval* f, lval* a);
+
 
 lval* lval_eval(lenv* e, lval* v);
 #endif
@@ -1,3842 +1,6630 @@
-#include "mpc.h"
-
-/*
-** State Type
-*/
-
-static mpc_state_t mpc_state_invalid(void) {
-  mpc_state_t s;
-  s.pos = -1;
-  s.row = -1;
-  s.col = -1;
-  return s;
-}
-
-static mpc_state_t mpc_state_new(void) {
-  mpc_state_t s;
-  s.pos = 0;
-  s.row = 0;
-  s.col = 0;
-  return s;
-}
-
-/*
-** Input Type
-*/
-
-/*
-** In mpc the input type has three modes of 
-** operation: String, File and Pipe.
-**
-** String is easy. The whole contents are 
-** loaded into a buffer and scanned through.
-** The cursor can jump around at will making 
-** backtracking easy.
-**
-** The second is a File which is also somewhat
-** easy. The contents are never loaded into 
-** memory but backtracking can still be achieved
-** by seeking in the file at different positions.
-**
-** The final mode is Pipe. This is the difficult
-** one. As we assume pipes cannot be seeked - and 
-** only support a single character lookahead at 
-** any point, when the input is marked for a 
-** potential backtracking we start buffering any 
-** input.
-**
-** This means that if we are requested to seek
-** back we can simply start reading from the
-** buffer instead of the input.
-**
-** Of course using `mpc_predictive` will disable
-** backtracking and make LL(1) grammars easy
-** to parse for all input methods.
-**
-*/
-
-enum {
-  MPC_INPUT_STRING = 0,
-  MPC_INPUT_FILE   = 1,
-  MPC_INPUT_PIPE   = 2
-};
-
-enum {
-  MPC_INPUT_MARKS_MIN = 32
-};
-
-enum {
-  MPC_INPUT_MEM_NUM = 512
-};
-
-typedef struct {
-  char mem[64];
-} mpc_mem_t;
-
-typedef struct {
-
-  int type;
-  char *filename;  
-  mpc_state_t state;
-  
-  char *string;
-  char *buffer;
-  FILE *file;
-  
-  int suppress;
-  int backtrack;
-  int marks_slots;
-  int marks_num;
-  mpc_state_t *marks;
-  
-  char *lasts;
-  char last;
-  
-  size_t mem_index;
-  char mem_full[MPC_INPUT_MEM_NUM];
-  mpc_mem_t mem[MPC_INPUT_MEM_NUM];
-  
-} mpc_input_t;
-
-static mpc_input_t *mpc_input_new_string(const char *filename, const char *string) {
-
-  mpc_input_t *i = malloc(sizeof(mpc_input_t));
-  
-  i->filename = malloc(strlen(filename) + 1);
-  strcpy(i->filename, filename);
-  i->type = MPC_INPUT_STRING;
-  
-  i->state = mpc_state_new();
-  
-  i->string = malloc(strlen(string) + 1);
-  strcpy(i->string, string);
-  i->buffer = NULL;
-  i->file = NULL;
-  
-  i->suppress = 0;
-  i->backtrack = 1;
-  i->marks_num = 0;
-  i->marks_slots = MPC_INPUT_MARKS_MIN;
-  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
-  i->lasts = malloc(sizeof(char) * i->marks_slots);
-  i->last = '\0';
-  
-  i->mem_index = 0;
-  memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
-  
-  return i;
-}
-
-static mpc_input_t *mpc_input_new_nstring(const char *filename, const char *string, size_t length) {
-
-  mpc_input_t *i = malloc(sizeof(mpc_input_t));
-  
-  i->filename = malloc(strlen(filename) + 1);
-  strcpy(i->filename, filename);
-  i->type = MPC_INPUT_STRING;
-  
-  i->state = mpc_state_new();
-  
-  i->string = malloc(length + 1);
-  strncpy(i->string, string, length);
-  i->string[length] = '\0';
-  i->buffer = NULL;
-  i->file = NULL;
-  
-  i->suppress = 0;
-  i->backtrack = 1;
-  i->marks_num = 0;
-  i->marks_slots = MPC_INPUT_MARKS_MIN;
-  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
-  i->lasts = malloc(sizeof(char) * i->marks_slots);
-  i->last = '\0';
-  
-  i->mem_index = 0;
-  memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
-  
-  return i;
-
-}
-
-static mpc_input_t *mpc_input_new_pipe(const char *filename, FILE *pipe) {
-
-  mpc_input_t *i = malloc(sizeof(mpc_input_t));
-  
-  i->filename = malloc(strlen(filename) + 1);
-  strcpy(i->filename, filename);
-  
-  i->type = MPC_INPUT_PIPE;
-  i->state = mpc_state_new();
-  
-  i->string = NULL;
-  i->buffer = NULL;
-  i->file = pipe;
-  
-  i->suppress = 0;
-  i->backtrack = 1;
-  i->marks_num = 0;
-  i->marks_slots = MPC_INPUT_MARKS_MIN;
-  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
-  i->lasts = malloc(sizeof(char) * i->marks_slots);
-  i->last = '\0';
-  
-  i->mem_index = 0;
-  memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
-  
-  return i;
-  
-}
-
-static mpc_input_t *mpc_input_new_file(const char *filename, FILE *file) {
-  
-  mpc_input_t *i = malloc(sizeof(mpc_input_t));
-  
-  i->filename = malloc(strlen(filename) + 1);
-  strcpy(i->filename, filename);
-  i->type = MPC_INPUT_FILE;
-  i->state = mpc_state_new();
-  
-  i->string = NULL;
-  i->buffer = NULL;
-  i->file = file;
-  
-  i->suppress = 0;
-  i->backtrack = 1;
-  i->marks_num = 0;
-  i->marks_slots = MPC_INPUT_MARKS_MIN;
-  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
-  i->lasts = malloc(sizeof(char) * i->marks_slots);
-  i->last = '\0';
-  
-  i->mem_index = 0;
-  memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
-  
-  return i;
-}
-
-static void mpc_input_delete(mpc_input_t *i) {
-  
-  free(i->filename);
-  
-  if (i->type == MPC_INPUT_STRING) { free(i->string); }
-  if (i->type == MPC_INPUT_PIPE) { free(i->buffer); }
-  
-  free(i->marks);
-  free(i->lasts);
-  free(i);
-}
-
-static int mpc_mem_ptr(mpc_input_t *i, void *p) {
-  return
-    (char*)p >= (char*)(i->mem) &&
-    (char*)p <  (char*)(i->mem) + (MPC_INPUT_MEM_NUM * sizeof(mpc_mem_t));
-}
-
-static void *mpc_malloc(mpc_input_t *i, size_t n) {
-  size_t j;
-  char *p;
-  
-  if (n > sizeof(mpc_mem_t)) { return malloc(n); }
-  
-  j = i->mem_index;
-  do {
-    if (!i->mem_full[i->mem_index]) {
-      p = (void*)(i->mem + i->mem_index);
-      i->mem_full[i->mem_index] = 1;
-      i->mem_index = (i->mem_index+1) % MPC_INPUT_MEM_NUM;
-      return p;
-    }
-    i->mem_index = (i->mem_index+1) % MPC_INPUT_MEM_NUM;
-  } while (j != i->mem_index);
-  
-  return malloc(n);
-}
-
-static void *mpc_calloc(mpc_input_t *i, size_t n, size_t m) {
-  char *x = mpc_malloc(i, n * m);
-  memset(x, 0, n * m);
-  return x;
-}
-
-static void mpc_free(mpc_input_t *i, void *p) {
-  size_t j;
-  if (!mpc_mem_ptr(i, p)) { free(p); return; }
-  j = ((size_t)(((char*)p) - ((char*)i->mem))) / sizeof(mpc_mem_t);
-  i->mem_full[j] = 0;
-}
-
-static void *mpc_realloc(mpc_input_t *i, void *p, size_t n) {
-  
-  char *q = NULL;
-  
-  if (!mpc_mem_ptr(i, p)) { return realloc(p, n); }
-  
-  if (n > sizeof(mpc_mem_t)) {
-    q = malloc(n);
-    memcpy(q, p, sizeof(mpc_mem_t));
-    mpc_free(i, p);
-    return q;
-  }
-  
-  return p;
-}
-
-static void *mpc_export(mpc_input_t *i, void *p) {
-  char *q = NULL;
-  if (!mpc_mem_ptr(i, p)) { return p; }
-  q = malloc(sizeof(mpc_mem_t));
-  memcpy(q, p, sizeof(mpc_mem_t));
-  mpc_free(i, p);
-  return q; 
-}
-
-static void mpc_input_backtrack_disable(mpc_input_t *i) { i->backtrack--; }
-static void mpc_input_backtrack_enable(mpc_input_t *i) { i->backtrack++; }
-
-static void mpc_input_suppress_disable(mpc_input_t *i) { i->suppress--; }
-static void mpc_input_suppress_enable(mpc_input_t *i) { i->suppress++; }
-
-static void mpc_input_mark(mpc_input_t *i) {
-  
-  if (i->backtrack < 1) { return; }
-  
-  i->marks_num++;
-  
-  if (i->marks_num > i->marks_slots) {
-    i->marks_slots = i->marks_num + i->marks_num / 2;
-    i->marks = realloc(i->marks, sizeof(mpc_state_t) * i->marks_slots);
-    i->lasts = realloc(i->lasts, sizeof(char) * i->marks_slots);
-  }
-
-  i->marks[i->marks_num-1] = i->state;
-  i->lasts[i->marks_num-1] = i->last;
-  
-  if (i->type == MPC_INPUT_PIPE && i->marks_num == 1) {
-    i->buffer = calloc(1, 1);
-  }
-  
-}
-
-static void mpc_input_unmark(mpc_input_t *i) {
-  
-  if (i->backtrack < 1) { return; }
-  
-  i->marks_num--;
-  
-  if (i->marks_slots > i->marks_num + i->marks_num / 2
-  &&  i->marks_slots > MPC_INPUT_MARKS_MIN) {
-    i->marks_slots = 
-      i->marks_num > MPC_INPUT_MARKS_MIN ?
-      i->marks_num : MPC_INPUT_MARKS_MIN;
-    i->marks = realloc(i->marks, sizeof(mpc_state_t) * i->marks_slots);
-    i->lasts = realloc(i->lasts, sizeof(char) * i->marks_slots);      
-  }
-  
-  if (i->type == MPC_INPUT_PIPE && i->marks_num == 0) {
-    free(i->buffer);
-    i->buffer = NULL;
-  }
-  
-}
-
-static void mpc_input_rewind(mpc_input_t *i) {
-  
-  if (i->backtrack < 1) { return; }
-  
-  i->state = i->marks[i->marks_num-1];
-  i->last  = i->lasts[i->marks_num-1];
-  
-  if (i->type == MPC_INPUT_FILE) {
-    fseek(i->file, i->state.pos, SEEK_SET);
-  }
-  
-  mpc_input_unmark(i);
-}
-
-static int mpc_input_buffer_in_range(mpc_input_t *i) {
-  return i->state.pos < (long)(strlen(i->buffer) + i->marks[0].pos);
-}
-
-static char mpc_input_buffer_get(mpc_input_t *i) {
-  return i->buffer[i->state.pos - i->marks[0].pos];
-}
-
-static int mpc_input_terminated(mpc_input_t *i) {
-  if (i->type == MPC_INPUT_STRING && i->state.pos == (long)strlen(i->string)) { return 1; }
-  if (i->type == MPC_INPUT_FILE && feof(i->file)) { return 1; }
-  if (i->type == MPC_INPUT_PIPE && feof(i->file)) { return 1; }
-  return 0;
-}
-
-static char mpc_input_getc(mpc_input_t *i) {
-  
-  char c = '\0';
-  
-  switch (i->type) {
-    
-    case MPC_INPUT_STRING: return i->string[i->state.pos];
-    case MPC_INPUT_FILE: c = fgetc(i->file); return c;
-    case MPC_INPUT_PIPE:
-    
-      if (!i->buffer) { c = getc(i->file); return c; }
-      
-      if (i->buffer && mpc_input_buffer_in_range(i)) {
-        c = mpc_input_buffer_get(i);
-        return c;
-      } else {
-        c = getc(i->file);
-        return c;
-      }
-    
-    default: return c;
-  }
-}
-
-static char mpc_input_peekc(mpc_input_t *i) {
-  
-  char c = '\0';
-  
-  switch (i->type) {
-    case MPC_INPUT_STRING: return i->string[i->state.pos];
-    case MPC_INPUT_FILE: 
-      
-      c = fgetc(i->file);
-      if (feof(i->file)) { return '\0'; }
-      
-      fseek(i->file, -1, SEEK_CUR);
-      return c;
-    
-    case MPC_INPUT_PIPE:
-      
-      if (!i->buffer) {
-        c = getc(i->file);
-        if (feof(i->file)) { return '\0'; }
-        ungetc(c, i->file);
-        return c;
-      }
-      
-      if (i->buffer && mpc_input_buffer_in_range(i)) {
-        return mpc_input_buffer_get(i);
-      } else {
-        c = getc(i->file);
-        if (feof(i->file)) { return '\0'; }
-        ungetc(c, i->file);
-        return c;
-      }
-    
-    default: return c;
-  }
-  
-}
-
-static int mpc_input_failure(mpc_input_t *i, char c) {
-
-  switch (i->type) {
-    case MPC_INPUT_STRING: { break; }
-    case MPC_INPUT_FILE: fseek(i->file, -1, SEEK_CUR); { break; }
-    case MPC_INPUT_PIPE: {
-      
-      if (!i->buffer) { ungetc(c, i->file); break; }
-      
-      if (i->buffer && mpc_input_buffer_in_range(i)) {
-        break;
-      } else {
-        ungetc(c, i->file); 
-      }
-    }
-    default: { break; }
-  }
-  return 0;
-}
-
-static int mpc_input_success(mpc_input_t *i, char c, char **o) {
-  
-  if (i->type == MPC_INPUT_PIPE
-  &&  i->buffer && !mpc_input_buffer_in_range(i)) {
-    i->buffer = realloc(i->buffer, strlen(i->buffer) + 2);
-    i->buffer[strlen(i->buffer) + 1] = '\0';
-    i->buffer[strlen(i->buffer) + 0] = c;
-  }
-  
-  i->last = c;
-  i->state.pos++;
-  i->state.col++;
-  
-  if (c == '\n') {
-    i->state.col = 0;
-    i->state.row++;
-  }
-  
-  if (o) {
-    (*o) = mpc_malloc(i, 2);
-    (*o)[0] = c;
-    (*o)[1] = '\0';
-  }
-  
-  return 1;
-}
-
-static int mpc_input_any(mpc_input_t *i, char **o) {
-  char x = mpc_input_getc(i);
-  if (mpc_input_terminated(i)) { return 0; }
-  return mpc_input_success(i, x, o);
-}
-
-static int mpc_input_char(mpc_input_t *i, char c, char **o) {
-  char x = mpc_input_getc(i);
-  if (mpc_input_terminated(i)) { return 0; }
-  return x == c ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);
-}
-
-static int mpc_input_range(mpc_input_t *i, char c, char d, char **o) {
-  char x = mpc_input_getc(i);
-  if (mpc_input_terminated(i)) { return 0; }
-  return x >= c && x <= d ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
-}
-
-static int mpc_input_oneof(mpc_input_t *i, const char *c, char **o) {
-  char x = mpc_input_getc(i);
-  if (mpc_input_terminated(i)) { return 0; }
-  return strchr(c, x) != 0 ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
-}
-
-static int mpc_input_noneof(mpc_input_t *i, const char *c, char **o) {
-  char x = mpc_input_getc(i);
-  if (mpc_input_terminated(i)) { return 0; }
-  return strchr(c, x) == 0 ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
-}
-
-static int mpc_input_satisfy(mpc_input_t *i, int(*cond)(char), char **o) {
-  char x = mpc_input_getc(i);
-  if (mpc_input_terminated(i)) { return 0; }
-  return cond(x) ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
-}
-
-static int mpc_input_string(mpc_input_t *i, const char *c, char **o) {
-  
-  const char *x = c;
-
-  mpc_input_mark(i);
-  while (*x) {
-    if (!mpc_input_char(i, *x, NULL)) {
-      mpc_input_rewind(i);
-      return 0;
-    }
-    x++;
-  }
-  mpc_input_unmark(i);
-  
-  *o = mpc_malloc(i, strlen(c) + 1);
-  strcpy(*o, c);
-  return 1;
-}
-
-static int mpc_input_anchor(mpc_input_t* i, int(*f)(char,char), char **o) {
-  *o = NULL;
-  return f(i->last, mpc_input_peekc(i));
-}
-
-static mpc_state_t *mpc_input_state_copy(mpc_input_t *i) {
-  mpc_state_t *r = mpc_malloc(i, sizeof(mpc_state_t));
-  memcpy(r, &i->state, sizeof(mpc_state_t));
-  return r;
-}
-
-/*
-** Error Type
-*/
-
-void mpc_err_delete(mpc_err_t *x) {
-  int i;
-  for (i = 0; i < x->expected_num; i++) { free(x->expected[i]); }
-  free(x->expected);
-  free(x->filename);
-  free(x->failure);
-  free(x);
-}
-
-void mpc_err_print(mpc_err_t *x) {
-  mpc_err_print_to(x, stdout);
-}
-
-void mpc_err_print_to(mpc_err_t *x, FILE *f) {
-  char *str = mpc_err_string(x);
-  fprintf(f, "%s", str);
-  free(str);
-}
-
-static void mpc_err_string_cat(char *buffer, int *pos, int *max, char const *fmt, ...) {
-  /* TODO: Error Checking on Length */
-  int left = ((*max) - (*pos));
-  va_list va;
-  va_start(va, fmt);
-  if (left < 0) { left = 0;}
-  (*pos) += vsprintf(buffer + (*pos), fmt, va);
-  va_end(va);
-}
-
-static char char_unescape_buffer[4];
-
-static const char *mpc_err_char_unescape(char c) {
-  
-  char_unescape_buffer[0] = '\'';
-  char_unescape_buffer[1] = ' ';
-  char_unescape_buffer[2] = '\'';
-  char_unescape_buffer[3] = '\0';
-  
-  switch (c) {
-    case '\a': return "bell";
-    case '\b': return "backspace";
-    case '\f': return "formfeed";
-    case '\r': return "carriage return";
-    case '\v': return "vertical tab";
-    case '\0': return "end of input";
-    case '\n': return "newline";
-    case '\t': return "tab";
-    case ' ' : return "space";
-    default:
-      char_unescape_buffer[1] = c;
-      return char_unescape_buffer;
-  }
-  
-}
-
-char *mpc_err_string(mpc_err_t *x) {
-
-  int i;  
-  int pos = 0; 
-  int max = 1023;
-  char *buffer = calloc(1, 1024);
-  
-  if (x->failure) {
-    mpc_err_string_cat(buffer, &pos, &max,
-    "%s: error: %s\n", x->filename, x->failure);
-    return buffer;
-  }
-  
-  mpc_err_string_cat(buffer, &pos, &max, 
-    "%s:%i:%i: error: expected ", x->filename, x->state.row+1, x->state.col+1);
-  
-  if (x->expected_num == 0) { mpc_err_string_cat(buffer, &pos, &max, "ERROR: NOTHING EXPECTED"); }
-  if (x->expected_num == 1) { mpc_err_string_cat(buffer, &pos, &max, "%s", x->expected[0]); }
-  if (x->expected_num >= 2) {
-  
-    for (i = 0; i < x->expected_num-2; i++) {
-      mpc_err_string_cat(buffer, &pos, &max, "%s, ", x->expected[i]);
-    } 
-    
-    mpc_err_string_cat(buffer, &pos, &max, "%s or %s", 
-      x->expected[x->expected_num-2], 
-      x->expected[x->expected_num-1]);
-  }
-  
-  mpc_err_string_cat(buffer, &pos, &max, " at ");
-  mpc_err_string_cat(buffer, &pos, &max, mpc_err_char_unescape(x->recieved));
-  mpc_err_string_cat(buffer, &pos, &max, "\n");
-  
-  return realloc(buffer, strlen(buffer) + 1);
-}
-
-static mpc_err_t *mpc_err_new(mpc_input_t *i, const char *expected) {
-  mpc_err_t *x;
-  if (i->suppress) { return NULL; }
-  x = mpc_malloc(i, sizeof(mpc_err_t));
-  x->filename = mpc_malloc(i, strlen(i->filename) + 1);
-  strcpy(x->filename, i->filename);
-  x->state = i->state;
-  x->expected_num = 1;
-  x->expected = mpc_malloc(i, sizeof(char*));
-  x->expected[0] = mpc_malloc(i, strlen(expected) + 1);
-  strcpy(x->expected[0], expected);
-  x->failure = NULL;
-  x->recieved = mpc_input_peekc(i);
-  return x;
-}
-
-static mpc_err_t *mpc_err_fail(mpc_input_t *i, const char *failure) {
-  mpc_err_t *x;
-  if (i->suppress) { return NULL; }
-  x = mpc_malloc(i, sizeof(mpc_err_t));
-  x->filename = mpc_malloc(i, strlen(i->filename) + 1);
-  strcpy(x->filename, i->filename);
-  x->state = i->state;
-  x->expected_num = 0;
-  x->expected = NULL;
-  x->failure = mpc_malloc(i, strlen(failure) + 1);
-  strcpy(x->failure, failure);
-  x->recieved = ' ';
-  return x;
-}
-
-static mpc_err_t *mpc_err_file(const char *filename, const char *failure) {
-  mpc_err_t *x;
-  x = malloc(sizeof(mpc_err_t));
-  x->filename = malloc(strlen(filename) + 1);
-  strcpy(x->filename, filename);
-  x->state = mpc_state_new();
-  x->expected_num = 0;
-  x->expected = NULL;
-  x->failure = malloc(strlen(failure) + 1);
-  strcpy(x->failure, failure);
-  x->recieved = ' ';
-  return x;
-}
-
-static void mpc_err_delete_internal(mpc_input_t *i, mpc_err_t *x) {
-  int j;
-  if (x == NULL) { return; }
-  for (j = 0; j < x->expected_num; j++) { mpc_free(i, x->expected[j]); }
-  mpc_free(i, x->expected);
-  mpc_free(i, x->filename);
-  mpc_free(i, x->failure);
-  mpc_free(i, x);
-}
-
-static mpc_err_t *mpc_err_export(mpc_input_t *i, mpc_err_t *x) {
-  int j;
-  for (j = 0; j < x->expected_num; j++) {
-    x->expected[j] = mpc_export(i, x->expected[j]);
-  }
-  x->expected = mpc_export(i, x->expected);
-  x->filename = mpc_export(i, x->filename);
-  x->failure = mpc_export(i, x->failure);
-  return mpc_export(i, x);
-}
-
-static int mpc_err_contains_expected(mpc_input_t *i, mpc_err_t *x, char *expected) {
-  int j;
-  (void)i;
-  for (j = 0; j < x->expected_num; j++) {
-    if (strcmp(x->expected[j], expected) == 0) { return 1; }
-  }
-  return 0;
-}
-
-static void mpc_err_add_expected(mpc_input_t *i, mpc_err_t *x, char *expected) {
-  (void)i;
-  x->expected_num++;
-  x->expected = mpc_realloc(i, x->expected, sizeof(char*) * x->expected_num);
-  x->expected[x->expected_num-1] = mpc_malloc(i, strlen(expected) + 1);
-  strcpy(x->expected[x->expected_num-1], expected);
-}
-
-static mpc_err_t *mpc_err_or(mpc_input_t *i, mpc_err_t** x, int n) {
-  
-  int j, k, fst;
-  mpc_err_t *e;
-  
-  fst = -1;
-  for (j = 0; j < n; j++) {
-    if (x[j] != NULL) { fst = j; }
-  }
-  
-  if (fst == -1) { return NULL; }
-  
-  e = mpc_malloc(i, sizeof(mpc_err_t));
-  e->state = mpc_state_invalid();
-  e->expected_num = 0;
-  e->expected = NULL;
-  e->failure = NULL;
-  e->filename = mpc_malloc(i, strlen(x[fst]->filename)+1);
-  strcpy(e->filename, x[fst]->filename);
-  
-  for (j = 0; j < n; j++) {
-    if (x[j] == NULL) { continue; }
-    if (x[j]->state.pos > e->state.pos) { e->state = x[j]->state; }
-  }
-  
-  for (j = 0; j < n; j++) {
-    if (x[j] == NULL) { continue; }
-    if (x[j]->state.pos < e->state.pos) { continue; }
-    
-    if (x[j]->failure) {
-      e->failure = mpc_malloc(i, strlen(x[j]->failure)+1);
-      strcpy(e->failure, x[j]->failure);
-      break;
-    }
-    
-    e->recieved = x[j]->recieved;
-    
-    for (k = 0; k < x[j]->expected_num; k++) {
-      if (!mpc_err_contains_expected(i, e, x[j]->expected[k])) {
-        mpc_err_add_expected(i, e, x[j]->expected[k]);
-      }
-    }
-  }
-  
-  for (j = 0; j < n; j++) {
-    if (x[j] == NULL) { continue; }
-    mpc_err_delete_internal(i, x[j]);
-  }
-  
-  return e;
-}
-
-static mpc_err_t *mpc_err_repeat(mpc_input_t *i, mpc_err_t *x, const char *prefix) {
-
-  int j = 0;
-  size_t l = 0;
-  char *expect = NULL;
-  
-  if (x == NULL) { return NULL; }
-  
-  if (x->expected_num == 0) {
-    expect = mpc_calloc(i, 1, 1);
-    x->expected_num = 1;
-    x->expected = mpc_realloc(i, x->expected, sizeof(char*) * x->expected_num);
-    x->expected[0] = expect;
-    return x;
-  }
-  
-  else if (x->expected_num == 1) {
-    expect = mpc_malloc(i, strlen(prefix) + strlen(x->expected[0]) + 1);
-    strcpy(expect, prefix);
-    strcat(expect, x->expected[0]);
-    mpc_free(i, x->expected[0]);
-    x->expected[0] = expect;
-    return x;
-  }
-  
-  else if (x->expected_num > 1) {
-    
-    l += strlen(prefix);
-    for (j = 0; j < x->expected_num-2; j++) {
-      l += strlen(x->expected[j]) + strlen(", ");
-    }
-    l += strlen(x->expected[x->expected_num-2]);
-    l += strlen(" or ");
-    l += strlen(x->expected[x->expected_num-1]);
-    
-    expect = mpc_malloc(i, l + 1);
-    
-    strcpy(expect, prefix);
-    for (j = 0; j < x->expected_num-2; j++) {
-      strcat(expect, x->expected[j]); strcat(expect, ", ");
-    }
-    strcat(expect, x->expected[x->expected_num-2]);
-    strcat(expect, " or ");
-    strcat(expect, x->expected[x->expected_num-1]);
-
-    for (j = 0; j < x->expected_num; j++) { mpc_free(i, x->expected[j]); }
-    
-    x->expected_num = 1;
-    x->expected = mpc_realloc(i, x->expected, sizeof(char*) * x->expected_num);
-    x->expected[0] = expect;
-    return x;
-  }
-  
-  return NULL;
-}
-
-static mpc_err_t *mpc_err_many1(mpc_input_t *i, mpc_err_t *x) {
-  return mpc_err_repeat(i, x, "one or more of ");
-}
-
-static mpc_err_t *mpc_err_count(mpc_input_t *i, mpc_err_t *x, int n) {
-  mpc_err_t *y;
-  int digits = n/10 + 1;
-  char *prefix;
-  prefix = mpc_malloc(i, digits + strlen(" of ") + 1);
-  sprintf(prefix, "%i of ", n);
-  y = mpc_err_repeat(i, x, prefix);
-  mpc_free(i, prefix);
-  return y;
-}
-
-static mpc_err_t *mpc_err_merge(mpc_input_t *i, mpc_err_t *x, mpc_err_t *y) {
-  mpc_err_t *errs[2];
-  errs[0] = x;
-  errs[1] = y;
-  return mpc_err_or(i, errs, 2);
-}
-
-/*
-** Parser Type
-*/
-
-enum {
-  MPC_TYPE_UNDEFINED = 0,
-  MPC_TYPE_PASS      = 1,
-  MPC_TYPE_FAIL      = 2,
-  MPC_TYPE_LIFT      = 3,
-  MPC_TYPE_LIFT_VAL  = 4,
-  MPC_TYPE_EXPECT    = 5,
-  MPC_TYPE_ANCHOR    = 6,
-  MPC_TYPE_STATE     = 7,
-  
-  MPC_TYPE_ANY       = 8,
-  MPC_TYPE_SINGLE    = 9,
-  MPC_TYPE_ONEOF     = 10,
-  MPC_TYPE_NONEOF    = 11,
-  MPC_TYPE_RANGE     = 12,
-  MPC_TYPE_SATISFY   = 13,
-  MPC_TYPE_STRING    = 14,
-  
-  MPC_TYPE_APPLY     = 15,
-  MPC_TYPE_APPLY_TO  = 16,
-  MPC_TYPE_PREDICT   = 17,
-  MPC_TYPE_NOT       = 18,
-  MPC_TYPE_MAYBE     = 19,
-  MPC_TYPE_MANY      = 20,
-  MPC_TYPE_MANY1     = 21,
-  MPC_TYPE_COUNT     = 22,
-  
-  MPC_TYPE_OR        = 23,
-  MPC_TYPE_AND       = 24
-};
-
-typedef struct { char *m; } mpc_pdata_fail_t;
-typedef struct { mpc_ctor_t lf; void *x; } mpc_pdata_lift_t;
-typedef struct { mpc_parser_t *x; char *m; } mpc_pdata_expect_t;
-typedef struct { int(*f)(char,char); } mpc_pdata_anchor_t;
-typedef struct { char x; } mpc_pdata_single_t;
-typedef struct { char x; char y; } mpc_pdata_range_t;
-typedef struct { int(*f)(char); } mpc_pdata_satisfy_t;
-typedef struct { char *x; } mpc_pdata_string_t;
-typedef struct { mpc_parser_t *x; mpc_apply_t f; } mpc_pdata_apply_t;
-typedef struct { mpc_parser_t *x; mpc_apply_to_t f; void *d; } mpc_pdata_apply_to_t;
-typedef struct { mpc_parser_t *x; } mpc_pdata_predict_t;
-typedef struct { mpc_parser_t *x; mpc_dtor_t dx; mpc_ctor_t lf; } mpc_pdata_not_t;
-typedef struct { int n; mpc_fold_t f; mpc_parser_t *x; mpc_dtor_t dx; } mpc_pdata_repeat_t;
-typedef struct { int n; mpc_parser_t **xs; } mpc_pdata_or_t;
-typedef struct { int n; mpc_fold_t f; mpc_parser_t **xs; mpc_dtor_t *dxs;  } mpc_pdata_and_t;
-
-typedef union {
-  mpc_pdata_fail_t fail;
-  mpc_pdata_lift_t lift;
-  mpc_pdata_expect_t expect;
-  mpc_pdata_anchor_t anchor;
-  mpc_pdata_single_t single;
-  mpc_pdata_range_t range;
-  mpc_pdata_satisfy_t satisfy;
-  mpc_pdata_string_t string;
-  mpc_pdata_apply_t apply;
-  mpc_pdata_apply_to_t apply_to;
-  mpc_pdata_predict_t predict;
-  mpc_pdata_not_t not;
-  mpc_pdata_repeat_t repeat;
-  mpc_pdata_and_t and;
-  mpc_pdata_or_t or;
-} mpc_pdata_t;
-
-struct mpc_parser_t {
-  char *name;
-  mpc_pdata_t data;
-  char type;
-  char retained;
-};
-
-static mpc_val_t *mpcf_input_nth_free(mpc_input_t *i, int n, mpc_val_t **xs, int x) {
-  int j;
-  for (j = 0; j < n; j++) { if (j != x) { mpc_free(i, xs[j]); } }
-  return xs[x];
-}
- 
-static mpc_val_t *mpcf_input_fst_free(mpc_input_t *i, int n, mpc_val_t **xs) { return mpcf_input_nth_free(i, n, xs, 0); }
-static mpc_val_t *mpcf_input_snd_free(mpc_input_t *i, int n, mpc_val_t **xs) { return mpcf_input_nth_free(i, n, xs, 1); }
-static mpc_val_t *mpcf_input_trd_free(mpc_input_t *i, int n, mpc_val_t **xs) { return mpcf_input_nth_free(i, n, xs, 2); }
-
-static mpc_val_t *mpcf_input_strfold(mpc_input_t *i, int n, mpc_val_t **xs) {
-  int j;
-  size_t l = 0;
-  if (n == 0) { return mpc_calloc(i, 1, 1); }
-  for (j = 0; j < n; j++) { l += strlen(xs[j]); }
-  xs[0] = mpc_realloc(i, xs[0], l + 1);
-  for (j = 1; j < n; j++) { strcat(xs[0], xs[j]); mpc_free(i, xs[j]); }
-  return xs[0];
-}
-
-static mpc_val_t *mpcf_input_state_ast(mpc_input_t *i, int n, mpc_val_t **xs) {
-  mpc_state_t *s = ((mpc_state_t**)xs)[0];
-  mpc_ast_t *a = ((mpc_ast_t**)xs)[1];
-  a = mpc_ast_state(a, *s);
-  mpc_free(i, s);
-  (void) n;
-  return a;
-}
-
-static mpc_val_t *mpc_parse_fold(mpc_input_t *i, mpc_fold_t f, int n, mpc_val_t **xs) {
-  int j;
-  if (f == mpcf_null)      { return mpcf_null(n, xs); }
-  if (f == mpcf_fst)       { return mpcf_fst(n, xs); }
-  if (f == mpcf_snd)       { return mpcf_snd(n, xs); }
-  if (f == mpcf_trd)       { return mpcf_trd(n, xs); }
-  if (f == mpcf_fst_free)  { return mpcf_input_fst_free(i, n, xs); }
-  if (f == mpcf_snd_free)  { return mpcf_input_snd_free(i, n, xs); }
-  if (f == mpcf_trd_free)  { return mpcf_input_trd_free(i, n, xs); }
-  if (f == mpcf_strfold)   { return mpcf_input_strfold(i, n, xs); }
-  if (f == mpcf_state_ast) { return mpcf_input_state_ast(i, n, xs); }
-  for (j = 0; j < n; j++) { xs[j] = mpc_export(i, xs[j]); }
-  return f(j, xs);
-}
-
-static mpc_val_t *mpcf_input_free(mpc_input_t *i, mpc_val_t *x) {
-  mpc_free(i, x);
-  return NULL;
-}
-
-static mpc_val_t *mpcf_input_str_ast(mpc_input_t *i, mpc_val_t *c) {
-  mpc_ast_t *a = mpc_ast_new("", c);
-  mpc_free(i, c);
-  return a;
-}
-
-static mpc_val_t *mpc_parse_apply(mpc_input_t *i, mpc_apply_t f, mpc_val_t *x) {
-  if (f == mpcf_free)     { return mpcf_input_free(i, x); }
-  if (f == mpcf_str_ast)  { return mpcf_input_str_ast(i, x); }
-  return f(mpc_export(i, x));
-}
-
-static mpc_val_t *mpc_parse_apply_to(mpc_input_t *i, mpc_apply_to_t f, mpc_val_t *x, mpc_val_t *d) {
-  return f(mpc_export(i, x), d);
-}
-
-static void mpc_parse_dtor(mpc_input_t *i, mpc_dtor_t d, mpc_val_t *x) {
-  if (d == free) { mpc_free(i, x); return; }
-  d(mpc_export(i, x));
-}
-
-enum {
-  MPC_PARSE_STACK_MIN = 4
-};
-
-#define MPC_SUCCESS(x) r->output = x; return 1
-#define MPC_FAILURE(x) r->error = x; return 0
-#define MPC_PRIMITIVE(x) \
-  if (x) { MPC_SUCCESS(r->output); } \
-  else { MPC_FAILURE(NULL); }
-
-static int mpc_parse_run(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r, mpc_err_t **e) {
-  
-  int j = 0, k = 0;
-  mpc_result_t results_stk[MPC_PARSE_STACK_MIN];
-  mpc_result_t *results;
-  int results_slots = MPC_PARSE_STACK_MIN;
-  
-  switch (p->type) {
-      
-    /* Basic Parsers */
-
-    case MPC_TYPE_ANY:     MPC_PRIMITIVE(mpc_input_any(i, (char**)&r->output));
-    case MPC_TYPE_SINGLE:  MPC_PRIMITIVE(mpc_input_char(i, p->data.single.x, (char**)&r->output));
-    case MPC_TYPE_RANGE:   MPC_PRIMITIVE(mpc_input_range(i, p->data.range.x, p->data.range.y, (char**)&r->output));
-    case MPC_TYPE_ONEOF:   MPC_PRIMITIVE(mpc_input_oneof(i, p->data.string.x, (char**)&r->output));
-    case MPC_TYPE_NONEOF:  MPC_PRIMITIVE(mpc_input_noneof(i, p->data.string.x, (char**)&r->output));
-    case MPC_TYPE_SATISFY: MPC_PRIMITIVE(mpc_input_satisfy(i, p->data.satisfy.f, (char**)&r->output));
-    case MPC_TYPE_STRING:  MPC_PRIMITIVE(mpc_input_string(i, p->data.string.x, (char**)&r->output));
-    case MPC_TYPE_ANCHOR:  MPC_PRIMITIVE(mpc_input_anchor(i, p->data.anchor.f, (char**)&r->output));
-    
-    /* Other parsers */
-    
-    case MPC_TYPE_UNDEFINED: MPC_FAILURE(mpc_err_fail(i, "Parser Undefined!"));
-    case MPC_TYPE_PASS:      MPC_SUCCESS(NULL);
-    case MPC_TYPE_FAIL:      MPC_FAILURE(mpc_err_fail(i, p->data.fail.m));
-    case MPC_TYPE_LIFT:      MPC_SUCCESS(p->data.lift.lf());
-    case MPC_TYPE_LIFT_VAL:  MPC_SUCCESS(p->data.lift.x);
-    case MPC_TYPE_STATE:     MPC_SUCCESS(mpc_input_state_copy(i));
-    
-    /* Application Parsers */
-    
-    case MPC_TYPE_APPLY:
-      if (mpc_parse_run(i, p->data.apply.x, r, e)) {
-        MPC_SUCCESS(mpc_parse_apply(i, p->data.apply.f, r->output));
-      } else {
-        MPC_FAILURE(r->output);
-      }
-    
-    case MPC_TYPE_APPLY_TO:
-      if (mpc_parse_run(i, p->data.apply_to.x, r, e)) {
-        MPC_SUCCESS(mpc_parse_apply_to(i, p->data.apply_to.f, r->output, p->data.apply_to.d));
-      } else {
-        MPC_FAILURE(r->error);
-      }
-    
-    case MPC_TYPE_EXPECT:
-      mpc_input_suppress_enable(i);
-      if (mpc_parse_run(i, p->data.expect.x, r, e)) {
-        mpc_input_suppress_disable(i);
-        MPC_SUCCESS(r->output);
-      } else {
-        mpc_input_suppress_disable(i);
-        MPC_FAILURE(mpc_err_new(i, p->data.expect.m));
-      }
-    
-    case MPC_TYPE_PREDICT:
-      mpc_input_backtrack_disable(i);
-      if (mpc_parse_run(i, p->data.predict.x, r, e)) {      
-        mpc_input_backtrack_enable(i);
-        MPC_SUCCESS(r->output);
-      } else {
-        mpc_input_backtrack_enable(i);
-        MPC_FAILURE(r->error);
-      }
-    
-    /* Optional Parsers */
-    
-    /* TODO: Update Not Error Message */
-    
-    case MPC_TYPE_NOT:
-      mpc_input_mark(i);
-      mpc_input_suppress_enable(i);
-      if (mpc_parse_run(i, p->data.not.x, r, e)) {
-        mpc_input_rewind(i);
-        mpc_input_suppress_disable(i);
-        mpc_parse_dtor(i, p->data.not.dx, r->output);
-        MPC_FAILURE(mpc_err_new(i, "opposite"));
-      } else {
-        mpc_input_unmark(i);
-        mpc_input_suppress_disable(i);
-        MPC_SUCCESS(p->data.not.lf());
-      }
-    
-    case MPC_TYPE_MAYBE:
-      if (mpc_parse_run(i, p->data.not.x, r, e)) {
-        MPC_SUCCESS(r->output);
-      } else {
-        *e = mpc_err_merge(i, *e, r->error);
-        MPC_SUCCESS(p->data.not.lf());
-      }
-    
-    /* Repeat Parsers */
-    
-    case MPC_TYPE_MANY:
-      
-      results = results_stk;
-      
-      while (mpc_parse_run(i, p->data.repeat.x, &results[j], e)) {
-        j++;
-        if (j == MPC_PARSE_STACK_MIN) {
-          results_slots = j + j / 2;
-          results = mpc_malloc(i, sizeof(mpc_result_t) * results_slots);
-          memcpy(results, results_stk, sizeof(mpc_result_t) * MPC_PARSE_STACK_MIN);
-        } else if (j >= results_slots) {
-          results_slots = j + j / 2;
-          results = mpc_realloc(i, results, sizeof(mpc_result_t) * results_slots);
-        }
-      }
-      
-      *e = mpc_err_merge(i, *e, results[j].error);
-      MPC_SUCCESS(
-        mpc_parse_fold(i, p->data.repeat.f, j, (mpc_val_t**)results);
-        if (j >= MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-    
-    case MPC_TYPE_MANY1:
-      
-      results = results_stk;
-      
-      while (mpc_parse_run(i, p->data.repeat.x, &results[j], e)) {
-        j++;
-        if (j == MPC_PARSE_STACK_MIN) {
-          results_slots = j + j / 2;
-          results = mpc_malloc(i, sizeof(mpc_result_t) * results_slots);
-          memcpy(results, results_stk, sizeof(mpc_result_t) * MPC_PARSE_STACK_MIN);
-        } else if (j >= results_slots) {
-          results_slots = j + j / 2;
-          results = mpc_realloc(i, results, sizeof(mpc_result_t) * results_slots);
-        }
-      }
-      
-      if (j == 0) {
-        MPC_FAILURE(
-          mpc_err_many1(i, results[j].error);
-          if (j >= MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-      } else {
-        *e = mpc_err_merge(i, *e, results[j].error);
-        MPC_SUCCESS(
-          mpc_parse_fold(i, p->data.repeat.f, j, (mpc_val_t**)results);
-          if (j >= MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-      }
-    
-    case MPC_TYPE_COUNT:
-      
-      results = p->data.repeat.n > MPC_PARSE_STACK_MIN
-        ? mpc_malloc(i, sizeof(mpc_result_t) * p->data.repeat.n)
-        : results_stk;
-      
-      while (mpc_parse_run(i, p->data.repeat.x, &results[j], e)) {
-        j++;
-        if (j == p->data.repeat.n) { break; }
-      }
-      
-      if (j == p->data.repeat.n) {
-        MPC_SUCCESS(
-          mpc_parse_fold(i, p->data.repeat.f, j, (mpc_val_t**)results);
-          if (p->data.repeat.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-      } else {
-        for (k = 0; k < j; k++) {
-          mpc_parse_dtor(i, p->data.repeat.dx, results[k].output);
-        }
-        MPC_FAILURE(
-          mpc_err_count(i, results[j].error, p->data.repeat.n);
-          if (p->data.repeat.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });  
-      }
-      
-    /* Combinatory Parsers */
-    
-    case MPC_TYPE_OR:
-      
-      if (p->data.or.n == 0) { MPC_SUCCESS(NULL); }
-      
-      results = p->data.or.n > MPC_PARSE_STACK_MIN
-        ? mpc_malloc(i, sizeof(mpc_result_t) * p->data.or.n)
-        : results_stk;
-      
-      for (j = 0; j < p->data.or.n; j++) {
-        if (mpc_parse_run(i, p->data.or.xs[j], &results[j], e)) {
-          MPC_SUCCESS(results[j].output;
-            if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-        } else {
-          *e = mpc_err_merge(i, *e, results[j].error);
-        } 
-      }
-      
-      MPC_FAILURE(NULL;
-        if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-    
-    case MPC_TYPE_AND:
-      
-      if (p->data.and.n == 0) { MPC_SUCCESS(NULL); }
-      
-      results = p->data.or.n > MPC_PARSE_STACK_MIN
-        ? mpc_malloc(i, sizeof(mpc_result_t) * p->data.or.n)
-        : results_stk;
-      
-      mpc_input_mark(i);
-      for (j = 0; j < p->data.and.n; j++) {
-        if (!mpc_parse_run(i, p->data.and.xs[j], &results[j], e)) {
-          mpc_input_rewind(i);
-          for (k = 0; k < j; k++) {
-            mpc_parse_dtor(i, p->data.and.dxs[k], results[k].output);
-          }
-          MPC_FAILURE(results[j].error;
-            if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-        }
-      }
-      mpc_input_unmark(i); 
-      MPC_SUCCESS(
-        mpc_parse_fold(i, p->data.and.f, j, (mpc_val_t**)results);
-        if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
-    
-    /* End */
-    
-    default:
-      
-      MPC_FAILURE(mpc_err_fail(i, "Unknown Parser Type Id!"));
-  }
-  
-  return 0;
-  
-}
-
-#undef MPC_SUCCESS
-#undef MPC_FAILURE
-#undef MPC_PRIMITIVE
-
-int mpc_parse_input(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r) {
-  int x;
-  mpc_err_t *e = mpc_err_fail(i, "Unknown Error");
-  e->state = mpc_state_invalid();
-  x = mpc_parse_run(i, p, r, &e);
-  if (x) {
-    mpc_err_delete_internal(i, e);
-    r->output = mpc_export(i, r->output);
-  } else {
-    r->error = mpc_err_export(i, mpc_err_merge(i, e, r->error));
-  }
-  return x;
-}
-
-int mpc_parse(const char *filename, const char *string, mpc_parser_t *p, mpc_result_t *r) {
-  int x;
-  mpc_input_t *i = mpc_input_new_string(filename, string);
-  x = mpc_parse_input(i, p, r);
-  mpc_input_delete(i);
-  return x;
-}
-
-int mpc_nparse(const char *filename, const char *string, size_t length, mpc_parser_t *p, mpc_result_t *r) {
-  int x;
-  mpc_input_t *i = mpc_input_new_nstring(filename, string, length);
-  x = mpc_parse_input(i, p, r);
-  mpc_input_delete(i);
-  return x;
-}
-
-int mpc_parse_file(const char *filename, FILE *file, mpc_parser_t *p, mpc_result_t *r) {
-  int x;
-  mpc_input_t *i = mpc_input_new_file(filename, file);
-  x = mpc_parse_input(i, p, r);
-  mpc_input_delete(i);
-  return x;
-}
-
-int mpc_parse_pipe(const char *filename, FILE *pipe, mpc_parser_t *p, mpc_result_t *r) {
-  int x;
-  mpc_input_t *i = mpc_input_new_pipe(filename, pipe);
-  x = mpc_parse_input(i, p, r);
-  mpc_input_delete(i);
-  return x;
-}
-
-int mpc_parse_contents(const char *filename, mpc_parser_t *p, mpc_result_t *r) {
-  
-  FILE *f = fopen(filename, "rb");
-  int res;
-  
-  if (f == NULL) {
-    r->output = NULL;
-    r->error = mpc_err_file(filename, "Unable to open file!");
-    return 0;
-  }
-  
-  res = mpc_parse_file(filename, f, p, r);
-  fclose(f);
-  return res;
-}
-
-/*
-** Building a Parser
-*/
-
-static void mpc_undefine_unretained(mpc_parser_t *p, int force);
-
-static void mpc_undefine_or(mpc_parser_t *p) {
-  
-  int i;
-  for (i = 0; i < p->data.or.n; i++) {
-    mpc_undefine_unretained(p->data.or.xs[i], 0);
-  }
-  free(p->data.or.xs);
-  
-}
-
-static void mpc_undefine_and(mpc_parser_t *p) {
-  
-  int i;
-  for (i = 0; i < p->data.and.n; i++) {
-    mpc_undefine_unretained(p->data.and.xs[i], 0);
-  }
-  free(p->data.and.xs);
-  free(p->data.and.dxs);
-  
-}
-
-static void mpc_undefine_unretained(mpc_parser_t *p, int force) {
-  
-  if (p->retained && !force) { return; }
-  
-  switch (p->type) {
-    
-    case MPC_TYPE_FAIL: free(p->data.fail.m); break;
-    
-    case MPC_TYPE_ONEOF: 
-    case MPC_TYPE_NONEOF:
-    case MPC_TYPE_STRING:
-      free(p->data.string.x); 
-      break;
-    
-    case MPC_TYPE_APPLY:    mpc_undefine_unretained(p->data.apply.x, 0);    break;
-    case MPC_TYPE_APPLY_TO: mpc_undefine_unretained(p->data.apply_to.x, 0); break;
-    case MPC_TYPE_PREDICT:  mpc_undefine_unretained(p->data.predict.x, 0);  break;
-    
-    case MPC_TYPE_MAYBE:
-    case MPC_TYPE_NOT:
-      mpc_undefine_unretained(p->data.not.x, 0);
-      break;
-    
-    case MPC_TYPE_EXPECT:
-      mpc_undefine_unretained(p->data.expect.x, 0);
-      free(p->data.expect.m);
-      break;
-      
-    case MPC_TYPE_MANY:
-    case MPC_TYPE_MANY1:
-    case MPC_TYPE_COUNT:
-      mpc_undefine_unretained(p->data.repeat.x, 0);
-      break;
-    
-    case MPC_TYPE_OR:  mpc_undefine_or(p);  break;
-    case MPC_TYPE_AND: mpc_undefine_and(p); break;
-    
-    default: break;
-  }
-  
-  if (!force) {
-    free(p->name);
-    free(p);
-  }
-  
-}
-
-void mpc_delete(mpc_parser_t *p) {
-  if (p->retained) {
-
-    if (p->type != MPC_TYPE_UNDEFINED) {
-      mpc_undefine_unretained(p, 0);
-    } 
-    
-    free(p->name);
-    free(p);
-  
-  } else {
-    mpc_undefine_unretained(p, 0);  
-  }
-}
-
-static void mpc_soft_delete(mpc_val_t *x) {
-  mpc_undefine_unretained(x, 0);
-}
-
-static mpc_parser_t *mpc_undefined(void) {
-  mpc_parser_t *p = calloc(1, sizeof(mpc_parser_t));
-  p->retained = 0;
-  p->type = MPC_TYPE_UNDEFINED;
-  p->name = NULL;
-  return p;
-}
-
-mpc_parser_t *mpc_new(const char *name) {
-  mpc_parser_t *p = mpc_undefined();
-  p->retained = 1;
-  p->name = realloc(p->name, strlen(name) + 1);
-  strcpy(p->name, name);
-  return p;
-}
-
-mpc_parser_t *mpc_copy(mpc_parser_t *a) {
-  int i = 0;
-  mpc_parser_t *p;
-  
-  if (a->retained) { return a; }
-  
-  p = mpc_undefined();
-  p->retained = a->retained;
-  p->type = a->type;
-  p->data = a->data;
-  
-  if (a->name) {
-    p->name = malloc(strlen(a->name)+1);
-    strcpy(p->name, a->name);
-  }
-  
-  switch (a->type) {
-    
-    case MPC_TYPE_FAIL:
-      p->data.fail.m = malloc(strlen(a->data.fail.m)+1);
-      strcpy(p->data.fail.m, a->data.fail.m);
-    break;
-    
-    case MPC_TYPE_ONEOF: 
-    case MPC_TYPE_NONEOF:
-    case MPC_TYPE_STRING:
-      p->data.string.x = malloc(strlen(a->data.string.x)+1);
-      strcpy(p->data.string.x, a->data.string.x);
-      break;
-    
-    case MPC_TYPE_APPLY:    p->data.apply.x    = mpc_copy(a->data.apply.x);    break;
-    case MPC_TYPE_APPLY_TO: p->data.apply_to.x = mpc_copy(a->data.apply_to.x); break;
-    case MPC_TYPE_PREDICT:  p->data.predict.x  = mpc_copy(a->data.predict.x);  break;
-    
-    case MPC_TYPE_MAYBE:
-    case MPC_TYPE_NOT:
-      p->data.not.x = mpc_copy(a->data.not.x);
-      break;
-    
-    case MPC_TYPE_EXPECT:
-      p->data.expect.x = mpc_copy(a->data.expect.x);
-      p->data.expect.m = malloc(strlen(a->data.expect.m)+1);
-      strcpy(p->data.expect.m, a->data.expect.m);
-      break;
-      
-    case MPC_TYPE_MANY:
-    case MPC_TYPE_MANY1:
-    case MPC_TYPE_COUNT:
-      p->data.repeat.x = mpc_copy(a->data.repeat.x);
-      break;
-    
-    case MPC_TYPE_OR:
-      p->data.or.xs = malloc(a->data.or.n * sizeof(mpc_parser_t*));
-      for (i = 0; i < a->data.or.n; i++) {
-        p->data.or.xs[i] = mpc_copy(a->data.or.xs[i]);
-      }
-    break;
-    case MPC_TYPE_AND:
-      p->data.and.xs = malloc(a->data.and.n * sizeof(mpc_parser_t*));
-      for (i = 0; i < a->data.and.n; i++) {
-        p->data.and.xs[i] = mpc_copy(a->data.and.xs[i]);
-      }
-      p->data.and.dxs = malloc((a->data.and.n-1) * sizeof(mpc_dtor_t));
-      for (i = 0; i < a->data.and.n-1; i++) {
-        p->data.and.dxs[i] = a->data.and.dxs[i];
-      }
-    break;
-    
-    default: break;
-  }
-
-  
-  return p;
-}
-
-mpc_parser_t *mpc_undefine(mpc_parser_t *p) {
-  mpc_undefine_unretained(p, 1);
-  p->type = MPC_TYPE_UNDEFINED;
-  return p;
-}
-
-mpc_parser_t *mpc_define(mpc_parser_t *p, mpc_parser_t *a) {
-  
-  if (p->retained) {
-    p->type = a->type;
-    p->data = a->data;
-  } else {
-    mpc_parser_t *a2 = mpc_failf("Attempt to assign to Unretained Parser!");
-    p->type = a2->type;
-    p->data = a2->data;
-    free(a2);
-  }
-  
-  free(a);
-  return p;  
-}
-
-void mpc_cleanup(int n, ...) {
-  int i;
-  mpc_parser_t **list = malloc(sizeof(mpc_parser_t*) * n);
-  
-  va_list va;
-  va_start(va, n);
-  for (i = 0; i < n; i++) { list[i] = va_arg(va, mpc_parser_t*); }
-  for (i = 0; i < n; i++) { mpc_undefine(list[i]); }
-  for (i = 0; i < n; i++) { mpc_delete(list[i]); }  
-  va_end(va);  
-
-  free(list);
-}
-
-mpc_parser_t *mpc_pass(void) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_PASS;
-  return p;
-}
-
-mpc_parser_t *mpc_fail(const char *m) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_FAIL;
-  p->data.fail.m = malloc(strlen(m) + 1);
-  strcpy(p->data.fail.m, m);
-  return p;
-}
-
-/*
-** As `snprintf` is not ANSI standard this 
-** function `mpc_failf` should be considered
-** unsafe.
-**
-** You have a few options if this is going to be
-** trouble.
-**
-** - Ensure the format string does not exceed
-**   the buffer length using precision specifiers
-**   such as `%.512s`.
-**
-** - Patch this function in your code base to 
-**   use `snprintf` or whatever variant your
-**   system supports.
-**
-** - Avoid it altogether.
-**
-*/
-
-mpc_parser_t *mpc_failf(const char *fmt, ...) {
-  
-  va_list va;
-  char *buffer;
-
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_FAIL;
-  
-  va_start(va, fmt);
-  buffer = malloc(2048);
-  vsprintf(buffer, fmt, va);
-  va_end(va);
-  
-  buffer = realloc(buffer, strlen(buffer) + 1);
-  p->data.fail.m = buffer;
-  return p;
-
-}
-
-mpc_parser_t *mpc_lift_val(mpc_val_t *x) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_LIFT_VAL;
-  p->data.lift.x = x;
-  return p;
-}
-
-mpc_parser_t *mpc_lift(mpc_ctor_t lf) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_LIFT;
-  p->data.lift.lf = lf;
-  return p;
-}
-
-mpc_parser_t *mpc_anchor(int(*f)(char,char)) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_ANCHOR;
-  p->data.anchor.f = f;
-  return mpc_expect(p, "anchor");
-}
-
-mpc_parser_t *mpc_state(void) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_STATE;
-  return p;
-}
-
-mpc_parser_t *mpc_expect(mpc_parser_t *a, const char *expected) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_EXPECT;
-  p->data.expect.x = a;
-  p->data.expect.m = malloc(strlen(expected) + 1);
-  strcpy(p->data.expect.m, expected);
-  return p;
-}
-
-/*
-** As `snprintf` is not ANSI standard this 
-** function `mpc_expectf` should be considered
-** unsafe.
-**
-** You have a few options if this is going to be
-** trouble.
-**
-** - Ensure the format string does not exceed
-**   the buffer length using precision specifiers
-**   such as `%.512s`.
-**
-** - Patch this function in your code base to 
-**   use `snprintf` or whatever variant your
-**   system supports.
-**
-** - Avoid it altogether.
-**
-*/
-
-mpc_parser_t *mpc_expectf(mpc_parser_t *a, const char *fmt, ...) {
-  va_list va;
-  char *buffer;
-
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_EXPECT;
-  
-  va_start(va, fmt);
-  buffer = malloc(2048);
-  vsprintf(buffer, fmt, va);
-  va_end(va);
-  
-  buffer = realloc(buffer, strlen(buffer) + 1);
-  p->data.expect.x = a;
-  p->data.expect.m = buffer;
-  return p;
-}
-
-/*
-** Basic Parsers
-*/
-
-mpc_parser_t *mpc_any(void) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_ANY;
-  return mpc_expect(p, "any character");
-}
-
-mpc_parser_t *mpc_char(char c) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_SINGLE;
-  p->data.single.x = c;
-  return mpc_expectf(p, "'%c'", c);
-}
-
-mpc_parser_t *mpc_range(char s, char e) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_RANGE;
-  p->data.range.x = s;
-  p->data.range.y = e;
-  return mpc_expectf(p, "character between '%c' and '%c'", s, e);
-}
-
-mpc_parser_t *mpc_oneof(const char *s) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_ONEOF;
-  p->data.string.x = malloc(strlen(s) + 1);
-  strcpy(p->data.string.x, s);
-  return mpc_expectf(p, "one of '%s'", s);
-}
-
-mpc_parser_t *mpc_noneof(const char *s) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_NONEOF;
-  p->data.string.x = malloc(strlen(s) + 1);
-  strcpy(p->data.string.x, s);
-  return mpc_expectf(p, "none of '%s'", s);
-
-}
-
-mpc_parser_t *mpc_satisfy(int(*f)(char)) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_SATISFY;
-  p->data.satisfy.f = f;
-  return mpc_expectf(p, "character satisfying function %p", f);
-}
-
-mpc_parser_t *mpc_string(const char *s) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_STRING;
-  p->data.string.x = malloc(strlen(s) + 1);
-  strcpy(p->data.string.x, s);
-  return mpc_expectf(p, "\"%s\"", s);
-}
-
-/*
-** Core Parsers
-*/
-
-mpc_parser_t *mpc_apply(mpc_parser_t *a, mpc_apply_t f) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_APPLY;
-  p->data.apply.x = a;
-  p->data.apply.f = f;
-  return p;
-}
-
-mpc_parser_t *mpc_apply_to(mpc_parser_t *a, mpc_apply_to_t f, void *x) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_APPLY_TO;
-  p->data.apply_to.x = a;
-  p->data.apply_to.f = f;
-  p->data.apply_to.d = x;
-  return p;
-}
-
-mpc_parser_t *mpc_predictive(mpc_parser_t *a) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_PREDICT;
-  p->data.predict.x = a;
-  return p;
-}
-
-mpc_parser_t *mpc_not_lift(mpc_parser_t *a, mpc_dtor_t da, mpc_ctor_t lf) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_NOT;
-  p->data.not.x = a;
-  p->data.not.dx = da;
-  p->data.not.lf = lf;
-  return p;
-}
-
-mpc_parser_t *mpc_not(mpc_parser_t *a, mpc_dtor_t da) {
-  return mpc_not_lift(a, da, mpcf_ctor_null);
-}
-
-mpc_parser_t *mpc_maybe_lift(mpc_parser_t *a, mpc_ctor_t lf) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_MAYBE;
-  p->data.not.x = a;
-  p->data.not.lf = lf;
-  return p;
-}
-
-mpc_parser_t *mpc_maybe(mpc_parser_t *a) {
-  return mpc_maybe_lift(a, mpcf_ctor_null);
-}
-
-mpc_parser_t *mpc_many(mpc_fold_t f, mpc_parser_t *a) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_MANY;
-  p->data.repeat.x = a;
-  p->data.repeat.f = f;
-  return p;
-}
-
-mpc_parser_t *mpc_many1(mpc_fold_t f, mpc_parser_t *a) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_MANY1;
-  p->data.repeat.x = a;
-  p->data.repeat.f = f;
-  return p;
-}
-
-mpc_parser_t *mpc_count(int n, mpc_fold_t f, mpc_parser_t *a, mpc_dtor_t da) {
-  mpc_parser_t *p = mpc_undefined();
-  p->type = MPC_TYPE_COUNT;
-  p->data.repeat.n = n;
-  p->data.repeat.f = f;
-  p->data.repeat.x = a;
-  p->data.repeat.dx = da;
-  return p;
-}
-
-mpc_parser_t *mpc_or(int n, ...) {
-
-  int i;
-  va_list va;
-
-  mpc_parser_t *p = mpc_undefined();
-  
-  p->type = MPC_TYPE_OR;
-  p->data.or.n = n;
-  p->data.or.xs = malloc(sizeof(mpc_parser_t*) * n);
-  
-  va_start(va, n);  
-  for (i = 0; i < n; i++) {
-    p->data.or.xs[i] = va_arg(va, mpc_parser_t*);
-  }
-  va_end(va);
-  
-  return p;
-}
-
-mpc_parser_t *mpc_and(int n, mpc_fold_t f, ...) {
-
-  int i;
-  va_list va;
-
-  mpc_parser_t *p = mpc_undefined();
-  
-  p->type = MPC_TYPE_AND;
-  p->data.and.n = n;
-  p->data.and.f = f;
-  p->data.and.xs = malloc(sizeof(mpc_parser_t*) * n);
-  p->data.and.dxs = malloc(sizeof(mpc_dtor_t) * (n-1));
-
-  va_start(va, f);  
-  for (i = 0; i < n; i++) {
-    p->data.and.xs[i] = va_arg(va, mpc_parser_t*);
-  }
-  for (i = 0; i < (n-1); i++) {
-    p->data.and.dxs[i] = va_arg(va, mpc_dtor_t);
-  }  
-  va_end(va);
-  
-  return p;
-}
-
-/*
-** Common Parsers
-*/
-
-static int mpc_soi_anchor(char prev, char next) { (void) next; return (prev == '\0'); }
-static int mpc_eoi_anchor(char prev, char next) { (void) prev; return (next == '\0'); }
-
-mpc_parser_t *mpc_soi(void) { return mpc_expect(mpc_anchor(mpc_soi_anchor), "start of input"); }
-mpc_parser_t *mpc_eoi(void) { return mpc_expect(mpc_anchor(mpc_eoi_anchor), "end of input"); }
-
-static int mpc_boundary_anchor(char prev, char next) {
-  const char* word = "abcdefghijklmnopqrstuvwxyz"
-                     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-                     "0123456789_";
-  if ( strchr(word, next) &&  prev == '\0') { return 1; }
-  if ( strchr(word, prev) &&  next == '\0') { return 1; }
-  if ( strchr(word, next) && !strchr(word, prev)) { return 1; }
-  if (!strchr(word, next) &&  strchr(word, prev)) { return 1; }
-  return 0;
-}
-
-mpc_parser_t *mpc_boundary(void) { return mpc_expect(mpc_anchor(mpc_boundary_anchor), "boundary"); }
-
-mpc_parser_t *mpc_whitespace(void) { return mpc_expect(mpc_oneof(" \f\n\r\t\v"), "whitespace"); }
-mpc_parser_t *mpc_whitespaces(void) { return mpc_expect(mpc_many(mpcf_strfold, mpc_whitespace()), "spaces"); }
-mpc_parser_t *mpc_blank(void) { return mpc_expect(mpc_apply(mpc_whitespaces(), mpcf_free), "whitespace"); }
-
-mpc_parser_t *mpc_newline(void) { return mpc_expect(mpc_char('\n'), "newline"); }
-mpc_parser_t *mpc_tab(void) { return mpc_expect(mpc_char('\t'), "tab"); }
-mpc_parser_t *mpc_escape(void) { return mpc_and(2, mpcf_strfold, mpc_char('\\'), mpc_any(), free); }
-
-mpc_parser_t *mpc_digit(void) { return mpc_expect(mpc_oneof("0123456789"), "digit"); }
-mpc_parser_t *mpc_hexdigit(void) { return mpc_expect(mpc_oneof("0123456789ABCDEFabcdef"), "hex digit"); }
-mpc_parser_t *mpc_octdigit(void) { return mpc_expect(mpc_oneof("01234567"), "oct digit"); }
-mpc_parser_t *mpc_digits(void) { return mpc_expect(mpc_many1(mpcf_strfold, mpc_digit()), "digits"); }
-mpc_parser_t *mpc_hexdigits(void) { return mpc_expect(mpc_many1(mpcf_strfold, mpc_hexdigit()), "hex digits"); }
-mpc_parser_t *mpc_octdigits(void) { return mpc_expect(mpc_many1(mpcf_strfold, mpc_octdigit()), "oct digits"); }
-
-mpc_parser_t *mpc_lower(void) { return mpc_expect(mpc_oneof("abcdefghijklmnopqrstuvwxyz"), "lowercase letter"); }
-mpc_parser_t *mpc_upper(void) { return mpc_expect(mpc_oneof("ABCDEFGHIJKLMNOPQRSTUVWXYZ"), "uppercase letter"); }
-mpc_parser_t *mpc_alpha(void) { return mpc_expect(mpc_oneof("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"), "letter"); }
-mpc_parser_t *mpc_underscore(void) { return mpc_expect(mpc_char('_'), "underscore"); }
-mpc_parser_t *mpc_alphanum(void) { return mpc_expect(mpc_or(3, mpc_alpha(), mpc_digit(), mpc_underscore()), "alphanumeric"); }
-
-mpc_parser_t *mpc_int(void) { return mpc_expect(mpc_apply(mpc_digits(), mpcf_int), "integer"); }
-mpc_parser_t *mpc_hex(void) { return mpc_expect(mpc_apply(mpc_hexdigits(), mpcf_hex), "hexadecimal"); }
-mpc_parser_t *mpc_oct(void) { return mpc_expect(mpc_apply(mpc_octdigits(), mpcf_oct), "octadecimal"); }
-mpc_parser_t *mpc_number(void) { return mpc_expect(mpc_or(3, mpc_int(), mpc_hex(), mpc_oct()), "number"); }
-
-mpc_parser_t *mpc_real(void) {
-
-  /* [+-]?\d+(\.\d+)?([eE][+-]?[0-9]+)? */
-  
-  mpc_parser_t *p0, *p1, *p2, *p30, *p31, *p32, *p3;
-  
-  p0 = mpc_maybe_lift(mpc_oneof("+-"), mpcf_ctor_str);
-  p1 = mpc_digits();
-  p2 = mpc_maybe_lift(mpc_and(2, mpcf_strfold, mpc_char('.'), mpc_digits(), free), mpcf_ctor_str);
-  p30 = mpc_oneof("eE");
-  p31 = mpc_maybe_lift(mpc_oneof("+-"), mpcf_ctor_str);
-  p32 = mpc_digits();
-  p3 = mpc_maybe_lift(mpc_and(3, mpcf_strfold, p30, p31, p32, free, free), mpcf_ctor_str);
-  
-  return mpc_expect(mpc_and(4, mpcf_strfold, p0, p1, p2, p3, free, free, free), "real");
-
-}
-
-mpc_parser_t *mpc_float(void) {
-  return mpc_expect(mpc_apply(mpc_real(), mpcf_float), "float");
-}
-
-mpc_parser_t *mpc_char_lit(void) {
-  return mpc_expect(mpc_between(mpc_or(2, mpc_escape(), mpc_any()), free, "'", "'"), "char");
-}
-
-mpc_parser_t *mpc_string_lit(void) {
-  mpc_parser_t *strchar = mpc_or(2, mpc_escape(), mpc_noneof("\""));
-  return mpc_expect(mpc_between(mpc_many(mpcf_strfold, strchar), free, "\"", "\""), "string");
-}
-
-mpc_parser_t *mpc_regex_lit(void) {  
-  mpc_parser_t *regexchar = mpc_or(2, mpc_escape(), mpc_noneof("/"));
-  return mpc_expect(mpc_between(mpc_many(mpcf_strfold, regexchar), free, "/", "/"), "regex");
-}
-
-mpc_parser_t *mpc_ident(void) {
-  mpc_parser_t *p0, *p1; 
-  p0 = mpc_or(2, mpc_alpha(), mpc_underscore());
-  p1 = mpc_many(mpcf_strfold, mpc_alphanum()); 
-  return mpc_and(2, mpcf_strfold, p0, p1, free);
-}
-
-/*
-** Useful Parsers
-*/
-
-mpc_parser_t *mpc_startwith(mpc_parser_t *a) { return mpc_and(2, mpcf_snd, mpc_soi(), a, mpcf_dtor_null); }
-mpc_parser_t *mpc_endwith(mpc_parser_t *a, mpc_dtor_t da) { return mpc_and(2, mpcf_fst, a, mpc_eoi(), da); }
-mpc_parser_t *mpc_whole(mpc_parser_t *a, mpc_dtor_t da) { return mpc_and(3, mpcf_snd, mpc_soi(), a, mpc_eoi(), mpcf_dtor_null, da); }
-
-mpc_parser_t *mpc_stripl(mpc_parser_t *a) { return mpc_and(2, mpcf_snd, mpc_blank(), a, mpcf_dtor_null); }
-mpc_parser_t *mpc_stripr(mpc_parser_t *a) { return mpc_and(2, mpcf_fst, a, mpc_blank(), mpcf_dtor_null); }
-mpc_parser_t *mpc_strip(mpc_parser_t *a) { return mpc_and(3, mpcf_snd, mpc_blank(), a, mpc_blank(), mpcf_dtor_null, mpcf_dtor_null); }
-mpc_parser_t *mpc_tok(mpc_parser_t *a) { return mpc_and(2, mpcf_fst, a, mpc_blank(), mpcf_dtor_null); }
-mpc_parser_t *mpc_sym(const char *s) { return mpc_tok(mpc_string(s)); }
-
-mpc_parser_t *mpc_total(mpc_parser_t *a, mpc_dtor_t da) { return mpc_whole(mpc_strip(a), da); }
-
-mpc_parser_t *mpc_between(mpc_parser_t *a, mpc_dtor_t ad, const char *o, const char *c) {
-  return mpc_and(3, mpcf_snd_free,
-    mpc_string(o), a, mpc_string(c),
-    free, ad);
-}
-
-mpc_parser_t *mpc_parens(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_between(a, ad, "(", ")"); }
-mpc_parser_t *mpc_braces(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_between(a, ad, "<", ">"); }
-mpc_parser_t *mpc_brackets(mpc_parser_t *a, mpc_dtor_t ad) { return mpc_between(a, ad, "{", "}"); }
-mpc_parser_t *mpc_squares(mpc_parser_t *a, mpc_dtor_t ad)  { return mpc_between(a, ad, "[", "]"); }
-
-mpc_parser_t *mpc_tok_between(mpc_parser_t *a, mpc_dtor_t ad, const char *o, const char *c) {
-  return mpc_and(3, mpcf_snd_free,
-    mpc_sym(o), mpc_tok(a), mpc_sym(c),
-    free, ad);
-}
-
-mpc_parser_t *mpc_tok_parens(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_tok_between(a, ad, "(", ")"); }
-mpc_parser_t *mpc_tok_braces(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_tok_between(a, ad, "<", ">"); }
-mpc_parser_t *mpc_tok_brackets(mpc_parser_t *a, mpc_dtor_t ad) { return mpc_tok_between(a, ad, "{", "}"); }
-mpc_parser_t *mpc_tok_squares(mpc_parser_t *a, mpc_dtor_t ad)  { return mpc_tok_between(a, ad, "[", "]"); }
-
-/*
-** Regular Expression Parsers
-*/
-
-/*
-** So here is a cute bootstrapping.
-**
-** I'm using the previously defined
-** mpc constructs and functions to
-** parse the user regex string and
-** construct a parser from it.
-**
-** As it turns out lots of the standard
-** mpc functions look a lot like `fold`
-** functions and so can be used indirectly
-** by many of the parsing functions to build
-** a parser directly - as we are parsing.
-**
-** This is certainly something that
-** would be less elegant/interesting 
-** in a two-phase parser which first
-** builds an AST and then traverses it
-** to generate the object.
-**
-** This whole thing acts as a great
-** case study for how trivial it can be
-** to write a great parser in a few
-** lines of code using mpc.
-*/
-
-/*
-**
-**  ### Regular Expression Grammar
-**
-**      <regex> : <term> | (<term> "|" <regex>)
-**     
-**      <term> : <factor>*
-**
-**      <factor> : <base>
-**               | <base> "*"
-**               | <base> "+"
-**               | <base> "?"
-**               | <base> "{" <digits> "}"
-**           
-**      <base> : <char>
-**             | "\" <char>
-**             | "(" <regex> ")"
-**             | "[" <range> "]"
-*/
-
-static mpc_val_t *mpcf_re_or(int n, mpc_val_t **xs) {
-  (void) n;
-  if (xs[1] == NULL) { return xs[0]; }
-  else { return mpc_or(2, xs[0], xs[1]); }
-}
-
-static mpc_val_t *mpcf_re_and(int n, mpc_val_t **xs) {
-  int i;
-  mpc_parser_t *p = mpc_lift(mpcf_ctor_str);
-  for (i = 0; i < n; i++) {
-    p = mpc_and(2, mpcf_strfold, p, xs[i], free);
-  }
-  return p;
-}
-
-static mpc_val_t *mpcf_re_repeat(int n, mpc_val_t **xs) {
-  int num;
-  (void) n;
-  if (xs[1] == NULL) { return xs[0]; }
-  switch(((char*)xs[1])[0])
-  {
-    case '*': { free(xs[1]); return mpc_many(mpcf_strfold, xs[0]); }; break;
-    case '+': { free(xs[1]); return mpc_many1(mpcf_strfold, xs[0]); }; break;
-    case '?': { free(xs[1]); return mpc_maybe_lift(xs[0], mpcf_ctor_str); }; break;
-    default:
-      num = *(int*)xs[1];
-      free(xs[1]);
-  }
-  
-  return mpc_count(num, mpcf_strfold, xs[0], free);
-}
-
-static mpc_parser_t *mpc_re_escape_char(char c) {
-  switch (c) {
-    case 'a': return mpc_char('\a');
-    case 'f': return mpc_char('\f');
-    case 'n': return mpc_char('\n');
-    case 'r': return mpc_char('\r');
-    case 't': return mpc_char('\t');
-    case 'v': return mpc_char('\v');
-    case 'b': return mpc_and(2, mpcf_snd, mpc_boundary(), mpc_lift(mpcf_ctor_str), free);
-    case 'B': return mpc_not_lift(mpc_boundary(), free, mpcf_ctor_str);
-    case 'A': return mpc_and(2, mpcf_snd, mpc_soi(), mpc_lift(mpcf_ctor_str), free);
-    case 'Z': return mpc_and(2, mpcf_snd, mpc_eoi(), mpc_lift(mpcf_ctor_str), free);
-    case 'd': return mpc_digit();
-    case 'D': return mpc_not_lift(mpc_digit(), free, mpcf_ctor_str);
-    case 's': return mpc_whitespace();
-    case 'S': return mpc_not_lift(mpc_whitespace(), free, mpcf_ctor_str);
-    case 'w': return mpc_alphanum();
-    case 'W': return mpc_not_lift(mpc_alphanum(), free, mpcf_ctor_str);
-    default: return NULL;
-  }
-}
-
-static mpc_val_t *mpcf_re_escape(mpc_val_t *x) {
-  
-  char *s = x;
-  mpc_parser_t *p;
-  
-  /* Regex Special Characters */
-  if (s[0] == '.') { free(s); return mpc_any(); }
-  if (s[0] == '^') { free(s); return mpc_and(2, mpcf_snd, mpc_soi(), mpc_lift(mpcf_ctor_str), free); }
-  if (s[0] == '$') { free(s); return mpc_and(2, mpcf_snd, mpc_eoi(), mpc_lift(mpcf_ctor_str), free); }
-  
-  /* Regex Escape */
-  if (s[0] == '\\') {
-    p = mpc_re_escape_char(s[1]);
-    p = (p == NULL) ? mpc_char(s[1]) : p;
-    free(s);
-    return p;
-  }
-  
-  /* Regex Standard */
-  p = mpc_char(s[0]);
-  free(s);
-  return p;
-}
-
-static const char *mpc_re_range_escape_char(char c) {
-  switch (c) {
-    case '-': return "-";
-    case 'a': return "\a";
-    case 'f': return "\f";
-    case 'n': return "\n";
-    case 'r': return "\r";
-    case 't': return "\t";
-    case 'v': return "\v";
-    case 'b': return "\b";
-    case 'd': return "0123456789";
-    case 's': return " \f\n\r\t\v";
-    case 'w': return "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
-    default: return NULL;
-  }
-}
-
-static mpc_val_t *mpcf_re_range(mpc_val_t *x) {
-  
-  mpc_parser_t *out;
-  size_t i, j;
-  size_t start, end;
-  const char *tmp = NULL;
-  const char *s = x;
-  int comp = s[0] == '^' ? 1 : 0;
-  char *range = calloc(1,1);
-  
-  if (s[0] == '\0') { free(x); return mpc_fail("Invalid Regex Range Expression"); } 
-  if (s[0] == '^' && 
-      s[1] == '\0') { free(x); return mpc_fail("Invalid Regex Range Expression"); }
-  
-  for (i = comp; i < strlen(s); i++){
-    
-    /* Regex Range Escape */
-    if (s[i] == '\\') {
-      tmp = mpc_re_range_escape_char(s[i+1]);
-      if (tmp != NULL) {
-        range = realloc(range, strlen(range) + strlen(tmp) + 1);
-        strcat(range, tmp);
-      } else {
-        range = realloc(range, strlen(range) + 1 + 1);
-        range[strlen(range) + 1] = '\0';
-        range[strlen(range) + 0] = s[i+1];      
-      }
-      i++;
-    }
-    
-    /* Regex Range...Range */
-    else if (s[i] == '-') {
-      if (s[i+1] == '\0' || i == 0) {
-          range = realloc(range, strlen(range) + strlen("-") + 1);
-          strcat(range, "-");
-      } else {
-        start = s[i-1]+1;
-        end = s[i+1]-1;
-        for (j = start; j <= end; j++) {
-          range = realloc(range, strlen(range) + 1 + 1 + 1);
-          range[strlen(range) + 1] = '\0';
-          range[strlen(range) + 0] = (char)j;
-        }        
-      }
-    }
-    
-    /* Regex Range Normal */
-    else {
-      range = realloc(range, strlen(range) + 1 + 1);
-      range[strlen(range) + 1] = '\0';
-      range[strlen(range) + 0] = s[i];
-    }
-  
-  }
-  
-  out = comp == 1 ? mpc_noneof(range) : mpc_oneof(range);
-  
-  free(x);
-  free(range);
-  
-  return out;
-}
-
-mpc_parser_t *mpc_re(const char *re) {
-  
-  char *err_msg;
-  mpc_parser_t *err_out;
-  mpc_result_t r;
-  mpc_parser_t *Regex, *Term, *Factor, *Base, *Range, *RegexEnclose; 
-  
-  Regex  = mpc_new("regex");
-  Term   = mpc_new("term");
-  Factor = mpc_new("factor");
-  Base   = mpc_new("base");
-  Range  = mpc_new("range");
-  
-  mpc_define(Regex, mpc_and(2, mpcf_re_or,
-    Term, 
-    mpc_maybe(mpc_and(2, mpcf_snd_free, mpc_char('|'), Regex, free)),
-    (mpc_dtor_t)mpc_delete
-  ));
-  
-  mpc_define(Term, mpc_many(mpcf_re_and, Factor));
-  
-  mpc_define(Factor, mpc_and(2, mpcf_re_repeat,
-    Base,
-    mpc_or(5,
-      mpc_char('*'), mpc_char('+'), mpc_char('?'),
-      mpc_brackets(mpc_int(), free),
-      mpc_pass()),
-    (mpc_dtor_t)mpc_delete
-  ));
-  
-  mpc_define(Base, mpc_or(4,
-    mpc_parens(Regex, (mpc_dtor_t)mpc_delete),
-    mpc_squares(Range, (mpc_dtor_t)mpc_delete),
-    mpc_apply(mpc_escape(), mpcf_re_escape),
-    mpc_apply(mpc_noneof(")|"), mpcf_re_escape)
-  ));
-  
-  mpc_define(Range, mpc_apply(
-    mpc_many(mpcf_strfold, mpc_or(2, mpc_escape(), mpc_noneof("]"))),
-    mpcf_re_range
-  ));
-  
-  RegexEnclose = mpc_whole(mpc_predictive(Regex), (mpc_dtor_t)mpc_delete);
-  
-  mpc_optimise(RegexEnclose);
-  mpc_optimise(Regex);
-  mpc_optimise(Term);
-  mpc_optimise(Factor);
-  mpc_optimise(Base);
-  mpc_optimise(Range);
-  
-  if(!mpc_parse("<mpc_re_compiler>", re, RegexEnclose, &r)) {
-    err_msg = mpc_err_string(r.error);
-    err_out = mpc_failf("Invalid Regex: %s", err_msg);
-    mpc_err_delete(r.error);  
-    free(err_msg);
-    r.output = err_out;
-  }
-  
-  mpc_cleanup(6, RegexEnclose, Regex, Term, Factor, Base, Range);
-  
-  mpc_optimise(r.output);
-  
-  return r.output;
-  
-}
-
-/*
-** Common Fold Functions
-*/
-
-void mpcf_dtor_null(mpc_val_t *x) { (void) x; return; }
-
-mpc_val_t *mpcf_ctor_null(void) { return NULL; }
-mpc_val_t *mpcf_ctor_str(void) { return calloc(1, 1); }
-mpc_val_t *mpcf_free(mpc_val_t *x) { free(x); return NULL; }
-
-mpc_val_t *mpcf_int(mpc_val_t *x) {
-  int *y = malloc(sizeof(int));
-  *y = strtol(x, NULL, 10);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_hex(mpc_val_t *x) {
-  int *y = malloc(sizeof(int));
-  *y = strtol(x, NULL, 16);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_oct(mpc_val_t *x) {
-  int *y = malloc(sizeof(int));
-  *y = strtol(x, NULL, 8);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_float(mpc_val_t *x) {
-  float *y = malloc(sizeof(float));
-  *y = strtod(x, NULL);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_strtriml(mpc_val_t *x) {
-  char *s = x;
-  while (isspace(*s)) {
-    memmove(s, s+1, strlen(s));
-  }
-  return s;
-}
-
-mpc_val_t *mpcf_strtrimr(mpc_val_t *x) {
-  char *s = x;
-  size_t l = strlen(s);
-  while (isspace(s[l-1])) {
-    s[l-1] = '\0'; l--;
-  }
-  return s;
-}
-
-mpc_val_t *mpcf_strtrim(mpc_val_t *x) {
-  return mpcf_strtriml(mpcf_strtrimr(x));
-}
-
-static const char mpc_escape_input_c[]  = {
-  '\a', '\b', '\f', '\n', '\r',
-  '\t', '\v', '\\', '\'', '\"', '\0'};
-    
-static const char *mpc_escape_output_c[] = {
-  "\\a", "\\b", "\\f", "\\n", "\\r", "\\t", 
-  "\\v", "\\\\", "\\'", "\\\"", "\\0", NULL};
-
-static const char mpc_escape_input_raw_re[] = { '/' };
-static const char *mpc_escape_output_raw_re[] = { "\\/", NULL };
-
-static const char mpc_escape_input_raw_cstr[] = { '"' };
-static const char *mpc_escape_output_raw_cstr[] = { "\\\"", NULL };
-
-static const char mpc_escape_input_raw_cchar[] = { '\'' };
-static const char *mpc_escape_output_raw_cchar[] = { "\\'", NULL };
-
-static mpc_val_t *mpcf_escape_new(mpc_val_t *x, const char *input, const char **output) {
-  
-  int i;
-  int found;
-  char buff[2];
-  char *s = x;
-  char *y = calloc(1, 1);
-  
-  while (*s) {
-    
-    i = 0;
-    found = 0;
-
-    while (output[i]) {
-      if (*s == input[i]) {
-        y = realloc(y, strlen(y) + strlen(output[i]) + 1);
-        strcat(y, output[i]);
-        found = 1;
-        break;
-      }
-      i++;
-    }
-    
-    if (!found) {
-      y = realloc(y, strlen(y) + 2);
-      buff[0] = *s; buff[1] = '\0';
-      strcat(y, buff);
-    }
-    
-    s++;
-  }
-  
-  
-  return y;
-}
-
-static mpc_val_t *mpcf_unescape_new(mpc_val_t *x, const char *input, const char **output) {
-  
-  int i;
-  int found = 0;
-  char buff[2];
-  char *s = x;
-  char *y = calloc(1, 1);
-  
-  while (*s) {
-    
-    i = 0;
-    found = 0;
-    
-    while (output[i]) {
-      if ((*(s+0)) == output[i][0] &&
-          (*(s+1)) == output[i][1]) {
-        y = realloc(y, strlen(y) + 1 + 1);
-        buff[0] = input[i]; buff[1] = '\0';
-        strcat(y, buff);
-        found = 1;
-        s++;
-        break;
-      }
-      i++;
-    }
-    
-    if (!found) {
-      y = realloc(y, strlen(y) + 1 + 1);
-      buff[0] = *s; buff[1] = '\0';
-      strcat(y, buff);
-    }
-    
-    if (*s == '\0') { break; }
-    else { s++; }
-  }
-  
-  return y;
-  
-}
-
-mpc_val_t *mpcf_escape(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_c, mpc_escape_output_c);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_unescape(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_c, mpc_escape_output_c);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_escape_regex(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_raw_re, mpc_escape_output_raw_re);
-  free(x);
-  return y;  
-}
-
-mpc_val_t *mpcf_unescape_regex(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_raw_re, mpc_escape_output_raw_re);
-  free(x);
-  return y;  
-}
-
-mpc_val_t *mpcf_escape_string_raw(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_raw_cstr, mpc_escape_output_raw_cstr);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_unescape_string_raw(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_raw_cstr, mpc_escape_output_raw_cstr);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_escape_char_raw(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_raw_cchar, mpc_escape_output_raw_cchar);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_unescape_char_raw(mpc_val_t *x) {
-  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_raw_cchar, mpc_escape_output_raw_cchar);
-  free(x);
-  return y;
-}
-
-mpc_val_t *mpcf_null(int n, mpc_val_t** xs) { (void) n; (void) xs; return NULL; }
-mpc_val_t *mpcf_fst(int n, mpc_val_t **xs) { (void) n; return xs[0]; }
-mpc_val_t *mpcf_snd(int n, mpc_val_t **xs) { (void) n; return xs[1]; }
-mpc_val_t *mpcf_trd(int n, mpc_val_t **xs) { (void) n; return xs[2]; }
-
-static mpc_val_t *mpcf_nth_free(int n, mpc_val_t **xs, int x) {
-  int i;
-  for (i = 0; i < n; i++) {
-    if (i != x) { free(xs[i]); }
-  }
-  return xs[x];
-}
- 
-mpc_val_t *mpcf_fst_free(int n, mpc_val_t **xs) { return mpcf_nth_free(n, xs, 0); }
-mpc_val_t *mpcf_snd_free(int n, mpc_val_t **xs) { return mpcf_nth_free(n, xs, 1); }
-mpc_val_t *mpcf_trd_free(int n, mpc_val_t **xs) { return mpcf_nth_free(n, xs, 2); }
-
-mpc_val_t *mpcf_strfold(int n, mpc_val_t **xs) {
-  int i;
-  size_t l = 0;
-  
-  if (n == 0) { return calloc(1, 1); }
-  
-  for (i = 0; i < n; i++) { l += strlen(xs[i]); }
-  
-  xs[0] = realloc(xs[0], l + 1);
-  
-  for (i = 1; i < n; i++) {
-    strcat(xs[0], xs[i]); free(xs[i]);
-  }
-  
-  return xs[0];
-}
-
-mpc_val_t *mpcf_maths(int n, mpc_val_t **xs) {
-  int **vs = (int**)xs;
-  (void) n;
-  
-  switch(((char*)xs[1])[0])
-  {
-    case '*': { *vs[0] *= *vs[2]; }; break;
-    case '/': { *vs[0] /= *vs[2]; }; break;
-    case '%': { *vs[0] %= *vs[2]; }; break;
-    case '+': { *vs[0] += *vs[2]; }; break;
-    case '-': { *vs[0] -= *vs[2]; }; break;
-    default: break;
-  }
-  
-  free(xs[1]); free(xs[2]);
-  
-  return xs[0];
-}
-
-/*
-** Printing
-*/
-
-static void mpc_print_unretained(mpc_parser_t *p, int force) {
-  
-  /* TODO: Print Everything Escaped */
-  
-  int i;
-  char *s, *e;
-  char buff[2];
-  
-  if (p->retained && !force) {;
-    if (p->name) { printf("<%s>", p->name); }
-    else { printf("<anon>"); }
-    return;
-  }
-  
-  if (p->type == MPC_TYPE_UNDEFINED) { printf("<?>"); }
-  if (p->type == MPC_TYPE_PASS)   { printf("<:>"); }
-  if (p->type == MPC_TYPE_FAIL)   { printf("<!>"); }
-  if (p->type == MPC_TYPE_LIFT)   { printf("<#>"); }
-  if (p->type == MPC_TYPE_STATE)  { printf("<S>"); }
-  if (p->type == MPC_TYPE_ANCHOR) { printf("<@>"); }
-  if (p->type == MPC_TYPE_EXPECT) {
-    printf("%s", p->data.expect.m);
-    /*mpc_print_unretained(p->data.expect.x, 0);*/
-  }
-  
-  if (p->type == MPC_TYPE_ANY) { printf("<.>"); }
-  if (p->type == MPC_TYPE_SATISFY) { printf("<f>"); }
-
-  if (p->type == MPC_TYPE_SINGLE) {
-    buff[0] = p->data.single.x; buff[1] = '\0';
-    s = mpcf_escape_new(
-      buff,
-      mpc_escape_input_c,
-      mpc_escape_output_c);
-    printf("'%s'", s);
-    free(s);
-  }
-  
-  if (p->type == MPC_TYPE_RANGE) {
-    buff[0] = p->data.range.x; buff[1] = '\0';
-    s = mpcf_escape_new(
-      buff,
-      mpc_escape_input_c,
-      mpc_escape_output_c);
-    buff[0] = p->data.range.y; buff[1] = '\0';
-    e = mpcf_escape_new(
-      buff,
-      mpc_escape_input_c,
-      mpc_escape_output_c);
-    printf("[%s-%s]", s, e);
-    free(s);
-    free(e);
-  }
-  
-  if (p->type == MPC_TYPE_ONEOF) {
-    s = mpcf_escape_new(
-      p->data.string.x,
-      mpc_escape_input_c,
-      mpc_escape_output_c);
-    printf("[%s]", s);
-    free(s);
-  }
-  
-  if (p->type == MPC_TYPE_NONEOF) {
-    s = mpcf_escape_new(
-      p->data.string.x,
-      mpc_escape_input_c,
-      mpc_escape_output_c);
-    printf("[^%s]", s);
-    free(s);
-  }
-  
-  if (p->type == MPC_TYPE_STRING) {
-    s = mpcf_escape_new(
-      p->data.string.x,
-      mpc_escape_input_c,
-      mpc_escape_output_c);
-    printf("\"%s\"", s);
-    free(s);
-  }
-  
-  if (p->type == MPC_TYPE_APPLY)    { mpc_print_unretained(p->data.apply.x, 0); }
-  if (p->type == MPC_TYPE_APPLY_TO) { mpc_print_unretained(p->data.apply_to.x, 0); }
-  if (p->type == MPC_TYPE_PREDICT)  { mpc_print_unretained(p->data.predict.x, 0); }
-
-  if (p->type == MPC_TYPE_NOT)   { mpc_print_unretained(p->data.not.x, 0); printf("!"); }
-  if (p->type == MPC_TYPE_MAYBE) { mpc_print_unretained(p->data.not.x, 0); printf("?"); }
-
-  if (p->type == MPC_TYPE_MANY)  { mpc_print_unretained(p->data.repeat.x, 0); printf("*"); }
-  if (p->type == MPC_TYPE_MANY1) { mpc_print_unretained(p->data.repeat.x, 0); printf("+"); }
-  if (p->type == MPC_TYPE_COUNT) { mpc_print_unretained(p->data.repeat.x, 0); printf("{%i}", p->data.repeat.n); }
-  
-  if (p->type == MPC_TYPE_OR) {
-    printf("(");
-    for(i = 0; i < p->data.or.n-1; i++) {
-      mpc_print_unretained(p->data.or.xs[i], 0);
-      printf(" | ");
-    }
-    mpc_print_unretained(p->data.or.xs[p->data.or.n-1], 0);
-    printf(")");
-  }
-  
-  if (p->type == MPC_TYPE_AND) {
-    printf("(");
-    for(i = 0; i < p->data.and.n-1; i++) {
-      mpc_print_unretained(p->data.and.xs[i], 0);
-      printf(" ");
-    }
-    mpc_print_unretained(p->data.and.xs[p->data.and.n-1], 0);
-    printf(")");
-  }
-  
-}
-
-void mpc_print(mpc_parser_t *p) {
-  mpc_print_unretained(p, 1);
-  printf("\n");
-}
-
-/*
-** Testing
-*/
-
-/*
-** These functions are slightly unwieldy and
-** also the whole of the testing suite for mpc
-** mpc is pretty shaky.
-**
-** It could do with a lot more tests and more
-** precision. Currently I am only really testing
-** changes off of the examples.
-**
-*/
-
-int mpc_test_fail(mpc_parser_t *p, const char *s, const void *d,
-  int(*tester)(const void*, const void*),
-  mpc_dtor_t destructor,
-  void(*printer)(const void*)) {
-  mpc_result_t r;
-  (void) printer;
-  if (mpc_parse("<test>", s, p, &r)) {
-
-    if (tester(r.output, d)) {
-      destructor(r.output);
-      return 0;
-    } else {
-      destructor(r.output);
-      return 1;
-    }
-  
-  } else {
-    mpc_err_delete(r.error);
-    return 1;
-  }
-  
-}
-
-int mpc_test_pass(mpc_parser_t *p, const char *s, const void *d,
-  int(*tester)(const void*, const void*), 
-  mpc_dtor_t destructor, 
-  void(*printer)(const void*)) {
-
-  mpc_result_t r;  
-  if (mpc_parse("<test>", s, p, &r)) {
-    
-    if (tester(r.output, d)) {
-      destructor(r.output);
-      return 1;
-    } else {
-      printf("Got "); printer(r.output); printf("\n");
-      printf("Expected "); printer(d); printf("\n");
-      destructor(r.output);
-      return 0;
-    }
-    
-  } else {    
-    mpc_err_print(r.error);
-    mpc_err_delete(r.error);
-    return 0;
-    
-  }
-  
-}
-
-
-/*
-** AST
-*/
-
-void mpc_ast_delete(mpc_ast_t *a) {
-  
-  int i;
-  
-  if (a == NULL) { return; }
-  
-  for (i = 0; i < a->children_num; i++) {
-    mpc_ast_delete(a->children[i]);
-  }
-  
-  free(a->children);
-  free(a->tag);
-  free(a->contents);
-  free(a);
-  
-}
-
-static void mpc_ast_delete_no_children(mpc_ast_t *a) {
-  free(a->children);
-  free(a->tag);
-  free(a->contents);
-  free(a);
-}
-
-mpc_ast_t *mpc_ast_new(const char *tag, const char *contents) {
-  
-  mpc_ast_t *a = malloc(sizeof(mpc_ast_t));
-  
-  a->tag = malloc(strlen(tag) + 1);
-  strcpy(a->tag, tag);
-  
-  a->contents = malloc(strlen(contents) + 1);
-  strcpy(a->contents, contents);
-  
-  a->state = mpc_state_new();
-  
-  a->children_num = 0;
-  a->children = NULL;
-  return a;
-  
-}
-
-mpc_ast_t *mpc_ast_build(int n, const char *tag, ...) {
-  
-  mpc_ast_t *a = mpc_ast_new(tag, "");
-  
-  int i;
-  va_list va;
-  va_start(va, tag);
-  
-  for (i = 0; i < n; i++) {
-    mpc_ast_add_child(a, va_arg(va, mpc_ast_t*));
-  }
-  
-  va_end(va);
-  
-  return a;
-  
-}
-
-mpc_ast_t *mpc_ast_add_root(mpc_ast_t *a) {
-
-  mpc_ast_t *r;
-
-  if (a == NULL) { return a; }
-  if (a->children_num == 0) { return a; }
-  if (a->children_num == 1) { return a; }
-
-  r = mpc_ast_new(">", "");
-  mpc_ast_add_child(r, a);
-  return r;
-}
-
-int mpc_ast_eq(mpc_ast_t *a, mpc_ast_t *b) {
-  
-  int i;
-
-  if (strcmp(a->tag, b->tag) != 0) { return 0; }
-  if (strcmp(a->contents, b->contents) != 0) { return 0; }
-  if (a->children_num != b->children_num) { return 0; }
-  
-  for (i = 0; i < a->children_num; i++) {
-    if (!mpc_ast_eq(a->children[i], b->children[i])) { return 0; }
-  }
-  
-  return 1;
-}
-
-mpc_ast_t *mpc_ast_add_child(mpc_ast_t *r, mpc_ast_t *a) {
-  r->children_num++;
-  r->children = realloc(r->children, sizeof(mpc_ast_t*) * r->children_num);
-  r->children[r->children_num-1] = a;
-  return r;
-}
-
-mpc_ast_t *mpc_ast_add_tag(mpc_ast_t *a, const char *t) {
-  if (a == NULL) { return a; }
-  a->tag = realloc(a->tag, strlen(t) + 1 + strlen(a->tag) + 1);
-  memmove(a->tag + strlen(t) + 1, a->tag, strlen(a->tag)+1);
-  memmove(a->tag, t, strlen(t));
-  memmove(a->tag + strlen(t), "|", 1);
-  return a;
-}
-
-mpc_ast_t *mpc_ast_add_root_tag(mpc_ast_t *a, const char *t) {
-  if (a == NULL) { return a; }
-  a->tag = realloc(a->tag, (strlen(t)-1) + strlen(a->tag) + 1);
-  memmove(a->tag + (strlen(t)-1), a->tag, strlen(a->tag)+1);
-  memmove(a->tag, t, (strlen(t)-1));
-  return a;
-}
-
-mpc_ast_t *mpc_ast_tag(mpc_ast_t *a, const char *t) {
-  a->tag = realloc(a->tag, strlen(t) + 1);
-  strcpy(a->tag, t);
-  return a;
-}
-
-mpc_ast_t *mpc_ast_state(mpc_ast_t *a, mpc_state_t s) {
-  if (a == NULL) { return a; }
-  a->state = s;
-  return a;
-}
-
-static void mpc_ast_print_depth(mpc_ast_t *a, int d, FILE *fp) {
-  
-  int i;
-  
-  if (a == NULL) {
-    fprintf(fp, "NULL\n");
-    return;
-  }
-  
-  for (i = 0; i < d; i++) { fprintf(fp, "  "); }
-  
-  if (strlen(a->contents)) {
-    fprintf(fp, "%s:%lu:%lu '%s'\n", a->tag, 
-      (long unsigned int)(a->state.row+1),
-      (long unsigned int)(a->state.col+1),
-      a->contents);
-  } else {
-    fprintf(fp, "%s \n", a->tag);
-  }
-  
-  for (i = 0; i < a->children_num; i++) {
-    mpc_ast_print_depth(a->children[i], d+1, fp);
-  }
-  
-}
-
-void mpc_ast_print(mpc_ast_t *a) {
-  mpc_ast_print_depth(a, 0, stdout);
-}
-
-void mpc_ast_print_to(mpc_ast_t *a, FILE *fp) {
-  mpc_ast_print_depth(a, 0, fp);
-}
-
-int mpc_ast_get_index(mpc_ast_t *ast, const char *tag) {
-  return mpc_ast_get_index_lb(ast, tag, 0);
-}
-
-int mpc_ast_get_index_lb(mpc_ast_t *ast, const char *tag, int lb) {
-  int i;
-
-  for(i=lb; i<ast->children_num; i++) {
-    if(strcmp(ast->children[i]->tag, tag) == 0) {
-      return i;
-    }
-  }
-
-  return -1;
-}
-
-mpc_ast_t *mpc_ast_get_child(mpc_ast_t *ast, const char *tag) {
-  return mpc_ast_get_child_lb(ast, tag, 0);
-}
-
-mpc_ast_t *mpc_ast_get_child_lb(mpc_ast_t *ast, const char *tag, int lb) {
-  int i;
-
-  for(i=lb; i<ast->children_num; i++) {
-    if(strcmp(ast->children[i]->tag, tag) == 0) {
-      return ast->children[i];
-    }
-  }
-
-  return NULL;
-}
-
-mpc_ast_trav_t *mpc_ast_traverse_start(mpc_ast_t *ast,
-                                       mpc_ast_trav_order_t order)
-{
-  mpc_ast_trav_t *trav, *n_trav;
-  mpc_ast_t *cnode = ast;
-
-  /* Create the traversal structure */
-  trav = malloc(sizeof(mpc_ast_trav_t));
-  trav->curr_node = cnode;
-  trav->parent = NULL;
-  trav->curr_child = 0;
-  trav->order = order;
-
-  /* Get start node */
-  switch(order) {
-    case mpc_ast_trav_order_pre:
-      /* Nothing else is needed for pre order start */
-      break;
-
-    case mpc_ast_trav_order_post:
-      while(cnode->children_num > 0) {
-        cnode = cnode->children[0];
-
-        n_trav = malloc(sizeof(mpc_ast_trav_t));
-        n_trav->curr_node = cnode;
-        n_trav->parent = trav;
-        n_trav->curr_child = 0;
-        n_trav->order = order;
-
-        trav = n_trav;
-      }
-
-      break;
-
-    default:
-      /* Unreachable, but compiler complaints */
-      break;
-  }
-
-  return trav;
-}
-
-mpc_ast_t *mpc_ast_traverse_next(mpc_ast_trav_t **trav) {
-  mpc_ast_trav_t *n_trav, *to_free;
-  mpc_ast_t *ret = NULL;
-  int cchild;
-
-  /* The end of traversal was reached */
-  if(*trav == NULL) return NULL;
-
-  switch((*trav)->order) {
-    case mpc_ast_trav_order_pre:
-      ret = (*trav)->curr_node;
-
-      /* If there aren't any more children, go up */
-      while(*trav != NULL &&
-        (*trav)->curr_child >= (*trav)->curr_node->children_num)
-      {
-        to_free = *trav;
-        *trav = (*trav)->parent;
-        free(to_free);
-      }
-
-      /* If trav is NULL, the end was reached */
-      if(*trav == NULL) {
-        break;
-      }
-
-      /* Go to next child */
-      n_trav = malloc(sizeof(mpc_ast_trav_t));
-
-      cchild = (*trav)->curr_child;
-      n_trav->curr_node = (*trav)->curr_node->children[cchild];
-      n_trav->parent = *trav;
-      n_trav->curr_child = 0;
-      n_trav->order = (*trav)->order;
-
-      (*trav)->curr_child++;
-      *trav = n_trav;
-
-      break;
-
-    case mpc_ast_trav_order_post:
-      ret = (*trav)->curr_node;
-
-      /* Move up tree to the parent If the parent doesn't have any more nodes,
-       * then this is the current node. If it does, move down to its left most
-       * child. Also, free the previous traversal node */
-      to_free = *trav;
-      *trav = (*trav)->parent;
-      free(to_free);
-
-      if(*trav == NULL)
-        break;
-
-      /* Next child */
-      (*trav)->curr_child++;
-
-      /* If there aren't any more children, this is the next node */
-      if((*trav)->curr_child >= (*trav)->curr_node->children_num) {
-        break;
-      }
-
-      /* If there are still more children, find the leftmost child from this
-       * node */
-      while((*trav)->curr_node->children_num > 0) {
-        n_trav = malloc(sizeof(mpc_ast_trav_t));
-
-        cchild = (*trav)->curr_child;
-        n_trav->curr_node = (*trav)->curr_node->children[cchild];
-        n_trav->parent = *trav;
-        n_trav->curr_child = 0;
-        n_trav->order = (*trav)->order;
-
-        *trav = n_trav;
-      }
-
-    default:
-      /* Unreachable, but compiler complaints */
-      break;
-  }
-
-  return ret;
-}
-
-void mpc_ast_traverse_free(mpc_ast_trav_t **trav) {
-  mpc_ast_trav_t *n_trav;
-
-  /* Go through parents until all are free */
-  while(*trav != NULL) {
-      n_trav = (*trav)->parent;
-      free(*trav);
-      *trav = n_trav;
-  }
-}
-
-mpc_val_t *mpcf_fold_ast(int n, mpc_val_t **xs) {
-  
-  int i, j;
-  mpc_ast_t** as = (mpc_ast_t**)xs;
-  mpc_ast_t *r;
-  
-  if (n == 0) { return NULL; }
-  if (n == 1) { return xs[0]; }
-  if (n == 2 && xs[1] == NULL) { return xs[0]; }
-  if (n == 2 && xs[0] == NULL) { return xs[1]; }
-  
-  r = mpc_ast_new(">", "");
-  
-  for (i = 0; i < n; i++) {
-    
-    if (as[i] == NULL) { continue; }
-    
-    if        (as[i] && as[i]->children_num == 0) {
-      mpc_ast_add_child(r, as[i]);
-    } else if (as[i] && as[i]->children_num == 1) {
-      mpc_ast_add_child(r, mpc_ast_add_root_tag(as[i]->children[0], as[i]->tag));
-      mpc_ast_delete_no_children(as[i]);
-    } else if (as[i] && as[i]->children_num >= 2) {
-      for (j = 0; j < as[i]->children_num; j++) {
-        mpc_ast_add_child(r, as[i]->children[j]);
-      }
-      mpc_ast_delete_no_children(as[i]);
-    }
-  
-  }
-  
-  if (r->children_num) {
-    r->state = r->children[0]->state;
-  }
-  
-  return r;
-}
-
-mpc_val_t *mpcf_str_ast(mpc_val_t *c) {
-  mpc_ast_t *a = mpc_ast_new("", c);
-  free(c);
-  return a;
-}
-
-mpc_val_t *mpcf_state_ast(int n, mpc_val_t **xs) {
-  mpc_state_t *s = ((mpc_state_t**)xs)[0];
-  mpc_ast_t *a = ((mpc_ast_t**)xs)[1];
-  (void)n;
-  a = mpc_ast_state(a, *s);
-  free(s);
-  return a;
-}
-
-mpc_parser_t *mpca_state(mpc_parser_t *a) {
-  return mpc_and(2, mpcf_state_ast, mpc_state(), a, free);
-}
-
-mpc_parser_t *mpca_tag(mpc_parser_t *a, const char *t) {
-  return mpc_apply_to(a, (mpc_apply_to_t)mpc_ast_tag, (void*)t);
-}
-
-mpc_parser_t *mpca_add_tag(mpc_parser_t *a, const char *t) {
-  return mpc_apply_to(a, (mpc_apply_to_t)mpc_ast_add_tag, (void*)t);
-}
-
-mpc_parser_t *mpca_root(mpc_parser_t *a) {
-  return mpc_apply(a, (mpc_apply_t)mpc_ast_add_root);
-}
-
-mpc_parser_t *mpca_not(mpc_parser_t *a) { return mpc_not(a, (mpc_dtor_t)mpc_ast_delete); }
-mpc_parser_t *mpca_maybe(mpc_parser_t *a) { return mpc_maybe(a); }
-mpc_parser_t *mpca_many(mpc_parser_t *a) { return mpc_many(mpcf_fold_ast, a); }
-mpc_parser_t *mpca_many1(mpc_parser_t *a) { return mpc_many1(mpcf_fold_ast, a); }
-mpc_parser_t *mpca_count(int n, mpc_parser_t *a) { return mpc_count(n, mpcf_fold_ast, a, (mpc_dtor_t)mpc_ast_delete); }
-
-mpc_parser_t *mpca_or(int n, ...) {
-
-  int i;
-  va_list va;
-
-  mpc_parser_t *p = mpc_undefined();
-  
-  p->type = MPC_TYPE_OR;
-  p->data.or.n = n;
-  p->data.or.xs = malloc(sizeof(mpc_parser_t*) * n);
-  
-  va_start(va, n);  
-  for (i = 0; i < n; i++) {
-    p->data.or.xs[i] = va_arg(va, mpc_parser_t*);
-  }
-  va_end(va);
-  
-  return p;
-  
-}
-
-mpc_parser_t *mpca_and(int n, ...) {
-  
-  int i;
-  va_list va;
-  
-  mpc_parser_t *p = mpc_undefined();
-  
-  p->type = MPC_TYPE_AND;
-  p->data.and.n = n;
-  p->data.and.f = mpcf_fold_ast;
-  p->data.and.xs = malloc(sizeof(mpc_parser_t*) * n);
-  p->data.and.dxs = malloc(sizeof(mpc_dtor_t) * (n-1));
-  
-  va_start(va, n);
-  for (i = 0; i < n; i++) {
-    p->data.and.xs[i] = va_arg(va, mpc_parser_t*);
-  }
-  for (i = 0; i < (n-1); i++) {
-    p->data.and.dxs[i] = (mpc_dtor_t)mpc_ast_delete;
-  }    
-  va_end(va);
-  
-  return p;  
-}
-
-mpc_parser_t *mpca_total(mpc_parser_t *a) { return mpc_total(a, (mpc_dtor_t)mpc_ast_delete); }
-
-/*
-** Grammar Parser
-*/
-
-/*
-** This is another interesting bootstrapping.
-**
-** Having a general purpose AST type allows
-** users to specify the grammar alone and
-** let all fold rules be automatically taken
-** care of by existing functions.
-**
-** You don't get to control the type spat
-** out but this means you can make a nice
-** parser to take in some grammar in nice
-** syntax and spit out a parser that works.
-**
-** The grammar for this looks surprisingly
-** like regex but the main difference is that
-** it is now whitespace insensitive and the
-** base type takes literals of some form.
-*/
-
-/*
-**
-**  ### Grammar Grammar
-**
-**      <grammar> : (<term> "|" <grammar>) | <term>
-**     
-**      <term> : <factor>*
-**
-**      <factor> : <base>
-**               | <base> "*"
-**               | <base> "+"
-**               | <base> "?"
-**               | <base> "{" <digits> "}"
-**           
-**      <base> : "<" (<digits> | <ident>) ">"
-**             | <string_lit>
-**             | <char_lit>
-**             | <regex_lit>
-**             | "(" <grammar> ")"
-*/
-
-typedef struct {
-  va_list *va;
-  int parsers_num;
-  mpc_parser_t **parsers;
-  int flags;
-} mpca_grammar_st_t;
-
-static mpc_val_t *mpcaf_grammar_or(int n, mpc_val_t **xs) {
-  (void) n;
-  if (xs[1] == NULL) { return xs[0]; }
-  else { return mpca_or(2, xs[0], xs[1]); }
-}
-
-static mpc_val_t *mpcaf_grammar_and(int n, mpc_val_t **xs) {
-  int i;
-  mpc_parser_t *p = mpc_pass();  
-  for (i = 0; i < n; i++) {
-    if (xs[i] != NULL) { p = mpca_and(2, p, xs[i]); }
-  }
-  return p;
-}
-
-static mpc_val_t *mpcaf_grammar_repeat(int n, mpc_val_t **xs) { 
-  int num;
-  (void) n;
-  if (xs[1] == NULL) { return xs[0]; }
-  switch(((char*)xs[1])[0])
-  {
-    case '*': { free(xs[1]); return mpca_many(xs[0]); }; break;
-    case '+': { free(xs[1]); return mpca_many1(xs[0]); }; break;
-    case '?': { free(xs[1]); return mpca_maybe(xs[0]); }; break;
-    case '!': { free(xs[1]); return mpca_not(xs[0]); }; break;
-    default:
-      num = *((int*)xs[1]);
-      free(xs[1]);
-  }
-  return mpca_count(num, xs[0]);
-}
-
-static mpc_val_t *mpcaf_grammar_string(mpc_val_t *x, void *s) {
-  mpca_grammar_st_t *st = s;
-  char *y = mpcf_unescape(x);
-  mpc_parser_t *p = (st->flags & MPCA_LANG_WHITESPACE_SENSITIVE) ? mpc_string(y) : mpc_tok(mpc_string(y));
-  free(y);
-  return mpca_state(mpca_tag(mpc_apply(p, mpcf_str_ast), "string"));
-}
-
-static mpc_val_t *mpcaf_grammar_char(mpc_val_t *x, void *s) {
-  mpca_grammar_st_t *st = s;
-  char *y = mpcf_unescape(x);
-  mpc_parser_t *p = (st->flags & MPCA_LANG_WHITESPACE_SENSITIVE) ? mpc_char(y[0]) : mpc_tok(mpc_char(y[0]));
-  free(y);
-  return mpca_state(mpca_tag(mpc_apply(p, mpcf_str_ast), "char"));
-}
-
-static mpc_val_t *mpcaf_grammar_regex(mpc_val_t *x, void *s) {
-  mpca_grammar_st_t *st = s;
-  char *y = mpcf_unescape_regex(x);
-  mpc_parser_t *p = (st->flags & MPCA_LANG_WHITESPACE_SENSITIVE) ? mpc_re(y) : mpc_tok(mpc_re(y));
-  free(y);
-  return mpca_state(mpca_tag(mpc_apply(p, mpcf_str_ast), "regex"));
-}
-
-/* Should this just use `isdigit` instead? */
-static int is_number(const char* s) {
-  size_t i;
-  for (i = 0; i < strlen(s); i++) { if (!strchr("0123456789", s[i])) { return 0; } }
-  return 1;
-}
-
-static mpc_parser_t *mpca_grammar_find_parser(char *x, mpca_grammar_st_t *st) {
-  
-  int i;
-  mpc_parser_t *p;
-  
-  /* Case of Number */
-  if (is_number(x)) {
-
-    i = strtol(x, NULL, 10);
-    
-    while (st->parsers_num <= i) {
-      st->parsers_num++;
-      st->parsers = realloc(st->parsers, sizeof(mpc_parser_t*) * st->parsers_num);
-      st->parsers[st->parsers_num-1] = va_arg(*st->va, mpc_parser_t*);
-      if (st->parsers[st->parsers_num-1] == NULL) {
-        return mpc_failf("No Parser in position %i! Only supplied %i Parsers!", i, st->parsers_num);
-      }
-    }
-    
-    return st->parsers[st->parsers_num-1];
-  
-  /* Case of Identifier */
-  } else {
-    
-    /* Search Existing Parsers */
-    for (i = 0; i < st->parsers_num; i++) {
-      mpc_parser_t *q = st->parsers[i];
-      if (q == NULL) { return mpc_failf("Unknown Parser '%s'!", x); }
-      if (q->name && strcmp(q->name, x) == 0) { return q; }
-    }
-    
-    /* Search New Parsers */
-    while (1) {
-    
-      p = va_arg(*st->va, mpc_parser_t*);
-      
-      st->parsers_num++;
-      st->parsers = realloc(st->parsers, sizeof(mpc_parser_t*) * st->parsers_num);
-      st->parsers[st->parsers_num-1] = p;
-      
-      if (p == NULL || p->name == NULL) { return mpc_failf("Unknown Parser '%s'!", x); }
-      if (p->name && strcmp(p->name, x) == 0) { return p; }
-      
-    }
-  
-  }  
-  
-}
-
-static mpc_val_t *mpcaf_grammar_id(mpc_val_t *x, void *s) {
-  
-  mpca_grammar_st_t *st = s;
-  mpc_parser_t *p = mpca_grammar_find_parser(x, st);
-  free(x);
-
-  if (p->name) {
-    return mpca_state(mpca_root(mpca_add_tag(p, p->name)));
-  } else {
-    return mpca_state(mpca_root(p));
-  }
-}
-
-mpc_parser_t *mpca_grammar_st(const char *grammar, mpca_grammar_st_t *st) {
-  
-  char *err_msg;
-  mpc_parser_t *err_out;
-  mpc_result_t r;
-  mpc_parser_t *GrammarTotal, *Grammar, *Term, *Factor, *Base;
-  
-  GrammarTotal = mpc_new("grammar_total");
-  Grammar = mpc_new("grammar");
-  Term = mpc_new("term");
-  Factor = mpc_new("factor");
-  Base = mpc_new("base");
-  
-  mpc_define(GrammarTotal,
-    mpc_predictive(mpc_total(Grammar, mpc_soft_delete))
-  );
-  
-  mpc_define(Grammar, mpc_and(2, mpcaf_grammar_or,
-    Term,
-    mpc_maybe(mpc_and(2, mpcf_snd_free, mpc_sym("|"), Grammar, free)),
-    mpc_soft_delete
-  ));
-  
-  mpc_define(Term, mpc_many1(mpcaf_grammar_and, Factor));
-  
-  mpc_define(Factor, mpc_and(2, mpcaf_grammar_repeat,
-    Base,
-      mpc_or(6,
-        mpc_sym("*"),
-        mpc_sym("+"),
-        mpc_sym("?"),
-        mpc_sym("!"),
-        mpc_tok_brackets(mpc_int(), free),
-        mpc_pass()),
-    mpc_soft_delete
-  ));
-  
-  mpc_define(Base, mpc_or(5,
-    mpc_apply_to(mpc_tok(mpc_string_lit()), mpcaf_grammar_string, st),
-    mpc_apply_to(mpc_tok(mpc_char_lit()),   mpcaf_grammar_char, st),
-    mpc_apply_to(mpc_tok(mpc_regex_lit()),  mpcaf_grammar_regex, st),
-    mpc_apply_to(mpc_tok_braces(mpc_or(2, mpc_digits(), mpc_ident()), free), mpcaf_grammar_id, st),
-    mpc_tok_parens(Grammar, mpc_soft_delete)
-  ));
-  
-  mpc_optimise(GrammarTotal);
-  mpc_optimise(Grammar);
-  mpc_optimise(Factor);
-  mpc_optimise(Term);
-  mpc_optimise(Base);
-  
-  if(!mpc_parse("<mpc_grammar_compiler>", grammar, GrammarTotal, &r)) {
-    err_msg = mpc_err_string(r.error);
-    err_out = mpc_failf("Invalid Grammar: %s", err_msg);
-    mpc_err_delete(r.error);
-    free(err_msg);
-    r.output = err_out;
-  }
-  
-  mpc_cleanup(5, GrammarTotal, Grammar, Term, Factor, Base);
-  
-  mpc_optimise(r.output);
-  
-  return (st->flags & MPCA_LANG_PREDICTIVE) ? mpc_predictive(r.output) : r.output;
-  
-}
-
-mpc_parser_t *mpca_grammar(int flags, const char *grammar, ...) {
-  mpca_grammar_st_t st;
-  mpc_parser_t *res;
-  va_list va;
-  va_start(va, grammar);
-  
-  st.va = &va;
-  st.parsers_num = 0;
-  st.parsers = NULL;
-  st.flags = flags;
-  
-  res = mpca_grammar_st(grammar, &st);  
-  free(st.parsers);
-  va_end(va);
-  return res;
-}
-
-typedef struct {
-  char *ident;
-  char *name;
-  mpc_parser_t *grammar;
-} mpca_stmt_t;
-
-static mpc_val_t *mpca_stmt_afold(int n, mpc_val_t **xs) {
-  mpca_stmt_t *stmt = malloc(sizeof(mpca_stmt_t));
-  stmt->ident = ((char**)xs)[0];
-  stmt->name = ((char**)xs)[1];
-  stmt->grammar = ((mpc_parser_t**)xs)[3];
-  (void) n;
-  free(((char**)xs)[2]);
-  free(((char**)xs)[4]);
-  
-  return stmt;
-}
-
-static mpc_val_t *mpca_stmt_fold(int n, mpc_val_t **xs) {
-  
-  int i;
-  mpca_stmt_t **stmts = malloc(sizeof(mpca_stmt_t*) * (n+1));
-  
-  for (i = 0; i < n; i++) {
-    stmts[i] = xs[i];
-  }
-  stmts[n] = NULL;  
-  
-  return stmts;
-}
-
-static void mpca_stmt_list_delete(mpc_val_t *x) {
-
-  mpca_stmt_t **stmts = x;
-
-  while(*stmts) {
-    mpca_stmt_t *stmt = *stmts; 
-    free(stmt->ident);
-    free(stmt->name);
-    mpc_soft_delete(stmt->grammar);
-    free(stmt);  
-    stmts++;
-  }
-  free(x);
-
-}
-
-static mpc_val_t *mpca_stmt_list_apply_to(mpc_val_t *x, void *s) {
-
-  mpca_grammar_st_t *st = s;
-  mpca_stmt_t *stmt;
-  mpca_stmt_t **stmts = x;
-  mpc_parser_t *left;
-
-  while(*stmts) {
-    stmt = *stmts;
-    left = mpca_grammar_find_parser(stmt->ident, st);
-    if (st->flags & MPCA_LANG_PREDICTIVE) { stmt->grammar = mpc_predictive(stmt->grammar); }
-    if (stmt->name) { stmt->grammar = mpc_expect(stmt->grammar, stmt->name); }
-    mpc_optimise(stmt->grammar);
-    mpc_define(left, stmt->grammar);
-    free(stmt->ident);
-    free(stmt->name);
-    free(stmt);
-    stmts++;
-  }
-  
-  free(x);
-  
-  return NULL;
-}
-
-static mpc_err_t *mpca_lang_st(mpc_input_t *i, mpca_grammar_st_t *st) {
-  
-  mpc_result_t r;
-  mpc_err_t *e;
-  mpc_parser_t *Lang, *Stmt, *Grammar, *Term, *Factor, *Base; 
-  
-  Lang    = mpc_new("lang");
-  Stmt    = mpc_new("stmt");
-  Grammar = mpc_new("grammar");
-  Term    = mpc_new("term");
-  Factor  = mpc_new("factor");
-  Base    = mpc_new("base");
-  
-  mpc_define(Lang, mpc_apply_to(
-    mpc_total(mpc_predictive(mpc_many(mpca_stmt_fold, Stmt)), mpca_stmt_list_delete),
-    mpca_stmt_list_apply_to, st
-  ));
-  
-  mpc_define(Stmt, mpc_and(5, mpca_stmt_afold,
-    mpc_tok(mpc_ident()), mpc_maybe(mpc_tok(mpc_string_lit())), mpc_sym(":"), Grammar, mpc_sym(";"),
-    free, free, free, mpc_soft_delete
-  ));
-  
-  mpc_define(Grammar, mpc_and(2, mpcaf_grammar_or,
-      Term,
-      mpc_maybe(mpc_and(2, mpcf_snd_free, mpc_sym("|"), Grammar, free)),
-      mpc_soft_delete
-  ));
-  
-  mpc_define(Term, mpc_many1(mpcaf_grammar_and, Factor));
-  
-  mpc_define(Factor, mpc_and(2, mpcaf_grammar_repeat,
-    Base,
-      mpc_or(6,
-        mpc_sym("*"),
-        mpc_sym("+"),
-        mpc_sym("?"),
-        mpc_sym("!"),
-        mpc_tok_brackets(mpc_int(), free),
-        mpc_pass()),
-    mpc_soft_delete
-  ));
-  
-  mpc_define(Base, mpc_or(5,
-    mpc_apply_to(mpc_tok(mpc_string_lit()), mpcaf_grammar_string, st),
-    mpc_apply_to(mpc_tok(mpc_char_lit()),   mpcaf_grammar_char, st),
-    mpc_apply_to(mpc_tok(mpc_regex_lit()),  mpcaf_grammar_regex, st),
-    mpc_apply_to(mpc_tok_braces(mpc_or(2, mpc_digits(), mpc_ident()), free), mpcaf_grammar_id, st),
-    mpc_tok_parens(Grammar, mpc_soft_delete)
-  ));
-  
-  mpc_optimise(Lang);
-  mpc_optimise(Stmt);
-  mpc_optimise(Grammar);
-  mpc_optimise(Term);
-  mpc_optimise(Factor);
-  mpc_optimise(Base);
-  
-  if (!mpc_parse_input(i, Lang, &r)) {
-    e = r.error;
-  } else {
-    e = NULL;
-  }
-  
-  mpc_cleanup(6, Lang, Stmt, Grammar, Term, Factor, Base);
-  
-  return e;
-}
-
-mpc_err_t *mpca_lang_file(int flags, FILE *f, ...) {
-  mpca_grammar_st_t st;
-  mpc_input_t *i;
-  mpc_err_t *err;
-
-  va_list va;  
-  va_start(va, f);
-  
-  st.va = &va;
-  st.parsers_num = 0;
-  st.parsers = NULL;
-  st.flags = flags;
-  
-  i = mpc_input_new_file("<mpca_lang_file>", f);
-  err = mpca_lang_st(i, &st);
-  mpc_input_delete(i);
-  
-  free(st.parsers);
-  va_end(va);
-  return err;
-}
-
-mpc_err_t *mpca_lang_pipe(int flags, FILE *p, ...) {
-  mpca_grammar_st_t st;
-  mpc_input_t *i;
-  mpc_err_t *err;
-
-  va_list va;  
-  va_start(va, p);
-  
-  st.va = &va;
-  st.parsers_num = 0;
-  st.parsers = NULL;
-  st.flags = flags;
-  
-  i = mpc_input_new_pipe("<mpca_lang_pipe>", p);
-  err = mpca_lang_st(i, &st);
-  mpc_input_delete(i);
-  
-  free(st.parsers);
-  va_end(va);
-  return err;
-}
-
-mpc_err_t *mpca_lang(int flags, const char *language, ...) {
-  
-  mpca_grammar_st_t st;
-  mpc_input_t *i;
-  mpc_err_t *err;
-  
-  va_list va;  
-  va_start(va, language);
-  
-  st.va = &va;
-  st.parsers_num = 0;
-  st.parsers = NULL;
-  st.flags = flags;
-  
-  i = mpc_input_new_string("<mpca_lang>", language);
-  err = mpca_lang_st(i, &st);
-  mpc_input_delete(i);
-  
-  free(st.parsers);
-  va_end(va);
-  return err;
-}
-
-mpc_err_t *mpca_lang_contents(int flags, const char *filename, ...) {
-  
-  mpca_grammar_st_t st;
-  mpc_input_t *i;
-  mpc_err_t *err;
-  
-  va_list va;
-
-  FILE *f = fopen(filename, "rb");
-  
-  if (f == NULL) {
-    err = mpc_err_file(filename, "Unable to open file!");
-    return err;
-  }
-  
-  va_start(va, filename);
-  
-  st.va = &va;
-  st.parsers_num = 0;
-  st.parsers = NULL;
-  st.flags = flags;
-  
-  i = mpc_input_new_file(filename, f);
-  err = mpca_lang_st(i, &st);
-  mpc_input_delete(i);
-  
-  free(st.parsers);
-  va_end(va);  
-  
-  fclose(f);
-  
-  return err;
-}
-
-static int mpc_nodecount_unretained(mpc_parser_t* p, int force) {
-
-  int i, total;
-
-  if (p->retained && !force) { return 0; }
-
-  if (p->type == MPC_TYPE_EXPECT) { return 1 + mpc_nodecount_unretained(p->data.expect.x, 0); }
-
-  if (p->type == MPC_TYPE_APPLY)    { return 1 + mpc_nodecount_unretained(p->data.apply.x, 0); }
-  if (p->type == MPC_TYPE_APPLY_TO) { return 1 + mpc_nodecount_unretained(p->data.apply_to.x, 0); }
-  if (p->type == MPC_TYPE_PREDICT)  { return 1 + mpc_nodecount_unretained(p->data.predict.x, 0); }
-
-  if (p->type == MPC_TYPE_NOT)   { return 1 + mpc_nodecount_unretained(p->data.not.x, 0); }
-  if (p->type == MPC_TYPE_MAYBE) { return 1 + mpc_nodecount_unretained(p->data.not.x, 0); }
-
-  if (p->type == MPC_TYPE_MANY)  { return 1 + mpc_nodecount_unretained(p->data.repeat.x, 0); }
-  if (p->type == MPC_TYPE_MANY1) { return 1 + mpc_nodecount_unretained(p->data.repeat.x, 0); }
-  if (p->type == MPC_TYPE_COUNT) { return 1 + mpc_nodecount_unretained(p->data.repeat.x, 0); }
-
-  if (p->type == MPC_TYPE_OR) { 
-    total = 0;
-    for(i = 0; i < p->data.or.n; i++) {
-      total += mpc_nodecount_unretained(p->data.or.xs[i], 0);
-    }
-    return total;
-  }
-  
-  if (p->type == MPC_TYPE_AND) {
-    total = 0;
-    for(i = 0; i < p->data.and.n; i++) {
-      total += mpc_nodecount_unretained(p->data.and.xs[i], 0);
-    }
-    return total;
-  }
-
-  return 1;
-  
-}
-
-void mpc_stats(mpc_parser_t* p) {
-  printf("Stats\n");
-  printf("=====\n");
-  printf("Node Count: %i\n", mpc_nodecount_unretained(p, 1));
-}
-
-static void mpc_optimise_unretained(mpc_parser_t *p, int force) {
-  
-  int i, n, m;
-  mpc_parser_t *t;
-  
-  if (p->retained && !force) { return; }
-  
-  /* Optimise Subexpressions */
-  
-  if (p->type == MPC_TYPE_EXPECT)   { mpc_optimise_unretained(p->data.expect.x, 0); }
-  if (p->type == MPC_TYPE_APPLY)    { mpc_optimise_unretained(p->data.apply.x, 0); }
-  if (p->type == MPC_TYPE_APPLY_TO) { mpc_optimise_unretained(p->data.apply_to.x, 0); }
-  if (p->type == MPC_TYPE_PREDICT)  { mpc_optimise_unretained(p->data.predict.x, 0); }
-  if (p->type == MPC_TYPE_NOT)      { mpc_optimise_unretained(p->data.not.x, 0); }
-  if (p->type == MPC_TYPE_MAYBE)    { mpc_optimise_unretained(p->data.not.x, 0); }
-  if (p->type == MPC_TYPE_MANY)     { mpc_optimise_unretained(p->data.repeat.x, 0); }
-  if (p->type == MPC_TYPE_MANY1)    { mpc_optimise_unretained(p->data.repeat.x, 0); }
-  if (p->type == MPC_TYPE_COUNT)    { mpc_optimise_unretained(p->data.repeat.x, 0); }
-  
-  if (p->type == MPC_TYPE_OR) { 
-    for(i = 0; i < p->data.or.n; i++) {
-      mpc_optimise_unretained(p->data.or.xs[i], 0);
-    }
-  }
-  
-  if (p->type == MPC_TYPE_AND) {
-    for(i = 0; i < p->data.and.n; i++) {
-      mpc_optimise_unretained(p->data.and.xs[i], 0);
-    }
-  }  
-  
-  /* Perform optimisations */
-  
-  while (1) {
-    
-    /* Merge rhs `or` */
-    if (p->type == MPC_TYPE_OR
-    &&  p->data.or.xs[p->data.or.n-1]->type == MPC_TYPE_OR
-    && !p->data.or.xs[p->data.or.n-1]->retained) {
-      t = p->data.or.xs[p->data.or.n-1];
-      n = p->data.or.n; m = t->data.or.n;
-      p->data.or.n = n + m - 1;
-      p->data.or.xs = realloc(p->data.or.xs, sizeof(mpc_parser_t*) * (n + m -1));
-      memmove(p->data.or.xs + n - 1, t->data.or.xs, m * sizeof(mpc_parser_t*));
-      free(t->data.or.xs); free(t->name); free(t);
-      continue;
-    }
-
-    /* Merge lhs `or` */
-    if (p->type == MPC_TYPE_OR
-    &&  p->data.or.xs[0]->type == MPC_TYPE_OR
-    && !p->data.or.xs[0]->retained) {
-      t = p->data.or.xs[0];
-      n = p->data.or.n; m = t->data.or.n;
-      p->data.or.n = n + m - 1;
-      p->data.or.xs = realloc(p->data.or.xs, sizeof(mpc_parser_t*) * (n + m -1));
-      memmove(p->data.or.xs + m, t->data.or.xs + 1, n * sizeof(mpc_parser_t*));
-      memmove(p->data.or.xs, t->data.or.xs, m * sizeof(mpc_parser_t*));
-      free(t->data.or.xs); free(t->name); free(t);
-      continue;
-    }
-    
-    /* Remove ast `pass` */
-    if (p->type == MPC_TYPE_AND
-    &&  p->data.and.n == 2
-    &&  p->data.and.xs[0]->type == MPC_TYPE_PASS
-    && !p->data.and.xs[0]->retained
-    &&  p->data.and.f == mpcf_fold_ast) {
-      t = p->data.and.xs[1];
-      mpc_delete(p->data.and.xs[0]);
-      free(p->data.and.xs); free(p->data.and.dxs); free(p->name);
-      memcpy(p, t, sizeof(mpc_parser_t));
-      free(t);
-      continue;
-    }
-    
-    /* Merge ast lhs `and` */
-    if (p->type == MPC_TYPE_AND
-    &&  p->data.and.f == mpcf_fold_ast
-    &&  p->data.and.xs[0]->type == MPC_TYPE_AND
-    && !p->data.and.xs[0]->retained
-    &&  p->data.and.xs[0]->data.and.f == mpcf_fold_ast) {
-      t = p->data.and.xs[0];
-      n = p->data.and.n; m = t->data.and.n;
-      p->data.and.n = n + m - 1;
-      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m - 1));
-      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
-      memmove(p->data.and.xs + m, p->data.and.xs + 1, (n - 1) * sizeof(mpc_parser_t*));
-      memmove(p->data.and.xs, t->data.and.xs, m * sizeof(mpc_parser_t*));
-      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = (mpc_dtor_t)mpc_ast_delete; }
-      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
-      continue;
-    }
-    
-    /* Merge ast rhs `and` */
-    if (p->type == MPC_TYPE_AND
-    &&  p->data.and.f == mpcf_fold_ast
-    &&  p->data.and.xs[p->data.and.n-1]->type == MPC_TYPE_AND
-    && !p->data.and.xs[p->data.and.n-1]->retained
-    &&  p->data.and.xs[p->data.and.n-1]->data.and.f == mpcf_fold_ast) {
-      t = p->data.and.xs[p->data.and.n-1];
-      n = p->data.and.n; m = t->data.and.n;
-      p->data.and.n = n + m - 1;
-      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m -1));
-      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
-      memmove(p->data.and.xs + n - 1, t->data.and.xs, m * sizeof(mpc_parser_t*));
-      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = (mpc_dtor_t)mpc_ast_delete; }
-      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
-      continue;
-    }
-
-    /* Remove re `lift` */
-    if (p->type == MPC_TYPE_AND
-    &&  p->data.and.n == 2
-    &&  p->data.and.xs[0]->type == MPC_TYPE_LIFT
-    &&  p->data.and.xs[0]->data.lift.lf == mpcf_ctor_str
-    && !p->data.and.xs[0]->retained
-    &&  p->data.and.f == mpcf_strfold) {
-      t = p->data.and.xs[1];
-      mpc_delete(p->data.and.xs[0]);
-      free(p->data.and.xs); free(p->data.and.dxs); free(p->name);
-      memcpy(p, t, sizeof(mpc_parser_t));
-      free(t);
-      continue;
-    }
-
-    /* Merge re lhs `and` */
-    if (p->type == MPC_TYPE_AND
-    &&  p->data.and.f == mpcf_strfold
-    &&  p->data.and.xs[0]->type == MPC_TYPE_AND
-    && !p->data.and.xs[0]->retained
-    &&  p->data.and.xs[0]->data.and.f == mpcf_strfold) {
-      t = p->data.and.xs[0];
-      n = p->data.and.n; m = t->data.and.n;
-      p->data.and.n = n + m - 1;
-      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m - 1));
-      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
-      memmove(p->data.and.xs + m, p->data.and.xs + 1, (n - 1) * sizeof(mpc_parser_t*));
-      memmove(p->data.and.xs, t->data.and.xs, m * sizeof(mpc_parser_t*));
-      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = free; }
-      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
-      continue;
-    }
-    
-    /* Merge re rhs `and` */
-    if (p->type == MPC_TYPE_AND
-    &&  p->data.and.f == mpcf_strfold
-    &&  p->data.and.xs[p->data.and.n-1]->type == MPC_TYPE_AND
-    && !p->data.and.xs[p->data.and.n-1]->retained
-    &&  p->data.and.xs[p->data.and.n-1]->data.and.f == mpcf_strfold) {
-      t = p->data.and.xs[p->data.and.n-1];
-      n = p->data.and.n; m = t->data.and.n;
-      p->data.and.n = n + m - 1;
-      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m -1));
-      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
-      memmove(p->data.and.xs + n - 1, t->data.and.xs, m * sizeof(mpc_parser_t*));
-      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = free; }
-      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
-      continue;
-    }
-    
-    return;
-    
-  }
-  
-}
-
-void mpc_optimise(mpc_parser_t *p) {
-  mpc_optimise_unretained(p, 1);
-}
-
+#include "mpc.h"
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#define MPC_ATOMICS
+#include <stdatomic.h>
+#endif
+
+/*
+** State Type
+*/
+
+static mpc_state_t mpc_state_invalid(void) {
+  mpc_state_t s;
+  s.pos = -1;
+  s.row = -1;
+  s.col = -1;
+  return s;
+}
+
+static mpc_state_t mpc_state_new(void) {
+  mpc_state_t s;
+  s.pos = 0;
+  s.row = 0;
+  s.col = 0;
+  return s;
+}
+
+/*
+** Input Type
+*/
+
+/*
+** In mpc the input type has three modes of 
+** operation: String, File and Pipe.
+**
+** String is easy. The whole contents are 
+** loaded into a buffer and scanned through.
+** The cursor can jump around at will making 
+** backtracking easy.
+**
+** The second is a File which is also somewhat
+** easy. The contents are never loaded into 
+** memory but backtracking can still be achieved
+** by seeking in the file at different positions.
+**
+** The final mode is Pipe. This is the difficult
+** one. As we assume pipes cannot be seeked - and 
+** only support a single character lookahead at 
+** any point, when the input is marked for a 
+** potential backtracking we start buffering any 
+** input.
+**
+** This means that if we are requested to seek
+** back we can simply start reading from the
+** buffer instead of the input.
+**
+** Of course using `mpc_predictive` will disable
+** backtracking and make LL(1) grammars easy
+** to parse for all input methods.
+**
+*/
+
+enum {
+  MPC_INPUT_STRING = 0,
+  MPC_INPUT_FILE   = 1,
+  MPC_INPUT_PIPE   = 2
+};
+
+enum {
+  MPC_INPUT_MARKS_MIN = 32
+};
+
+/*
+** Scratch memory for a parse is handed out from
+** chunks by bumping a pointer. Small blocks are
+** rounded up to a power of two size class and
+** carry a header holding that class, so freed
+** blocks go onto a free list per class and are
+** reused in constant time. When a chunk is used
+** up a larger one is added, and only blocks over
+** the largest class go straight to malloc.
+**
+** Chunks start on a page boundary and span whole
+** pages, and every page of them is kept in a hash
+** set. Whether a block came from the arena or from
+** malloc is then found from its page alone, without
+** walking the chunks or reading a header the block
+** may not have.
+*/
+
+enum {
+  MPC_MEM_CLASSES   = 5,
+  MPC_MEM_CLASS_MIN = 16,
+  MPC_MEM_CLASS_MAX = 256,
+  MPC_MEM_CHUNK_MIN = 4096,
+  MPC_MEM_PAGE      = 4096,
+  MPC_MEM_PAGES_MIN = 64
+};
+
+typedef struct mpc_mem_chunk_t {
+  struct mpc_mem_chunk_t *next;
+  void *block;
+  size_t size;
+} mpc_mem_chunk_t;
+
+/*
+** A context may also build its syntax trees in
+** an arena of its own which outlives the scratch
+** memory of the parse. Tags in such trees are
+** interned, so combining them is cached by the
+** pointers of the tags being combined.
+*/
+
+enum {
+  MPC_AST_CHUNK_MIN  = 16384,
+  MPC_AST_TAGS_MIN   = 64,
+  MPC_AST_CACHE_SIZE = 256
+};
+
+enum {
+  MPC_AST_TAG_SET  = 0,
+  MPC_AST_TAG_ADD  = 1,
+  MPC_AST_TAG_ROOT = 2
+};
+
+typedef struct {
+  int op;
+  const char *a;
+  const char *b;
+  char *r;
+} mpc_ast_cache_t;
+
+typedef struct {
+  mpc_mem_chunk_t *chunks;
+  char *bump;
+  char *end;
+  int tags_num;
+  int tags_slots;
+  char **tags;
+  mpc_ast_cache_t cache[MPC_AST_CACHE_SIZE];
+} mpc_ast_arena_t;
+
+/*
+** While parsing, errors are not built as they
+** occur. Only the furthest position reached by a
+** failure is tracked along with what was expected
+** there, each as a pointer to the message of the
+** parser which failed. The error itself is built
+** from these only if the whole parse fails.
+*/
+
+enum {
+  MPC_ERR_ENTRIES_MIN = 8
+};
+
+enum {
+  MPC_ERR_GROUP_NONE  = 0,
+  MPC_ERR_GROUP_MANY1 = -1
+};
+
+typedef struct {
+  const char *msg;
+  int failure;
+  int group;
+} mpc_err_entry_t;
+
+typedef struct {
+  mpc_state_t state;
+  char recieved;
+  mpc_err_entry_t entry;
+} mpc_err_pending_t;
+
+typedef struct {
+
+  int type;
+  char *filename;  
+  mpc_state_t state;
+  
+  char *string;
+  long length;
+  char *buffer;
+  FILE *file;
+  
+  int suppress;
+  int backtrack;
+  int marks_slots;
+  int marks_num;
+  mpc_state_t *marks;
+  
+  char *lasts;
+  char last;
+  
+  mpc_mem_chunk_t *mem_chunks;
+  char *mem_bump;
+  char *mem_end;
+  void *mem_free[MPC_MEM_CLASSES];
+  mpc_mem_stats_t mem_stats;
+  size_t mem_pages_num;
+  size_t mem_pages_slots;
+  uintptr_t *mem_pages;
+  
+  mpc_ast_arena_t *ast;
+  
+  mpc_state_t err_state;
+  char err_recieved;
+  int err_failed;
+  int err_num;
+  int err_slots;
+  mpc_err_entry_t *errs;
+  mpc_err_pending_t err_pending;
+  
+} mpc_input_t;
+
+/*
+** Contexts fold their counts into these totals
+** after every parse. Where C11 atomics exist they
+** are updated atomically, so parses may run on
+** several threads at once.
+*/
+
+#ifdef MPC_ATOMICS
+typedef atomic_ulong mpc_mem_total_t;
+#define mpc_mem_total_add(t, n) atomic_fetch_add_explicit(&(t), (n), memory_order_relaxed)
+#define mpc_mem_total_get(t) atomic_load_explicit(&(t), memory_order_relaxed)
+#define mpc_mem_total_set(t, n) atomic_store_explicit(&(t), (n), memory_order_relaxed)
+#else
+typedef unsigned long mpc_mem_total_t;
+#define mpc_mem_total_add(t, n) ((t) += (n))
+#define mpc_mem_total_get(t) (t)
+#define mpc_mem_total_set(t, n) ((t) = (n))
+#endif
+
+static struct {
+  mpc_mem_total_t allocs;
+  mpc_mem_total_t hits;
+  mpc_mem_total_t spills;
+  mpc_mem_total_t heap;
+} mpc_mem_stats_total;
+
+static void mpc_mem_init(mpc_input_t *i) {
+  i->ast = NULL;
+  i->err_state = mpc_state_invalid();
+  i->err_num = 0;
+  i->err_slots = 0;
+  i->errs = NULL;
+  i->mem_chunks = NULL;
+  i->mem_bump = NULL;
+  i->mem_end = NULL;
+  memset(i->mem_free, 0, sizeof(i->mem_free));
+  memset(&i->mem_stats, 0, sizeof(mpc_mem_stats_t));
+  i->mem_pages_num = 0;
+  i->mem_pages_slots = 0;
+  i->mem_pages = NULL;
+}
+
+static void mpc_mem_stats_fold(mpc_input_t *i) {
+  mpc_mem_total_add(mpc_mem_stats_total.allocs, i->mem_stats.hits + i->mem_stats.spills + i->mem_stats.heap);
+  mpc_mem_total_add(mpc_mem_stats_total.hits,   i->mem_stats.hits);
+  mpc_mem_total_add(mpc_mem_stats_total.spills, i->mem_stats.spills);
+  mpc_mem_total_add(mpc_mem_stats_total.heap,   i->mem_stats.heap);
+  memset(&i->mem_stats, 0, sizeof(mpc_mem_stats_t));
+}
+
+/*
+** The page set is open addressed. Pages are
+** numbered from their address, so no page the
+** arena can own is numbered zero, which marks an
+** empty slot.
+*/
+
+static size_t mpc_mem_page_slot(uintptr_t x, size_t slots) {
+  return (size_t)(x * 2654435761u) & (slots - 1);
+}
+
+static void mpc_mem_page_put(uintptr_t *pages, size_t slots, uintptr_t x) {
+  size_t j = mpc_mem_page_slot(x, slots);
+  while (pages[j]) { j = (j + 1) & (slots - 1); }
+  pages[j] = x;
+}
+
+static void mpc_mem_pages_add(mpc_input_t *i, mpc_mem_chunk_t *k) {
+  
+  size_t j, slots;
+  uintptr_t x, *pages;
+  uintptr_t first = (uintptr_t)k / MPC_MEM_PAGE;
+  uintptr_t last = first + k->size / MPC_MEM_PAGE;
+  
+  if ((i->mem_pages_num + k->size / MPC_MEM_PAGE) * 2 > i->mem_pages_slots) {
+    slots = i->mem_pages_slots ? i->mem_pages_slots : MPC_MEM_PAGES_MIN;
+    while ((i->mem_pages_num + k->size / MPC_MEM_PAGE) * 2 > slots) { slots *= 2; }
+    pages = calloc(slots, sizeof(uintptr_t));
+    for (j = 0; j < i->mem_pages_slots; j++) {
+      if (i->mem_pages[j]) { mpc_mem_page_put(pages, slots, i->mem_pages[j]); }
+    }
+    free(i->mem_pages);
+    i->mem_pages = pages;
+    i->mem_pages_slots = slots;
+  }
+  
+  for (x = first; x < last; x++) {
+    mpc_mem_page_put(i->mem_pages, i->mem_pages_slots, x);
+  }
+  i->mem_pages_num += k->size / MPC_MEM_PAGE;
+}
+
+static void mpc_mem_release(mpc_input_t *i) {
+  mpc_mem_chunk_t *k = i->mem_chunks, *n;
+  while (k) { n = k->next; free(k->block); k = n; }
+  free(i->mem_pages);
+  free(i->errs);
+  mpc_mem_stats_fold(i);
+  mpc_mem_init(i);
+}
+
+/*
+** Empties the arena for another parse, keeping
+** only the newest chunk, which is the largest.
+*/
+
+static void mpc_mem_reset(mpc_input_t *i) {
+  
+  mpc_mem_chunk_t *k = i->mem_chunks, *n;
+  
+  mpc_mem_stats_fold(i);
+  memset(i->mem_free, 0, sizeof(i->mem_free));
+  if (k == NULL) { return; }
+  
+  n = k->next;
+  k->next = NULL;
+  while (n) { k = n->next; free(n->block); n = k; }
+  
+  memset(i->mem_pages, 0, i->mem_pages_slots * sizeof(uintptr_t));
+  i->mem_pages_num = 0;
+  mpc_mem_pages_add(i, i->mem_chunks);
+  
+  i->mem_bump = (char*)(i->mem_chunks + 1);
+  i->mem_end = (char*)i->mem_chunks + i->mem_chunks->size;
+}
+
+void mpc_mem_stats(mpc_mem_stats_t *s) {
+  s->allocs = mpc_mem_total_get(mpc_mem_stats_total.allocs);
+  s->hits   = mpc_mem_total_get(mpc_mem_stats_total.hits);
+  s->spills = mpc_mem_total_get(mpc_mem_stats_total.spills);
+  s->heap   = mpc_mem_total_get(mpc_mem_stats_total.heap);
+}
+
+void mpc_mem_stats_reset(void) {
+  mpc_mem_total_set(mpc_mem_stats_total.allocs, 0);
+  mpc_mem_total_set(mpc_mem_stats_total.hits,   0);
+  mpc_mem_total_set(mpc_mem_stats_total.spills, 0);
+  mpc_mem_total_set(mpc_mem_stats_total.heap,   0);
+}
+
+static mpc_input_t *mpc_input_new_string(const char *filename, const char *string) {
+
+  mpc_input_t *i = malloc(sizeof(mpc_input_t));
+  
+  i->filename = malloc(strlen(filename) + 1);
+  strcpy(i->filename, filename);
+  i->type = MPC_INPUT_STRING;
+  
+  i->state = mpc_state_new();
+  
+  i->length = strlen(string);
+  i->string = malloc(i->length + 1);
+  strcpy(i->string, string);
+  i->buffer = NULL;
+  i->file = NULL;
+  
+  i->suppress = 0;
+  i->backtrack = 1;
+  i->marks_num = 0;
+  i->marks_slots = MPC_INPUT_MARKS_MIN;
+  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
+  i->lasts = malloc(sizeof(char) * i->marks_slots);
+  i->last = '\0';
+  
+  mpc_mem_init(i);
+  
+  return i;
+}
+
+static mpc_input_t *mpc_input_new_nstring(const char *filename, const char *string, size_t length) {
+
+  mpc_input_t *i = malloc(sizeof(mpc_input_t));
+  
+  i->filename = malloc(strlen(filename) + 1);
+  strcpy(i->filename, filename);
+  i->type = MPC_INPUT_STRING;
+  
+  i->state = mpc_state_new();
+  
+  i->string = malloc(length + 1);
+  strncpy(i->string, string, length);
+  i->string[length] = '\0';
+  i->length = strlen(i->string);
+  i->buffer = NULL;
+  i->file = NULL;
+  
+  i->suppress = 0;
+  i->backtrack = 1;
+  i->marks_num = 0;
+  i->marks_slots = MPC_INPUT_MARKS_MIN;
+  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
+  i->lasts = malloc(sizeof(char) * i->marks_slots);
+  i->last = '\0';
+  
+  mpc_mem_init(i);
+  
+  return i;
+
+}
+
+static mpc_input_t *mpc_input_new_pipe(const char *filename, FILE *pipe) {
+
+  mpc_input_t *i = malloc(sizeof(mpc_input_t));
+  
+  i->filename = malloc(strlen(filename) + 1);
+  strcpy(i->filename, filename);
+  
+  i->type = MPC_INPUT_PIPE;
+  i->state = mpc_state_new();
+  
+  i->string = NULL;
+  i->length = 0;
+  i->buffer = NULL;
+  i->file = pipe;
+  
+  i->suppress = 0;
+  i->backtrack = 1;
+  i->marks_num = 0;
+  i->marks_slots = MPC_INPUT_MARKS_MIN;
+  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
+  i->lasts = malloc(sizeof(char) * i->marks_slots);
+  i->last = '\0';
+  
+  mpc_mem_init(i);
+  
+  return i;
+  
+}
+
+static mpc_input_t *mpc_input_new_file(const char *filename, FILE *file) {
+  
+  mpc_input_t *i = malloc(sizeof(mpc_input_t));
+  
+  i->filename = malloc(strlen(filename) + 1);
+  strcpy(i->filename, filename);
+  i->type = MPC_INPUT_FILE;
+  i->state = mpc_state_new();
+  
+  i->string = NULL;
+  i->length = 0;
+  i->buffer = NULL;
+  i->file = file;
+  
+  i->suppress = 0;
+  i->backtrack = 1;
+  i->marks_num = 0;
+  i->marks_slots = MPC_INPUT_MARKS_MIN;
+  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
+  i->lasts = malloc(sizeof(char) * i->marks_slots);
+  i->last = '\0';
+  
+  mpc_mem_init(i);
+  
+  return i;
+}
+
+static void mpc_input_delete(mpc_input_t *i) {
+  
+  free(i->filename);
+  
+  if (i->type == MPC_INPUT_STRING) { free(i->string); }
+  if (i->type == MPC_INPUT_PIPE) { free(i->buffer); }
+  
+  free(i->marks);
+  free(i->lasts);
+  mpc_mem_release(i);
+  free(i);
+}
+
+static int mpc_mem_ptr(mpc_input_t *i, void *p) {
+  uintptr_t x = (uintptr_t)p / MPC_MEM_PAGE;
+  size_t j;
+  if (i->mem_pages_slots == 0) { return 0; }
+  j = mpc_mem_page_slot(x, i->mem_pages_slots);
+  while (i->mem_pages[j]) {
+    if (i->mem_pages[j] == x) { return 1; }
+    j = (j + 1) & (i->mem_pages_slots - 1);
+  }
+  return 0;
+}
+
+static const unsigned char mpc_mem_classes[] = {
+  0, 0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4
+};
+
+static size_t mpc_mem_class_size(void *p) {
+  return (size_t)MPC_MEM_CLASS_MIN << ((size_t*)p)[-1];
+}
+
+static void *mpc_malloc(mpc_input_t *i, size_t n) {
+  
+  size_t c, m, size;
+  char *p, *block;
+  mpc_mem_chunk_t *k;
+  
+  if (n > MPC_MEM_CLASS_MAX) {
+    i->mem_stats.heap++;
+    return malloc(n);
+  }
+  
+  c = mpc_mem_classes[(n + MPC_MEM_CLASS_MIN - 1) / MPC_MEM_CLASS_MIN];
+  
+  if (i->mem_free[c]) {
+    p = i->mem_free[c];
+    i->mem_free[c] = *(void**)p;
+    i->mem_stats.hits++;
+    return p;
+  }
+  
+  m = sizeof(size_t) + ((size_t)MPC_MEM_CLASS_MIN << c);
+  
+  if ((size_t)(i->mem_end - i->mem_bump) < m) {
+    size = i->mem_chunks ? i->mem_chunks->size * 2 : MPC_MEM_CHUNK_MIN;
+    block = malloc(size + MPC_MEM_PAGE - 1);
+    k = (mpc_mem_chunk_t*)(((uintptr_t)block + MPC_MEM_PAGE - 1) & ~(uintptr_t)(MPC_MEM_PAGE - 1));
+    k->next = i->mem_chunks;
+    k->block = block;
+    k->size = size;
+    i->mem_chunks = k;
+    i->mem_bump = (char*)(k + 1);
+    i->mem_end = (char*)k + size;
+    mpc_mem_pages_add(i, k);
+    i->mem_stats.spills++;
+  } else {
+    i->mem_stats.hits++;
+  }
+  
+  p = i->mem_bump;
+  i->mem_bump += m;
+  *(size_t*)p = c;
+  return p + sizeof(size_t);
+}
+
+static void *mpc_calloc(mpc_input_t *i, size_t n, size_t m) {
+  char *x = mpc_malloc(i, n * m);
+  memset(x, 0, n * m);
+  return x;
+}
+
+static void mpc_free(mpc_input_t *i, void *p) {
+  size_t c;
+  if (!mpc_mem_ptr(i, p)) { free(p); return; }
+  c = ((size_t*)p)[-1];
+  *(void**)p = i->mem_free[c];
+  i->mem_free[c] = p;
+}
+
+static void *mpc_realloc(mpc_input_t *i, void *p, size_t n) {
+  
+  char *q = NULL;
+  size_t m;
+  
+  if (!mpc_mem_ptr(i, p)) { return realloc(p, n); }
+  
+  m = mpc_mem_class_size(p);
+  if (n <= m) { return p; }
+  
+  q = mpc_malloc(i, n);
+  memcpy(q, p, m);
+  mpc_free(i, p);
+  return q;
+}
+
+static void *mpc_export(mpc_input_t *i, void *p) {
+  char *q = NULL;
+  size_t m;
+  if (!mpc_mem_ptr(i, p)) { return p; }
+  m = mpc_mem_class_size(p);
+  q = malloc(m);
+  memcpy(q, p, m);
+  mpc_free(i, p);
+  return q; 
+}
+
+static void mpc_input_backtrack_disable(mpc_input_t *i) { i->backtrack--; }
+static void mpc_input_backtrack_enable(mpc_input_t *i) { i->backtrack++; }
+
+static void mpc_input_suppress_disable(mpc_input_t *i) { i->suppress--; }
+static void mpc_input_suppress_enable(mpc_input_t *i) { i->suppress++; }
+
+static void mpc_input_mark(mpc_input_t *i) {
+  
+  if (i->backtrack < 1) { return; }
+  
+  i->marks_num++;
+  
+  if (i->marks_num > i->marks_slots) {
+    i->marks_slots = i->marks_num + i->marks_num / 2;
+    i->marks = realloc(i->marks, sizeof(mpc_state_t) * i->marks_slots);
+    i->lasts = realloc(i->lasts, sizeof(char) * i->marks_slots);
+  }
+
+  i->marks[i->marks_num-1] = i->state;
+  i->lasts[i->marks_num-1] = i->last;
+  
+  if (i->type == MPC_INPUT_PIPE && i->marks_num == 1) {
+    i->buffer = calloc(1, 1);
+  }
+  
+}
+
+static void mpc_input_unmark(mpc_input_t *i) {
+  
+  if (i->backtrack < 1) { return; }
+  
+  i->marks_num--;
+  
+  if (i->marks_slots > i->marks_num + i->marks_num / 2
+  &&  i->marks_slots > MPC_INPUT_MARKS_MIN) {
+    i->marks_slots = 
+      i->marks_num > MPC_INPUT_MARKS_MIN ?
+      i->marks_num : MPC_INPUT_MARKS_MIN;
+    i->marks = realloc(i->marks, sizeof(mpc_state_t) * i->marks_slots);
+    i->lasts = realloc(i->lasts, sizeof(char) * i->marks_slots);      
+  }
+  
+  if (i->type == MPC_INPUT_PIPE && i->marks_num == 0) {
+    free(i->buffer);
+    i->buffer = NULL;
+  }
+  
+}
+
+static void mpc_input_rewind(mpc_input_t *i) {
+  
+  if (i->backtrack < 1) { return; }
+  
+  i->state = i->marks[i->marks_num-1];
+  i->last  = i->lasts[i->marks_num-1];
+  
+  if (i->type == MPC_INPUT_FILE) {
+    fseek(i->file, i->state.pos, SEEK_SET);
+  }
+  
+  mpc_input_unmark(i);
+}
+
+static int mpc_input_buffer_in_range(mpc_input_t *i) {
+  return i->state.pos < (long)(strlen(i->buffer) + i->marks[0].pos);
+}
+
+static char mpc_input_buffer_get(mpc_input_t *i) {
+  return i->buffer[i->state.pos - i->marks[0].pos];
+}
+
+static int mpc_input_terminated(mpc_input_t *i) {
+  if (i->type == MPC_INPUT_STRING && i->state.pos == i->length) { return 1; }
+  if (i->type == MPC_INPUT_FILE && feof(i->file)) { return 1; }
+  if (i->type == MPC_INPUT_PIPE && feof(i->file)) { return 1; }
+  return 0;
+}
+
+static char mpc_input_getc(mpc_input_t *i) {
+  
+  char c = '\0';
+  
+  switch (i->type) {
+    
+    case MPC_INPUT_STRING: return i->state.pos < i->length ? i->string[i->state.pos] : '\0';
+    case MPC_INPUT_FILE: c = fgetc(i->file); return c;
+    case MPC_INPUT_PIPE:
+    
+      if (!i->buffer) { c = getc(i->file); return c; }
+      
+      if (i->buffer && mpc_input_buffer_in_range(i)) {
+        c = mpc_input_buffer_get(i);
+        return c;
+      } else {
+        c = getc(i->file);
+        return c;
+      }
+    
+    default: return c;
+  }
+}
+
+static char mpc_input_peekc(mpc_input_t *i) {
+  
+  char c = '\0';
+  
+  switch (i->type) {
+    case MPC_INPUT_STRING: return i->state.pos < i->length ? i->string[i->state.pos] : '\0';
+    case MPC_INPUT_FILE: 
+      
+      c = fgetc(i->file);
+      if (feof(i->file)) { return '\0'; }
+      
+      fseek(i->file, -1, SEEK_CUR);
+      return c;
+    
+    case MPC_INPUT_PIPE:
+      
+      if (!i->buffer) {
+        c = getc(i->file);
+        if (feof(i->file)) { return '\0'; }
+        ungetc(c, i->file);
+        return c;
+      }
+      
+      if (i->buffer && mpc_input_buffer_in_range(i)) {
+        return mpc_input_buffer_get(i);
+      } else {
+        c = getc(i->file);
+        if (feof(i->file)) { return '\0'; }
+        ungetc(c, i->file);
+        return c;
+      }
+    
+    default: return c;
+  }
+  
+}
+
+static int mpc_input_failure(mpc_input_t *i, char c) {
+
+  switch (i->type) {
+    case MPC_INPUT_STRING: { break; }
+    case MPC_INPUT_FILE: fseek(i->file, -1, SEEK_CUR); { break; }
+    case MPC_INPUT_PIPE: {
+      
+      if (!i->buffer) { ungetc(c, i->file); break; }
+      
+      if (i->buffer && mpc_input_buffer_in_range(i)) {
+        break;
+      } else {
+        ungetc(c, i->file); 
+      }
+    }
+    default: { break; }
+  }
+  return 0;
+}
+
+static int mpc_input_success(mpc_input_t *i, char c, char **o) {
+  
+  if (i->type == MPC_INPUT_PIPE
+  &&  i->buffer && !mpc_input_buffer_in_range(i)) {
+    i->buffer = realloc(i->buffer, strlen(i->buffer) + 2);
+    i->buffer[strlen(i->buffer) + 1] = '\0';
+    i->buffer[strlen(i->buffer) + 0] = c;
+  }
+  
+  i->last = c;
+  i->state.pos++;
+  i->state.col++;
+  
+  if (c == '\n') {
+    i->state.col = 0;
+    i->state.row++;
+  }
+  
+  if (o) {
+    (*o) = mpc_malloc(i, 2);
+    (*o)[0] = c;
+    (*o)[1] = '\0';
+  }
+  
+  return 1;
+}
+
+static int mpc_input_any(mpc_input_t *i, char **o) {
+  char x = mpc_input_getc(i);
+  if (mpc_input_terminated(i)) { return 0; }
+  return mpc_input_success(i, x, o);
+}
+
+static int mpc_input_char(mpc_input_t *i, char c, char **o) {
+  char x = mpc_input_getc(i);
+  if (mpc_input_terminated(i)) { return 0; }
+  return x == c ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);
+}
+
+static int mpc_input_range(mpc_input_t *i, char c, char d, char **o) {
+  char x = mpc_input_getc(i);
+  if (mpc_input_terminated(i)) { return 0; }
+  return x >= c && x <= d ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
+}
+
+/*
+** Character classes are stored as a bitmap of
+** the characters they accept, so `oneof` and
+** `noneof` are a single bit test per character.
+**
+** The accepted set is also kept as a short list
+** of contiguous ranges which lets whole runs of
+** the class be scanned sixteen bytes at a time.
+*/
+
+enum {
+  MPC_CLASS_RANGES_MAX = 16
+};
+
+typedef struct {
+  unsigned char bits[32];
+  int ranges_num;
+  unsigned char lo[MPC_CLASS_RANGES_MAX];
+  unsigned char width[MPC_CLASS_RANGES_MAX];
+} mpc_class_t;
+
+static int mpc_class_has(const mpc_class_t *c, char x) {
+  unsigned char u = (unsigned char)x;
+  return c->bits[u >> 3] & (1 << (u & 7));
+}
+
+static mpc_class_t *mpc_class_new(const unsigned char *bits) {
+  
+  int j, start = -1;
+  mpc_class_t *c = malloc(sizeof(mpc_class_t));
+  memcpy(c->bits, bits, sizeof(c->bits));
+  c->ranges_num = 0;
+  
+  /* The terminator never takes part in a run */
+  for (j = 1; j <= 256; j++) {
+    if (j < 256 && (bits[j >> 3] & (1 << (j & 7)))) {
+      if (start < 0) { start = j; }
+      continue;
+    }
+    if (start < 0) { continue; }
+    if (c->ranges_num == MPC_CLASS_RANGES_MAX) { c->ranges_num = 0; break; }
+    c->lo[c->ranges_num] = (unsigned char)start;
+    c->width[c->ranges_num] = (unsigned char)(j - 1 - start);
+    c->ranges_num++;
+    start = -1;
+  }
+  
+  return c;
+}
+
+static mpc_class_t *mpc_class_copy(const mpc_class_t *c) {
+  mpc_class_t *d = malloc(sizeof(mpc_class_t));
+  memcpy(d, c, sizeof(mpc_class_t));
+  return d;
+}
+
+/*
+** Returns the length of the run of characters in
+** `s` accepted by the class, looking at no more
+** than `n` characters.
+*/
+
+static long mpc_class_span(const mpc_class_t *c, const char *s, long n) {
+  
+  long j = 0;
+  
+#if defined(__SSE2__)
+  int k, m;
+  __m128i x, d, in;
+  
+  if (c->ranges_num > 0) {
+    while (j + 16 <= n) {
+      x = _mm_loadu_si128((const __m128i*)(s + j));
+      in = _mm_setzero_si128();
+      for (k = 0; k < c->ranges_num; k++) {
+        d = _mm_sub_epi8(x, _mm_set1_epi8((char)c->lo[k]));
+        d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8((char)c->width[k])), d);
+        in = _mm_or_si128(in, d);
+      }
+      m = _mm_movemask_epi8(in);
+      if (m != 0xFFFF) {
+        m = ~m;
+        while (!(m & 1)) { m >>= 1; j++; }
+        return j;
+      }
+      j += 16;
+    }
+  }
+#endif
+  
+  while (j < n && mpc_class_has(c, s[j])) { j++; }
+  return j;
+}
+
+static int mpc_input_oneof(mpc_input_t *i, const mpc_class_t *c, char **o) {
+  char x = mpc_input_getc(i);
+  if (mpc_input_terminated(i)) { return 0; }
+  return mpc_class_has(c, x) ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
+}
+
+static int mpc_input_satisfy(mpc_input_t *i, int(*cond)(char), char **o) {
+  char x = mpc_input_getc(i);
+  if (mpc_input_terminated(i)) { return 0; }
+  return cond(x) ? mpc_input_success(i, x, o) : mpc_input_failure(i, x);  
+}
+
+static int mpc_input_string(mpc_input_t *i, const char *c, char **o) {
+  
+  const char *x = c;
+
+  mpc_input_mark(i);
+  while (*x) {
+    if (!mpc_input_char(i, *x, NULL)) {
+      mpc_input_rewind(i);
+      return 0;
+    }
+    x++;
+  }
+  mpc_input_unmark(i);
+  
+  *o = mpc_malloc(i, strlen(c) + 1);
+  strcpy(*o, c);
+  return 1;
+}
+
+static int mpc_input_anchor(mpc_input_t* i, int(*f)(char,char), char **o) {
+  *o = NULL;
+  return f(i->last, mpc_input_peekc(i));
+}
+
+static mpc_state_t *mpc_input_state_copy(mpc_input_t *i) {
+  mpc_state_t *r = mpc_malloc(i, sizeof(mpc_state_t));
+  memcpy(r, &i->state, sizeof(mpc_state_t));
+  return r;
+}
+
+/*
+** Advances the input over `n` characters which
+** have already been matched directly against the
+** underlying string, keeping rows and columns in
+** step with `mpc_input_success`.
+*/
+
+static void mpc_input_advance(mpc_input_t *i, const char *s, long n) {
+  long j;
+  if (n == 0) { return; }
+  for (j = 0; j < n; j++) {
+    if (s[j] == '\n') { i->state.col = 0; i->state.row++; }
+    else { i->state.col++; }
+  }
+  i->state.pos += n;
+  i->last = s[n-1];
+}
+
+/*
+** Consumes the longest run of the class at the
+** cursor, succeeding only if it is at least `min`
+** characters long.
+*/
+
+static int mpc_input_span(mpc_input_t *i, const mpc_class_t *c, long min, char **o) {
+  const char *s = i->string + i->state.pos;
+  long n = mpc_class_span(c, s, i->length - i->state.pos);
+  if (n < min) { return 0; }
+  *o = mpc_malloc(i, n + 1);
+  memcpy(*o, s, n);
+  (*o)[n] = '\0';
+  mpc_input_advance(i, s, n);
+  return 1;
+}
+
+/*
+** A DFA is a flat transition table of 256 columns
+** per state. State zero is the start state and a
+** negative entry marks the dead state. States
+** which loop back onto themselves keep the loop
+** as a class so runs can be skipped in one go.
+*/
+
+typedef struct {
+  int states_num;
+  int *trans;
+  char *accept;
+  int expected_num;
+  char **expected;
+  unsigned long *reports;
+  mpc_class_t **loops;
+} mpc_dfa_t;
+
+static int mpc_input_dfa(mpc_input_t *i, mpc_dfa_t *d, long *stop, char **o) {
+
+  const unsigned char *s = (const unsigned char*)i->string + i->state.pos;
+  const int *trans = d->trans;
+  int state = 0, final = 0;
+  long j = 0, n = i->length - i->state.pos;
+  long k = d->accept[0] ? 0 : -1;
+
+  while (j < n) {
+    state = trans[state * 256 + s[j]];
+    if (state < 0) { break; }
+    j++;
+    if (d->loops[state]) {
+      j += mpc_class_span(d->loops[state], (const char*)s + j, n - j);
+    }
+    if (d->accept[state]) { k = j; final = state; }
+  }
+
+  *stop = j;
+  if (k < 0) { return -1; }
+
+  *o = mpc_malloc(i, k + 1);
+  memcpy(*o, s, k);
+  (*o)[k] = '\0';
+  mpc_input_advance(i, (const char*)s, k);
+  return final;
+}
+
+/*
+** Error Type
+*/
+
+void mpc_err_delete(mpc_err_t *x) {
+  int i;
+  for (i = 0; i < x->expected_num; i++) { free(x->expected[i]); }
+  free(x->expected);
+  free(x->filename);
+  free(x->failure);
+  free(x);
+}
+
+void mpc_err_print(mpc_err_t *x) {
+  mpc_err_print_to(x, stdout);
+}
+
+void mpc_err_print_to(mpc_err_t *x, FILE *f) {
+  char *str = mpc_err_string(x);
+  fprintf(f, "%s", str);
+  free(str);
+}
+
+static void mpc_err_string_cat(char *buffer, int *pos, int *max, char const *fmt, ...) {
+  /* TODO: Error Checking on Length */
+  int left = ((*max) - (*pos));
+  va_list va;
+  va_start(va, fmt);
+  if (left < 0) { left = 0;}
+  (*pos) += vsprintf(buffer + (*pos), fmt, va);
+  va_end(va);
+}
+
+static const char *mpc_err_char_unescape(char c, char *buffer) {
+  
+  buffer[0] = '\'';
+  buffer[1] = ' ';
+  buffer[2] = '\'';
+  buffer[3] = '\0';
+  
+  switch (c) {
+    case '\a': return "bell";
+    case '\b': return "backspace";
+    case '\f': return "formfeed";
+    case '\r': return "carriage return";
+    case '\v': return "vertical tab";
+    case '\0': return "end of input";
+    case '\n': return "newline";
+    case '\t': return "tab";
+    case ' ' : return "space";
+    default:
+      buffer[1] = c;
+      return buffer;
+  }
+  
+}
+
+char *mpc_err_string(mpc_err_t *x) {
+
+  int i;  
+  int pos = 0; 
+  int max = 1023;
+  char quoted[4];
+  char *buffer = calloc(1, 1024);
+  
+  if (x->failure) {
+    mpc_err_string_cat(buffer, &pos, &max,
+    "%s: error: %s\n", x->filename, x->failure);
+    return buffer;
+  }
+  
+  mpc_err_string_cat(buffer, &pos, &max, 
+    "%s:%i:%i: error: expected ", x->filename, x->state.row+1, x->state.col+1);
+  
+  if (x->expected_num == 0) { mpc_err_string_cat(buffer, &pos, &max, "ERROR: NOTHING EXPECTED"); }
+  if (x->expected_num == 1) { mpc_err_string_cat(buffer, &pos, &max, "%s", x->expected[0]); }
+  if (x->expected_num >= 2) {
+  
+    for (i = 0; i < x->expected_num-2; i++) {
+      mpc_err_string_cat(buffer, &pos, &max, "%s, ", x->expected[i]);
+    } 
+    
+    mpc_err_string_cat(buffer, &pos, &max, "%s or %s", 
+      x->expected[x->expected_num-2], 
+      x->expected[x->expected_num-1]);
+  }
+  
+  mpc_err_string_cat(buffer, &pos, &max, " at ");
+  mpc_err_string_cat(buffer, &pos, &max, mpc_err_char_unescape(x->recieved, quoted));
+  mpc_err_string_cat(buffer, &pos, &max, "\n");
+  
+  return realloc(buffer, strlen(buffer) + 1);
+}
+
+/*
+** A failing parser which reports an error puts
+** it in the pending slot of the input and returns
+** the marker below as its error. Nothing else can
+** fail before the pending error is either recorded
+** or regrouped by its parent.
+*/
+
+static mpc_err_t mpc_err_marker;
+
+static mpc_err_t *mpc_err_pending(mpc_input_t *i, const char *msg, int failure) {
+  mpc_err_pending_t *x = &i->err_pending;
+  if (i->suppress || i->state.pos < i->err_state.pos) { return NULL; }
+  x->state = i->state;
+  x->recieved = failure ? ' ' : mpc_input_peekc(i);
+  x->entry.msg = msg;
+  x->entry.failure = failure;
+  x->entry.group = MPC_ERR_GROUP_NONE;
+  return &mpc_err_marker;
+}
+
+static mpc_err_t *mpc_err_new(mpc_input_t *i, const char *expected) {
+  return mpc_err_pending(i, expected, 0);
+}
+
+static mpc_err_t *mpc_err_fail(mpc_input_t *i, const char *failure) {
+  return mpc_err_pending(i, failure, 1);
+}
+
+static mpc_err_t *mpc_err_file(const char *filename, const char *failure) {
+  mpc_err_t *x;
+  x = malloc(sizeof(mpc_err_t));
+  x->filename = malloc(strlen(filename) + 1);
+  strcpy(x->filename, filename);
+  x->state = mpc_state_new();
+  x->expected_num = 0;
+  x->expected = NULL;
+  x->failure = malloc(strlen(failure) + 1);
+  strcpy(x->failure, failure);
+  x->recieved = ' ';
+  return x;
+}
+
+static void mpc_err_reset(mpc_input_t *i) {
+  i->err_state = mpc_state_invalid();
+  i->err_recieved = ' ';
+  i->err_failed = 0;
+  i->err_num = 0;
+}
+
+/*
+** Errors at a position before the furthest are
+** dropped, as are any after a failure message at
+** the furthest position. Repeats of an entry
+** already seen there are skipped by pointer.
+*/
+
+static void mpc_err_record_entry(mpc_input_t *i, mpc_state_t s, char recieved, const mpc_err_entry_t *x) {
+  
+  int j;
+  
+  if (s.pos < i->err_state.pos) { return; }
+  if (s.pos > i->err_state.pos) {
+    i->err_state = s;
+    i->err_failed = 0;
+    i->err_num = 0;
+  }
+  
+  if (i->err_failed) { return; }
+  if (!x->failure) { i->err_recieved = recieved; }
+  
+  for (j = 0; j < i->err_num; j++) {
+    if (i->errs[j].msg == x->msg
+    &&  i->errs[j].group == x->group
+    &&  i->errs[j].failure == x->failure) { return; }
+  }
+  
+  if (i->err_num == i->err_slots) {
+    i->err_slots = i->err_slots ? i->err_slots * 2 : MPC_ERR_ENTRIES_MIN;
+    i->errs = realloc(i->errs, sizeof(mpc_err_entry_t) * i->err_slots);
+  }
+  
+  i->errs[i->err_num++] = *x;
+  if (x->failure) { i->err_failed = 1; }
+}
+
+static void mpc_err_record(mpc_input_t *i, mpc_err_t *x) {
+  if (x == NULL) { return; }
+  mpc_err_record_entry(i, i->err_pending.state, i->err_pending.recieved, &i->err_pending.entry);
+}
+
+static char *mpc_err_entry_string(mpc_input_t *i, const mpc_err_entry_t *x) {
+  
+  char prefix[32];
+  char *s;
+  
+  if      (x->group == MPC_ERR_GROUP_MANY1) { strcpy(prefix, "one or more of "); }
+  else if (x->group > 0)                    { sprintf(prefix, "%i of ", x->group); }
+  else                                      { prefix[0] = '\0'; }
+  
+  s = mpc_malloc(i, strlen(prefix) + strlen(x->msg) + 1);
+  strcpy(s, prefix);
+  strcat(s, x->msg);
+  return s;
+}
+
+/*
+** `many1` and `count` report the error of their
+** child prefixed with how many were expected.
+*/
+
+static mpc_err_t *mpc_err_group(mpc_input_t *i, mpc_err_t *x, int group) {
+  mpc_err_entry_t *e = &i->err_pending.entry;
+  if (x == NULL || e->failure) { return x; }
+  if (e->group != MPC_ERR_GROUP_NONE) { e->msg = mpc_err_entry_string(i, e); }
+  e->group = group;
+  return x;
+}
+
+static mpc_err_t *mpc_err_many1(mpc_input_t *i, mpc_err_t *x) {
+  return mpc_err_group(i, x, MPC_ERR_GROUP_MANY1);
+}
+
+static mpc_err_t *mpc_err_count(mpc_input_t *i, mpc_err_t *x, int n) {
+  return mpc_err_group(i, x, n);
+}
+
+/*
+** When a regex combinator stops it leaves behind
+** the errors of every repetition or option that was
+** tried at the final position. A DFA match reports
+** the same errors for the state it finished in.
+*/
+
+static void mpc_err_report(mpc_input_t *i, const char **expected, unsigned long report) {
+  
+  int j;
+  char recieved;
+  mpc_err_entry_t x;
+  
+  if (i->suppress || i->state.pos < i->err_state.pos) { return; }
+  if (report == 0) { return; }
+  
+  recieved = mpc_input_peekc(i);
+  x.failure = 0;
+  x.group = MPC_ERR_GROUP_NONE;
+  
+  for (j = 0; (report >> j) != 0; j++) {
+    if (report & (1ul << j)) {
+      x.msg = expected[j];
+      mpc_err_record_entry(i, i->state, recieved, &x);
+    }
+  }
+}
+
+static void mpc_err_dfa(mpc_input_t *i, mpc_dfa_t *d, int state) {
+  mpc_err_report(i, (const char**)d->expected, d->reports[state]);
+}
+
+/*
+** Builds the error for a failed parse from what
+** was recorded at the furthest position.
+*/
+
+static mpc_err_t *mpc_err_build(mpc_input_t *i) {
+  
+  int j, k;
+  char *x;
+  mpc_err_t *e = malloc(sizeof(mpc_err_t));
+  
+  e->filename = malloc(strlen(i->filename) + 1);
+  strcpy(e->filename, i->filename);
+  e->state = i->err_state;
+  e->expected_num = 0;
+  e->expected = NULL;
+  e->failure = NULL;
+  e->recieved = i->err_recieved;
+  
+  if (i->err_state.pos < 0) {
+    e->failure = malloc(strlen("Unknown Error") + 1);
+    strcpy(e->failure, "Unknown Error");
+    return e;
+  }
+  
+  for (j = 0; j < i->err_num; j++) {
+    
+    if (i->errs[j].failure) {
+      e->failure = malloc(strlen(i->errs[j].msg) + 1);
+      strcpy(e->failure, i->errs[j].msg);
+      break;
+    }
+    
+    x = mpc_export(i, mpc_err_entry_string(i, &i->errs[j]));
+    
+    for (k = 0; k < e->expected_num; k++) {
+      if (strcmp(e->expected[k], x) == 0) { break; }
+    }
+    
+    if (k < e->expected_num) { free(x); continue; }
+    
+    e->expected_num++;
+    e->expected = realloc(e->expected, sizeof(char*) * e->expected_num);
+    e->expected[e->expected_num-1] = x;
+  }
+  
+  return e;
+}
+
+/*
+** Parser Type
+*/
+
+enum {
+  MPC_TYPE_UNDEFINED = 0,
+  MPC_TYPE_PASS      = 1,
+  MPC_TYPE_FAIL      = 2,
+  MPC_TYPE_LIFT      = 3,
+  MPC_TYPE_LIFT_VAL  = 4,
+  MPC_TYPE_EXPECT    = 5,
+  MPC_TYPE_ANCHOR    = 6,
+  MPC_TYPE_STATE     = 7,
+  
+  MPC_TYPE_ANY       = 8,
+  MPC_TYPE_SINGLE    = 9,
+  MPC_TYPE_ONEOF     = 10,
+  MPC_TYPE_NONEOF    = 11,
+  MPC_TYPE_RANGE     = 12,
+  MPC_TYPE_SATISFY   = 13,
+  MPC_TYPE_STRING    = 14,
+  
+  MPC_TYPE_APPLY     = 15,
+  MPC_TYPE_APPLY_TO  = 16,
+  MPC_TYPE_PREDICT   = 17,
+  MPC_TYPE_NOT       = 18,
+  MPC_TYPE_MAYBE     = 19,
+  MPC_TYPE_MANY      = 20,
+  MPC_TYPE_MANY1     = 21,
+  MPC_TYPE_COUNT     = 22,
+  
+  MPC_TYPE_OR        = 23,
+  MPC_TYPE_AND       = 24,
+  
+  MPC_TYPE_DFA       = 25
+};
+
+typedef struct { char *m; } mpc_pdata_fail_t;
+typedef struct { mpc_ctor_t lf; void *x; } mpc_pdata_lift_t;
+typedef struct { mpc_parser_t *x; char *m; } mpc_pdata_expect_t;
+typedef struct { int(*f)(char,char); } mpc_pdata_anchor_t;
+typedef struct { char x; } mpc_pdata_single_t;
+typedef struct { char x; char y; } mpc_pdata_range_t;
+typedef struct { int(*f)(char); } mpc_pdata_satisfy_t;
+typedef struct { char *x; } mpc_pdata_string_t;
+typedef struct { char *x; mpc_class_t *c; } mpc_pdata_class_t;
+typedef struct { mpc_parser_t *x; mpc_apply_t f; } mpc_pdata_apply_t;
+typedef struct { mpc_parser_t *x; mpc_apply_to_t f; void *d; } mpc_pdata_apply_to_t;
+typedef struct { mpc_parser_t *x; } mpc_pdata_predict_t;
+typedef struct { mpc_parser_t *x; mpc_dtor_t dx; mpc_ctor_t lf; } mpc_pdata_not_t;
+typedef struct { int n; mpc_fold_t f; mpc_parser_t *x; mpc_dtor_t dx; } mpc_pdata_repeat_t;
+typedef struct { int n; mpc_parser_t **xs; } mpc_pdata_or_t;
+typedef struct { int n; mpc_fold_t f; mpc_parser_t **xs; mpc_dtor_t *dxs;  } mpc_pdata_and_t;
+typedef struct { mpc_dfa_t *d; mpc_parser_t *x; } mpc_pdata_dfa_t;
+
+typedef union {
+  mpc_pdata_fail_t fail;
+  mpc_pdata_lift_t lift;
+  mpc_pdata_expect_t expect;
+  mpc_pdata_anchor_t anchor;
+  mpc_pdata_single_t single;
+  mpc_pdata_range_t range;
+  mpc_pdata_satisfy_t satisfy;
+  mpc_pdata_string_t string;
+  mpc_pdata_class_t cls;
+  mpc_pdata_apply_t apply;
+  mpc_pdata_apply_to_t apply_to;
+  mpc_pdata_predict_t predict;
+  mpc_pdata_not_t not;
+  mpc_pdata_repeat_t repeat;
+  mpc_pdata_and_t and;
+  mpc_pdata_or_t or;
+  mpc_pdata_dfa_t dfa;
+} mpc_pdata_t;
+
+struct mpc_parser_t {
+  char *name;
+  mpc_pdata_t data;
+  char type;
+  char retained;
+};
+
+static void mpc_dfa_delete(mpc_dfa_t *d) {
+  int i;
+  for (i = 0; i < d->expected_num; i++) { free(d->expected[i]); }
+  for (i = 0; i < d->states_num; i++) { free(d->loops[i]); }
+  free(d->expected);
+  free(d->loops);
+  free(d->reports);
+  free(d->trans);
+  free(d->accept);
+  free(d);
+}
+
+static mpc_dfa_t *mpc_dfa_copy(mpc_dfa_t *d) {
+  int i;
+  mpc_dfa_t *c = malloc(sizeof(mpc_dfa_t));
+  c->states_num = d->states_num;
+  c->trans = malloc(sizeof(int) * 256 * d->states_num);
+  c->accept = malloc(d->states_num);
+  c->reports = malloc(sizeof(unsigned long) * d->states_num);
+  memcpy(c->trans, d->trans, sizeof(int) * 256 * d->states_num);
+  memcpy(c->accept, d->accept, d->states_num);
+  memcpy(c->reports, d->reports, sizeof(unsigned long) * d->states_num);
+  c->expected_num = d->expected_num;
+  c->expected = malloc(sizeof(char*) * d->expected_num);
+  for (i = 0; i < d->expected_num; i++) {
+    c->expected[i] = malloc(strlen(d->expected[i]) + 1);
+    strcpy(c->expected[i], d->expected[i]);
+  }
+  c->loops = malloc(sizeof(mpc_class_t*) * d->states_num);
+  for (i = 0; i < d->states_num; i++) {
+    c->loops[i] = d->loops[i] ? mpc_class_copy(d->loops[i]) : NULL;
+  }
+  return c;
+}
+
+static mpc_val_t *mpcf_input_nth_free(mpc_input_t *i, int n, mpc_val_t **xs, int x) {
+  int j;
+  for (j = 0; j < n; j++) { if (j != x) { mpc_free(i, xs[j]); } }
+  return xs[x];
+}
+ 
+static mpc_val_t *mpcf_input_fst_free(mpc_input_t *i, int n, mpc_val_t **xs) { return mpcf_input_nth_free(i, n, xs, 0); }
+static mpc_val_t *mpcf_input_snd_free(mpc_input_t *i, int n, mpc_val_t **xs) { return mpcf_input_nth_free(i, n, xs, 1); }
+static mpc_val_t *mpcf_input_trd_free(mpc_input_t *i, int n, mpc_val_t **xs) { return mpcf_input_nth_free(i, n, xs, 2); }
+
+static mpc_val_t *mpcf_input_strfold(mpc_input_t *i, int n, mpc_val_t **xs) {
+  int j;
+  size_t l = 0;
+  if (n == 0) { return mpc_calloc(i, 1, 1); }
+  for (j = 0; j < n; j++) { l += strlen(xs[j]); }
+  xs[0] = mpc_realloc(i, xs[0], l + 1);
+  for (j = 1; j < n; j++) { strcat(xs[0], xs[j]); mpc_free(i, xs[j]); }
+  return xs[0];
+}
+
+static mpc_val_t *mpcf_input_state_ast(mpc_input_t *i, int n, mpc_val_t **xs) {
+  mpc_state_t *s = ((mpc_state_t**)xs)[0];
+  mpc_ast_t *a = ((mpc_ast_t**)xs)[1];
+  a = mpc_ast_state(a, *s);
+  mpc_free(i, s);
+  (void) n;
+  return a;
+}
+
+/*
+** AST Arena
+*/
+
+static mpc_ast_arena_t *mpc_ast_arena_new(void) {
+  mpc_ast_arena_t *s = calloc(1, sizeof(mpc_ast_arena_t));
+  s->tags_slots = MPC_AST_TAGS_MIN;
+  s->tags = calloc(s->tags_slots, sizeof(char*));
+  return s;
+}
+
+static void mpc_ast_arena_clear(mpc_ast_arena_t *s) {
+  
+  mpc_mem_chunk_t *k = s->chunks, *n;
+  if (k == NULL) { return; }
+  
+  n = k->next;
+  k->next = NULL;
+  while (n) { k = n->next; free(n); n = k; }
+  
+  s->bump = (char*)(s->chunks + 1);
+  s->end = s->bump + s->chunks->size;
+}
+
+static void mpc_ast_arena_delete(mpc_ast_arena_t *s) {
+  int j;
+  mpc_mem_chunk_t *k = s->chunks, *n;
+  while (k) { n = k->next; free(k); k = n; }
+  for (j = 0; j < s->tags_slots; j++) { free(s->tags[j]); }
+  free(s->tags);
+  free(s);
+}
+
+static void *mpc_ast_arena_alloc(mpc_ast_arena_t *s, size_t n) {
+  
+  size_t size;
+  char *p;
+  mpc_mem_chunk_t *k;
+  
+  n = (n + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  
+  if ((size_t)(s->end - s->bump) < n) {
+    size = s->chunks ? s->chunks->size * 2 : MPC_AST_CHUNK_MIN;
+    while (size < n) { size *= 2; }
+    k = malloc(sizeof(mpc_mem_chunk_t) + size);
+    k->next = s->chunks;
+    k->size = size;
+    s->chunks = k;
+    s->bump = (char*)(k + 1);
+    s->end = s->bump + size;
+  }
+  
+  p = s->bump;
+  s->bump += n;
+  return p;
+}
+
+static unsigned long mpc_ast_arena_hash(const char *x) {
+  unsigned long h = 2166136261ul;
+  while (*x) { h = (h ^ (unsigned char)*x++) * 16777619ul; }
+  return h;
+}
+
+static char *mpc_ast_arena_intern(mpc_ast_arena_t *s, const char *x) {
+  
+  int j, slots;
+  char **tags;
+  unsigned long h = mpc_ast_arena_hash(x);
+  
+  j = (int)(h & (unsigned long)(s->tags_slots - 1));
+  while (s->tags[j]) {
+    if (strcmp(s->tags[j], x) == 0) { return s->tags[j]; }
+    j = (j + 1) & (s->tags_slots - 1);
+  }
+  
+  s->tags[j] = malloc(strlen(x) + 1);
+  strcpy(s->tags[j], x);
+  s->tags_num++;
+  
+  if (s->tags_num * 2 > s->tags_slots) {
+    
+    slots = s->tags_slots * 2;
+    tags = calloc(slots, sizeof(char*));
+    
+    for (j = 0; j < s->tags_slots; j++) {
+      if (s->tags[j] == NULL) { continue; }
+      h = mpc_ast_arena_hash(s->tags[j]) & (unsigned long)(slots - 1);
+      while (tags[h]) { h = (h + 1) & (unsigned long)(slots - 1); }
+      tags[h] = s->tags[j];
+    }
+    
+    free(s->tags);
+    s->tags = tags;
+    s->tags_slots = slots;
+    return mpc_ast_arena_intern(s, x);
+  }
+  
+  return s->tags[j];
+}
+
+/*
+** Combines two tags as `mpc_ast_tag`,
+** `mpc_ast_add_tag` or `mpc_ast_add_root_tag`
+** would, returning the interned result.
+*/
+
+static char *mpc_ast_arena_tag(mpc_ast_arena_t *s, int op, const char *a, const char *b) {
+  
+  char *x, *r;
+  size_t la, lb;
+  mpc_ast_cache_t *c = &s->cache[
+    (((size_t)a >> 3) ^ ((size_t)b >> 5) ^ (size_t)op) & (MPC_AST_CACHE_SIZE - 1)];
+  
+  if (c->r && c->op == op && c->a == a && c->b == b) { return c->r; }
+  
+  la = strlen(a);
+  lb = b ? strlen(b) : 0;
+  x = malloc(la + lb + 2);
+  
+  switch (op) {
+    case MPC_AST_TAG_ADD:
+      memcpy(x, a, la); x[la] = '|'; memcpy(x + la + 1, b, lb + 1);
+      break;
+    case MPC_AST_TAG_ROOT:
+      memcpy(x, a, la - 1); memcpy(x + la - 1, b, lb + 1);
+      break;
+    default:
+      memcpy(x, a, la + 1);
+      break;
+  }
+  
+  r = mpc_ast_arena_intern(s, x);
+  free(x);
+  
+  c->op = op; c->a = a; c->b = b; c->r = r;
+  return r;
+}
+
+static mpc_ast_t *mpc_ast_arena_span(mpc_ast_arena_t *s, const char *tag, const char *contents, size_t n) {
+  mpc_ast_t *a = mpc_ast_arena_alloc(s, sizeof(mpc_ast_t));
+  a->tag = mpc_ast_arena_tag(s, MPC_AST_TAG_SET, tag, NULL);
+  a->contents = mpc_ast_arena_alloc(s, n + 1);
+  memcpy(a->contents, contents, n);
+  a->contents[n] = '\0';
+  a->state = mpc_state_new();
+  a->children_num = 0;
+  a->children = NULL;
+  a->rule = 0;
+  a->token = MPC_AST_TOKEN_NONE;
+  return a;
+}
+
+static mpc_ast_t *mpc_ast_arena_node(mpc_ast_arena_t *s, const char *tag, const char *contents) {
+  return mpc_ast_arena_span(s, tag, contents, strlen(contents));
+}
+
+static mpc_ast_t *mpc_ast_arena_add_root(mpc_ast_arena_t *s, mpc_ast_t *a) {
+  mpc_ast_t *r;
+  if (a == NULL || a->children_num <= 1) { return a; }
+  r = mpc_ast_arena_node(s, ">", "");
+  r->children = mpc_ast_arena_alloc(s, sizeof(mpc_ast_t*));
+  r->children[0] = a;
+  r->children_num = 1;
+  return r;
+}
+
+static mpc_ast_t *mpc_ast_arena_fold(mpc_ast_arena_t *s, int n, mpc_ast_t **as) {
+  
+  int i, j, k = 0;
+  mpc_ast_t *r, *c;
+  
+  if (n == 0) { return NULL; }
+  if (n == 1) { return as[0]; }
+  if (n == 2 && as[1] == NULL) { return as[0]; }
+  if (n == 2 && as[0] == NULL) { return as[1]; }
+  
+  for (i = 0; i < n; i++) {
+    if (as[i] == NULL) { continue; }
+    k += as[i]->children_num >= 2 ? as[i]->children_num : 1;
+  }
+  
+  r = mpc_ast_arena_node(s, ">", "");
+  if (k) { r->children = mpc_ast_arena_alloc(s, sizeof(mpc_ast_t*) * k); }
+  
+  for (i = 0; i < n; i++) {
+    
+    if (as[i] == NULL) { continue; }
+    
+    if (as[i]->children_num == 0) {
+      r->children[r->children_num++] = as[i];
+    } else if (as[i]->children_num == 1) {
+      c = as[i]->children[0];
+      c->tag = mpc_ast_arena_tag(s, MPC_AST_TAG_ROOT, as[i]->tag, c->tag);
+      r->children[r->children_num++] = c;
+    } else {
+      for (j = 0; j < as[i]->children_num; j++) {
+        r->children[r->children_num++] = as[i]->children[j];
+      }
+    }
+  
+  }
+  
+  if (r->children_num) {
+    r->state = r->children[0]->state;
+  }
+  
+  return r;
+}
+
+static mpc_val_t *mpc_parse_fold(mpc_input_t *i, mpc_fold_t f, int n, mpc_val_t **xs) {
+  int j;
+  if (f == mpcf_null)      { return mpcf_null(n, xs); }
+  if (f == mpcf_fst)       { return mpcf_fst(n, xs); }
+  if (f == mpcf_snd)       { return mpcf_snd(n, xs); }
+  if (f == mpcf_trd)       { return mpcf_trd(n, xs); }
+  if (f == mpcf_fst_free)  { return mpcf_input_fst_free(i, n, xs); }
+  if (f == mpcf_snd_free)  { return mpcf_input_snd_free(i, n, xs); }
+  if (f == mpcf_trd_free)  { return mpcf_input_trd_free(i, n, xs); }
+  if (f == mpcf_strfold)   { return mpcf_input_strfold(i, n, xs); }
+  if (f == mpcf_state_ast) { return mpcf_input_state_ast(i, n, xs); }
+  if (f == mpcf_fold_ast && i->ast) { return mpc_ast_arena_fold(i->ast, n, (mpc_ast_t**)xs); }
+  for (j = 0; j < n; j++) { xs[j] = mpc_export(i, xs[j]); }
+  return f(j, xs);
+}
+
+static mpc_val_t *mpcf_input_free(mpc_input_t *i, mpc_val_t *x) {
+  mpc_free(i, x);
+  return NULL;
+}
+
+static mpc_val_t *mpcf_input_str_ast(mpc_input_t *i, mpc_val_t *c) {
+  mpc_ast_t *a = i->ast ? mpc_ast_arena_node(i->ast, "", c) : mpc_ast_new("", c);
+  mpc_free(i, c);
+  return a;
+}
+
+static mpc_val_t *mpc_parse_apply(mpc_input_t *i, mpc_apply_t f, mpc_val_t *x) {
+  if (f == mpcf_free)     { return mpcf_input_free(i, x); }
+  if (f == mpcf_str_ast)  { return mpcf_input_str_ast(i, x); }
+  if (f == (mpc_apply_t)mpc_ast_add_root && i->ast) { return mpc_ast_arena_add_root(i->ast, x); }
+  return f(mpc_export(i, x));
+}
+
+static mpc_val_t *mpc_parse_apply_to(mpc_input_t *i, mpc_apply_to_t f, mpc_val_t *x, mpc_val_t *d) {
+  
+  mpc_ast_t *a = x;
+  
+  if (i->ast && a && f == (mpc_apply_to_t)mpc_ast_tag) {
+    a->tag = mpc_ast_arena_tag(i->ast, MPC_AST_TAG_SET, d, NULL);
+    return a;
+  }
+  
+  if (i->ast && a && f == (mpc_apply_to_t)mpc_ast_add_tag) {
+    a->tag = mpc_ast_arena_tag(i->ast, MPC_AST_TAG_ADD, d, a->tag);
+    return a;
+  }
+  
+  return f(mpc_export(i, x), d);
+}
+
+static void mpc_parse_dtor(mpc_input_t *i, mpc_dtor_t d, mpc_val_t *x) {
+  if (d == free) { mpc_free(i, x); return; }
+  if (d == (mpc_dtor_t)mpc_ast_delete && i->ast) { return; }
+  d(mpc_export(i, x));
+}
+
+enum {
+  MPC_PARSE_STACK_MIN = 4
+};
+
+#define MPC_SUCCESS(x) r->output = x; return 1
+#define MPC_FAILURE(x) r->error = x; return 0
+#define MPC_PRIMITIVE(x) \
+  if (x) { MPC_SUCCESS(r->output); } \
+  else { MPC_FAILURE(NULL); }
+
+/*
+** A repetition of a single character class which
+** is folded into a string can be scanned as one
+** run rather than a character at a time. Returns
+** the class if `p` is such a repetition.
+*/
+
+static mpc_class_t *mpc_parse_span_class(mpc_parser_t *p) {
+  mpc_parser_t *x;
+  if (p->data.repeat.f != mpcf_strfold) { return NULL; }
+  x = p->data.repeat.x;
+  while (x->type == MPC_TYPE_EXPECT) { x = x->data.expect.x; }
+  if (x->type != MPC_TYPE_ONEOF && x->type != MPC_TYPE_NONEOF) { return NULL; }
+  return x->data.cls.c;
+}
+
+static int mpc_parse_run(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r) {
+  
+  int j = 0, k = 0;
+  long l = 0;
+  mpc_class_t *c;
+  mpc_result_t results_stk[MPC_PARSE_STACK_MIN];
+  mpc_result_t *results;
+  int results_slots = MPC_PARSE_STACK_MIN;
+  
+  switch (p->type) {
+      
+    /* Basic Parsers */
+
+    case MPC_TYPE_ANY:     MPC_PRIMITIVE(mpc_input_any(i, (char**)&r->output));
+    case MPC_TYPE_SINGLE:  MPC_PRIMITIVE(mpc_input_char(i, p->data.single.x, (char**)&r->output));
+    case MPC_TYPE_RANGE:   MPC_PRIMITIVE(mpc_input_range(i, p->data.range.x, p->data.range.y, (char**)&r->output));
+    case MPC_TYPE_ONEOF:   MPC_PRIMITIVE(mpc_input_oneof(i, p->data.cls.c, (char**)&r->output));
+    case MPC_TYPE_NONEOF:  MPC_PRIMITIVE(mpc_input_oneof(i, p->data.cls.c, (char**)&r->output));
+    case MPC_TYPE_SATISFY: MPC_PRIMITIVE(mpc_input_satisfy(i, p->data.satisfy.f, (char**)&r->output));
+    case MPC_TYPE_STRING:  MPC_PRIMITIVE(mpc_input_string(i, p->data.string.x, (char**)&r->output));
+    case MPC_TYPE_ANCHOR:  MPC_PRIMITIVE(mpc_input_anchor(i, p->data.anchor.f, (char**)&r->output));
+    
+    /* Other parsers */
+    
+    case MPC_TYPE_UNDEFINED: MPC_FAILURE(mpc_err_fail(i, "Parser Undefined!"));
+    case MPC_TYPE_PASS:      MPC_SUCCESS(NULL);
+    case MPC_TYPE_FAIL:      MPC_FAILURE(mpc_err_fail(i, p->data.fail.m));
+    case MPC_TYPE_LIFT:      MPC_SUCCESS(p->data.lift.lf());
+    case MPC_TYPE_LIFT_VAL:  MPC_SUCCESS(p->data.lift.x);
+    case MPC_TYPE_STATE:     MPC_SUCCESS(mpc_input_state_copy(i));
+    
+    /* Application Parsers */
+    
+    case MPC_TYPE_APPLY:
+      if (mpc_parse_run(i, p->data.apply.x, r)) {
+        MPC_SUCCESS(mpc_parse_apply(i, p->data.apply.f, r->output));
+      } else {
+        MPC_FAILURE(r->output);
+      }
+    
+    case MPC_TYPE_APPLY_TO:
+      if (mpc_parse_run(i, p->data.apply_to.x, r)) {
+        MPC_SUCCESS(mpc_parse_apply_to(i, p->data.apply_to.f, r->output, p->data.apply_to.d));
+      } else {
+        MPC_FAILURE(r->error);
+      }
+    
+    case MPC_TYPE_EXPECT:
+      mpc_input_suppress_enable(i);
+      if (mpc_parse_run(i, p->data.expect.x, r)) {
+        mpc_input_suppress_disable(i);
+        MPC_SUCCESS(r->output);
+      } else {
+        mpc_input_suppress_disable(i);
+        MPC_FAILURE(mpc_err_new(i, p->data.expect.m));
+      }
+    
+    case MPC_TYPE_PREDICT:
+      mpc_input_backtrack_disable(i);
+      if (mpc_parse_run(i, p->data.predict.x, r)) {      
+        mpc_input_backtrack_enable(i);
+        MPC_SUCCESS(r->output);
+      } else {
+        mpc_input_backtrack_enable(i);
+        MPC_FAILURE(r->error);
+      }
+    
+    /* Optional Parsers */
+    
+    /* TODO: Update Not Error Message */
+    
+    case MPC_TYPE_NOT:
+      mpc_input_mark(i);
+      mpc_input_suppress_enable(i);
+      if (mpc_parse_run(i, p->data.not.x, r)) {
+        mpc_input_rewind(i);
+        mpc_input_suppress_disable(i);
+        mpc_parse_dtor(i, p->data.not.dx, r->output);
+        MPC_FAILURE(mpc_err_new(i, "opposite"));
+      } else {
+        mpc_input_unmark(i);
+        mpc_input_suppress_disable(i);
+        MPC_SUCCESS(p->data.not.lf());
+      }
+    
+    case MPC_TYPE_MAYBE:
+      if (mpc_parse_run(i, p->data.not.x, r)) {
+        MPC_SUCCESS(r->output);
+      } else {
+        mpc_err_record(i, r->error);
+        MPC_SUCCESS(p->data.not.lf());
+      }
+    
+    /* Repeat Parsers */
+    
+    case MPC_TYPE_MANY:
+      
+      /* The run is followed by one more attempt at the class for its error */
+      if (i->type == MPC_INPUT_STRING
+      && (c = mpc_parse_span_class(p)) != NULL
+      &&  mpc_input_span(i, c, 0, (char**)&r->output)) {
+        mpc_parse_run(i, p->data.repeat.x, &results_stk[0]);
+        mpc_err_record(i, results_stk[0].error);
+        MPC_SUCCESS(r->output);
+      }
+      
+      results = results_stk;
+      
+      while (mpc_parse_run(i, p->data.repeat.x, &results[j])) {
+        j++;
+        if (j == MPC_PARSE_STACK_MIN) {
+          results_slots = j + j / 2;
+          results = mpc_malloc(i, sizeof(mpc_result_t) * results_slots);
+          memcpy(results, results_stk, sizeof(mpc_result_t) * MPC_PARSE_STACK_MIN);
+        } else if (j >= results_slots) {
+          results_slots = j + j / 2;
+          results = mpc_realloc(i, results, sizeof(mpc_result_t) * results_slots);
+        }
+      }
+      
+      mpc_err_record(i, results[j].error);
+      MPC_SUCCESS(
+        mpc_parse_fold(i, p->data.repeat.f, j, (mpc_val_t**)results);
+        if (j >= MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+    
+    case MPC_TYPE_MANY1:
+      
+      if (i->type == MPC_INPUT_STRING
+      && (c = mpc_parse_span_class(p)) != NULL
+      &&  mpc_input_span(i, c, 1, (char**)&r->output)) {
+        mpc_parse_run(i, p->data.repeat.x, &results_stk[0]);
+        mpc_err_record(i, results_stk[0].error);
+        MPC_SUCCESS(r->output);
+      }
+      
+      results = results_stk;
+      
+      while (mpc_parse_run(i, p->data.repeat.x, &results[j])) {
+        j++;
+        if (j == MPC_PARSE_STACK_MIN) {
+          results_slots = j + j / 2;
+          results = mpc_malloc(i, sizeof(mpc_result_t) * results_slots);
+          memcpy(results, results_stk, sizeof(mpc_result_t) * MPC_PARSE_STACK_MIN);
+        } else if (j >= results_slots) {
+          results_slots = j + j / 2;
+          results = mpc_realloc(i, results, sizeof(mpc_result_t) * results_slots);
+        }
+      }
+      
+      if (j == 0) {
+        MPC_FAILURE(
+          mpc_err_many1(i, results[j].error);
+          if (j >= MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+      } else {
+        mpc_err_record(i, results[j].error);
+        MPC_SUCCESS(
+          mpc_parse_fold(i, p->data.repeat.f, j, (mpc_val_t**)results);
+          if (j >= MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+      }
+    
+    case MPC_TYPE_COUNT:
+      
+      results = p->data.repeat.n > MPC_PARSE_STACK_MIN
+        ? mpc_malloc(i, sizeof(mpc_result_t) * p->data.repeat.n)
+        : results_stk;
+      
+      while (mpc_parse_run(i, p->data.repeat.x, &results[j])) {
+        j++;
+        if (j == p->data.repeat.n) { break; }
+      }
+      
+      if (j == p->data.repeat.n) {
+        MPC_SUCCESS(
+          mpc_parse_fold(i, p->data.repeat.f, j, (mpc_val_t**)results);
+          if (p->data.repeat.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+      } else {
+        for (k = 0; k < j; k++) {
+          mpc_parse_dtor(i, p->data.repeat.dx, results[k].output);
+        }
+        MPC_FAILURE(
+          mpc_err_count(i, results[j].error, p->data.repeat.n);
+          if (p->data.repeat.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });  
+      }
+      
+    /* Combinatory Parsers */
+    
+    case MPC_TYPE_OR:
+      
+      if (p->data.or.n == 0) { MPC_SUCCESS(NULL); }
+      
+      results = p->data.or.n > MPC_PARSE_STACK_MIN
+        ? mpc_malloc(i, sizeof(mpc_result_t) * p->data.or.n)
+        : results_stk;
+      
+      for (j = 0; j < p->data.or.n; j++) {
+        if (mpc_parse_run(i, p->data.or.xs[j], &results[j])) {
+          MPC_SUCCESS(results[j].output;
+            if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+        } else {
+          mpc_err_record(i, results[j].error);
+        } 
+      }
+      
+      MPC_FAILURE(NULL;
+        if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+    
+    case MPC_TYPE_AND:
+      
+      if (p->data.and.n == 0) { MPC_SUCCESS(NULL); }
+      
+      results = p->data.or.n > MPC_PARSE_STACK_MIN
+        ? mpc_malloc(i, sizeof(mpc_result_t) * p->data.or.n)
+        : results_stk;
+      
+      mpc_input_mark(i);
+      for (j = 0; j < p->data.and.n; j++) {
+        if (!mpc_parse_run(i, p->data.and.xs[j], &results[j])) {
+          mpc_input_rewind(i);
+          for (k = 0; k < j; k++) {
+            mpc_parse_dtor(i, p->data.and.dxs[k], results[k].output);
+          }
+          MPC_FAILURE(results[j].error;
+            if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+        }
+      }
+      mpc_input_unmark(i); 
+      MPC_SUCCESS(
+        mpc_parse_fold(i, p->data.and.f, j, (mpc_val_t**)results);
+        if (p->data.or.n > MPC_PARSE_STACK_MIN) { mpc_free(i, results); });
+    
+    /* Compiled Parsers */
+    
+    /*
+    ** The DFA only runs over string input. On any
+    ** other input, or when it fails, the original
+    ** combinator is run instead so that behaviour
+    ** and error messages are unchanged. A failure
+    ** which cannot reach the furthest error so far
+    ** is not worth running again.
+    */
+    
+    case MPC_TYPE_DFA:
+      if (i->type == MPC_INPUT_STRING) {
+        j = mpc_input_dfa(i, p->data.dfa.d, &l, (char**)&r->output);
+        if (j >= 0) {
+          mpc_err_dfa(i, p->data.dfa.d, j);
+          MPC_SUCCESS(r->output);
+        }
+        /* The combinator fails no further on than the DFA */
+        if (i->suppress || i->state.pos + l < i->err_state.pos) { MPC_FAILURE(NULL); }
+      }
+      return mpc_parse_run(i, p->data.dfa.x, r);
+    
+    /* End */
+    
+    default:
+      
+      MPC_FAILURE(mpc_err_fail(i, "Unknown Parser Type Id!"));
+  }
+  
+  return 0;
+  
+}
+
+#undef MPC_SUCCESS
+#undef MPC_FAILURE
+#undef MPC_PRIMITIVE
+
+static mpc_err_t *mpc_parse_error(mpc_input_t *i, mpc_err_t *x) {
+  /* Only a failure returned from the top keeps what was expected before it */
+  if (i->err_failed) {
+    i->errs[0] = i->errs[i->err_num-1];
+    i->err_num = 1;
+  }
+  mpc_err_record(i, x);
+  return mpc_err_build(i);
+}
+
+int mpc_parse_input(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r) {
+  int x;
+  mpc_err_reset(i);
+  x = mpc_parse_run(i, p, r);
+  if (x) {
+    r->output = mpc_export(i, r->output);
+  } else {
+    r->error = mpc_parse_error(i, r->error);
+  }
+  return x;
+}
+
+int mpc_parse(const char *filename, const char *string, mpc_parser_t *p, mpc_result_t *r) {
+  int x;
+  mpc_input_t *i = mpc_input_new_string(filename, string);
+  x = mpc_parse_input(i, p, r);
+  mpc_input_delete(i);
+  return x;
+}
+
+int mpc_nparse(const char *filename, const char *string, size_t length, mpc_parser_t *p, mpc_result_t *r) {
+  int x;
+  mpc_input_t *i = mpc_input_new_nstring(filename, string, length);
+  x = mpc_parse_input(i, p, r);
+  mpc_input_delete(i);
+  return x;
+}
+
+int mpc_parse_file(const char *filename, FILE *file, mpc_parser_t *p, mpc_result_t *r) {
+  int x;
+  mpc_input_t *i = mpc_input_new_file(filename, file);
+  x = mpc_parse_input(i, p, r);
+  mpc_input_delete(i);
+  return x;
+}
+
+int mpc_parse_pipe(const char *filename, FILE *pipe, mpc_parser_t *p, mpc_result_t *r) {
+  int x;
+  mpc_input_t *i = mpc_input_new_pipe(filename, pipe);
+  x = mpc_parse_input(i, p, r);
+  mpc_input_delete(i);
+  return x;
+}
+
+int mpc_parse_contents(const char *filename, mpc_parser_t *p, mpc_result_t *r) {
+  
+  FILE *f = fopen(filename, "rb");
+  int res;
+  
+  if (f == NULL) {
+    r->output = NULL;
+    r->error = mpc_err_file(filename, "Unable to open file!");
+    return 0;
+  }
+  
+  res = mpc_parse_file(filename, f, p, r);
+  fclose(f);
+  return res;
+}
+
+/*
+** Parse Contexts
+*/
+
+/*
+** A context keeps one string input alive across
+** many parses. Its marks, filename buffer and
+** scratch arena are reset rather than freed, and
+** the string being parsed is read in place, so a
+** small parse costs little more than the parse
+** itself.
+**
+** With `MPC_CONTEXT_AST_ARENA` the syntax trees
+** built by the `mpca` functions are allocated in
+** the context. A tree stays valid until the next
+** parse or `mpc_context_clear` and is released
+** with it, so it must not be passed to
+** `mpc_ast_delete`. Tags are cached by address,
+** so the context should be cleared if the grammar
+** is rebuilt.
+**
+** `mpc_context_origin` sets the row and column
+** each parse starts counting from, so a piece cut
+** out of a longer stream reports positions in the
+** stream rather than in the piece.
+*/
+
+enum {
+  MPC_CONTEXT_FILENAME_MIN = 64
+};
+
+struct mpc_context_t {
+  int flags;
+  size_t filename_slots;
+  mpc_state_t origin;
+  mpc_input_t input;
+};
+
+mpc_context_t *mpc_context_new(int flags) {
+  
+  mpc_context_t *c = malloc(sizeof(mpc_context_t));
+  mpc_input_t *i = &c->input;
+  
+  c->flags = flags;
+  c->filename_slots = MPC_CONTEXT_FILENAME_MIN;
+  c->origin = mpc_state_new();
+  
+  i->filename = malloc(c->filename_slots);
+  i->filename[0] = '\0';
+  i->type = MPC_INPUT_STRING;
+  i->state = mpc_state_new();
+  
+  i->string = NULL;
+  i->length = 0;
+  i->buffer = NULL;
+  i->file = NULL;
+  
+  i->suppress = 0;
+  i->backtrack = 1;
+  i->marks_num = 0;
+  i->marks_slots = MPC_INPUT_MARKS_MIN;
+  i->marks = malloc(sizeof(mpc_state_t) * i->marks_slots);
+  i->lasts = malloc(sizeof(char) * i->marks_slots);
+  i->last = '\0';
+  
+  mpc_mem_init(i);
+  
+  if (flags & MPC_CONTEXT_AST_ARENA) { i->ast = mpc_ast_arena_new(); }
+  
+  return c;
+}
+
+void mpc_context_delete(mpc_context_t *c) {
+  free(c->input.filename);
+  free(c->input.marks);
+  free(c->input.lasts);
+  if (c->input.ast) { mpc_ast_arena_delete(c->input.ast); }
+  mpc_mem_release(&c->input);
+  free(c);
+}
+
+void mpc_context_origin(mpc_context_t *c, long row, long col) {
+  c->origin.row = row;
+  c->origin.col = col;
+}
+
+void mpc_context_clear(mpc_context_t *c) {
+  if (c->input.ast == NULL) { return; }
+  mpc_ast_arena_clear(c->input.ast);
+  memset(c->input.ast->cache, 0, sizeof(c->input.ast->cache));
+}
+
+static mpc_input_t *mpc_context_begin(mpc_context_t *c, const char *filename, const char *string, size_t length) {
+  
+  mpc_input_t *i = &c->input;
+  size_t n = strlen(filename) + 1;
+  const char *end = memchr(string, '\0', length);
+  
+  if (c->input.ast) { mpc_ast_arena_clear(c->input.ast); }
+  
+  if (n > c->filename_slots) {
+    c->filename_slots = n;
+    i->filename = realloc(i->filename, n);
+  }
+  memcpy(i->filename, filename, n);
+  
+  /* Like mpc_nparse the input stops at any terminator */
+  i->string = (char*)string;
+  i->length = end ? (long)(end - string) : (long)length;
+  
+  i->state = c->origin;
+  i->suppress = 0;
+  i->backtrack = 1;
+  i->marks_num = 0;
+  i->last = '\0';
+  
+  return i;
+}
+
+static void mpc_context_end(mpc_context_t *c) {
+  c->input.string = NULL;
+  mpc_mem_reset(&c->input);
+}
+
+int mpc_context_nparse(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_parser_t *p, mpc_result_t *r) {
+  int x = mpc_parse_input(mpc_context_begin(c, filename, string, length), p, r);
+  mpc_context_end(c);
+  return x;
+}
+
+int mpc_context_parse(mpc_context_t *c, const char *filename, const char *string, mpc_parser_t *p, mpc_result_t *r) {
+  return mpc_context_nparse(c, filename, string, strlen(string), p, r);
+}
+
+/*
+** Generated Parsers
+*/
+
+/*
+** Code written by `mpc_codegen` runs over the
+** string of a context directly and calls back in
+** here only to record errors and build trees, so
+** both behave exactly as they do for the parser
+** the code was generated from. The cursor lives
+** in the `mpc_gen_t` and is copied onto the input
+** whenever the input needs to see it.
+*/
+
+static int mpc_boundary_anchor(char prev, char next);
+
+static mpc_input_t *mpc_gen_input(mpc_gen_t *g) {
+  mpc_input_t *i = &g->context->input;
+  i->state = g->state;
+  i->suppress = g->suppress;
+  return i;
+}
+
+void mpc_gen_expect(mpc_gen_t *g, const char *m) {
+  g->err = mpc_err_new(mpc_gen_input(g), m) != NULL;
+}
+
+void mpc_gen_failure(mpc_gen_t *g, const char *m) {
+  g->err = mpc_err_fail(mpc_gen_input(g), m) != NULL;
+}
+
+void mpc_gen_record(mpc_gen_t *g) {
+  if (g->err) { mpc_err_record(&g->context->input, &mpc_err_marker); }
+}
+
+void mpc_gen_many1(mpc_gen_t *g) {
+  if (g->err) { mpc_err_many1(&g->context->input, &mpc_err_marker); }
+}
+
+void mpc_gen_count(mpc_gen_t *g, int n) {
+  if (g->err) { mpc_err_count(&g->context->input, &mpc_err_marker, n); }
+}
+
+void mpc_gen_report(mpc_gen_t *g, const char **expected, unsigned long report) {
+  mpc_err_report(mpc_gen_input(g), expected, report);
+}
+
+int mpc_gen_reaches(mpc_gen_t *g, long pos) {
+  return !g->suppress && pos >= g->context->input.err_state.pos;
+}
+
+int mpc_gen_boundary(mpc_gen_t *g) {
+  long pos = g->state.pos;
+  return mpc_boundary_anchor(
+    pos > 0 ? g->string[pos-1] : '\0',
+    pos < g->length ? g->string[pos] : '\0');
+}
+
+void mpc_gen_advance(mpc_gen_t *g, long n) {
+  const char *s = g->string + g->state.pos;
+  const char *e = s + n;
+  for (; s < e; s++) {
+    if (*s == '\n') { g->state.row++; g->state.col = 0; }
+    else { g->state.col++; }
+  }
+  g->state.pos += n;
+}
+
+mpc_val_t *mpc_gen_str_ast(mpc_gen_t *g, long start, long end) {
+  
+  mpc_ast_t *a;
+  mpc_input_t *i = &g->context->input;
+  size_t n = (size_t)(end - start);
+  
+  if (i->ast) { return mpc_ast_arena_span(i->ast, "", g->string + start, n); }
+  
+  a = mpc_ast_new("", "");
+  a->contents = realloc(a->contents, n + 1);
+  memcpy(a->contents, g->string + start, n);
+  a->contents[n] = '\0';
+  return a;
+}
+
+mpc_val_t *mpc_gen_tag(mpc_gen_t *g, mpc_val_t *x, const char *t) {
+  mpc_ast_t *a = x;
+  mpc_input_t *i = &g->context->input;
+  if (i->ast == NULL) { return mpc_ast_tag(a, t); }
+  a->tag = mpc_ast_arena_tag(i->ast, MPC_AST_TAG_SET, t, NULL);
+  return a;
+}
+
+mpc_val_t *mpc_gen_add_tag(mpc_gen_t *g, mpc_val_t *x, const char *t) {
+  mpc_ast_t *a = x;
+  mpc_input_t *i = &g->context->input;
+  if (i->ast == NULL || a == NULL) { return mpc_ast_add_tag(a, t); }
+  a->tag = mpc_ast_arena_tag(i->ast, MPC_AST_TAG_ADD, t, a->tag);
+  return a;
+}
+
+mpc_val_t *mpc_gen_add_root(mpc_gen_t *g, mpc_val_t *x) {
+  mpc_input_t *i = &g->context->input;
+  if (i->ast == NULL) { return mpc_ast_add_root(x); }
+  return mpc_ast_arena_add_root(i->ast, x);
+}
+
+mpc_val_t *mpc_gen_fold(mpc_gen_t *g, int n, mpc_val_t **xs) {
+  mpc_input_t *i = &g->context->input;
+  if (i->ast == NULL) { return mpcf_fold_ast(n, xs); }
+  return mpc_ast_arena_fold(i->ast, n, (mpc_ast_t**)xs);
+}
+
+void mpc_gen_push(mpc_gen_t *g, mpc_val_t *x) {
+  if (g->stack_num == g->stack_slots) {
+    g->stack_slots = g->stack_slots ? g->stack_slots * 2 : MPC_PARSE_STACK_MIN;
+    g->stack = g->stack
+      ? mpc_realloc(&g->context->input, g->stack, sizeof(mpc_val_t*) * g->stack_slots)
+      : mpc_malloc(&g->context->input, sizeof(mpc_val_t*) * g->stack_slots);
+  }
+  g->stack[g->stack_num++] = x;
+}
+
+mpc_val_t *mpc_gen_fold_stack(mpc_gen_t *g, int base) {
+  mpc_val_t *x = mpc_gen_fold(g, g->stack_num - base, g->stack + base);
+  g->stack_num = base;
+  return x;
+}
+
+void mpc_gen_drop(mpc_gen_t *g, int base) {
+  while (g->stack_num > base) { mpc_gen_delete(g, g->stack[--g->stack_num]); }
+}
+
+void mpc_gen_delete(mpc_gen_t *g, mpc_val_t *x) {
+  if (g->context->input.ast == NULL) { mpc_ast_delete(x); }
+}
+
+int mpc_gen_nparse(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_gen_rule_t f, mpc_result_t *r) {
+  
+  int x;
+  mpc_gen_t g;
+  mpc_input_t *i;
+  mpc_context_t *t = c ? c : mpc_context_new(MPC_CONTEXT_DEFAULT);
+  
+  i = mpc_context_begin(t, filename, string, length);
+  mpc_err_reset(i);
+  
+  g.string = i->string;
+  g.length = i->length;
+  g.state = i->state;
+  g.suppress = 0;
+  g.backtrack = 1;
+  g.err = 0;
+  g.stack_num = 0;
+  g.stack_slots = 0;
+  g.stack = NULL;
+  g.context = t;
+  
+  x = f(&g, &r->output);
+  if (!x) { r->error = mpc_parse_error(mpc_gen_input(&g), g.err ? &mpc_err_marker : NULL); }
+  
+  mpc_free(i, g.stack);
+  mpc_context_end(t);
+  if (c == NULL) { mpc_context_delete(t); }
+  return x;
+}
+
+int mpc_gen_parse(mpc_context_t *c, const char *filename, const char *string, mpc_gen_rule_t f, mpc_result_t *r) {
+  return mpc_gen_nparse(c, filename, string, strlen(string), f, r);
+}
+
+/*
+** Building a Parser
+*/
+
+static void mpc_undefine_unretained(mpc_parser_t *p, int force);
+
+static void mpc_undefine_or(mpc_parser_t *p) {
+  
+  int i;
+  for (i = 0; i < p->data.or.n; i++) {
+    mpc_undefine_unretained(p->data.or.xs[i], 0);
+  }
+  free(p->data.or.xs);
+  
+}
+
+static void mpc_undefine_and(mpc_parser_t *p) {
+  
+  int i;
+  for (i = 0; i < p->data.and.n; i++) {
+    mpc_undefine_unretained(p->data.and.xs[i], 0);
+  }
+  free(p->data.and.xs);
+  free(p->data.and.dxs);
+  
+}
+
+static void mpc_undefine_unretained(mpc_parser_t *p, int force) {
+  
+  if (p->retained && !force) { return; }
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_FAIL: free(p->data.fail.m); break;
+    
+    case MPC_TYPE_ONEOF: 
+    case MPC_TYPE_NONEOF:
+      free(p->data.cls.x);
+      free(p->data.cls.c);
+      break;
+    
+    case MPC_TYPE_STRING:
+      free(p->data.string.x); 
+      break;
+    
+    case MPC_TYPE_APPLY:    mpc_undefine_unretained(p->data.apply.x, 0);    break;
+    case MPC_TYPE_APPLY_TO: mpc_undefine_unretained(p->data.apply_to.x, 0); break;
+    case MPC_TYPE_PREDICT:  mpc_undefine_unretained(p->data.predict.x, 0);  break;
+    
+    case MPC_TYPE_MAYBE:
+    case MPC_TYPE_NOT:
+      mpc_undefine_unretained(p->data.not.x, 0);
+      break;
+    
+    case MPC_TYPE_EXPECT:
+      mpc_undefine_unretained(p->data.expect.x, 0);
+      free(p->data.expect.m);
+      break;
+      
+    case MPC_TYPE_MANY:
+    case MPC_TYPE_MANY1:
+    case MPC_TYPE_COUNT:
+      mpc_undefine_unretained(p->data.repeat.x, 0);
+      break;
+    
+    case MPC_TYPE_OR:  mpc_undefine_or(p);  break;
+    case MPC_TYPE_AND: mpc_undefine_and(p); break;
+    
+    case MPC_TYPE_DFA:
+      mpc_dfa_delete(p->data.dfa.d);
+      mpc_undefine_unretained(p->data.dfa.x, 0);
+      break;
+    
+    default: break;
+  }
+  
+  if (!force) {
+    free(p->name);
+    free(p);
+  }
+  
+}
+
+void mpc_delete(mpc_parser_t *p) {
+  if (p->retained) {
+
+    if (p->type != MPC_TYPE_UNDEFINED) {
+      mpc_undefine_unretained(p, 0);
+    } 
+    
+    free(p->name);
+    free(p);
+  
+  } else {
+    mpc_undefine_unretained(p, 0);  
+  }
+}
+
+static void mpc_soft_delete(mpc_val_t *x) {
+  mpc_undefine_unretained(x, 0);
+}
+
+static mpc_parser_t *mpc_undefined(void) {
+  mpc_parser_t *p = calloc(1, sizeof(mpc_parser_t));
+  p->retained = 0;
+  p->type = MPC_TYPE_UNDEFINED;
+  p->name = NULL;
+  return p;
+}
+
+mpc_parser_t *mpc_new(const char *name) {
+  mpc_parser_t *p = mpc_undefined();
+  p->retained = 1;
+  p->name = realloc(p->name, strlen(name) + 1);
+  strcpy(p->name, name);
+  return p;
+}
+
+mpc_parser_t *mpc_copy(mpc_parser_t *a) {
+  int i = 0;
+  mpc_parser_t *p;
+  
+  if (a->retained) { return a; }
+  
+  p = mpc_undefined();
+  p->retained = a->retained;
+  p->type = a->type;
+  p->data = a->data;
+  
+  if (a->name) {
+    p->name = malloc(strlen(a->name)+1);
+    strcpy(p->name, a->name);
+  }
+  
+  switch (a->type) {
+    
+    case MPC_TYPE_FAIL:
+      p->data.fail.m = malloc(strlen(a->data.fail.m)+1);
+      strcpy(p->data.fail.m, a->data.fail.m);
+    break;
+    
+    case MPC_TYPE_ONEOF: 
+    case MPC_TYPE_NONEOF:
+      p->data.cls.x = malloc(strlen(a->data.cls.x)+1);
+      strcpy(p->data.cls.x, a->data.cls.x);
+      p->data.cls.c = mpc_class_copy(a->data.cls.c);
+      break;
+    
+    case MPC_TYPE_STRING:
+      p->data.string.x = malloc(strlen(a->data.string.x)+1);
+      strcpy(p->data.string.x, a->data.string.x);
+      break;
+    
+    case MPC_TYPE_APPLY:    p->data.apply.x    = mpc_copy(a->data.apply.x);    break;
+    case MPC_TYPE_APPLY_TO: p->data.apply_to.x = mpc_copy(a->data.apply_to.x); break;
+    case MPC_TYPE_PREDICT:  p->data.predict.x  = mpc_copy(a->data.predict.x);  break;
+    
+    case MPC_TYPE_MAYBE:
+    case MPC_TYPE_NOT:
+      p->data.not.x = mpc_copy(a->data.not.x);
+      break;
+    
+    case MPC_TYPE_EXPECT:
+      p->data.expect.x = mpc_copy(a->data.expect.x);
+      p->data.expect.m = malloc(strlen(a->data.expect.m)+1);
+      strcpy(p->data.expect.m, a->data.expect.m);
+      break;
+      
+    case MPC_TYPE_MANY:
+    case MPC_TYPE_MANY1:
+    case MPC_TYPE_COUNT:
+      p->data.repeat.x = mpc_copy(a->data.repeat.x);
+      break;
+    
+    case MPC_TYPE_OR:
+      p->data.or.xs = malloc(a->data.or.n * sizeof(mpc_parser_t*));
+      for (i = 0; i < a->data.or.n; i++) {
+        p->data.or.xs[i] = mpc_copy(a->data.or.xs[i]);
+      }
+    break;
+    case MPC_TYPE_AND:
+      p->data.and.xs = malloc(a->data.and.n * sizeof(mpc_parser_t*));
+      for (i = 0; i < a->data.and.n; i++) {
+        p->data.and.xs[i] = mpc_copy(a->data.and.xs[i]);
+      }
+      p->data.and.dxs = malloc((a->data.and.n-1) * sizeof(mpc_dtor_t));
+      for (i = 0; i < a->data.and.n-1; i++) {
+        p->data.and.dxs[i] = a->data.and.dxs[i];
+      }
+    break;
+    
+    case MPC_TYPE_DFA:
+      p->data.dfa.d = mpc_dfa_copy(a->data.dfa.d);
+      p->data.dfa.x = mpc_copy(a->data.dfa.x);
+      break;
+    
+    default: break;
+  }
+
+  
+  return p;
+}
+
+mpc_parser_t *mpc_undefine(mpc_parser_t *p) {
+  mpc_undefine_unretained(p, 1);
+  p->type = MPC_TYPE_UNDEFINED;
+  return p;
+}
+
+mpc_parser_t *mpc_define(mpc_parser_t *p, mpc_parser_t *a) {
+  
+  if (p->retained) {
+    p->type = a->type;
+    p->data = a->data;
+  } else {
+    mpc_parser_t *a2 = mpc_failf("Attempt to assign to Unretained Parser!");
+    p->type = a2->type;
+    p->data = a2->data;
+    free(a2);
+  }
+  
+  free(a);
+  return p;  
+}
+
+void mpc_cleanup(int n, ...) {
+  int i;
+  mpc_parser_t **list = malloc(sizeof(mpc_parser_t*) * n);
+  
+  va_list va;
+  va_start(va, n);
+  for (i = 0; i < n; i++) { list[i] = va_arg(va, mpc_parser_t*); }
+  for (i = 0; i < n; i++) { mpc_undefine(list[i]); }
+  for (i = 0; i < n; i++) { mpc_delete(list[i]); }  
+  va_end(va);  
+
+  free(list);
+}
+
+mpc_parser_t *mpc_pass(void) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_PASS;
+  return p;
+}
+
+mpc_parser_t *mpc_fail(const char *m) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_FAIL;
+  p->data.fail.m = malloc(strlen(m) + 1);
+  strcpy(p->data.fail.m, m);
+  return p;
+}
+
+/*
+** As `snprintf` is not ANSI standard this 
+** function `mpc_failf` should be considered
+** unsafe.
+**
+** You have a few options if this is going to be
+** trouble.
+**
+** - Ensure the format string does not exceed
+**   the buffer length using precision specifiers
+**   such as `%.512s`.
+**
+** - Patch this function in your code base to 
+**   use `snprintf` or whatever variant your
+**   system supports.
+**
+** - Avoid it altogether.
+**
+*/
+
+mpc_parser_t *mpc_failf(const char *fmt, ...) {
+  
+  va_list va;
+  char *buffer;
+
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_FAIL;
+  
+  va_start(va, fmt);
+  buffer = malloc(2048);
+  vsprintf(buffer, fmt, va);
+  va_end(va);
+  
+  buffer = realloc(buffer, strlen(buffer) + 1);
+  p->data.fail.m = buffer;
+  return p;
+
+}
+
+mpc_parser_t *mpc_lift_val(mpc_val_t *x) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_LIFT_VAL;
+  p->data.lift.x = x;
+  return p;
+}
+
+mpc_parser_t *mpc_lift(mpc_ctor_t lf) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_LIFT;
+  p->data.lift.lf = lf;
+  return p;
+}
+
+mpc_parser_t *mpc_anchor(int(*f)(char,char)) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_ANCHOR;
+  p->data.anchor.f = f;
+  return mpc_expect(p, "anchor");
+}
+
+mpc_parser_t *mpc_state(void) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_STATE;
+  return p;
+}
+
+mpc_parser_t *mpc_expect(mpc_parser_t *a, const char *expected) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_EXPECT;
+  p->data.expect.x = a;
+  p->data.expect.m = malloc(strlen(expected) + 1);
+  strcpy(p->data.expect.m, expected);
+  return p;
+}
+
+/*
+** As `snprintf` is not ANSI standard this 
+** function `mpc_expectf` should be considered
+** unsafe.
+**
+** You have a few options if this is going to be
+** trouble.
+**
+** - Ensure the format string does not exceed
+**   the buffer length using precision specifiers
+**   such as `%.512s`.
+**
+** - Patch this function in your code base to 
+**   use `snprintf` or whatever variant your
+**   system supports.
+**
+** - Avoid it altogether.
+**
+*/
+
+mpc_parser_t *mpc_expectf(mpc_parser_t *a, const char *fmt, ...) {
+  va_list va;
+  char *buffer;
+
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_EXPECT;
+  
+  va_start(va, fmt);
+  buffer = malloc(2048);
+  vsprintf(buffer, fmt, va);
+  va_end(va);
+  
+  buffer = realloc(buffer, strlen(buffer) + 1);
+  p->data.expect.x = a;
+  p->data.expect.m = buffer;
+  return p;
+}
+
+/*
+** Basic Parsers
+*/
+
+mpc_parser_t *mpc_any(void) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_ANY;
+  return mpc_expect(p, "any character");
+}
+
+mpc_parser_t *mpc_char(char c) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_SINGLE;
+  p->data.single.x = c;
+  return mpc_expectf(p, "'%c'", c);
+}
+
+mpc_parser_t *mpc_range(char s, char e) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_RANGE;
+  p->data.range.x = s;
+  p->data.range.y = e;
+  return mpc_expectf(p, "character between '%c' and '%c'", s, e);
+}
+
+/*
+** Builds a class parser from the set of member
+** characters. Like `strchr` a `oneof` treats the
+** terminator as a member and `noneof` rejects it.
+*/
+
+static mpc_parser_t *mpc_class(int type, const char *s, unsigned char *bits) {
+  
+  int j;
+  mpc_parser_t *p = mpc_undefined();
+  
+  bits[0] |= 1;
+  if (type == MPC_TYPE_NONEOF) {
+    for (j = 0; j < 32; j++) { bits[j] = (unsigned char)~bits[j]; }
+  }
+  
+  p->type = type;
+  p->data.cls.x = malloc(strlen(s) + 1);
+  strcpy(p->data.cls.x, s);
+  p->data.cls.c = mpc_class_new(bits);
+  
+  return type == MPC_TYPE_ONEOF
+    ? mpc_expectf(p, "one of '%s'", s)
+    : mpc_expectf(p, "none of '%s'", s);
+}
+
+static void mpc_class_bits(const char *s, unsigned char *bits) {
+  const unsigned char *u = (const unsigned char*)s;
+  memset(bits, 0, 32);
+  while (*u) { bits[*u >> 3] |= (unsigned char)(1 << (*u & 7)); u++; }
+}
+
+mpc_parser_t *mpc_oneof(const char *s) {
+  unsigned char bits[32];
+  mpc_class_bits(s, bits);
+  return mpc_class(MPC_TYPE_ONEOF, s, bits);
+}
+
+mpc_parser_t *mpc_noneof(const char *s) {
+  unsigned char bits[32];
+  mpc_class_bits(s, bits);
+  return mpc_class(MPC_TYPE_NONEOF, s, bits);
+}
+
+mpc_parser_t *mpc_satisfy(int(*f)(char)) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_SATISFY;
+  p->data.satisfy.f = f;
+  return mpc_expectf(p, "character satisfying function %p", f);
+}
+
+mpc_parser_t *mpc_string(const char *s) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_STRING;
+  p->data.string.x = malloc(strlen(s) + 1);
+  strcpy(p->data.string.x, s);
+  return mpc_expectf(p, "\"%s\"", s);
+}
+
+/*
+** Core Parsers
+*/
+
+mpc_parser_t *mpc_apply(mpc_parser_t *a, mpc_apply_t f) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_APPLY;
+  p->data.apply.x = a;
+  p->data.apply.f = f;
+  return p;
+}
+
+mpc_parser_t *mpc_apply_to(mpc_parser_t *a, mpc_apply_to_t f, void *x) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_APPLY_TO;
+  p->data.apply_to.x = a;
+  p->data.apply_to.f = f;
+  p->data.apply_to.d = x;
+  return p;
+}
+
+mpc_parser_t *mpc_predictive(mpc_parser_t *a) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_PREDICT;
+  p->data.predict.x = a;
+  return p;
+}
+
+mpc_parser_t *mpc_not_lift(mpc_parser_t *a, mpc_dtor_t da, mpc_ctor_t lf) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_NOT;
+  p->data.not.x = a;
+  p->data.not.dx = da;
+  p->data.not.lf = lf;
+  return p;
+}
+
+mpc_parser_t *mpc_not(mpc_parser_t *a, mpc_dtor_t da) {
+  return mpc_not_lift(a, da, mpcf_ctor_null);
+}
+
+mpc_parser_t *mpc_maybe_lift(mpc_parser_t *a, mpc_ctor_t lf) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_MAYBE;
+  p->data.not.x = a;
+  p->data.not.lf = lf;
+  return p;
+}
+
+mpc_parser_t *mpc_maybe(mpc_parser_t *a) {
+  return mpc_maybe_lift(a, mpcf_ctor_null);
+}
+
+mpc_parser_t *mpc_many(mpc_fold_t f, mpc_parser_t *a) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_MANY;
+  p->data.repeat.x = a;
+  p->data.repeat.f = f;
+  return p;
+}
+
+mpc_parser_t *mpc_many1(mpc_fold_t f, mpc_parser_t *a) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_MANY1;
+  p->data.repeat.x = a;
+  p->data.repeat.f = f;
+  return p;
+}
+
+mpc_parser_t *mpc_count(int n, mpc_fold_t f, mpc_parser_t *a, mpc_dtor_t da) {
+  mpc_parser_t *p = mpc_undefined();
+  p->type = MPC_TYPE_COUNT;
+  p->data.repeat.n = n;
+  p->data.repeat.f = f;
+  p->data.repeat.x = a;
+  p->data.repeat.dx = da;
+  return p;
+}
+
+mpc_parser_t *mpc_or(int n, ...) {
+
+  int i;
+  va_list va;
+
+  mpc_parser_t *p = mpc_undefined();
+  
+  p->type = MPC_TYPE_OR;
+  p->data.or.n = n;
+  p->data.or.xs = malloc(sizeof(mpc_parser_t*) * n);
+  
+  va_start(va, n);  
+  for (i = 0; i < n; i++) {
+    p->data.or.xs[i] = va_arg(va, mpc_parser_t*);
+  }
+  va_end(va);
+  
+  return p;
+}
+
+mpc_parser_t *mpc_and(int n, mpc_fold_t f, ...) {
+
+  int i;
+  va_list va;
+
+  mpc_parser_t *p = mpc_undefined();
+  
+  p->type = MPC_TYPE_AND;
+  p->data.and.n = n;
+  p->data.and.f = f;
+  p->data.and.xs = malloc(sizeof(mpc_parser_t*) * n);
+  p->data.and.dxs = malloc(sizeof(mpc_dtor_t) * (n-1));
+
+  va_start(va, f);  
+  for (i = 0; i < n; i++) {
+    p->data.and.xs[i] = va_arg(va, mpc_parser_t*);
+  }
+  for (i = 0; i < (n-1); i++) {
+    p->data.and.dxs[i] = va_arg(va, mpc_dtor_t);
+  }  
+  va_end(va);
+  
+  return p;
+}
+
+/*
+** Common Parsers
+*/
+
+static int mpc_soi_anchor(char prev, char next) { (void) next; return (prev == '\0'); }
+static int mpc_eoi_anchor(char prev, char next) { (void) prev; return (next == '\0'); }
+
+mpc_parser_t *mpc_soi(void) { return mpc_expect(mpc_anchor(mpc_soi_anchor), "start of input"); }
+mpc_parser_t *mpc_eoi(void) { return mpc_expect(mpc_anchor(mpc_eoi_anchor), "end of input"); }
+
+static int mpc_boundary_anchor(char prev, char next) {
+  const char* word = "abcdefghijklmnopqrstuvwxyz"
+                     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                     "0123456789_";
+  if ( strchr(word, next) &&  prev == '\0') { return 1; }
+  if ( strchr(word, prev) &&  next == '\0') { return 1; }
+  if ( strchr(word, next) && !strchr(word, prev)) { return 1; }
+  if (!strchr(word, next) &&  strchr(word, prev)) { return 1; }
+  return 0;
+}
+
+mpc_parser_t *mpc_boundary(void) { return mpc_expect(mpc_anchor(mpc_boundary_anchor), "boundary"); }
+
+mpc_parser_t *mpc_whitespace(void) { return mpc_expect(mpc_oneof(" \f\n\r\t\v"), "whitespace"); }
+mpc_parser_t *mpc_whitespaces(void) { return mpc_expect(mpc_many(mpcf_strfold, mpc_whitespace()), "spaces"); }
+mpc_parser_t *mpc_blank(void) { return mpc_expect(mpc_apply(mpc_whitespaces(), mpcf_free), "whitespace"); }
+
+mpc_parser_t *mpc_newline(void) { return mpc_expect(mpc_char('\n'), "newline"); }
+mpc_parser_t *mpc_tab(void) { return mpc_expect(mpc_char('\t'), "tab"); }
+mpc_parser_t *mpc_escape(void) { return mpc_and(2, mpcf_strfold, mpc_char('\\'), mpc_any(), free); }
+
+mpc_parser_t *mpc_digit(void) { return mpc_expect(mpc_oneof("0123456789"), "digit"); }
+mpc_parser_t *mpc_hexdigit(void) { return mpc_expect(mpc_oneof("0123456789ABCDEFabcdef"), "hex digit"); }
+mpc_parser_t *mpc_octdigit(void) { return mpc_expect(mpc_oneof("01234567"), "oct digit"); }
+mpc_parser_t *mpc_digits(void) { return mpc_expect(mpc_many1(mpcf_strfold, mpc_digit()), "digits"); }
+mpc_parser_t *mpc_hexdigits(void) { return mpc_expect(mpc_many1(mpcf_strfold, mpc_hexdigit()), "hex digits"); }
+mpc_parser_t *mpc_octdigits(void) { return mpc_expect(mpc_many1(mpcf_strfold, mpc_octdigit()), "oct digits"); }
+
+mpc_parser_t *mpc_lower(void) { return mpc_expect(mpc_oneof("abcdefghijklmnopqrstuvwxyz"), "lowercase letter"); }
+mpc_parser_t *mpc_upper(void) { return mpc_expect(mpc_oneof("ABCDEFGHIJKLMNOPQRSTUVWXYZ"), "uppercase letter"); }
+mpc_parser_t *mpc_alpha(void) { return mpc_expect(mpc_oneof("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"), "letter"); }
+mpc_parser_t *mpc_underscore(void) { return mpc_expect(mpc_char('_'), "underscore"); }
+mpc_parser_t *mpc_alphanum(void) { return mpc_expect(mpc_or(3, mpc_alpha(), mpc_digit(), mpc_underscore()), "alphanumeric"); }
+
+mpc_parser_t *mpc_int(void) { return mpc_expect(mpc_apply(mpc_digits(), mpcf_int), "integer"); }
+mpc_parser_t *mpc_hex(void) { return mpc_expect(mpc_apply(mpc_hexdigits(), mpcf_hex), "hexadecimal"); }
+mpc_parser_t *mpc_oct(void) { return mpc_expect(mpc_apply(mpc_octdigits(), mpcf_oct), "octadecimal"); }
+mpc_parser_t *mpc_number(void) { return mpc_expect(mpc_or(3, mpc_int(), mpc_hex(), mpc_oct()), "number"); }
+
+mpc_parser_t *mpc_real(void) {
+
+  /* [+-]?\d+(\.\d+)?([eE][+-]?[0-9]+)? */
+  
+  mpc_parser_t *p0, *p1, *p2, *p30, *p31, *p32, *p3;
+  
+  p0 = mpc_maybe_lift(mpc_oneof("+-"), mpcf_ctor_str);
+  p1 = mpc_digits();
+  p2 = mpc_maybe_lift(mpc_and(2, mpcf_strfold, mpc_char('.'), mpc_digits(), free), mpcf_ctor_str);
+  p30 = mpc_oneof("eE");
+  p31 = mpc_maybe_lift(mpc_oneof("+-"), mpcf_ctor_str);
+  p32 = mpc_digits();
+  p3 = mpc_maybe_lift(mpc_and(3, mpcf_strfold, p30, p31, p32, free, free), mpcf_ctor_str);
+  
+  return mpc_expect(mpc_and(4, mpcf_strfold, p0, p1, p2, p3, free, free, free), "real");
+
+}
+
+mpc_parser_t *mpc_float(void) {
+  return mpc_expect(mpc_apply(mpc_real(), mpcf_float), "float");
+}
+
+mpc_parser_t *mpc_char_lit(void) {
+  return mpc_expect(mpc_between(mpc_or(2, mpc_escape(), mpc_any()), free, "'", "'"), "char");
+}
+
+mpc_parser_t *mpc_string_lit(void) {
+  mpc_parser_t *strchar = mpc_or(2, mpc_escape(), mpc_noneof("\""));
+  return mpc_expect(mpc_between(mpc_many(mpcf_strfold, strchar), free, "\"", "\""), "string");
+}
+
+mpc_parser_t *mpc_regex_lit(void) {  
+  mpc_parser_t *regexchar = mpc_or(2, mpc_escape(), mpc_noneof("/"));
+  return mpc_expect(mpc_between(mpc_many(mpcf_strfold, regexchar), free, "/", "/"), "regex");
+}
+
+mpc_parser_t *mpc_ident(void) {
+  mpc_parser_t *p0, *p1; 
+  p0 = mpc_or(2, mpc_alpha(), mpc_underscore());
+  p1 = mpc_many(mpcf_strfold, mpc_alphanum()); 
+  return mpc_and(2, mpcf_strfold, p0, p1, free);
+}
+
+/*
+** Useful Parsers
+*/
+
+mpc_parser_t *mpc_startwith(mpc_parser_t *a) { return mpc_and(2, mpcf_snd, mpc_soi(), a, mpcf_dtor_null); }
+mpc_parser_t *mpc_endwith(mpc_parser_t *a, mpc_dtor_t da) { return mpc_and(2, mpcf_fst, a, mpc_eoi(), da); }
+mpc_parser_t *mpc_whole(mpc_parser_t *a, mpc_dtor_t da) { return mpc_and(3, mpcf_snd, mpc_soi(), a, mpc_eoi(), mpcf_dtor_null, da); }
+
+mpc_parser_t *mpc_stripl(mpc_parser_t *a) { return mpc_and(2, mpcf_snd, mpc_blank(), a, mpcf_dtor_null); }
+mpc_parser_t *mpc_stripr(mpc_parser_t *a) { return mpc_and(2, mpcf_fst, a, mpc_blank(), mpcf_dtor_null); }
+mpc_parser_t *mpc_strip(mpc_parser_t *a) { return mpc_and(3, mpcf_snd, mpc_blank(), a, mpc_blank(), mpcf_dtor_null, mpcf_dtor_null); }
+mpc_parser_t *mpc_tok(mpc_parser_t *a) { return mpc_and(2, mpcf_fst, a, mpc_blank(), mpcf_dtor_null); }
+mpc_parser_t *mpc_sym(const char *s) { return mpc_tok(mpc_string(s)); }
+
+mpc_parser_t *mpc_total(mpc_parser_t *a, mpc_dtor_t da) { return mpc_whole(mpc_strip(a), da); }
+
+mpc_parser_t *mpc_between(mpc_parser_t *a, mpc_dtor_t ad, const char *o, const char *c) {
+  return mpc_and(3, mpcf_snd_free,
+    mpc_string(o), a, mpc_string(c),
+    free, ad);
+}
+
+mpc_parser_t *mpc_parens(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_between(a, ad, "(", ")"); }
+mpc_parser_t *mpc_braces(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_between(a, ad, "<", ">"); }
+mpc_parser_t *mpc_brackets(mpc_parser_t *a, mpc_dtor_t ad) { return mpc_between(a, ad, "{", "}"); }
+mpc_parser_t *mpc_squares(mpc_parser_t *a, mpc_dtor_t ad)  { return mpc_between(a, ad, "[", "]"); }
+
+mpc_parser_t *mpc_tok_between(mpc_parser_t *a, mpc_dtor_t ad, const char *o, const char *c) {
+  return mpc_and(3, mpcf_snd_free,
+    mpc_sym(o), mpc_tok(a), mpc_sym(c),
+    free, ad);
+}
+
+mpc_parser_t *mpc_tok_parens(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_tok_between(a, ad, "(", ")"); }
+mpc_parser_t *mpc_tok_braces(mpc_parser_t *a, mpc_dtor_t ad)   { return mpc_tok_between(a, ad, "<", ">"); }
+mpc_parser_t *mpc_tok_brackets(mpc_parser_t *a, mpc_dtor_t ad) { return mpc_tok_between(a, ad, "{", "}"); }
+mpc_parser_t *mpc_tok_squares(mpc_parser_t *a, mpc_dtor_t ad)  { return mpc_tok_between(a, ad, "[", "]"); }
+
+/*
+** Regular Expression Parsers
+*/
+
+/*
+** So here is a cute bootstrapping.
+**
+** I'm using the previously defined
+** mpc constructs and functions to
+** parse the user regex string and
+** construct a parser from it.
+**
+** As it turns out lots of the standard
+** mpc functions look a lot like `fold`
+** functions and so can be used indirectly
+** by many of the parsing functions to build
+** a parser directly - as we are parsing.
+**
+** This is certainly something that
+** would be less elegant/interesting 
+** in a two-phase parser which first
+** builds an AST and then traverses it
+** to generate the object.
+**
+** This whole thing acts as a great
+** case study for how trivial it can be
+** to write a great parser in a few
+** lines of code using mpc.
+*/
+
+/*
+**
+**  ### Regular Expression Grammar
+**
+**      <regex> : <term> | (<term> "|" <regex>)
+**     
+**      <term> : <factor>*
+**
+**      <factor> : <base>
+**               | <base> "*"
+**               | <base> "+"
+**               | <base> "?"
+**               | <base> "{" <digits> "}"
+**           
+**      <base> : <char>
+**             | "\" <char>
+**             | "(" <regex> ")"
+**             | "[" <range> "]"
+*/
+
+static mpc_val_t *mpcf_re_or(int n, mpc_val_t **xs) {
+  (void) n;
+  if (xs[1] == NULL) { return xs[0]; }
+  else { return mpc_or(2, xs[0], xs[1]); }
+}
+
+static mpc_val_t *mpcf_re_and(int n, mpc_val_t **xs) {
+  int i;
+  mpc_parser_t *p = mpc_lift(mpcf_ctor_str);
+  for (i = 0; i < n; i++) {
+    p = mpc_and(2, mpcf_strfold, p, xs[i], free);
+  }
+  return p;
+}
+
+static mpc_val_t *mpcf_re_repeat(int n, mpc_val_t **xs) {
+  int num;
+  (void) n;
+  if (xs[1] == NULL) { return xs[0]; }
+  switch(((char*)xs[1])[0])
+  {
+    case '*': { free(xs[1]); return mpc_many(mpcf_strfold, xs[0]); }; break;
+    case '+': { free(xs[1]); return mpc_many1(mpcf_strfold, xs[0]); }; break;
+    case '?': { free(xs[1]); return mpc_maybe_lift(xs[0], mpcf_ctor_str); }; break;
+    default:
+      num = *(int*)xs[1];
+      free(xs[1]);
+  }
+  
+  return mpc_count(num, mpcf_strfold, xs[0], free);
+}
+
+static mpc_parser_t *mpc_re_escape_char(char c) {
+  switch (c) {
+    case 'a': return mpc_char('\a');
+    case 'f': return mpc_char('\f');
+    case 'n': return mpc_char('\n');
+    case 'r': return mpc_char('\r');
+    case 't': return mpc_char('\t');
+    case 'v': return mpc_char('\v');
+    case 'b': return mpc_and(2, mpcf_snd, mpc_boundary(), mpc_lift(mpcf_ctor_str), free);
+    case 'B': return mpc_not_lift(mpc_boundary(), free, mpcf_ctor_str);
+    case 'A': return mpc_and(2, mpcf_snd, mpc_soi(), mpc_lift(mpcf_ctor_str), free);
+    case 'Z': return mpc_and(2, mpcf_snd, mpc_eoi(), mpc_lift(mpcf_ctor_str), free);
+    case 'd': return mpc_digit();
+    case 'D': return mpc_not_lift(mpc_digit(), free, mpcf_ctor_str);
+    case 's': return mpc_whitespace();
+    case 'S': return mpc_not_lift(mpc_whitespace(), free, mpcf_ctor_str);
+    case 'w': return mpc_alphanum();
+    case 'W': return mpc_not_lift(mpc_alphanum(), free, mpcf_ctor_str);
+    default: return NULL;
+  }
+}
+
+static mpc_val_t *mpcf_re_escape(mpc_val_t *x) {
+  
+  char *s = x;
+  mpc_parser_t *p;
+  
+  /* Regex Special Characters */
+  if (s[0] == '.') { free(s); return mpc_any(); }
+  if (s[0] == '^') { free(s); return mpc_and(2, mpcf_snd, mpc_soi(), mpc_lift(mpcf_ctor_str), free); }
+  if (s[0] == '$') { free(s); return mpc_and(2, mpcf_snd, mpc_eoi(), mpc_lift(mpcf_ctor_str), free); }
+  
+  /* Regex Escape */
+  if (s[0] == '\\') {
+    p = mpc_re_escape_char(s[1]);
+    p = (p == NULL) ? mpc_char(s[1]) : p;
+    free(s);
+    return p;
+  }
+  
+  /* Regex Standard */
+  p = mpc_char(s[0]);
+  free(s);
+  return p;
+}
+
+static const char *mpc_re_range_escape_char(char c) {
+  switch (c) {
+    case '-': return "-";
+    case 'a': return "\a";
+    case 'f': return "\f";
+    case 'n': return "\n";
+    case 'r': return "\r";
+    case 't': return "\t";
+    case 'v': return "\v";
+    case 'b': return "\b";
+    case 'd': return "0123456789";
+    case 's': return " \f\n\r\t\v";
+    case 'w': return "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    default: return NULL;
+  }
+}
+
+/*
+** Expands a regex range into the bitmap of its
+** member characters. The expansion is also kept
+** as a string, in order, to describe the class
+** in error messages.
+*/
+
+static void mpc_re_range_add(char **range, size_t *n, size_t *slots, unsigned char *bits, char c) {
+  unsigned char u = (unsigned char)c;
+  if (*n + 1 >= *slots) {
+    *slots = *slots * 2;
+    *range = realloc(*range, *slots);
+  }
+  (*range)[(*n)++] = c;
+  bits[u >> 3] |= (unsigned char)(1 << (u & 7));
+}
+
+static char *mpc_re_range_bits(const char *s, int comp, unsigned char *bits) {
+  
+  size_t i, l = strlen(s), n = 0, slots = l + 1;
+  int j, start, end;
+  const char *tmp = NULL;
+  char *range = malloc(slots);
+  
+  memset(bits, 0, 32);
+  
+  for (i = comp; i < l; i++){
+    
+    /* Regex Range Escape */
+    if (s[i] == '\\') {
+      if (s[i+1] == '\0') { break; }
+      tmp = mpc_re_range_escape_char(s[i+1]);
+      if (tmp != NULL) {
+        while (*tmp) { mpc_re_range_add(&range, &n, &slots, bits, *tmp++); }
+      } else {
+        mpc_re_range_add(&range, &n, &slots, bits, s[i+1]);
+      }
+      i++;
+    }
+    
+    /* Regex Range...Range */
+    else if (s[i] == '-') {
+      if (s[i+1] == '\0' || i == 0) {
+        mpc_re_range_add(&range, &n, &slots, bits, '-');
+      } else {
+        start = (unsigned char)s[i-1]+1;
+        end = (unsigned char)s[i+1]-1;
+        for (j = start; j <= end; j++) {
+          mpc_re_range_add(&range, &n, &slots, bits, (char)j);
+        }        
+      }
+    }
+    
+    /* Regex Range Normal */
+    else {
+      mpc_re_range_add(&range, &n, &slots, bits, s[i]);
+    }
+  
+  }
+  
+  range[n] = '\0';
+  return range;
+}
+
+static mpc_val_t *mpcf_re_range(mpc_val_t *x) {
+  
+  mpc_parser_t *out;
+  const char *s = x;
+  int comp = s[0] == '^' ? 1 : 0;
+  unsigned char bits[32];
+  char *range;
+  
+  if (s[0] == '\0') { free(x); return mpc_fail("Invalid Regex Range Expression"); } 
+  if (s[0] == '^' && 
+      s[1] == '\0') { free(x); return mpc_fail("Invalid Regex Range Expression"); }
+  
+  range = mpc_re_range_bits(s, comp, bits);
+  out = mpc_class(comp == 1 ? MPC_TYPE_NONEOF : MPC_TYPE_ONEOF, range, bits);
+  
+  free(x);
+  free(range);
+  
+  return out;
+}
+
+/*
+** Regular Expression DFA
+*/
+
+/*
+** Most token regexes are just a sequence of 
+** character classes, each maybe followed by
+** `*`, `+` or `?`, with a few alternatives.
+**
+** When no repeated class overlaps with what can
+** directly follow it, and all alternatives start
+** with different characters, the greedy combinator
+** parser can never backtrack and so matches exactly
+** the longest match of the equivalent DFA.
+**
+** Regexes of this shape are compiled into a table
+** using the position (Glushkov) automaton and the
+** subset construction. Everything else - groups,
+** anchors, counts, boundaries or overlapping
+** classes - keeps using the combinator alone.
+*/
+
+enum {
+  MPC_RE_DFA_POSITIONS_MAX = 31,
+  MPC_RE_DFA_STATES_MAX    = 256
+};
+
+typedef struct {
+  char set[256];
+  char rep;
+  int end;
+  char *expected;
+} mpc_re_pos_t;
+
+static void mpc_re_dfa_chars(char *set, const char *chars) {
+  while (*chars) { set[(unsigned char)*chars] = 1; chars++; }
+}
+
+static char *mpc_re_dfa_expected(const char *fmt, const char *x) {
+  char *e = malloc(strlen(fmt) + strlen(x) + 1);
+  sprintf(e, fmt, x);
+  return e;
+}
+
+static int mpc_re_dfa_class(const char **re, mpc_re_pos_t *pos) {
+  
+  const char *s = *re;
+  const char *t;
+  char *set = pos->set;
+  char *body, *range;
+  char lit[2];
+  unsigned char bits[32];
+  int j, comp;
+  
+  memset(set, 0, 256);
+  lit[0] = s[0]; lit[1] = '\0';
+  
+  /* Regex Escape */
+  if (s[0] == '\\') {
+    lit[0] = s[1];
+    switch (s[1]) {
+      case '\0': return 0;
+      case 'b': case 'B': case 'A': case 'Z':
+      case 'D': case 'S': case 'W': return 0;
+      case 'a': lit[0] = '\a'; break;
+      case 'f': lit[0] = '\f'; break;
+      case 'n': lit[0] = '\n'; break;
+      case 'r': lit[0] = '\r'; break;
+      case 't': lit[0] = '\t'; break;
+      case 'v': lit[0] = '\v'; break;
+      case 'd':
+        mpc_re_dfa_chars(set, "0123456789");
+        pos->expected = mpc_re_dfa_expected("%s", "digit");
+        *re = s + 2;
+        return 1;
+      case 's':
+        mpc_re_dfa_chars(set, " \f\n\r\t\v");
+        pos->expected = mpc_re_dfa_expected("%s", "whitespace");
+        *re = s + 2;
+        return 1;
+      case 'w':
+        mpc_re_dfa_chars(set,
+          "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+        pos->expected = mpc_re_dfa_expected("%s", "alphanumeric");
+        *re = s + 2;
+        return 1;
+      default: break;
+    }
+    set[(unsigned char)lit[0]] = 1;
+    pos->expected = mpc_re_dfa_expected("'%s'", lit);
+    *re = s + 2;
+    return 1;
+  }
+  
+  /* Regex Any */
+  if (s[0] == '.') {
+    for (j = 1; j < 256; j++) { set[j] = 1; }
+    pos->expected = mpc_re_dfa_expected("%s", "any character");
+    *re = s + 1;
+    return 1;
+  }
+  
+  /* Regex Range */
+  if (s[0] == '[') {
+    
+    t = s + 1;
+    while (*t && *t != ']') {
+      if (t[0] == '\\') {
+        if (t[1] == '\0') { return 0; }
+        t += 2;
+      } else {
+        t++;
+      }
+    }
+    if (*t != ']') { return 0; }
+    
+    body = malloc(t - s);
+    memcpy(body, s + 1, t - s - 1);
+    body[t - s - 1] = '\0';
+    
+    comp = body[0] == '^' ? 1 : 0;
+    if (body[0] == '\0' || (comp && body[1] == '\0')) { free(body); return 0; }
+    
+    range = mpc_re_range_bits(body, comp, bits);
+    for (j = 1; j < 256; j++) { set[j] = (bits[j >> 3] & (1 << (j & 7))) ? !comp : comp; }
+    set[0] = 0;
+    pos->expected = mpc_re_dfa_expected(comp ? "none of '%s'" : "one of '%s'", range);
+    
+    free(range);
+    free(body);
+    *re = t + 1;
+    return 1;
+  }
+  
+  /* Groups, anchors and odd literals */
+  if (strchr("()^$*+?{", s[0])) { return 0; }
+  
+  set[(unsigned char)s[0]] = 1;
+  pos->expected = mpc_re_dfa_expected("'%s'", lit);
+  *re = s + 1;
+  return 1;
+}
+
+static int mpc_re_dfa_overlap(mpc_re_pos_t *ps, unsigned long qs, const char *set) {
+  int p, c;
+  for (p = 0; p < MPC_RE_DFA_POSITIONS_MAX; p++) {
+    if (!(qs & (1ul << p))) { continue; }
+    for (c = 1; c < 256; c++) {
+      if (ps[p].set[c] && set[c]) { return 1; }
+    }
+  }
+  return 0;
+}
+
+static unsigned long mpc_re_dfa_first(mpc_re_pos_t *ps, int k, int end) {
+  unsigned long qs = 0;
+  for (; k < end; k++) {
+    qs |= 1ul << k;
+    if (ps[k].rep != '*' && ps[k].rep != '?') { break; }
+  }
+  return qs;
+}
+
+static int mpc_re_dfa_nullable(mpc_re_pos_t *ps, int k, int end) {
+  for (; k < end; k++) {
+    if (ps[k].rep != '*' && ps[k].rep != '?') { return 0; }
+  }
+  return 1;
+}
+
+static unsigned long mpc_re_dfa_range(int k, int end) {
+  unsigned long qs = 0;
+  for (; k < end; k++) { qs |= 1ul << k; }
+  return qs;
+}
+
+static int mpc_re_dfa_check(mpc_re_pos_t *ps, int n, unsigned long *first, int *accept) {
+  
+  char starts[256];
+  unsigned long cand;
+  int p, q, k, c, alts;
+  
+  /* No repetition may overlap what follows it */
+  
+  for (p = 0; p < n; p++) {
+    if (ps[p].rep != '\0'
+    &&  mpc_re_dfa_overlap(ps, mpc_re_dfa_first(ps, p+1, ps[p].end), ps[p].set)) {
+      return 0;
+    }
+  }
+  
+  /* Alternatives must start differently */
+  
+  memset(starts, 0, 256);
+  *first = 0;
+  *accept = 0;
+  
+  alts = 0;
+  for (p = 0; p < n; p = ps[p].end) { alts++; }
+  
+  if (n == 0) { *accept = 1; return 1; }
+  
+  for (p = 0; p < n; p = q) {
+    q = ps[p].end;
+    if (mpc_re_dfa_nullable(ps, p, q)) {
+      if (alts > 1) { return 0; }
+      *accept = 1;
+    }
+    cand = mpc_re_dfa_first(ps, p, q);
+    if (mpc_re_dfa_overlap(ps, cand, starts)) { return 0; }
+    for (k = p; k < q; k++) {
+      if (!(cand & (1ul << k))) { continue; }
+      for (c = 1; c < 256; c++) { starts[c] |= ps[k].set[c]; }
+    }
+    *first |= cand;
+  }
+  
+  return 1;
+}
+
+static mpc_dfa_t *mpc_re_dfa(const char *re) {
+  
+  mpc_re_pos_t ps[MPC_RE_DFA_POSITIONS_MAX];
+  unsigned long follow[MPC_RE_DFA_POSITIONS_MAX];
+  char last[MPC_RE_DFA_POSITIONS_MAX];
+  unsigned long keys[MPC_RE_DFA_STATES_MAX];
+  unsigned long start_bit = 1ul << MPC_RE_DFA_POSITIONS_MAX;
+  unsigned long first, cand, next;
+  int start_accept, empty = 0;
+  int n = 0, alt = 0, p, q, c, st, looped;
+  unsigned char bits[32];
+  mpc_dfa_t *d = NULL;
+  
+  /* Read Positions */
+  
+  while (1) {
+    if (*re == '\0' || *re == '|') {
+      if (alt == n && *re == '|') { empty = 1; }
+      for (p = alt; p < n; p++) { ps[p].end = n; }
+      if (*re == '\0') { break; }
+      re++; alt = n;
+      continue;
+    }
+    if (n == MPC_RE_DFA_POSITIONS_MAX) { goto done; }
+    if (!mpc_re_dfa_class(&re, &ps[n])) { goto done; }
+    n++;
+    ps[n-1].rep = (*re == '*' || *re == '+' || *re == '?') ? *re++ : '\0';
+  }
+  
+  if (empty || (alt == n && alt != 0)) { goto done; }
+  if (!mpc_re_dfa_check(ps, n, &first, &start_accept)) { goto done; }
+  
+  /* Position Automaton */
+  
+  for (p = 0; p < n; p++) {
+    follow[p] = mpc_re_dfa_first(ps, p+1, ps[p].end);
+    if (ps[p].rep == '*' || ps[p].rep == '+') { follow[p] |= 1ul << p; }
+    last[p] = mpc_re_dfa_nullable(ps, p+1, ps[p].end);
+  }
+  
+  /* Subset Construction */
+  
+  d = malloc(sizeof(mpc_dfa_t));
+  d->trans = malloc(sizeof(int) * 256 * MPC_RE_DFA_STATES_MAX);
+  d->accept = malloc(MPC_RE_DFA_STATES_MAX);
+  d->reports = malloc(sizeof(unsigned long) * MPC_RE_DFA_STATES_MAX);
+  d->loops = calloc(MPC_RE_DFA_STATES_MAX, sizeof(mpc_class_t*));
+  d->expected_num = n;
+  d->expected = malloc(sizeof(char*) * (n ? n : 1));
+  for (p = 0; p < n; p++) { d->expected[p] = ps[p].expected; }
+  d->states_num = 1;
+  keys[0] = start_bit;
+  
+  for (st = 0; st < d->states_num; st++) {
+    
+    if (keys[st] == start_bit) {
+      cand = first;
+      d->accept[st] = start_accept;
+      d->reports[st] = n ? mpc_re_dfa_range(0, ps[0].end) : 0;
+    } else {
+      cand = 0;
+      d->accept[st] = 0;
+      d->reports[st] = 0;
+      for (p = 0; p < n; p++) {
+        if (!(keys[st] & (1ul << p))) { continue; }
+        cand |= follow[p];
+        d->accept[st] |= last[p];
+        d->reports[st] |= mpc_re_dfa_range(p+1, ps[p].end);
+        if (ps[p].rep == '*' || ps[p].rep == '+') { d->reports[st] |= 1ul << p; }
+      }
+    }
+    
+    d->trans[st * 256] = -1;
+    for (c = 1; c < 256; c++) {
+      
+      next = 0;
+      for (p = 0; p < n; p++) {
+        if ((cand & (1ul << p)) && ps[p].set[c]) { next |= 1ul << p; }
+      }
+      
+      if (next == 0) { d->trans[st * 256 + c] = -1; continue; }
+      
+      for (q = 0; q < d->states_num; q++) {
+        if (keys[q] == next) { break; }
+      }
+      
+      if (q == d->states_num) {
+        if (q == MPC_RE_DFA_STATES_MAX) { mpc_dfa_delete(d); return NULL; }
+        keys[q] = next;
+        d->states_num++;
+      }
+      
+      d->trans[st * 256 + c] = q;
+    }
+  }
+  
+  d->trans = realloc(d->trans, sizeof(int) * 256 * d->states_num);
+  d->accept = realloc(d->accept, d->states_num);
+  d->reports = realloc(d->reports, sizeof(unsigned long) * d->states_num);
+  d->loops = realloc(d->loops, sizeof(mpc_class_t*) * d->states_num);
+  
+  /* Self Loops */
+  
+  for (st = 0; st < d->states_num; st++) {
+    looped = 0;
+    memset(bits, 0, sizeof(bits));
+    for (c = 1; c < 256; c++) {
+      if (d->trans[st * 256 + c] != st) { continue; }
+      bits[c >> 3] |= (unsigned char)(1 << (c & 7));
+      looped = 1;
+    }
+    if (looped) { d->loops[st] = mpc_class_new(bits); }
+  }
+  
+  return d;
+  
+done:
+  for (p = 0; p < n; p++) { free(ps[p].expected); }
+  return NULL;
+}
+
+mpc_parser_t *mpc_re(const char *re) {
+  
+  char *err_msg;
+  mpc_parser_t *err_out, *p;
+  mpc_result_t r;
+  mpc_parser_t *Regex, *Term, *Factor, *Base, *Range, *RegexEnclose; 
+  mpc_dfa_t *d = NULL;
+  
+  Regex  = mpc_new("regex");
+  Term   = mpc_new("term");
+  Factor = mpc_new("factor");
+  Base   = mpc_new("base");
+  Range  = mpc_new("range");
+  
+  mpc_define(Regex, mpc_and(2, mpcf_re_or,
+    Term, 
+    mpc_maybe(mpc_and(2, mpcf_snd_free, mpc_char('|'), Regex, free)),
+    (mpc_dtor_t)mpc_delete
+  ));
+  
+  mpc_define(Term, mpc_many(mpcf_re_and, Factor));
+  
+  mpc_define(Factor, mpc_and(2, mpcf_re_repeat,
+    Base,
+    mpc_or(5,
+      mpc_char('*'), mpc_char('+'), mpc_char('?'),
+      mpc_brackets(mpc_int(), free),
+      mpc_pass()),
+    (mpc_dtor_t)mpc_delete
+  ));
+  
+  mpc_define(Base, mpc_or(4,
+    mpc_parens(Regex, (mpc_dtor_t)mpc_delete),
+    mpc_squares(Range, (mpc_dtor_t)mpc_delete),
+    mpc_apply(mpc_escape(), mpcf_re_escape),
+    mpc_apply(mpc_noneof(")|"), mpcf_re_escape)
+  ));
+  
+  mpc_define(Range, mpc_apply(
+    mpc_many(mpcf_strfold, mpc_or(2, mpc_escape(), mpc_noneof("]"))),
+    mpcf_re_range
+  ));
+  
+  RegexEnclose = mpc_whole(mpc_predictive(Regex), (mpc_dtor_t)mpc_delete);
+  
+  mpc_optimise(RegexEnclose);
+  mpc_optimise(Regex);
+  mpc_optimise(Term);
+  mpc_optimise(Factor);
+  mpc_optimise(Base);
+  mpc_optimise(Range);
+  
+  if(!mpc_parse("<mpc_re_compiler>", re, RegexEnclose, &r)) {
+    err_msg = mpc_err_string(r.error);
+    err_out = mpc_failf("Invalid Regex: %s", err_msg);
+    mpc_err_delete(r.error);  
+    free(err_msg);
+    r.output = err_out;
+  } else {
+    d = mpc_re_dfa(re);
+  }
+  
+  mpc_cleanup(6, RegexEnclose, Regex, Term, Factor, Base, Range);
+  
+  mpc_optimise(r.output);
+  
+  if (d == NULL) { return r.output; }
+  
+  p = mpc_undefined();
+  p->type = MPC_TYPE_DFA;
+  p->data.dfa.d = d;
+  p->data.dfa.x = r.output;
+  return p;
+  
+}
+
+/*
+** Common Fold Functions
+*/
+
+void mpcf_dtor_null(mpc_val_t *x) { (void) x; return; }
+
+mpc_val_t *mpcf_ctor_null(void) { return NULL; }
+mpc_val_t *mpcf_ctor_str(void) { return calloc(1, 1); }
+mpc_val_t *mpcf_free(mpc_val_t *x) { free(x); return NULL; }
+
+mpc_val_t *mpcf_int(mpc_val_t *x) {
+  int *y = malloc(sizeof(int));
+  *y = strtol(x, NULL, 10);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_hex(mpc_val_t *x) {
+  int *y = malloc(sizeof(int));
+  *y = strtol(x, NULL, 16);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_oct(mpc_val_t *x) {
+  int *y = malloc(sizeof(int));
+  *y = strtol(x, NULL, 8);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_float(mpc_val_t *x) {
+  float *y = malloc(sizeof(float));
+  *y = strtod(x, NULL);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_strtriml(mpc_val_t *x) {
+  char *s = x;
+  while (isspace(*s)) {
+    memmove(s, s+1, strlen(s));
+  }
+  return s;
+}
+
+mpc_val_t *mpcf_strtrimr(mpc_val_t *x) {
+  char *s = x;
+  size_t l = strlen(s);
+  while (isspace(s[l-1])) {
+    s[l-1] = '\0'; l--;
+  }
+  return s;
+}
+
+mpc_val_t *mpcf_strtrim(mpc_val_t *x) {
+  return mpcf_strtriml(mpcf_strtrimr(x));
+}
+
+static const char mpc_escape_input_c[]  = {
+  '\a', '\b', '\f', '\n', '\r',
+  '\t', '\v', '\\', '\'', '\"', '\0'};
+    
+static const char *mpc_escape_output_c[] = {
+  "\\a", "\\b", "\\f", "\\n", "\\r", "\\t", 
+  "\\v", "\\\\", "\\'", "\\\"", "\\0", NULL};
+
+static const char mpc_escape_input_raw_re[] = { '/' };
+static const char *mpc_escape_output_raw_re[] = { "\\/", NULL };
+
+static const char mpc_escape_input_raw_cstr[] = { '"' };
+static const char *mpc_escape_output_raw_cstr[] = { "\\\"", NULL };
+
+static const char mpc_escape_input_raw_cchar[] = { '\'' };
+static const char *mpc_escape_output_raw_cchar[] = { "\\'", NULL };
+
+static mpc_val_t *mpcf_escape_new(mpc_val_t *x, const char *input, const char **output) {
+  
+  int i;
+  int found;
+  char buff[2];
+  char *s = x;
+  char *y = calloc(1, 1);
+  
+  while (*s) {
+    
+    i = 0;
+    found = 0;
+
+    while (output[i]) {
+      if (*s == input[i]) {
+        y = realloc(y, strlen(y) + strlen(output[i]) + 1);
+        strcat(y, output[i]);
+        found = 1;
+        break;
+      }
+      i++;
+    }
+    
+    if (!found) {
+      y = realloc(y, strlen(y) + 2);
+      buff[0] = *s; buff[1] = '\0';
+      strcat(y, buff);
+    }
+    
+    s++;
+  }
+  
+  
+  return y;
+}
+
+static mpc_val_t *mpcf_unescape_new(mpc_val_t *x, const char *input, const char **output) {
+  
+  int i;
+  int found = 0;
+  char buff[2];
+  char *s = x;
+  char *y = calloc(1, 1);
+  
+  while (*s) {
+    
+    i = 0;
+    found = 0;
+    
+    while (output[i]) {
+      if ((*(s+0)) == output[i][0] &&
+          (*(s+1)) == output[i][1]) {
+        y = realloc(y, strlen(y) + 1 + 1);
+        buff[0] = input[i]; buff[1] = '\0';
+        strcat(y, buff);
+        found = 1;
+        s++;
+        break;
+      }
+      i++;
+    }
+    
+    if (!found) {
+      y = realloc(y, strlen(y) + 1 + 1);
+      buff[0] = *s; buff[1] = '\0';
+      strcat(y, buff);
+    }
+    
+    if (*s == '\0') { break; }
+    else { s++; }
+  }
+  
+  return y;
+  
+}
+
+mpc_val_t *mpcf_escape(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_c, mpc_escape_output_c);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_unescape(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_c, mpc_escape_output_c);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_escape_regex(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_raw_re, mpc_escape_output_raw_re);
+  free(x);
+  return y;  
+}
+
+mpc_val_t *mpcf_unescape_regex(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_raw_re, mpc_escape_output_raw_re);
+  free(x);
+  return y;  
+}
+
+mpc_val_t *mpcf_escape_string_raw(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_raw_cstr, mpc_escape_output_raw_cstr);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_unescape_string_raw(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_raw_cstr, mpc_escape_output_raw_cstr);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_escape_char_raw(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_escape_new(x, mpc_escape_input_raw_cchar, mpc_escape_output_raw_cchar);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_unescape_char_raw(mpc_val_t *x) {
+  mpc_val_t *y = mpcf_unescape_new(x, mpc_escape_input_raw_cchar, mpc_escape_output_raw_cchar);
+  free(x);
+  return y;
+}
+
+mpc_val_t *mpcf_null(int n, mpc_val_t** xs) { (void) n; (void) xs; return NULL; }
+mpc_val_t *mpcf_fst(int n, mpc_val_t **xs) { (void) n; return xs[0]; }
+mpc_val_t *mpcf_snd(int n, mpc_val_t **xs) { (void) n; return xs[1]; }
+mpc_val_t *mpcf_trd(int n, mpc_val_t **xs) { (void) n; return xs[2]; }
+
+static mpc_val_t *mpcf_nth_free(int n, mpc_val_t **xs, int x) {
+  int i;
+  for (i = 0; i < n; i++) {
+    if (i != x) { free(xs[i]); }
+  }
+  return xs[x];
+}
+ 
+mpc_val_t *mpcf_fst_free(int n, mpc_val_t **xs) { return mpcf_nth_free(n, xs, 0); }
+mpc_val_t *mpcf_snd_free(int n, mpc_val_t **xs) { return mpcf_nth_free(n, xs, 1); }
+mpc_val_t *mpcf_trd_free(int n, mpc_val_t **xs) { return mpcf_nth_free(n, xs, 2); }
+
+mpc_val_t *mpcf_strfold(int n, mpc_val_t **xs) {
+  int i;
+  size_t l = 0;
+  
+  if (n == 0) { return calloc(1, 1); }
+  
+  for (i = 0; i < n; i++) { l += strlen(xs[i]); }
+  
+  xs[0] = realloc(xs[0], l + 1);
+  
+  for (i = 1; i < n; i++) {
+    strcat(xs[0], xs[i]); free(xs[i]);
+  }
+  
+  return xs[0];
+}
+
+mpc_val_t *mpcf_maths(int n, mpc_val_t **xs) {
+  int **vs = (int**)xs;
+  (void) n;
+  
+  switch(((char*)xs[1])[0])
+  {
+    case '*': { *vs[0] *= *vs[2]; }; break;
+    case '/': { *vs[0] /= *vs[2]; }; break;
+    case '%': { *vs[0] %= *vs[2]; }; break;
+    case '+': { *vs[0] += *vs[2]; }; break;
+    case '-': { *vs[0] -= *vs[2]; }; break;
+    default: break;
+  }
+  
+  free(xs[1]); free(xs[2]);
+  
+  return xs[0];
+}
+
+/*
+** Printing
+*/
+
+static void mpc_print_unretained(mpc_parser_t *p, int force) {
+  
+  /* TODO: Print Everything Escaped */
+  
+  int i;
+  char *s, *e;
+  char buff[2];
+  
+  if (p->retained && !force) {;
+    if (p->name) { printf("<%s>", p->name); }
+    else { printf("<anon>"); }
+    return;
+  }
+  
+  if (p->type == MPC_TYPE_UNDEFINED) { printf("<?>"); }
+  if (p->type == MPC_TYPE_PASS)   { printf("<:>"); }
+  if (p->type == MPC_TYPE_FAIL)   { printf("<!>"); }
+  if (p->type == MPC_TYPE_LIFT)   { printf("<#>"); }
+  if (p->type == MPC_TYPE_STATE)  { printf("<S>"); }
+  if (p->type == MPC_TYPE_ANCHOR) { printf("<@>"); }
+  if (p->type == MPC_TYPE_EXPECT) {
+    printf("%s", p->data.expect.m);
+    /*mpc_print_unretained(p->data.expect.x, 0);*/
+  }
+  
+  if (p->type == MPC_TYPE_ANY) { printf("<.>"); }
+  if (p->type == MPC_TYPE_SATISFY) { printf("<f>"); }
+
+  if (p->type == MPC_TYPE_SINGLE) {
+    buff[0] = p->data.single.x; buff[1] = '\0';
+    s = mpcf_escape_new(
+      buff,
+      mpc_escape_input_c,
+      mpc_escape_output_c);
+    printf("'%s'", s);
+    free(s);
+  }
+  
+  if (p->type == MPC_TYPE_RANGE) {
+    buff[0] = p->data.range.x; buff[1] = '\0';
+    s = mpcf_escape_new(
+      buff,
+      mpc_escape_input_c,
+      mpc_escape_output_c);
+    buff[0] = p->data.range.y; buff[1] = '\0';
+    e = mpcf_escape_new(
+      buff,
+      mpc_escape_input_c,
+      mpc_escape_output_c);
+    printf("[%s-%s]", s, e);
+    free(s);
+    free(e);
+  }
+  
+  if (p->type == MPC_TYPE_ONEOF) {
+    s = mpcf_escape_new(
+      p->data.cls.x,
+      mpc_escape_input_c,
+      mpc_escape_output_c);
+    printf("[%s]", s);
+    free(s);
+  }
+  
+  if (p->type == MPC_TYPE_NONEOF) {
+    s = mpcf_escape_new(
+      p->data.cls.x,
+      mpc_escape_input_c,
+      mpc_escape_output_c);
+    printf("[^%s]", s);
+    free(s);
+  }
+  
+  if (p->type == MPC_TYPE_STRING) {
+    s = mpcf_escape_new(
+      p->data.string.x,
+      mpc_escape_input_c,
+      mpc_escape_output_c);
+    printf("\"%s\"", s);
+    free(s);
+  }
+  
+  if (p->type == MPC_TYPE_APPLY)    { mpc_print_unretained(p->data.apply.x, 0); }
+  if (p->type == MPC_TYPE_APPLY_TO) { mpc_print_unretained(p->data.apply_to.x, 0); }
+  if (p->type == MPC_TYPE_PREDICT)  { mpc_print_unretained(p->data.predict.x, 0); }
+  if (p->type == MPC_TYPE_DFA)      { mpc_print_unretained(p->data.dfa.x, 0); }
+
+  if (p->type == MPC_TYPE_NOT)   { mpc_print_unretained(p->data.not.x, 0); printf("!"); }
+  if (p->type == MPC_TYPE_MAYBE) { mpc_print_unretained(p->data.not.x, 0); printf("?"); }
+
+  if (p->type == MPC_TYPE_MANY)  { mpc_print_unretained(p->data.repeat.x, 0); printf("*"); }
+  if (p->type == MPC_TYPE_MANY1) { mpc_print_unretained(p->data.repeat.x, 0); printf("+"); }
+  if (p->type == MPC_TYPE_COUNT) { mpc_print_unretained(p->data.repeat.x, 0); printf("{%i}", p->data.repeat.n); }
+  
+  if (p->type == MPC_TYPE_OR) {
+    printf("(");
+    for(i = 0; i < p->data.or.n-1; i++) {
+      mpc_print_unretained(p->data.or.xs[i], 0);
+      printf(" | ");
+    }
+    mpc_print_unretained(p->data.or.xs[p->data.or.n-1], 0);
+    printf(")");
+  }
+  
+  if (p->type == MPC_TYPE_AND) {
+    printf("(");
+    for(i = 0; i < p->data.and.n-1; i++) {
+      mpc_print_unretained(p->data.and.xs[i], 0);
+      printf(" ");
+    }
+    mpc_print_unretained(p->data.and.xs[p->data.and.n-1], 0);
+    printf(")");
+  }
+  
+}
+
+void mpc_print(mpc_parser_t *p) {
+  mpc_print_unretained(p, 1);
+  printf("\n");
+}
+
+/*
+** Testing
+*/
+
+/*
+** These functions are slightly unwieldy and
+** also the whole of the testing suite for mpc
+** mpc is pretty shaky.
+**
+** It could do with a lot more tests and more
+** precision. Currently I am only really testing
+** changes off of the examples.
+**
+*/
+
+int mpc_test_fail(mpc_parser_t *p, const char *s, const void *d,
+  int(*tester)(const void*, const void*),
+  mpc_dtor_t destructor,
+  void(*printer)(const void*)) {
+  mpc_result_t r;
+  (void) printer;
+  if (mpc_parse("<test>", s, p, &r)) {
+
+    if (tester(r.output, d)) {
+      destructor(r.output);
+      return 0;
+    } else {
+      destructor(r.output);
+      return 1;
+    }
+  
+  } else {
+    mpc_err_delete(r.error);
+    return 1;
+  }
+  
+}
+
+int mpc_test_pass(mpc_parser_t *p, const char *s, const void *d,
+  int(*tester)(const void*, const void*), 
+  mpc_dtor_t destructor, 
+  void(*printer)(const void*)) {
+
+  mpc_result_t r;  
+  if (mpc_parse("<test>", s, p, &r)) {
+    
+    if (tester(r.output, d)) {
+      destructor(r.output);
+      return 1;
+    } else {
+      printf("Got "); printer(r.output); printf("\n");
+      printf("Expected "); printer(d); printf("\n");
+      destructor(r.output);
+      return 0;
+    }
+    
+  } else {    
+    mpc_err_print(r.error);
+    mpc_err_delete(r.error);
+    return 0;
+    
+  }
+  
+}
+
+
+/*
+** AST
+*/
+
+void mpc_ast_delete(mpc_ast_t *a) {
+  
+  int i;
+  
+  if (a == NULL) { return; }
+  
+  for (i = 0; i < a->children_num; i++) {
+    mpc_ast_delete(a->children[i]);
+  }
+  
+  free(a->children);
+  free(a->tag);
+  free(a->contents);
+  free(a);
+  
+}
+
+static void mpc_ast_delete_no_children(mpc_ast_t *a) {
+  free(a->children);
+  free(a->tag);
+  free(a->contents);
+  free(a);
+}
+
+mpc_ast_t *mpc_ast_new(const char *tag, const char *contents) {
+  
+  mpc_ast_t *a = malloc(sizeof(mpc_ast_t));
+  
+  a->tag = malloc(strlen(tag) + 1);
+  strcpy(a->tag, tag);
+  
+  a->contents = malloc(strlen(contents) + 1);
+  strcpy(a->contents, contents);
+  
+  a->state = mpc_state_new();
+  
+  a->children_num = 0;
+  a->children = NULL;
+  a->rule = 0;
+  a->token = MPC_AST_TOKEN_NONE;
+  return a;
+  
+}
+
+mpc_ast_t *mpc_ast_build(int n, const char *tag, ...) {
+  
+  mpc_ast_t *a = mpc_ast_new(tag, "");
+  
+  int i;
+  va_list va;
+  va_start(va, tag);
+  
+  for (i = 0; i < n; i++) {
+    mpc_ast_add_child(a, va_arg(va, mpc_ast_t*));
+  }
+  
+  va_end(va);
+  
+  return a;
+  
+}
+
+mpc_ast_t *mpc_ast_add_root(mpc_ast_t *a) {
+
+  mpc_ast_t *r;
+
+  if (a == NULL) { return a; }
+  if (a->children_num == 0) { return a; }
+  if (a->children_num == 1) { return a; }
+
+  r = mpc_ast_new(">", "");
+  mpc_ast_add_child(r, a);
+  return r;
+}
+
+int mpc_ast_eq(mpc_ast_t *a, mpc_ast_t *b) {
+  
+  int i;
+
+  if (strcmp(a->tag, b->tag) != 0) { return 0; }
+  if (strcmp(a->contents, b->contents) != 0) { return 0; }
+  if (a->children_num != b->children_num) { return 0; }
+  
+  for (i = 0; i < a->children_num; i++) {
+    if (!mpc_ast_eq(a->children[i], b->children[i])) { return 0; }
+  }
+  
+  return 1;
+}
+
+mpc_ast_t *mpc_ast_add_child(mpc_ast_t *r, mpc_ast_t *a) {
+  r->children_num++;
+  r->children = realloc(r->children, sizeof(mpc_ast_t*) * r->children_num);
+  r->children[r->children_num-1] = a;
+  return r;
+}
+
+mpc_ast_t *mpc_ast_add_tag(mpc_ast_t *a, const char *t) {
+  if (a == NULL) { return a; }
+  a->tag = realloc(a->tag, strlen(t) + 1 + strlen(a->tag) + 1);
+  memmove(a->tag + strlen(t) + 1, a->tag, strlen(a->tag)+1);
+  memmove(a->tag, t, strlen(t));
+  memmove(a->tag + strlen(t), "|", 1);
+  return a;
+}
+
+mpc_ast_t *mpc_ast_add_root_tag(mpc_ast_t *a, const char *t) {
+  if (a == NULL) { return a; }
+  a->tag = realloc(a->tag, (strlen(t)-1) + strlen(a->tag) + 1);
+  memmove(a->tag + (strlen(t)-1), a->tag, strlen(a->tag)+1);
+  memmove(a->tag, t, (strlen(t)-1));
+  return a;
+}
+
+mpc_ast_t *mpc_ast_tag(mpc_ast_t *a, const char *t) {
+  a->tag = realloc(a->tag, strlen(t) + 1);
+  strcpy(a->tag, t);
+  return a;
+}
+
+mpc_ast_t *mpc_ast_state(mpc_ast_t *a, mpc_state_t s) {
+  if (a == NULL) { return a; }
+  a->state = s;
+  return a;
+}
+
+/* A node keeps the innermost rule which built it */
+mpc_ast_t *mpc_ast_rule(mpc_ast_t *a, int rule) {
+  if (a == NULL || a->rule) { return a; }
+  a->rule = rule;
+  return a;
+}
+
+mpc_ast_t *mpc_ast_token(mpc_ast_t *a, int token) {
+  if (a == NULL) { return a; }
+  a->token = token;
+  return a;
+}
+
+static void mpc_ast_print_depth(mpc_ast_t *a, int d, FILE *fp) {
+  
+  int i;
+  
+  if (a == NULL) {
+    fprintf(fp, "NULL\n");
+    return;
+  }
+  
+  for (i = 0; i < d; i++) { fprintf(fp, "  "); }
+  
+  if (strlen(a->contents)) {
+    fprintf(fp, "%s:%lu:%lu '%s'\n", a->tag, 
+      (long unsigned int)(a->state.row+1),
+      (long unsigned int)(a->state.col+1),
+      a->contents);
+  } else {
+    fprintf(fp, "%s \n", a->tag);
+  }
+  
+  for (i = 0; i < a->children_num; i++) {
+    mpc_ast_print_depth(a->children[i], d+1, fp);
+  }
+  
+}
+
+void mpc_ast_print(mpc_ast_t *a) {
+  mpc_ast_print_depth(a, 0, stdout);
+}
+
+void mpc_ast_print_to(mpc_ast_t *a, FILE *fp) {
+  mpc_ast_print_depth(a, 0, fp);
+}
+
+int mpc_ast_get_index(mpc_ast_t *ast, const char *tag) {
+  return mpc_ast_get_index_lb(ast, tag, 0);
+}
+
+int mpc_ast_get_index_lb(mpc_ast_t *ast, const char *tag, int lb) {
+  int i;
+
+  for(i=lb; i<ast->children_num; i++) {
+    if(strcmp(ast->children[i]->tag, tag) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+mpc_ast_t *mpc_ast_get_child(mpc_ast_t *ast, const char *tag) {
+  return mpc_ast_get_child_lb(ast, tag, 0);
+}
+
+mpc_ast_t *mpc_ast_get_child_lb(mpc_ast_t *ast, const char *tag, int lb) {
+  int i;
+
+  for(i=lb; i<ast->children_num; i++) {
+    if(strcmp(ast->children[i]->tag, tag) == 0) {
+      return ast->children[i];
+    }
+  }
+
+  return NULL;
+}
+
+mpc_ast_trav_t *mpc_ast_traverse_start(mpc_ast_t *ast,
+                                       mpc_ast_trav_order_t order)
+{
+  mpc_ast_trav_t *trav, *n_trav;
+  mpc_ast_t *cnode = ast;
+
+  /* Create the traversal structure */
+  trav = malloc(sizeof(mpc_ast_trav_t));
+  trav->curr_node = cnode;
+  trav->parent = NULL;
+  trav->curr_child = 0;
+  trav->order = order;
+
+  /* Get start node */
+  switch(order) {
+    case mpc_ast_trav_order_pre:
+      /* Nothing else is needed for pre order start */
+      break;
+
+    case mpc_ast_trav_order_post:
+      while(cnode->children_num > 0) {
+        cnode = cnode->children[0];
+
+        n_trav = malloc(sizeof(mpc_ast_trav_t));
+        n_trav->curr_node = cnode;
+        n_trav->parent = trav;
+        n_trav->curr_child = 0;
+        n_trav->order = order;
+
+        trav = n_trav;
+      }
+
+      break;
+
+    default:
+      /* Unreachable, but compiler complaints */
+      break;
+  }
+
+  return trav;
+}
+
+mpc_ast_t *mpc_ast_traverse_next(mpc_ast_trav_t **trav) {
+  mpc_ast_trav_t *n_trav, *to_free;
+  mpc_ast_t *ret = NULL;
+  int cchild;
+
+  /* The end of traversal was reached */
+  if(*trav == NULL) return NULL;
+
+  switch((*trav)->order) {
+    case mpc_ast_trav_order_pre:
+      ret = (*trav)->curr_node;
+
+      /* If there aren't any more children, go up */
+      while(*trav != NULL &&
+        (*trav)->curr_child >= (*trav)->curr_node->children_num)
+      {
+        to_free = *trav;
+        *trav = (*trav)->parent;
+        free(to_free);
+      }
+
+      /* If trav is NULL, the end was reached */
+      if(*trav == NULL) {
+        break;
+      }
+
+      /* Go to next child */
+      n_trav = malloc(sizeof(mpc_ast_trav_t));
+
+      cchild = (*trav)->curr_child;
+      n_trav->curr_node = (*trav)->curr_node->children[cchild];
+      n_trav->parent = *trav;
+      n_trav->curr_child = 0;
+      n_trav->order = (*trav)->order;
+
+      (*trav)->curr_child++;
+      *trav = n_trav;
+
+      break;
+
+    case mpc_ast_trav_order_post:
+      ret = (*trav)->curr_node;
+
+      /* Move up tree to the parent If the parent doesn't have any more nodes,
+       * then this is the current node. If it does, move down to its left most
+       * child. Also, free the previous traversal node */
+      to_free = *trav;
+      *trav = (*trav)->parent;
+      free(to_free);
+
+      if(*trav == NULL)
+        break;
+
+      /* Next child */
+      (*trav)->curr_child++;
+
+      /* If there aren't any more children, this is the next node */
+      if((*trav)->curr_child >= (*trav)->curr_node->children_num) {
+        break;
+      }
+
+      /* If there are still more children, find the leftmost child from this
+       * node */
+      while((*trav)->curr_node->children_num > 0) {
+        n_trav = malloc(sizeof(mpc_ast_trav_t));
+
+        cchild = (*trav)->curr_child;
+        n_trav->curr_node = (*trav)->curr_node->children[cchild];
+        n_trav->parent = *trav;
+        n_trav->curr_child = 0;
+        n_trav->order = (*trav)->order;
+
+        *trav = n_trav;
+      }
+
+    default:
+      /* Unreachable, but compiler complaints */
+      break;
+  }
+
+  return ret;
+}
+
+void mpc_ast_traverse_free(mpc_ast_trav_t **trav) {
+  mpc_ast_trav_t *n_trav;
+
+  /* Go through parents until all are free */
+  while(*trav != NULL) {
+      n_trav = (*trav)->parent;
+      free(*trav);
+      *trav = n_trav;
+  }
+}
+
+mpc_val_t *mpcf_fold_ast(int n, mpc_val_t **xs) {
+  
+  int i, j;
+  mpc_ast_t** as = (mpc_ast_t**)xs;
+  mpc_ast_t *r;
+  
+  if (n == 0) { return NULL; }
+  if (n == 1) { return xs[0]; }
+  if (n == 2 && xs[1] == NULL) { return xs[0]; }
+  if (n == 2 && xs[0] == NULL) { return xs[1]; }
+  
+  r = mpc_ast_new(">", "");
+  
+  for (i = 0; i < n; i++) {
+    
+    if (as[i] == NULL) { continue; }
+    
+    if        (as[i] && as[i]->children_num == 0) {
+      mpc_ast_add_child(r, as[i]);
+    } else if (as[i] && as[i]->children_num == 1) {
+      mpc_ast_add_child(r, mpc_ast_add_root_tag(as[i]->children[0], as[i]->tag));
+      mpc_ast_delete_no_children(as[i]);
+    } else if (as[i] && as[i]->children_num >= 2) {
+      for (j = 0; j < as[i]->children_num; j++) {
+        mpc_ast_add_child(r, as[i]->children[j]);
+      }
+      mpc_ast_delete_no_children(as[i]);
+    }
+  
+  }
+  
+  if (r->children_num) {
+    r->state = r->children[0]->state;
+  }
+  
+  return r;
+}
+
+mpc_val_t *mpcf_str_ast(mpc_val_t *c) {
+  mpc_ast_t *a = mpc_ast_new("", c);
+  free(c);
+  return a;
+}
+
+mpc_val_t *mpcf_state_ast(int n, mpc_val_t **xs) {
+  mpc_state_t *s = ((mpc_state_t**)xs)[0];
+  mpc_ast_t *a = ((mpc_ast_t**)xs)[1];
+  (void)n;
+  a = mpc_ast_state(a, *s);
+  free(s);
+  return a;
+}
+
+mpc_parser_t *mpca_state(mpc_parser_t *a) {
+  return mpc_and(2, mpcf_state_ast, mpc_state(), a, free);
+}
+
+mpc_parser_t *mpca_tag(mpc_parser_t *a, const char *t) {
+  return mpc_apply_to(a, (mpc_apply_to_t)mpc_ast_tag, (void*)t);
+}
+
+mpc_parser_t *mpca_add_tag(mpc_parser_t *a, const char *t) {
+  return mpc_apply_to(a, (mpc_apply_to_t)mpc_ast_add_tag, (void*)t);
+}
+
+mpc_parser_t *mpca_root(mpc_parser_t *a) {
+  return mpc_apply(a, (mpc_apply_t)mpc_ast_add_root);
+}
+
+/* The number is carried in the pointer given to the function */
+static mpc_val_t *mpcaf_rule(mpc_val_t *x, void *d) {
+  return mpc_ast_rule(x, (int)(size_t)d);
+}
+
+static mpc_val_t *mpcaf_token(mpc_val_t *x, void *d) {
+  return mpc_ast_token(x, (int)(size_t)d);
+}
+
+mpc_parser_t *mpca_rule(mpc_parser_t *a, int rule) {
+  return mpc_apply_to(a, mpcaf_rule, (void*)(size_t)rule);
+}
+
+mpc_parser_t *mpca_token(mpc_parser_t *a, int token) {
+  return mpc_apply_to(a, mpcaf_token, (void*)(size_t)token);
+}
+
+mpc_parser_t *mpca_not(mpc_parser_t *a) { return mpc_not(a, (mpc_dtor_t)mpc_ast_delete); }
+mpc_parser_t *mpca_maybe(mpc_parser_t *a) { return mpc_maybe(a); }
+mpc_parser_t *mpca_many(mpc_parser_t *a) { return mpc_many(mpcf_fold_ast, a); }
+mpc_parser_t *mpca_many1(mpc_parser_t *a) { return mpc_many1(mpcf_fold_ast, a); }
+mpc_parser_t *mpca_count(int n, mpc_parser_t *a) { return mpc_count(n, mpcf_fold_ast, a, (mpc_dtor_t)mpc_ast_delete); }
+
+mpc_parser_t *mpca_or(int n, ...) {
+
+  int i;
+  va_list va;
+
+  mpc_parser_t *p = mpc_undefined();
+  
+  p->type = MPC_TYPE_OR;
+  p->data.or.n = n;
+  p->data.or.xs = malloc(sizeof(mpc_parser_t*) * n);
+  
+  va_start(va, n);  
+  for (i = 0; i < n; i++) {
+    p->data.or.xs[i] = va_arg(va, mpc_parser_t*);
+  }
+  va_end(va);
+  
+  return p;
+  
+}
+
+mpc_parser_t *mpca_and(int n, ...) {
+  
+  int i;
+  va_list va;
+  
+  mpc_parser_t *p = mpc_undefined();
+  
+  p->type = MPC_TYPE_AND;
+  p->data.and.n = n;
+  p->data.and.f = mpcf_fold_ast;
+  p->data.and.xs = malloc(sizeof(mpc_parser_t*) * n);
+  p->data.and.dxs = malloc(sizeof(mpc_dtor_t) * (n-1));
+  
+  va_start(va, n);
+  for (i = 0; i < n; i++) {
+    p->data.and.xs[i] = va_arg(va, mpc_parser_t*);
+  }
+  for (i = 0; i < (n-1); i++) {
+    p->data.and.dxs[i] = (mpc_dtor_t)mpc_ast_delete;
+  }    
+  va_end(va);
+  
+  return p;  
+}
+
+mpc_parser_t *mpca_total(mpc_parser_t *a) { return mpc_total(a, (mpc_dtor_t)mpc_ast_delete); }
+
+/*
+** Grammar Parser
+*/
+
+/*
+** This is another interesting bootstrapping.
+**
+** Having a general purpose AST type allows
+** users to specify the grammar alone and
+** let all fold rules be automatically taken
+** care of by existing functions.
+**
+** You don't get to control the type spat
+** out but this means you can make a nice
+** parser to take in some grammar in nice
+** syntax and spit out a parser that works.
+**
+** The grammar for this looks surprisingly
+** like regex but the main difference is that
+** it is now whitespace insensitive and the
+** base type takes literals of some form.
+*/
+
+/*
+**
+**  ### Grammar Grammar
+**
+**      <grammar> : (<term> "|" <grammar>) | <term>
+**     
+**      <term> : <factor>*
+**
+**      <factor> : <base>
+**               | <base> "*"
+**               | <base> "+"
+**               | <base> "?"
+**               | <base> "{" <digits> "}"
+**           
+**      <base> : "<" (<digits> | <ident>) ">"
+**             | <string_lit>
+**             | <char_lit>
+**             | <regex_lit>
+**             | "(" <grammar> ")"
+*/
+
+typedef struct {
+  va_list *va;
+  int parsers_num;
+  mpc_parser_t **parsers;
+  int flags;
+} mpca_grammar_st_t;
+
+static mpc_val_t *mpcaf_grammar_or(int n, mpc_val_t **xs) {
+  (void) n;
+  if (xs[1] == NULL) { return xs[0]; }
+  else { return mpca_or(2, xs[0], xs[1]); }
+}
+
+static mpc_val_t *mpcaf_grammar_and(int n, mpc_val_t **xs) {
+  int i;
+  mpc_parser_t *p = mpc_pass();  
+  for (i = 0; i < n; i++) {
+    if (xs[i] != NULL) { p = mpca_and(2, p, xs[i]); }
+  }
+  return p;
+}
+
+static mpc_val_t *mpcaf_grammar_repeat(int n, mpc_val_t **xs) { 
+  int num;
+  (void) n;
+  if (xs[1] == NULL) { return xs[0]; }
+  switch(((char*)xs[1])[0])
+  {
+    case '*': { free(xs[1]); return mpca_many(xs[0]); }; break;
+    case '+': { free(xs[1]); return mpca_many1(xs[0]); }; break;
+    case '?': { free(xs[1]); return mpca_maybe(xs[0]); }; break;
+    case '!': { free(xs[1]); return mpca_not(xs[0]); }; break;
+    default:
+      num = *((int*)xs[1]);
+      free(xs[1]);
+  }
+  return mpca_count(num, xs[0]);
+}
+
+static mpc_val_t *mpcaf_grammar_string(mpc_val_t *x, void *s) {
+  mpca_grammar_st_t *st = s;
+  char *y = mpcf_unescape(x);
+  mpc_parser_t *p = (st->flags & MPCA_LANG_WHITESPACE_SENSITIVE) ? mpc_string(y) : mpc_tok(mpc_string(y));
+  free(y);
+  return mpca_state(mpca_token(mpca_tag(mpc_apply(p, mpcf_str_ast), "string"), MPC_AST_TOKEN_STRING));
+}
+
+static mpc_val_t *mpcaf_grammar_char(mpc_val_t *x, void *s) {
+  mpca_grammar_st_t *st = s;
+  char *y = mpcf_unescape(x);
+  mpc_parser_t *p = (st->flags & MPCA_LANG_WHITESPACE_SENSITIVE) ? mpc_char(y[0]) : mpc_tok(mpc_char(y[0]));
+  free(y);
+  return mpca_state(mpca_token(mpca_tag(mpc_apply(p, mpcf_str_ast), "char"), MPC_AST_TOKEN_CHAR));
+}
+
+static mpc_val_t *mpcaf_grammar_regex(mpc_val_t *x, void *s) {
+  mpca_grammar_st_t *st = s;
+  char *y = mpcf_unescape_regex(x);
+  mpc_parser_t *p = (st->flags & MPCA_LANG_WHITESPACE_SENSITIVE) ? mpc_re(y) : mpc_tok(mpc_re(y));
+  free(y);
+  return mpca_state(mpca_token(mpca_tag(mpc_apply(p, mpcf_str_ast), "regex"), MPC_AST_TOKEN_REGEX));
+}
+
+/* Should this just use `isdigit` instead? */
+static int is_number(const char* s) {
+  size_t i;
+  for (i = 0; i < strlen(s); i++) { if (!strchr("0123456789", s[i])) { return 0; } }
+  return 1;
+}
+
+static mpc_parser_t *mpca_grammar_find_parser(char *x, mpca_grammar_st_t *st) {
+  
+  int i;
+  mpc_parser_t *p;
+  
+  /* Case of Number */
+  if (is_number(x)) {
+
+    i = strtol(x, NULL, 10);
+    
+    while (st->parsers_num <= i) {
+      st->parsers_num++;
+      st->parsers = realloc(st->parsers, sizeof(mpc_parser_t*) * st->parsers_num);
+      st->parsers[st->parsers_num-1] = va_arg(*st->va, mpc_parser_t*);
+      if (st->parsers[st->parsers_num-1] == NULL) {
+        return mpc_failf("No Parser in position %i! Only supplied %i Parsers!", i, st->parsers_num);
+      }
+    }
+    
+    return st->parsers[st->parsers_num-1];
+  
+  /* Case of Identifier */
+  } else {
+    
+    /* Search Existing Parsers */
+    for (i = 0; i < st->parsers_num; i++) {
+      mpc_parser_t *q = st->parsers[i];
+      if (q == NULL) { return mpc_failf("Unknown Parser '%s'!", x); }
+      if (q->name && strcmp(q->name, x) == 0) { return q; }
+    }
+    
+    /* Search New Parsers */
+    while (1) {
+    
+      p = va_arg(*st->va, mpc_parser_t*);
+      
+      st->parsers_num++;
+      st->parsers = realloc(st->parsers, sizeof(mpc_parser_t*) * st->parsers_num);
+      st->parsers[st->parsers_num-1] = p;
+      
+      if (p == NULL || p->name == NULL) { return mpc_failf("Unknown Parser '%s'!", x); }
+      if (p->name && strcmp(p->name, x) == 0) { return p; }
+      
+    }
+  
+  }  
+  
+}
+
+static mpc_val_t *mpcaf_grammar_id(mpc_val_t *x, void *s) {
+  
+  mpca_grammar_st_t *st = s;
+  mpc_parser_t *p = mpca_grammar_find_parser(x, st);
+  free(x);
+
+  if (p->name) {
+    return mpca_state(mpca_root(mpca_add_tag(p, p->name)));
+  } else {
+    return mpca_state(mpca_root(p));
+  }
+}
+
+mpc_parser_t *mpca_grammar_st(const char *grammar, mpca_grammar_st_t *st) {
+  
+  char *err_msg;
+  mpc_parser_t *err_out;
+  mpc_result_t r;
+  mpc_parser_t *GrammarTotal, *Grammar, *Term, *Factor, *Base;
+  
+  GrammarTotal = mpc_new("grammar_total");
+  Grammar = mpc_new("grammar");
+  Term = mpc_new("term");
+  Factor = mpc_new("factor");
+  Base = mpc_new("base");
+  
+  mpc_define(GrammarTotal,
+    mpc_predictive(mpc_total(Grammar, mpc_soft_delete))
+  );
+  
+  mpc_define(Grammar, mpc_and(2, mpcaf_grammar_or,
+    Term,
+    mpc_maybe(mpc_and(2, mpcf_snd_free, mpc_sym("|"), Grammar, free)),
+    mpc_soft_delete
+  ));
+  
+  mpc_define(Term, mpc_many1(mpcaf_grammar_and, Factor));
+  
+  mpc_define(Factor, mpc_and(2, mpcaf_grammar_repeat,
+    Base,
+      mpc_or(6,
+        mpc_sym("*"),
+        mpc_sym("+"),
+        mpc_sym("?"),
+        mpc_sym("!"),
+        mpc_tok_brackets(mpc_int(), free),
+        mpc_pass()),
+    mpc_soft_delete
+  ));
+  
+  mpc_define(Base, mpc_or(5,
+    mpc_apply_to(mpc_tok(mpc_string_lit()), mpcaf_grammar_string, st),
+    mpc_apply_to(mpc_tok(mpc_char_lit()),   mpcaf_grammar_char, st),
+    mpc_apply_to(mpc_tok(mpc_regex_lit()),  mpcaf_grammar_regex, st),
+    mpc_apply_to(mpc_tok_braces(mpc_or(2, mpc_digits(), mpc_ident()), free), mpcaf_grammar_id, st),
+    mpc_tok_parens(Grammar, mpc_soft_delete)
+  ));
+  
+  mpc_optimise(GrammarTotal);
+  mpc_optimise(Grammar);
+  mpc_optimise(Factor);
+  mpc_optimise(Term);
+  mpc_optimise(Base);
+  
+  if(!mpc_parse("<mpc_grammar_compiler>", grammar, GrammarTotal, &r)) {
+    err_msg = mpc_err_string(r.error);
+    err_out = mpc_failf("Invalid Grammar: %s", err_msg);
+    mpc_err_delete(r.error);
+    free(err_msg);
+    r.output = err_out;
+  }
+  
+  mpc_cleanup(5, GrammarTotal, Grammar, Term, Factor, Base);
+  
+  mpc_optimise(r.output);
+  
+  return (st->flags & MPCA_LANG_PREDICTIVE) ? mpc_predictive(r.output) : r.output;
+  
+}
+
+mpc_parser_t *mpca_grammar(int flags, const char *grammar, ...) {
+  mpca_grammar_st_t st;
+  mpc_parser_t *res;
+  va_list va;
+  va_start(va, grammar);
+  
+  st.va = &va;
+  st.parsers_num = 0;
+  st.parsers = NULL;
+  st.flags = flags;
+  
+  res = mpca_grammar_st(grammar, &st);  
+  free(st.parsers);
+  va_end(va);
+  return res;
+}
+
+typedef struct {
+  char *ident;
+  char *name;
+  mpc_parser_t *grammar;
+} mpca_stmt_t;
+
+static mpc_val_t *mpca_stmt_afold(int n, mpc_val_t **xs) {
+  mpca_stmt_t *stmt = malloc(sizeof(mpca_stmt_t));
+  stmt->ident = ((char**)xs)[0];
+  stmt->name = ((char**)xs)[1];
+  stmt->grammar = ((mpc_parser_t**)xs)[3];
+  (void) n;
+  free(((char**)xs)[2]);
+  free(((char**)xs)[4]);
+  
+  return stmt;
+}
+
+static mpc_val_t *mpca_stmt_fold(int n, mpc_val_t **xs) {
+  
+  int i;
+  mpca_stmt_t **stmts = malloc(sizeof(mpca_stmt_t*) * (n+1));
+  
+  for (i = 0; i < n; i++) {
+    stmts[i] = xs[i];
+  }
+  stmts[n] = NULL;  
+  
+  return stmts;
+}
+
+static void mpca_stmt_list_delete(mpc_val_t *x) {
+
+  mpca_stmt_t **stmts = x;
+
+  while(*stmts) {
+    mpca_stmt_t *stmt = *stmts; 
+    free(stmt->ident);
+    free(stmt->name);
+    mpc_soft_delete(stmt->grammar);
+    free(stmt);  
+    stmts++;
+  }
+  free(x);
+
+}
+
+static mpc_val_t *mpca_stmt_list_apply_to(mpc_val_t *x, void *s) {
+
+  mpca_grammar_st_t *st = s;
+  mpca_stmt_t *stmt;
+  mpca_stmt_t **stmts = x;
+  mpc_parser_t *left;
+  int rule;
+
+  while(*stmts) {
+    stmt = *stmts;
+    left = mpca_grammar_find_parser(stmt->ident, st);
+    if (st->flags & MPCA_LANG_PREDICTIVE) { stmt->grammar = mpc_predictive(stmt->grammar); }
+    if (stmt->name) { stmt->grammar = mpc_expect(stmt->grammar, stmt->name); }
+    for (rule = 0; rule < st->parsers_num; rule++) {
+      if (st->parsers[rule] == left) { stmt->grammar = mpca_rule(stmt->grammar, rule + 1); break; }
+    }
+    mpc_optimise(stmt->grammar);
+    mpc_define(left, stmt->grammar);
+    free(stmt->ident);
+    free(stmt->name);
+    free(stmt);
+    stmts++;
+  }
+  
+  free(x);
+  
+  return NULL;
+}
+
+static mpc_err_t *mpca_lang_st(mpc_input_t *i, mpca_grammar_st_t *st) {
+  
+  mpc_result_t r;
+  mpc_err_t *e;
+  mpc_parser_t *Lang, *Stmt, *Grammar, *Term, *Factor, *Base; 
+  
+  Lang    = mpc_new("lang");
+  Stmt    = mpc_new("stmt");
+  Grammar = mpc_new("grammar");
+  Term    = mpc_new("term");
+  Factor  = mpc_new("factor");
+  Base    = mpc_new("base");
+  
+  mpc_define(Lang, mpc_apply_to(
+    mpc_total(mpc_predictive(mpc_many(mpca_stmt_fold, Stmt)), mpca_stmt_list_delete),
+    mpca_stmt_list_apply_to, st
+  ));
+  
+  mpc_define(Stmt, mpc_and(5, mpca_stmt_afold,
+    mpc_tok(mpc_ident()), mpc_maybe(mpc_tok(mpc_string_lit())), mpc_sym(":"), Grammar, mpc_sym(";"),
+    free, free, free, mpc_soft_delete
+  ));
+  
+  mpc_define(Grammar, mpc_and(2, mpcaf_grammar_or,
+      Term,
+      mpc_maybe(mpc_and(2, mpcf_snd_free, mpc_sym("|"), Grammar, free)),
+      mpc_soft_delete
+  ));
+  
+  mpc_define(Term, mpc_many1(mpcaf_grammar_and, Factor));
+  
+  mpc_define(Factor, mpc_and(2, mpcaf_grammar_repeat,
+    Base,
+      mpc_or(6,
+        mpc_sym("*"),
+        mpc_sym("+"),
+        mpc_sym("?"),
+        mpc_sym("!"),
+        mpc_tok_brackets(mpc_int(), free),
+        mpc_pass()),
+    mpc_soft_delete
+  ));
+  
+  mpc_define(Base, mpc_or(5,
+    mpc_apply_to(mpc_tok(mpc_string_lit()), mpcaf_grammar_string, st),
+    mpc_apply_to(mpc_tok(mpc_char_lit()),   mpcaf_grammar_char, st),
+    mpc_apply_to(mpc_tok(mpc_regex_lit()),  mpcaf_grammar_regex, st),
+    mpc_apply_to(mpc_tok_braces(mpc_or(2, mpc_digits(), mpc_ident()), free), mpcaf_grammar_id, st),
+    mpc_tok_parens(Grammar, mpc_soft_delete)
+  ));
+  
+  mpc_optimise(Lang);
+  mpc_optimise(Stmt);
+  mpc_optimise(Grammar);
+  mpc_optimise(Term);
+  mpc_optimise(Factor);
+  mpc_optimise(Base);
+  
+  if (!mpc_parse_input(i, Lang, &r)) {
+    e = r.error;
+  } else {
+    e = NULL;
+  }
+  
+  mpc_cleanup(6, Lang, Stmt, Grammar, Term, Factor, Base);
+  
+  return e;
+}
+
+mpc_err_t *mpca_lang_file(int flags, FILE *f, ...) {
+  mpca_grammar_st_t st;
+  mpc_input_t *i;
+  mpc_err_t *err;
+
+  va_list va;  
+  va_start(va, f);
+  
+  st.va = &va;
+  st.parsers_num = 0;
+  st.parsers = NULL;
+  st.flags = flags;
+  
+  i = mpc_input_new_file("<mpca_lang_file>", f);
+  err = mpca_lang_st(i, &st);
+  mpc_input_delete(i);
+  
+  free(st.parsers);
+  va_end(va);
+  return err;
+}
+
+mpc_err_t *mpca_lang_pipe(int flags, FILE *p, ...) {
+  mpca_grammar_st_t st;
+  mpc_input_t *i;
+  mpc_err_t *err;
+
+  va_list va;  
+  va_start(va, p);
+  
+  st.va = &va;
+  st.parsers_num = 0;
+  st.parsers = NULL;
+  st.flags = flags;
+  
+  i = mpc_input_new_pipe("<mpca_lang_pipe>", p);
+  err = mpca_lang_st(i, &st);
+  mpc_input_delete(i);
+  
+  free(st.parsers);
+  va_end(va);
+  return err;
+}
+
+mpc_err_t *mpca_lang(int flags, const char *language, ...) {
+  
+  mpca_grammar_st_t st;
+  mpc_input_t *i;
+  mpc_err_t *err;
+  
+  va_list va;  
+  va_start(va, language);
+  
+  st.va = &va;
+  st.parsers_num = 0;
+  st.parsers = NULL;
+  st.flags = flags;
+  
+  i = mpc_input_new_string("<mpca_lang>", language);
+  err = mpca_lang_st(i, &st);
+  mpc_input_delete(i);
+  
+  free(st.parsers);
+  va_end(va);
+  return err;
+}
+
+mpc_err_t *mpca_lang_contents(int flags, const char *filename, ...) {
+  
+  mpca_grammar_st_t st;
+  mpc_input_t *i;
+  mpc_err_t *err;
+  
+  va_list va;
+
+  FILE *f = fopen(filename, "rb");
+  
+  if (f == NULL) {
+    err = mpc_err_file(filename, "Unable to open file!");
+    return err;
+  }
+  
+  va_start(va, filename);
+  
+  st.va = &va;
+  st.parsers_num = 0;
+  st.parsers = NULL;
+  st.flags = flags;
+  
+  i = mpc_input_new_file(filename, f);
+  err = mpca_lang_st(i, &st);
+  mpc_input_delete(i);
+  
+  free(st.parsers);
+  va_end(va);  
+  
+  fclose(f);
+  
+  return err;
+}
+
+static int mpc_nodecount_unretained(mpc_parser_t* p, int force) {
+
+  int i, total;
+
+  if (p->retained && !force) { return 0; }
+
+  if (p->type == MPC_TYPE_EXPECT) { return 1 + mpc_nodecount_unretained(p->data.expect.x, 0); }
+
+  if (p->type == MPC_TYPE_APPLY)    { return 1 + mpc_nodecount_unretained(p->data.apply.x, 0); }
+  if (p->type == MPC_TYPE_APPLY_TO) { return 1 + mpc_nodecount_unretained(p->data.apply_to.x, 0); }
+  if (p->type == MPC_TYPE_PREDICT)  { return 1 + mpc_nodecount_unretained(p->data.predict.x, 0); }
+  if (p->type == MPC_TYPE_DFA)      { return 1 + mpc_nodecount_unretained(p->data.dfa.x, 0); }
+
+  if (p->type == MPC_TYPE_NOT)   { return 1 + mpc_nodecount_unretained(p->data.not.x, 0); }
+  if (p->type == MPC_TYPE_MAYBE) { return 1 + mpc_nodecount_unretained(p->data.not.x, 0); }
+
+  if (p->type == MPC_TYPE_MANY)  { return 1 + mpc_nodecount_unretained(p->data.repeat.x, 0); }
+  if (p->type == MPC_TYPE_MANY1) { return 1 + mpc_nodecount_unretained(p->data.repeat.x, 0); }
+  if (p->type == MPC_TYPE_COUNT) { return 1 + mpc_nodecount_unretained(p->data.repeat.x, 0); }
+
+  if (p->type == MPC_TYPE_OR) { 
+    total = 0;
+    for(i = 0; i < p->data.or.n; i++) {
+      total += mpc_nodecount_unretained(p->data.or.xs[i], 0);
+    }
+    return total;
+  }
+  
+  if (p->type == MPC_TYPE_AND) {
+    total = 0;
+    for(i = 0; i < p->data.and.n; i++) {
+      total += mpc_nodecount_unretained(p->data.and.xs[i], 0);
+    }
+    return total;
+  }
+
+  return 1;
+  
+}
+
+void mpc_stats(mpc_parser_t* p) {
+  printf("Stats\n");
+  printf("=====\n");
+  printf("Node Count: %i\n", mpc_nodecount_unretained(p, 1));
+}
+
+static void mpc_optimise_unretained(mpc_parser_t *p, int force) {
+  
+  int i, n, m;
+  mpc_parser_t *t;
+  
+  if (p->retained && !force) { return; }
+  
+  /* Optimise Subexpressions */
+  
+  if (p->type == MPC_TYPE_EXPECT)   { mpc_optimise_unretained(p->data.expect.x, 0); }
+  if (p->type == MPC_TYPE_APPLY)    { mpc_optimise_unretained(p->data.apply.x, 0); }
+  if (p->type == MPC_TYPE_APPLY_TO) { mpc_optimise_unretained(p->data.apply_to.x, 0); }
+  if (p->type == MPC_TYPE_PREDICT)  { mpc_optimise_unretained(p->data.predict.x, 0); }
+  if (p->type == MPC_TYPE_DFA)      { mpc_optimise_unretained(p->data.dfa.x, 0); }
+  if (p->type == MPC_TYPE_NOT)      { mpc_optimise_unretained(p->data.not.x, 0); }
+  if (p->type == MPC_TYPE_MAYBE)    { mpc_optimise_unretained(p->data.not.x, 0); }
+  if (p->type == MPC_TYPE_MANY)     { mpc_optimise_unretained(p->data.repeat.x, 0); }
+  if (p->type == MPC_TYPE_MANY1)    { mpc_optimise_unretained(p->data.repeat.x, 0); }
+  if (p->type == MPC_TYPE_COUNT)    { mpc_optimise_unretained(p->data.repeat.x, 0); }
+  
+  if (p->type == MPC_TYPE_OR) { 
+    for(i = 0; i < p->data.or.n; i++) {
+      mpc_optimise_unretained(p->data.or.xs[i], 0);
+    }
+  }
+  
+  if (p->type == MPC_TYPE_AND) {
+    for(i = 0; i < p->data.and.n; i++) {
+      mpc_optimise_unretained(p->data.and.xs[i], 0);
+    }
+  }  
+  
+  /* Perform optimisations */
+  
+  while (1) {
+    
+    /* Merge rhs `or` */
+    if (p->type == MPC_TYPE_OR
+    &&  p->data.or.xs[p->data.or.n-1]->type == MPC_TYPE_OR
+    && !p->data.or.xs[p->data.or.n-1]->retained) {
+      t = p->data.or.xs[p->data.or.n-1];
+      n = p->data.or.n; m = t->data.or.n;
+      p->data.or.n = n + m - 1;
+      p->data.or.xs = realloc(p->data.or.xs, sizeof(mpc_parser_t*) * (n + m -1));
+      memmove(p->data.or.xs + n - 1, t->data.or.xs, m * sizeof(mpc_parser_t*));
+      free(t->data.or.xs); free(t->name); free(t);
+      continue;
+    }
+
+    /* Merge lhs `or` */
+    if (p->type == MPC_TYPE_OR
+    &&  p->data.or.xs[0]->type == MPC_TYPE_OR
+    && !p->data.or.xs[0]->retained) {
+      t = p->data.or.xs[0];
+      n = p->data.or.n; m = t->data.or.n;
+      p->data.or.n = n + m - 1;
+      p->data.or.xs = realloc(p->data.or.xs, sizeof(mpc_parser_t*) * (n + m -1));
+      memmove(p->data.or.xs + m, t->data.or.xs + 1, n * sizeof(mpc_parser_t*));
+      memmove(p->data.or.xs, t->data.or.xs, m * sizeof(mpc_parser_t*));
+      free(t->data.or.xs); free(t->name); free(t);
+      continue;
+    }
+    
+    /* Remove ast `pass` */
+    if (p->type == MPC_TYPE_AND
+    &&  p->data.and.n == 2
+    &&  p->data.and.xs[0]->type == MPC_TYPE_PASS
+    && !p->data.and.xs[0]->retained
+    &&  p->data.and.f == mpcf_fold_ast) {
+      t = p->data.and.xs[1];
+      mpc_delete(p->data.and.xs[0]);
+      free(p->data.and.xs); free(p->data.and.dxs); free(p->name);
+      memcpy(p, t, sizeof(mpc_parser_t));
+      free(t);
+      continue;
+    }
+    
+    /* Merge ast lhs `and` */
+    if (p->type == MPC_TYPE_AND
+    &&  p->data.and.f == mpcf_fold_ast
+    &&  p->data.and.xs[0]->type == MPC_TYPE_AND
+    && !p->data.and.xs[0]->retained
+    &&  p->data.and.xs[0]->data.and.f == mpcf_fold_ast) {
+      t = p->data.and.xs[0];
+      n = p->data.and.n; m = t->data.and.n;
+      p->data.and.n = n + m - 1;
+      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m - 1));
+      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
+      memmove(p->data.and.xs + m, p->data.and.xs + 1, (n - 1) * sizeof(mpc_parser_t*));
+      memmove(p->data.and.xs, t->data.and.xs, m * sizeof(mpc_parser_t*));
+      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = (mpc_dtor_t)mpc_ast_delete; }
+      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
+      continue;
+    }
+    
+    /* Merge ast rhs `and` */
+    if (p->type == MPC_TYPE_AND
+    &&  p->data.and.f == mpcf_fold_ast
+    &&  p->data.and.xs[p->data.and.n-1]->type == MPC_TYPE_AND
+    && !p->data.and.xs[p->data.and.n-1]->retained
+    &&  p->data.and.xs[p->data.and.n-1]->data.and.f == mpcf_fold_ast) {
+      t = p->data.and.xs[p->data.and.n-1];
+      n = p->data.and.n; m = t->data.and.n;
+      p->data.and.n = n + m - 1;
+      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m -1));
+      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
+      memmove(p->data.and.xs + n - 1, t->data.and.xs, m * sizeof(mpc_parser_t*));
+      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = (mpc_dtor_t)mpc_ast_delete; }
+      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
+      continue;
+    }
+
+    /* Remove re `lift` */
+    if (p->type == MPC_TYPE_AND
+    &&  p->data.and.n == 2
+    &&  p->data.and.xs[0]->type == MPC_TYPE_LIFT
+    &&  p->data.and.xs[0]->data.lift.lf == mpcf_ctor_str
+    && !p->data.and.xs[0]->retained
+    &&  p->data.and.f == mpcf_strfold) {
+      t = p->data.and.xs[1];
+      mpc_delete(p->data.and.xs[0]);
+      free(p->data.and.xs); free(p->data.and.dxs); free(p->name);
+      memcpy(p, t, sizeof(mpc_parser_t));
+      free(t);
+      continue;
+    }
+
+    /* Merge re lhs `and` */
+    if (p->type == MPC_TYPE_AND
+    &&  p->data.and.f == mpcf_strfold
+    &&  p->data.and.xs[0]->type == MPC_TYPE_AND
+    && !p->data.and.xs[0]->retained
+    &&  p->data.and.xs[0]->data.and.f == mpcf_strfold) {
+      t = p->data.and.xs[0];
+      n = p->data.and.n; m = t->data.and.n;
+      p->data.and.n = n + m - 1;
+      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m - 1));
+      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
+      memmove(p->data.and.xs + m, p->data.and.xs + 1, (n - 1) * sizeof(mpc_parser_t*));
+      memmove(p->data.and.xs, t->data.and.xs, m * sizeof(mpc_parser_t*));
+      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = free; }
+      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
+      continue;
+    }
+    
+    /* Merge re rhs `and` */
+    if (p->type == MPC_TYPE_AND
+    &&  p->data.and.f == mpcf_strfold
+    &&  p->data.and.xs[p->data.and.n-1]->type == MPC_TYPE_AND
+    && !p->data.and.xs[p->data.and.n-1]->retained
+    &&  p->data.and.xs[p->data.and.n-1]->data.and.f == mpcf_strfold) {
+      t = p->data.and.xs[p->data.and.n-1];
+      n = p->data.and.n; m = t->data.and.n;
+      p->data.and.n = n + m - 1;
+      p->data.and.xs = realloc(p->data.and.xs, sizeof(mpc_parser_t*) * (n + m -1));
+      p->data.and.dxs = realloc(p->data.and.dxs, sizeof(mpc_dtor_t) * (n + m - 1 - 1));
+      memmove(p->data.and.xs + n - 1, t->data.and.xs, m * sizeof(mpc_parser_t*));
+      for (i = 0; i < p->data.and.n-1; i++) { p->data.and.dxs[i] = free; }
+      free(t->data.and.xs); free(t->data.and.dxs); free(t->name); free(t); 
+      continue;
+    }
+    
+    return;
+    
+  }
+  
+}
+
+void mpc_optimise(mpc_parser_t *p) {
+  mpc_optimise_unretained(p, 1);
+}
+
+
+/*
+** Code Generation
+*/
+
+/*
+** `mpc_codegen` writes a grammar out as C. Every
+** retained parser becomes a function and all the
+** others are inlined into it as straight line code
+** so parsing no longer walks the parser graph.
+**
+** Only the shapes built by `mpca_lang` and `mpc_re`
+** can be written out. The values passed between
+** parsers must be syntax trees or strings, and a
+** string is always the input between two points,
+** so it is kept as that span and only copied out
+** when a tree node is made of it.
+**
+** Errors are reported through the same calls as
+** the parser would make, in the same order, so the
+** generated code fails with the same message.
+*/
+
+enum {
+  MPC_CODEGEN_NONE = 0,
+  MPC_CODEGEN_SPAN = 1,
+  MPC_CODEGEN_AST  = 2
+};
+
+typedef struct {
+  FILE *f;
+  const char *prefix;
+  int depth;
+  int ids;
+  int suppressed;
+  int predictive;
+  mpc_parser_t *rule;
+  int rules_num;
+  mpc_parser_t **rules;
+  int classes_num;
+  const mpc_class_t **classes;
+  int dfas_num;
+  mpc_dfa_t **dfas;
+  char *error;
+} mpc_codegen_t;
+
+static void mpc_codegen_line(mpc_codegen_t *cg, const char *fmt, ...) {
+  int j;
+  va_list va;
+  if (cg->f == NULL) { return; }
+  for (j = 0; j < cg->depth; j++) { fputs("  ", cg->f); }
+  va_start(va, fmt);
+  vfprintf(cg->f, fmt, va);
+  va_end(va);
+  fputc('\n', cg->f);
+}
+
+static void mpc_codegen_open(mpc_codegen_t *cg) {
+  mpc_codegen_line(cg, "{");
+  cg->depth++;
+}
+
+static void mpc_codegen_close(mpc_codegen_t *cg) {
+  cg->depth--;
+  mpc_codegen_line(cg, "}");
+}
+
+static void mpc_codegen_error(mpc_codegen_t *cg, const char *why) {
+  const char *name = cg->rule && cg->rule->name ? cg->rule->name : "<anonymous>";
+  if (cg->error) { return; }
+  cg->error = malloc(strlen(name) + strlen(why) + 64);
+  sprintf(cg->error, "Cannot generate code for parser '%s': %s", name, why);
+}
+
+static char *mpc_codegen_quote(const char *s) {
+  
+  const unsigned char *u = (const unsigned char*)s;
+  char *q = malloc(strlen(s) * 4 + 3);
+  char *o = q;
+  
+  *o++ = '"';
+  for (; *u; u++) {
+    switch (*u) {
+      case '"':  *o++ = '\\'; *o++ = '"'; break;
+      case '\\': *o++ = '\\'; *o++ = '\\'; break;
+      case '?':  *o++ = '\\'; *o++ = '?'; break;
+      case '\n': *o++ = '\\'; *o++ = 'n'; break;
+      case '\t': *o++ = '\\'; *o++ = 't'; break;
+      case '\r': *o++ = '\\'; *o++ = 'r'; break;
+      default:
+        if (*u >= 32 && *u < 127) { *o++ = (char)*u; }
+        else { sprintf(o, "\\%03o", *u); o += 4; }
+    }
+  }
+  *o++ = '"';
+  *o = '\0';
+  return q;
+}
+
+static void mpc_codegen_char(char *buf, char c) {
+  if (c >= 32 && c < 127 && c != '\'' && c != '\\') { sprintf(buf, "'%c'", c); }
+  else { sprintf(buf, "(char)%d", (int)c); }
+}
+
+static int mpc_codegen_is_ident(const char *s) {
+  if (s == NULL || !(isalpha((unsigned char)*s) || *s == '_')) { return 0; }
+  while (*s) {
+    if (!(isalnum((unsigned char)*s) || *s == '_')) { return 0; }
+    s++;
+  }
+  return 1;
+}
+
+static int mpc_codegen_rule(mpc_codegen_t *cg, mpc_parser_t *p) {
+  int j;
+  for (j = 0; j < cg->rules_num; j++) {
+    if (cg->rules[j] == p) { return j; }
+  }
+  cg->rules = realloc(cg->rules, sizeof(mpc_parser_t*) * (cg->rules_num + 1));
+  cg->rules[cg->rules_num] = p;
+  return cg->rules_num++;
+}
+
+static void mpc_codegen_rule_name(mpc_codegen_t *cg, int r, char *buf, size_t size) {
+  int j;
+  const char *name = cg->rules[r]->name;
+  if (mpc_codegen_is_ident(name) && strlen(cg->prefix) + strlen(name) + sizeof("_rule_") <= size) {
+    for (j = 0; j < r; j++) {
+      if (cg->rules[j]->name && strcmp(cg->rules[j]->name, name) == 0) { break; }
+    }
+    if (j == r) { snprintf(buf, size, "%s_rule_%s", cg->prefix, name); return; }
+  }
+  snprintf(buf, size, "%s_rule%d", cg->prefix, r);
+}
+
+static int mpc_codegen_class(mpc_codegen_t *cg, const mpc_class_t *c) {
+  int j;
+  for (j = 0; j < cg->classes_num; j++) {
+    if (memcmp(cg->classes[j]->bits, c->bits, sizeof(c->bits)) == 0) { return j; }
+  }
+  cg->classes = realloc(cg->classes, sizeof(mpc_class_t*) * (cg->classes_num + 1));
+  cg->classes[cg->classes_num] = c;
+  return cg->classes_num++;
+}
+
+static int mpc_codegen_dfa(mpc_codegen_t *cg, mpc_dfa_t *d) {
+  int j;
+  for (j = 0; j < cg->dfas_num; j++) {
+    if (cg->dfas[j] == d) { return j; }
+  }
+  cg->dfas = realloc(cg->dfas, sizeof(mpc_dfa_t*) * (cg->dfas_num + 1));
+  cg->dfas[cg->dfas_num] = d;
+  return cg->dfas_num++;
+}
+
+/*
+** Properties of parsers used to decide what code
+** is needed. A retained parser below the one being
+** written is a call to its function.
+*/
+
+static int mpc_codegen_pick(mpc_fold_t f) {
+  if (f == mpcf_fst || f == mpcf_fst_free) { return 0; }
+  if (f == mpcf_snd || f == mpcf_snd_free) { return 1; }
+  if (f == mpcf_trd || f == mpcf_trd_free) { return 2; }
+  return -1;
+}
+
+static int mpc_codegen_kind(mpc_parser_t *p, int top) {
+  
+  int j, k, r = -1;
+  
+  if (p->retained && !top) { return MPC_CODEGEN_AST; }
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_ANY:    case MPC_TYPE_SINGLE: case MPC_TYPE_RANGE:
+    case MPC_TYPE_ONEOF:  case MPC_TYPE_NONEOF: case MPC_TYPE_STRING:
+    case MPC_TYPE_DFA:
+      return MPC_CODEGEN_SPAN;
+    
+    case MPC_TYPE_UNDEFINED: case MPC_TYPE_FAIL:
+    case MPC_TYPE_PASS:      case MPC_TYPE_ANCHOR:
+      return MPC_CODEGEN_NONE;
+    
+    case MPC_TYPE_LIFT:
+      if (p->data.lift.lf == mpcf_ctor_null) { return MPC_CODEGEN_NONE; }
+      if (p->data.lift.lf == mpcf_ctor_str)  { return MPC_CODEGEN_SPAN; }
+      return -1;
+    
+    case MPC_TYPE_LIFT_VAL:
+      return p->data.lift.x == NULL ? MPC_CODEGEN_NONE : -1;
+    
+    case MPC_TYPE_EXPECT:  return mpc_codegen_kind(p->data.expect.x, 0);
+    case MPC_TYPE_PREDICT: return mpc_codegen_kind(p->data.predict.x, 0);
+    
+    case MPC_TYPE_APPLY:
+      if (p->data.apply.f == mpcf_str_ast) { return MPC_CODEGEN_AST; }
+      if (p->data.apply.f == (mpc_apply_t)mpc_ast_add_root) { return MPC_CODEGEN_AST; }
+      if (p->data.apply.f == mpcf_free) { return MPC_CODEGEN_NONE; }
+      return -1;
+    
+    case MPC_TYPE_APPLY_TO:
+      if (p->data.apply_to.f == (mpc_apply_to_t)mpc_ast_tag)     { return MPC_CODEGEN_AST; }
+      if (p->data.apply_to.f == (mpc_apply_to_t)mpc_ast_add_tag) { return MPC_CODEGEN_AST; }
+      if (p->data.apply_to.f == mpcaf_rule)  { return MPC_CODEGEN_AST; }
+      if (p->data.apply_to.f == mpcaf_token) { return MPC_CODEGEN_AST; }
+      return -1;
+    
+    case MPC_TYPE_NOT:
+      if (p->data.not.lf == mpcf_ctor_null) { return MPC_CODEGEN_NONE; }
+      if (p->data.not.lf == mpcf_ctor_str)  { return MPC_CODEGEN_SPAN; }
+      return -1;
+    
+    case MPC_TYPE_MAYBE:
+      k = mpc_codegen_kind(p->data.not.x, 0);
+      if (p->data.not.lf == mpcf_ctor_null) { return k == MPC_CODEGEN_SPAN ? -1 : k; }
+      if (p->data.not.lf == mpcf_ctor_str)  { return k == MPC_CODEGEN_SPAN ? k : -1; }
+      return -1;
+    
+    case MPC_TYPE_MANY: case MPC_TYPE_MANY1: case MPC_TYPE_COUNT:
+      if (p->data.repeat.f == mpcf_fold_ast) { return MPC_CODEGEN_AST; }
+      if (p->data.repeat.f == mpcf_strfold)  { return MPC_CODEGEN_SPAN; }
+      return -1;
+    
+    case MPC_TYPE_OR:
+      for (j = 0; j < p->data.or.n; j++) {
+        if (p->data.or.xs[j]->type == MPC_TYPE_FAIL && !p->data.or.xs[j]->retained) { continue; }
+        k = mpc_codegen_kind(p->data.or.xs[j], 0);
+        if (k < 0) { return -1; }
+        if (r < 0 || r == k) { r = k; continue; }
+        if (r + k == MPC_CODEGEN_AST) { r = MPC_CODEGEN_AST; continue; }
+        return -1;
+      }
+      return r < 0 ? MPC_CODEGEN_NONE : r;
+    
+    case MPC_TYPE_AND:
+      if (p->data.and.n == 0) { return MPC_CODEGEN_NONE; }
+      if (p->data.and.f == mpcf_fold_ast) { return MPC_CODEGEN_AST; }
+      if (p->data.and.f == mpcf_strfold)  { return MPC_CODEGEN_SPAN; }
+      if (p->data.and.f == mpcf_null)     { return MPC_CODEGEN_NONE; }
+      if (p->data.and.f == mpcf_state_ast
+      &&  p->data.and.n == 2
+      &&  p->data.and.xs[0]->type == MPC_TYPE_STATE
+      && !p->data.and.xs[0]->retained) {
+        return MPC_CODEGEN_AST;
+      }
+      j = mpc_codegen_pick(p->data.and.f);
+      if (j >= 0 && j < p->data.and.n) { return mpc_codegen_kind(p->data.and.xs[j], 0); }
+      return -1;
+    
+    default: return -1;
+  }
+}
+
+static int mpc_codegen_empty(mpc_parser_t *p) {
+  
+  int j;
+  
+  if (p->retained) { return 0; }
+  
+  switch (p->type) {
+    case MPC_TYPE_UNDEFINED: case MPC_TYPE_FAIL:
+    case MPC_TYPE_PASS:      case MPC_TYPE_ANCHOR:
+    case MPC_TYPE_LIFT:      case MPC_TYPE_LIFT_VAL:
+    case MPC_TYPE_NOT:
+      return 1;
+    case MPC_TYPE_EXPECT:  return mpc_codegen_empty(p->data.expect.x);
+    case MPC_TYPE_PREDICT: return mpc_codegen_empty(p->data.predict.x);
+    case MPC_TYPE_AND:
+      for (j = 0; j < p->data.and.n; j++) {
+        if (!mpc_codegen_empty(p->data.and.xs[j])) { return 0; }
+      }
+      return 1;
+    default: return 0;
+  }
+}
+
+static int mpc_codegen_fails(mpc_parser_t *p, int top);
+
+/* Whether a parser fails without consuming anything even when it cannot backtrack */
+static int mpc_codegen_atomic(mpc_parser_t *p) {
+  
+  int j;
+  
+  if (p->retained) { return 0; }
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_ANY:    case MPC_TYPE_SINGLE: case MPC_TYPE_RANGE:
+    case MPC_TYPE_ONEOF:  case MPC_TYPE_NONEOF: case MPC_TYPE_ANCHOR:
+    case MPC_TYPE_FAIL:   case MPC_TYPE_UNDEFINED:
+    case MPC_TYPE_PASS:   case MPC_TYPE_LIFT:   case MPC_TYPE_LIFT_VAL:
+    case MPC_TYPE_MAYBE:  case MPC_TYPE_MANY:
+      return 1;
+    
+    case MPC_TYPE_STRING:  return strlen(p->data.string.x) <= 1;
+    case MPC_TYPE_EXPECT:  return mpc_codegen_atomic(p->data.expect.x);
+    case MPC_TYPE_PREDICT: return mpc_codegen_atomic(p->data.predict.x);
+    case MPC_TYPE_DFA:     return mpc_codegen_atomic(p->data.dfa.x);
+    
+    case MPC_TYPE_OR:
+      for (j = 0; j < p->data.or.n; j++) {
+        if (!mpc_codegen_atomic(p->data.or.xs[j])) { return 0; }
+      }
+      return 1;
+    
+    case MPC_TYPE_AND:
+      for (j = 1; j < p->data.and.n; j++) {
+        if (mpc_codegen_fails(p->data.and.xs[j], 0)) { return 0; }
+      }
+      return p->data.and.n == 0 || mpc_codegen_atomic(p->data.and.xs[0]);
+    
+    default: return 0;
+  }
+}
+
+/*
+** Whether the string value of a parser is exactly
+** the input it consumes. Without backtracking a
+** part that fails may still have consumed input,
+** so the parts a parser recovers from must also
+** fail cleanly.
+*/
+static int mpc_codegen_exact(mpc_parser_t *p, int predictive) {
+  
+  int j, k;
+  
+  if (p->retained) { return 0; }
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_ANY:    case MPC_TYPE_SINGLE: case MPC_TYPE_RANGE:
+    case MPC_TYPE_ONEOF:  case MPC_TYPE_NONEOF: case MPC_TYPE_STRING:
+    case MPC_TYPE_DFA:    case MPC_TYPE_FAIL:   case MPC_TYPE_UNDEFINED:
+      return 1;
+    
+    case MPC_TYPE_LIFT: return p->data.lift.lf == mpcf_ctor_str;
+    case MPC_TYPE_NOT:  return p->data.not.lf == mpcf_ctor_str;
+    
+    case MPC_TYPE_EXPECT:  return mpc_codegen_exact(p->data.expect.x, predictive);
+    case MPC_TYPE_PREDICT: return mpc_codegen_exact(p->data.predict.x, predictive);
+    
+    case MPC_TYPE_MAYBE:
+      return p->data.not.lf == mpcf_ctor_str
+        && mpc_codegen_exact(p->data.not.x, predictive)
+        && (!predictive || mpc_codegen_atomic(p->data.not.x));
+    
+    case MPC_TYPE_MANY: case MPC_TYPE_MANY1: case MPC_TYPE_COUNT:
+      return p->data.repeat.f == mpcf_strfold
+        && mpc_codegen_exact(p->data.repeat.x, predictive)
+        && (!predictive || p->type == MPC_TYPE_COUNT || mpc_codegen_atomic(p->data.repeat.x));
+    
+    case MPC_TYPE_OR:
+      if (p->data.or.n == 0) { return 0; }
+      for (j = 0; j < p->data.or.n; j++) {
+        if (!mpc_codegen_exact(p->data.or.xs[j], predictive)) { return 0; }
+        if (predictive && j < p->data.or.n - 1 && !mpc_codegen_atomic(p->data.or.xs[j])) { return 0; }
+      }
+      return 1;
+    
+    case MPC_TYPE_AND:
+      if (p->data.and.n == 0) { return 0; }
+      k = mpc_codegen_pick(p->data.and.f);
+      if (p->data.and.f != mpcf_strfold && (k < 0 || k >= p->data.and.n)) { return 0; }
+      for (j = 0; j < p->data.and.n; j++) {
+        if (k < 0 || j == k) {
+          if (!mpc_codegen_exact(p->data.and.xs[j], predictive)) { return 0; }
+        } else {
+          if (!mpc_codegen_empty(p->data.and.xs[j])) { return 0; }
+        }
+      }
+      return 1;
+    
+    default: return 0;
+  }
+}
+
+static int mpc_codegen_fails(mpc_parser_t *p, int top) {
+  
+  int j;
+  
+  if (p->retained && !top) { return 1; }
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_PASS:  case MPC_TYPE_LIFT: case MPC_TYPE_LIFT_VAL:
+    case MPC_TYPE_STATE: case MPC_TYPE_MANY: case MPC_TYPE_MAYBE:
+      return 0;
+    
+    case MPC_TYPE_STRING: return p->data.string.x[0] != '\0';
+    
+    case MPC_TYPE_EXPECT:   return mpc_codegen_fails(p->data.expect.x, 0);
+    case MPC_TYPE_PREDICT:  return mpc_codegen_fails(p->data.predict.x, 0);
+    case MPC_TYPE_APPLY:    return mpc_codegen_fails(p->data.apply.x, 0);
+    case MPC_TYPE_APPLY_TO: return mpc_codegen_fails(p->data.apply_to.x, 0);
+    case MPC_TYPE_MANY1:    return mpc_codegen_fails(p->data.repeat.x, 0);
+    case MPC_TYPE_COUNT:
+      return p->data.repeat.n > 0 && mpc_codegen_fails(p->data.repeat.x, 0);
+    
+    case MPC_TYPE_OR:
+      if (p->data.or.n == 0) { return 0; }
+      for (j = 0; j < p->data.or.n; j++) {
+        if (!mpc_codegen_fails(p->data.or.xs[j], 0)) { return 0; }
+      }
+      return 1;
+    
+    case MPC_TYPE_AND:
+      for (j = 0; j < p->data.and.n; j++) {
+        if (mpc_codegen_fails(p->data.and.xs[j], 0)) { return 1; }
+      }
+      return 0;
+    
+    default: return 1;
+  }
+}
+
+static int mpc_codegen_calls(mpc_parser_t *p) {
+  
+  int j;
+  
+  if (p->retained) { return 1; }
+  
+  switch (p->type) {
+    case MPC_TYPE_EXPECT:   return mpc_codegen_calls(p->data.expect.x);
+    case MPC_TYPE_PREDICT:  return mpc_codegen_calls(p->data.predict.x);
+    case MPC_TYPE_APPLY:    return mpc_codegen_calls(p->data.apply.x);
+    case MPC_TYPE_APPLY_TO: return mpc_codegen_calls(p->data.apply_to.x);
+    case MPC_TYPE_NOT:      return mpc_codegen_calls(p->data.not.x);
+    case MPC_TYPE_MAYBE:    return mpc_codegen_calls(p->data.not.x);
+    case MPC_TYPE_MANY:     return mpc_codegen_calls(p->data.repeat.x);
+    case MPC_TYPE_MANY1:    return mpc_codegen_calls(p->data.repeat.x);
+    case MPC_TYPE_COUNT:    return mpc_codegen_calls(p->data.repeat.x);
+    case MPC_TYPE_DFA:      return mpc_codegen_calls(p->data.dfa.x);
+    case MPC_TYPE_OR:
+      for (j = 0; j < p->data.or.n; j++) {
+        if (mpc_codegen_calls(p->data.or.xs[j])) { return 1; }
+      }
+      return 0;
+    case MPC_TYPE_AND:
+      for (j = 0; j < p->data.and.n; j++) {
+        if (mpc_codegen_calls(p->data.and.xs[j])) { return 1; }
+      }
+      return 0;
+    default: return 0;
+  }
+}
+
+/* Finds every rule reachable from a parser and whether any of it predicts */
+static void mpc_codegen_scan(mpc_codegen_t *cg, mpc_parser_t *p, int top) {
+  
+  int j;
+  
+  if (p->retained && !top) {
+    j = cg->rules_num;
+    if (mpc_codegen_rule(cg, p) == j) { mpc_codegen_scan(cg, p, 1); }
+    return;
+  }
+  
+  if (p->type == MPC_TYPE_PREDICT) { cg->predictive = 1; }
+  
+  switch (p->type) {
+    case MPC_TYPE_EXPECT:   mpc_codegen_scan(cg, p->data.expect.x, 0); break;
+    case MPC_TYPE_PREDICT:  mpc_codegen_scan(cg, p->data.predict.x, 0); break;
+    case MPC_TYPE_APPLY:    mpc_codegen_scan(cg, p->data.apply.x, 0); break;
+    case MPC_TYPE_APPLY_TO: mpc_codegen_scan(cg, p->data.apply_to.x, 0); break;
+    case MPC_TYPE_NOT:
+    case MPC_TYPE_MAYBE:    mpc_codegen_scan(cg, p->data.not.x, 0); break;
+    case MPC_TYPE_MANY:
+    case MPC_TYPE_MANY1:
+    case MPC_TYPE_COUNT:    mpc_codegen_scan(cg, p->data.repeat.x, 0); break;
+    case MPC_TYPE_DFA:      mpc_codegen_scan(cg, p->data.dfa.x, 0); break;
+    case MPC_TYPE_OR:
+      for (j = 0; j < p->data.or.n; j++) { mpc_codegen_scan(cg, p->data.or.xs[j], 0); }
+      break;
+    case MPC_TYPE_AND:
+      for (j = 0; j < p->data.and.n; j++) { mpc_codegen_scan(cg, p->data.and.xs[j], 0); }
+      break;
+    default: break;
+  }
+}
+
+/*
+** Emitting Code
+**
+** Each parser is written with the label to jump
+** to when it fails and where to put its value: a
+** tree variable `out`, or for a string the pair of
+** variables `oa` and `ob` marking its span.
+*/
+
+static void mpc_codegen_node(mpc_codegen_t *cg, mpc_parser_t *p, int mode,
+  const char *out, const char *oa, const char *ob, int fail, int top);
+
+static void mpc_codegen_rewind(mpc_codegen_t *cg, int s) {
+  if (cg->predictive) {
+    mpc_codegen_line(cg, "if (g->backtrack > 0) { g->state = s%d; }", s);
+  } else {
+    mpc_codegen_line(cg, "g->state = s%d;", s);
+  }
+}
+
+static void mpc_codegen_record(mpc_codegen_t *cg) {
+  if (cg->suppressed) { return; }
+  mpc_codegen_line(cg, "if (g->err) { mpc_gen_record(g); }");
+}
+
+static void mpc_codegen_expect(mpc_codegen_t *cg, const char *m, int failure) {
+  char *q;
+  if (cg->suppressed) { mpc_codegen_line(cg, "g->err = 0;"); return; }
+  q = mpc_codegen_quote(m);
+  mpc_codegen_line(cg, failure ? "mpc_gen_failure(g, %s);" : "mpc_gen_expect(g, %s);", q);
+  free(q);
+}
+
+/* Steps over one character which may be a newline */
+static void mpc_codegen_step(mpc_codegen_t *cg, int newline) {
+  if (newline) {
+    mpc_codegen_line(cg, "if (g->string[g->state.pos] == '\\n') { g->state.row++; g->state.col = 0; } else { g->state.col++; }");
+  } else {
+    mpc_codegen_line(cg, "g->state.col++;");
+  }
+  mpc_codegen_line(cg, "g->state.pos++;");
+}
+
+static void mpc_codegen_string(mpc_codegen_t *cg, const char *s, int fail) {
+  
+  int id = ++cg->ids;
+  size_t l = strlen(s);
+  const char *nl = strrchr(s, '\n');
+  char *q = mpc_codegen_quote(s);
+  int rows = 0;
+  const char *t;
+  
+  for (t = s; *t; t++) { if (*t == '\n') { rows++; } }
+  
+  if (l == 0) { free(q); return; }
+  
+  if (cg->predictive) {
+    
+    /* Without backtracking a partial match is left consumed */
+    mpc_codegen_open(cg);
+    mpc_codegen_line(cg, "long j%d = 0;", id);
+    mpc_codegen_line(cg, "while (j%d < %lu && g->state.pos + j%d < g->length && g->string[g->state.pos + j%d] == %s[j%d]) { j%d++; }",
+      id, (unsigned long)l, id, id, q, id, id);
+    mpc_codegen_line(cg, "if (j%d < %lu) {", id, (unsigned long)l);
+    mpc_codegen_line(cg, "  if (g->backtrack < 1) { mpc_gen_advance(g, j%d); }", id);
+    mpc_codegen_line(cg, "  g->err = 0; goto f%d;", fail);
+    mpc_codegen_line(cg, "}");
+    mpc_codegen_close(cg);
+    
+  } else {
+    mpc_codegen_line(cg, "if (g->length - g->state.pos < %lu || memcmp(g->string + g->state.pos, %s, %lu) != 0) { g->err = 0; goto f%d; }",
+      (unsigned long)l, q, (unsigned long)l, fail);
+  }
+  
+  mpc_codegen_line(cg, "g->state.pos += %lu;", (unsigned long)l);
+  if (rows) {
+    mpc_codegen_line(cg, "g->state.row += %d;", rows);
+    mpc_codegen_line(cg, "g->state.col = %lu;", (unsigned long)(l - (size_t)(nl - s) - 1));
+  } else {
+    mpc_codegen_line(cg, "g->state.col += %lu;", (unsigned long)l);
+  }
+  
+  free(q);
+}
+
+static void mpc_codegen_primitive(mpc_codegen_t *cg, mpc_parser_t *p, int fail) {
+  
+  char x[16], y[16];
+  int k;
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_ANY:
+      mpc_codegen_line(cg, "if (g->state.pos >= g->length) { g->err = 0; goto f%d; }", fail);
+      mpc_codegen_step(cg, 1);
+      break;
+    
+    case MPC_TYPE_SINGLE:
+      mpc_codegen_char(x, p->data.single.x);
+      mpc_codegen_line(cg, "if (g->state.pos >= g->length || g->string[g->state.pos] != %s) { g->err = 0; goto f%d; }", x, fail);
+      if (p->data.single.x == '\n') {
+        mpc_codegen_line(cg, "g->state.row++;");
+        mpc_codegen_line(cg, "g->state.col = 0;");
+        mpc_codegen_line(cg, "g->state.pos++;");
+      } else {
+        mpc_codegen_step(cg, 0);
+      }
+      break;
+    
+    case MPC_TYPE_RANGE:
+      mpc_codegen_char(x, p->data.range.x);
+      mpc_codegen_char(y, p->data.range.y);
+      mpc_codegen_line(cg, "if (g->state.pos >= g->length || g->string[g->state.pos] < %s || g->string[g->state.pos] > %s) { g->err = 0; goto f%d; }",
+        x, y, fail);
+      mpc_codegen_step(cg, '\n' >= p->data.range.x && '\n' <= p->data.range.y);
+      break;
+    
+    case MPC_TYPE_ONEOF:
+    case MPC_TYPE_NONEOF:
+      k = mpc_codegen_class(cg, p->data.cls.c);
+      mpc_codegen_line(cg, "if (g->state.pos >= g->length || !(%s_class%d[(unsigned char)g->string[g->state.pos] >> 3] & (1 << (g->string[g->state.pos] & 7)))) { g->err = 0; goto f%d; }",
+        cg->prefix, k, fail);
+      mpc_codegen_step(cg, mpc_class_has(p->data.cls.c, '\n'));
+      break;
+    
+    case MPC_TYPE_STRING:
+      mpc_codegen_string(cg, p->data.string.x, fail);
+      break;
+    
+    case MPC_TYPE_ANCHOR:
+      if (p->data.anchor.f == mpc_soi_anchor) {
+        mpc_codegen_line(cg, "if (g->state.pos != 0) { g->err = 0; goto f%d; }", fail);
+      } else if (p->data.anchor.f == mpc_eoi_anchor) {
+        mpc_codegen_line(cg, "if (g->state.pos < g->length) { g->err = 0; goto f%d; }", fail);
+      } else if (p->data.anchor.f == mpc_boundary_anchor) {
+        mpc_codegen_line(cg, "if (!mpc_gen_boundary(g)) { g->err = 0; goto f%d; }", fail);
+      } else {
+        mpc_codegen_error(cg, "unknown anchor function");
+      }
+      break;
+    
+    default:
+      mpc_codegen_error(cg, "unsupported parser type");
+      break;
+  }
+}
+
+/*
+** A regex compiled into a DFA is walked through
+** its table. When it does not match, the regex is
+** run as the parser would run it, only to find
+** the errors it reports.
+*/
+
+static void mpc_codegen_dfa_run(mpc_codegen_t *cg, mpc_parser_t *p, int fail) {
+  
+  int id = ++cg->ids, k, c, newline = 0;
+  mpc_dfa_t *d = p->data.dfa.d;
+  
+  k = mpc_codegen_dfa(cg, d);
+  
+  for (c = 0; c < d->states_num; c++) {
+    if (d->trans[c * 256 + '\n'] >= 0) { newline = 1; }
+  }
+  
+  mpc_codegen_open(cg);
+  mpc_codegen_line(cg, "const unsigned char *s%d = (const unsigned char*)g->string + g->state.pos;", id);
+  mpc_codegen_line(cg, "long j%d = 0, k%d = %d, n%d = g->length - g->state.pos;", id, id, d->accept[0] ? 0 : -1, id);
+  mpc_codegen_line(cg, cg->suppressed ? "int st%d = 0;" : "int st%d = 0, fin%d = 0;", id, id);
+  mpc_codegen_line(cg, "while (j%d < n%d) {", id, id);
+  mpc_codegen_line(cg, "  st%d = %s_dfa%d[st%d * 256 + s%d[j%d]];", id, cg->prefix, k, id, id, id);
+  mpc_codegen_line(cg, "  if (st%d < 0) { break; }", id);
+  mpc_codegen_line(cg, "  j%d++;", id);
+  mpc_codegen_line(cg, cg->suppressed
+    ? "  if (%s_dfa%d_accept[st%d]) { k%d = j%d; }"
+    : "  if (%s_dfa%d_accept[st%d]) { k%d = j%d; fin%d = st%d; }",
+    cg->prefix, k, id, id, id, id, id);
+  mpc_codegen_line(cg, "}");
+  mpc_codegen_line(cg, "if (k%d >= 0) {", id);
+  cg->depth++;
+  if (newline) {
+    mpc_codegen_line(cg, "mpc_gen_advance(g, k%d);", id);
+  } else {
+    mpc_codegen_line(cg, "g->state.pos += k%d;", id);
+    mpc_codegen_line(cg, "g->state.col += k%d;", id);
+  }
+  if (!cg->suppressed) {
+    mpc_codegen_line(cg, "if (%s_dfa%d_reports[fin%d]) { mpc_gen_report(g, %s_dfa%d_expected, %s_dfa%d_reports[fin%d]); }",
+      cg->prefix, k, id, cg->prefix, k, cg->prefix, k, id);
+  }
+  mpc_codegen_line(cg, "goto e%d;", id);
+  cg->depth--;
+  mpc_codegen_line(cg, "}");
+  
+  if (cg->suppressed) {
+    mpc_codegen_line(cg, "g->err = 0; goto f%d;", fail);
+  } else {
+    /* The regex fails no further on than the DFA */
+    mpc_codegen_line(cg, "if (!mpc_gen_reaches(g, g->state.pos + j%d)) { g->err = 0; goto f%d; }", id, fail);
+    mpc_codegen_node(cg, p->data.dfa.x, MPC_CODEGEN_NONE, NULL, NULL, NULL, fail, 0);
+  }
+  
+  mpc_codegen_close(cg);
+  mpc_codegen_line(cg, "e%d: ;", id);
+}
+
+static void mpc_codegen_repeat(mpc_codegen_t *cg, mpc_parser_t *p, int mode, const char *out, int fail) {
+  
+  int id = ++cg->ids, l = ++cg->ids;
+  int ast = mode == MPC_CODEGEN_AST;
+  int fails = mpc_codegen_fails(p->data.repeat.x, 0);
+  char t[32];
+  
+  sprintf(t, "t%d", id);
+  
+  mpc_codegen_open(cg);
+  if (ast) { mpc_codegen_line(cg, "int b%d = g->stack_num;", id); }
+  if (ast) { mpc_codegen_line(cg, "mpc_val_t *t%d;", id); }
+  if (p->type != MPC_TYPE_MANY) { mpc_codegen_line(cg, "int j%d;", id); }
+  
+  if (p->type == MPC_TYPE_COUNT) {
+    mpc_codegen_line(cg, "for (j%d = 0; j%d < %d; j%d++) {", id, id, p->data.repeat.n, id);
+  } else {
+    if (p->type == MPC_TYPE_MANY1) { mpc_codegen_line(cg, "j%d = 0;", id); }
+    mpc_codegen_line(cg, "while (1) {");
+  }
+  
+  cg->depth++;
+  mpc_codegen_node(cg, p->data.repeat.x, ast ? MPC_CODEGEN_AST : MPC_CODEGEN_NONE, t, NULL, NULL, l, 0);
+  if (ast) { mpc_codegen_line(cg, "mpc_gen_push(g, t%d);", id); }
+  if (p->type == MPC_TYPE_MANY1) { mpc_codegen_line(cg, "j%d++;", id); }
+  cg->depth--;
+  mpc_codegen_line(cg, "}");
+  
+  if (p->type == MPC_TYPE_COUNT && fails) {
+    mpc_codegen_line(cg, "goto e%d;", id);
+    mpc_codegen_line(cg, "f%d:", l);
+    cg->depth++;
+    if (ast) { mpc_codegen_line(cg, "mpc_gen_drop(g, b%d);", id); }
+    if (!cg->suppressed) { mpc_codegen_line(cg, "if (g->err) { mpc_gen_count(g, %d); }", p->data.repeat.n); }
+    mpc_codegen_line(cg, "goto f%d;", fail);
+    cg->depth--;
+    mpc_codegen_line(cg, "e%d: ;", id);
+  }
+  
+  if (p->type != MPC_TYPE_COUNT && fails) {
+    mpc_codegen_line(cg, "f%d: ;", l);
+    if (p->type == MPC_TYPE_MANY1) {
+      mpc_codegen_line(cg, "if (j%d == 0) {", id);
+      cg->depth++;
+      if (!cg->suppressed) { mpc_codegen_line(cg, "if (g->err) { mpc_gen_many1(g); }"); }
+      mpc_codegen_line(cg, "goto f%d;", fail);
+      cg->depth--;
+      mpc_codegen_line(cg, "}");
+    }
+    mpc_codegen_record(cg);
+  }
+  
+  if (ast) { mpc_codegen_line(cg, "%s = mpc_gen_fold_stack(g, b%d);", out, id); }
+  mpc_codegen_close(cg);
+}
+
+static void mpc_codegen_or(mpc_codegen_t *cg, mpc_parser_t *p, int mode,
+  const char *out, const char *oa, const char *ob, int fail) {
+  
+  int id = ++cg->ids, j, l, jumped = 0;
+  
+  if (p->data.or.n == 0) {
+    if (mode == MPC_CODEGEN_AST) { mpc_codegen_line(cg, "%s = NULL;", out); }
+    return;
+  }
+  
+  for (j = 0; j < p->data.or.n; j++) {
+    
+    l = ++cg->ids;
+    mpc_codegen_node(cg, p->data.or.xs[j], mode, out, oa, ob, l, 0);
+    
+    /* An option which cannot fail ends the choice */
+    if (!mpc_codegen_fails(p->data.or.xs[j], 0)) { break; }
+    
+    mpc_codegen_line(cg, "goto e%d;", id);
+    mpc_codegen_line(cg, "f%d: ;", l);
+    mpc_codegen_record(cg);
+    jumped = 1;
+  }
+  
+  if (j == p->data.or.n) { mpc_codegen_line(cg, "g->err = 0; goto f%d;", fail); }
+  if (jumped) { mpc_codegen_line(cg, "e%d: ;", id); }
+}
+
+static void mpc_codegen_and(mpc_codegen_t *cg, mpc_parser_t *p, int mode,
+  const char *out, const char *oa, const char *ob, int fail) {
+  
+  int id = ++cg->ids, j, n = p->data.and.n;
+  int pick = mpc_codegen_pick(p->data.and.f);
+  int fold = p->data.and.f == mpcf_fold_ast;
+  int state = p->data.and.f == mpcf_state_ast;
+  int fails = mpc_codegen_fails(p, 0);
+  int reached = 0;
+  int *labels;
+  char x[32];
+  
+  if (n == 0) {
+    if (mode == MPC_CODEGEN_AST) { mpc_codegen_line(cg, "%s = NULL;", out); }
+    return;
+  }
+  
+  if (state) { pick = 1; }
+  
+  labels = malloc(sizeof(int) * n);
+  
+  mpc_codegen_open(cg);
+  if (fails || state) { mpc_codegen_line(cg, "mpc_state_t s%d = g->state;", id); }
+  if (fold) { mpc_codegen_line(cg, "mpc_val_t *xs%d[%d];", id, n); }
+  
+  for (j = 0; j < n; j++) {
+    labels[j] = ++cg->ids;
+    if (state && j == 0) { continue; }
+    if (fold) {
+      sprintf(x, "xs%d[%d]", id, j);
+      mpc_codegen_node(cg, p->data.and.xs[j], MPC_CODEGEN_AST, x, NULL, NULL, labels[j], 0);
+    } else if (j == pick) {
+      mpc_codegen_node(cg, p->data.and.xs[j], mode, out, oa, ob, labels[j], 0);
+    } else {
+      mpc_codegen_node(cg, p->data.and.xs[j], MPC_CODEGEN_NONE, NULL, NULL, NULL, labels[j], 0);
+    }
+  }
+  
+  if (fold) { mpc_codegen_line(cg, "%s = mpc_gen_fold(g, %d, xs%d);", out, n, id); }
+  if (state) { mpc_codegen_line(cg, "if (%s) { ((mpc_ast_t*)%s)->state = s%d; }", out, out, id); }
+  
+  /* Failing part way deletes the trees already built */
+  if (fails) {
+    mpc_codegen_line(cg, "goto e%d;", id);
+    for (j = n - 1; j >= 0; j--) {
+      if (mpc_codegen_fails(p->data.and.xs[j], 0)) {
+        mpc_codegen_line(cg, "f%d: ;", labels[j]);
+        reached = 1;
+      }
+      if (!reached || j == 0) { continue; }
+      if (fold) {
+        mpc_codegen_line(cg, "mpc_gen_delete(g, xs%d[%d]);", id, j - 1);
+      } else if (j - 1 == pick && mode == MPC_CODEGEN_AST) {
+        mpc_codegen_line(cg, "mpc_gen_delete(g, %s);", out);
+      }
+    }
+    mpc_codegen_rewind(cg, id);
+    mpc_codegen_line(cg, "goto f%d;", fail);
+    mpc_codegen_line(cg, "e%d: ;", id);
+  }
+  
+  mpc_codegen_close(cg);
+  free(labels);
+}
+
+static void mpc_codegen_node(mpc_codegen_t *cg, mpc_parser_t *p, int mode,
+  const char *out, const char *oa, const char *ob, int fail, int top) {
+  
+  int id, l, k, calls;
+  char a[32], b[32], t[256];
+  char *q;
+  
+  if (cg->error) { return; }
+  
+  /* Failing parsers have no value to speak of */
+  if (!(p->retained && !top)
+  && (p->type == MPC_TYPE_FAIL || p->type == MPC_TYPE_UNDEFINED)) {
+    mpc_codegen_expect(cg, p->type == MPC_TYPE_FAIL ? p->data.fail.m : "Parser Undefined!", 1);
+    mpc_codegen_line(cg, "goto f%d;", fail);
+    return;
+  }
+  
+  k = mpc_codegen_kind(p, top);
+  if (k < 0) { mpc_codegen_error(cg, "unsupported function or value"); return; }
+  
+  /* Trees not wanted are still built and then deleted */
+  if (mode == MPC_CODEGEN_NONE && k == MPC_CODEGEN_AST) {
+    id = ++cg->ids;
+    sprintf(t, "t%d", id);
+    mpc_codegen_open(cg);
+    mpc_codegen_line(cg, "mpc_val_t *t%d;", id);
+    mpc_codegen_node(cg, p, MPC_CODEGEN_AST, t, NULL, NULL, fail, top);
+    mpc_codegen_line(cg, "mpc_gen_delete(g, t%d);", id);
+    mpc_codegen_close(cg);
+    return;
+  }
+  
+  if (mode == MPC_CODEGEN_AST && k == MPC_CODEGEN_NONE) {
+    mpc_codegen_node(cg, p, MPC_CODEGEN_NONE, NULL, NULL, NULL, fail, top);
+    mpc_codegen_line(cg, "%s = NULL;", out);
+    return;
+  }
+  
+  if (mode != MPC_CODEGEN_NONE && k != mode) {
+    mpc_codegen_error(cg, "string value used as a tree");
+    return;
+  }
+  
+  if (mode == MPC_CODEGEN_SPAN && mpc_codegen_exact(p, cg->predictive)) {
+    mpc_codegen_line(cg, "%s = g->state.pos;", oa);
+    mpc_codegen_node(cg, p, MPC_CODEGEN_NONE, NULL, NULL, NULL, fail, top);
+    mpc_codegen_line(cg, "%s = g->state.pos;", ob);
+    return;
+  }
+  
+  if (p->retained && !top) {
+    id = mpc_codegen_rule(cg, p);
+    mpc_codegen_rule_name(cg, id, t, sizeof(t));
+    mpc_codegen_line(cg, "if (!%s(g, &%s)) { goto f%d; }", t, out, fail);
+    return;
+  }
+  
+  switch (p->type) {
+    
+    case MPC_TYPE_ANY:    case MPC_TYPE_SINGLE: case MPC_TYPE_RANGE:
+    case MPC_TYPE_ONEOF:  case MPC_TYPE_NONEOF: case MPC_TYPE_STRING:
+    case MPC_TYPE_ANCHOR:
+      mpc_codegen_primitive(cg, p, fail);
+      break;
+    
+    case MPC_TYPE_PASS: case MPC_TYPE_LIFT: case MPC_TYPE_LIFT_VAL:
+      break;
+    
+    case MPC_TYPE_DFA:
+      mpc_codegen_dfa_run(cg, p, fail);
+      break;
+    
+    case MPC_TYPE_EXPECT:
+      
+      id = ++cg->ids; l = ++cg->ids;
+      calls = mpc_codegen_calls(p->data.expect.x);
+      
+      if (calls) { mpc_codegen_line(cg, "g->suppress++;"); }
+      cg->suppressed++;
+      mpc_codegen_node(cg, p->data.expect.x, mode, out, oa, ob, l, 0);
+      cg->suppressed--;
+      if (calls) { mpc_codegen_line(cg, "g->suppress--;"); }
+      
+      if (mpc_codegen_fails(p->data.expect.x, 0)) {
+        mpc_codegen_line(cg, "goto e%d;", id);
+        mpc_codegen_line(cg, "f%d:", l);
+        cg->depth++;
+        if (calls) { mpc_codegen_line(cg, "g->suppress--;"); }
+        mpc_codegen_expect(cg, p->data.expect.m, 0);
+        mpc_codegen_line(cg, "goto f%d;", fail);
+        cg->depth--;
+        mpc_codegen_line(cg, "e%d: ;", id);
+      }
+      break;
+    
+    case MPC_TYPE_PREDICT:
+      
+      id = ++cg->ids; l = ++cg->ids;
+      mpc_codegen_line(cg, "g->backtrack--;");
+      mpc_codegen_node(cg, p->data.predict.x, mode, out, oa, ob, l, 0);
+      mpc_codegen_line(cg, "g->backtrack++;");
+      if (mpc_codegen_fails(p->data.predict.x, 0)) {
+        mpc_codegen_line(cg, "goto e%d;", id);
+        mpc_codegen_line(cg, "f%d: g->backtrack++; goto f%d;", l, fail);
+        mpc_codegen_line(cg, "e%d: ;", id);
+      }
+      break;
+    
+    case MPC_TYPE_NOT:
+      
+      id = ++cg->ids; l = ++cg->ids;
+      calls = mpc_codegen_calls(p->data.not.x);
+      
+      mpc_codegen_open(cg);
+      mpc_codegen_line(cg, "mpc_state_t s%d = g->state;", id);
+      if (calls) { mpc_codegen_line(cg, "g->suppress++;"); }
+      cg->suppressed++;
+      mpc_codegen_node(cg, p->data.not.x, MPC_CODEGEN_NONE, NULL, NULL, NULL, l, 0);
+      cg->suppressed--;
+      mpc_codegen_rewind(cg, id);
+      if (calls) { mpc_codegen_line(cg, "g->suppress--;"); }
+      mpc_codegen_expect(cg, "opposite", 0);
+      mpc_codegen_line(cg, "goto f%d;", fail);
+      if (mpc_codegen_fails(p->data.not.x, 0)) {
+        mpc_codegen_line(cg, "f%d: ;", l);
+        if (calls) { mpc_codegen_line(cg, "g->suppress--;"); }
+      }
+      mpc_codegen_close(cg);
+      break;
+    
+    case MPC_TYPE_MAYBE:
+      
+      id = ++cg->ids; l = ++cg->ids;
+      mpc_codegen_node(cg, p->data.not.x, mode, out, oa, ob, l, 0);
+      if (mpc_codegen_fails(p->data.not.x, 0)) {
+        mpc_codegen_line(cg, "goto e%d;", id);
+        mpc_codegen_line(cg, "f%d: ;", l);
+        mpc_codegen_record(cg);
+        if (mode == MPC_CODEGEN_AST) { mpc_codegen_line(cg, "%s = NULL;", out); }
+        if (mode == MPC_CODEGEN_SPAN) { mpc_codegen_line(cg, "%s = %s = g->state.pos;", oa, ob); }
+        mpc_codegen_line(cg, "e%d: ;", id);
+      }
+      break;
+    
+    case MPC_TYPE_MANY: case MPC_TYPE_MANY1: case MPC_TYPE_COUNT:
+      if (mode == MPC_CODEGEN_SPAN) { mpc_codegen_error(cg, "inexact string repetition"); break; }
+      mpc_codegen_repeat(cg, p, mode, out, fail);
+      break;
+    
+    case MPC_TYPE_OR:
+      mpc_codegen_or(cg, p, mode, out, oa, ob, fail);
+      break;
+    
+    case MPC_TYPE_AND:
+      if (mode == MPC_CODEGEN_SPAN && mpc_codegen_pick(p->data.and.f) < 0) {
+        mpc_codegen_error(cg, "inexact string sequence");
+        break;
+      }
+      mpc_codegen_and(cg, p, mode, out, oa, ob, fail);
+      break;
+    
+    case MPC_TYPE_APPLY:
+      
+      if (p->data.apply.f == mpcf_str_ast) {
+        id = ++cg->ids;
+        sprintf(a, "a%d", id);
+        sprintf(b, "b%d", id);
+        mpc_codegen_open(cg);
+        mpc_codegen_line(cg, "long a%d, b%d;", id, id);
+        mpc_codegen_node(cg, p->data.apply.x, MPC_CODEGEN_SPAN, NULL, a, b, fail, 0);
+        mpc_codegen_line(cg, "%s = mpc_gen_str_ast(g, a%d, b%d);", out, id, id);
+        mpc_codegen_close(cg);
+      } else if (p->data.apply.f == mpcf_free) {
+        mpc_codegen_node(cg, p->data.apply.x, MPC_CODEGEN_NONE, NULL, NULL, NULL, fail, 0);
+      } else {
+        mpc_codegen_node(cg, p->data.apply.x, MPC_CODEGEN_AST, out, NULL, NULL, fail, 0);
+        mpc_codegen_line(cg, "%s = mpc_gen_add_root(g, %s);", out, out);
+      }
+      break;
+    
+    case MPC_TYPE_APPLY_TO:
+      
+      mpc_codegen_node(cg, p->data.apply_to.x, MPC_CODEGEN_AST, out, NULL, NULL, fail, 0);
+      
+      if (p->data.apply_to.f == mpcaf_rule || p->data.apply_to.f == mpcaf_token) {
+        mpc_codegen_line(cg, "%s = %s(%s, %d);", out,
+          p->data.apply_to.f == mpcaf_rule ? "mpc_ast_rule" : "mpc_ast_token",
+          out, (int)(size_t)p->data.apply_to.d);
+      } else {
+        q = mpc_codegen_quote((const char*)p->data.apply_to.d);
+        mpc_codegen_line(cg, "%s = %s(g, %s, %s);", out,
+          p->data.apply_to.f == (mpc_apply_to_t)mpc_ast_tag ? "mpc_gen_tag" : "mpc_gen_add_tag", out, q);
+        free(q);
+      }
+      break;
+    
+    default:
+      mpc_codegen_error(cg, "unsupported parser type");
+      break;
+  }
+}
+
+/*
+** Writing Files
+*/
+
+static void mpc_codegen_tables(mpc_codegen_t *cg) {
+  
+  int j, k, s;
+  mpc_dfa_t *d;
+  char *q;
+  
+  for (j = 0; j < cg->classes_num; j++) {
+    fprintf(cg->f, "static const unsigned char %s_class%d[32] = {", cg->prefix, j);
+    for (k = 0; k < 32; k++) {
+      fprintf(cg->f, "%s%s%d", k ? "," : "", k % 16 ? " " : "\n  ", cg->classes[j]->bits[k]);
+    }
+    fprintf(cg->f, "\n};\n\n");
+  }
+  
+  for (j = 0; j < cg->dfas_num; j++) {
+    
+    d = cg->dfas[j];
+    
+    fprintf(cg->f, "static const short %s_dfa%d[%d] = {", cg->prefix, j, d->states_num * 256);
+    for (k = 0; k < d->states_num * 256; k++) {
+      fprintf(cg->f, "%s%s%d", k ? "," : "", k % 16 ? " " : "\n  ", d->trans[k]);
+    }
+    fprintf(cg->f, "\n};\n\n");
+    
+    fprintf(cg->f, "static const char %s_dfa%d_accept[%d] = {", cg->prefix, j, d->states_num);
+    for (s = 0; s < d->states_num; s++) {
+      fprintf(cg->f, "%s%s%d", s ? "," : "", s % 16 ? " " : "\n  ", d->accept[s] ? 1 : 0);
+    }
+    fprintf(cg->f, "\n};\n\n");
+    
+    fprintf(cg->f, "static const unsigned long %s_dfa%d_reports[%d] = {", cg->prefix, j, d->states_num);
+    for (s = 0; s < d->states_num; s++) {
+      fprintf(cg->f, "%s%s%luUL", s ? "," : "", s % 8 ? " " : "\n  ", d->reports[s]);
+    }
+    fprintf(cg->f, "\n};\n\n");
+    
+    fprintf(cg->f, "static const char *%s_dfa%d_expected[%d] = {", cg->prefix, j,
+      d->expected_num ? d->expected_num : 1);
+    if (d->expected_num == 0) { fprintf(cg->f, "\n  NULL"); }
+    for (s = 0; s < d->expected_num; s++) {
+      q = mpc_codegen_quote(d->expected[s]);
+      fprintf(cg->f, "%s\n  %s", s ? "," : "", q);
+      free(q);
+    }
+    fprintf(cg->f, "\n};\n\n");
+  }
+}
+
+static void mpc_codegen_rules(mpc_codegen_t *cg) {
+  
+  int j, l;
+  char name[256];
+  
+  for (j = 0; j < cg->rules_num && cg->error == NULL; j++) {
+    
+    cg->rule = cg->rules[j];
+    l = ++cg->ids;
+    mpc_codegen_rule_name(cg, j, name, sizeof(name));
+    
+    if (mpc_codegen_kind(cg->rule, 1) == MPC_CODEGEN_SPAN) {
+      mpc_codegen_error(cg, "rules must build trees");
+      return;
+    }
+    
+    mpc_codegen_line(cg, "static int %s(mpc_gen_t *g, mpc_val_t **x) {", name);
+    cg->depth++;
+    mpc_codegen_node(cg, cg->rule, MPC_CODEGEN_AST, "*x", NULL, NULL, l, 1);
+    mpc_codegen_line(cg, "return 1;");
+    if (mpc_codegen_fails(cg->rule, 1)) {
+      mpc_codegen_line(cg, "f%d:", l);
+      mpc_codegen_line(cg, "  return 0;");
+    }
+    cg->depth--;
+    mpc_codegen_line(cg, "}");
+    mpc_codegen_line(cg, "");
+  }
+}
+
+/* Names the rule numbers `mpca_lang` gave to the parsers written out */
+static void mpc_codegen_rule_ids(mpc_codegen_t *cg, FILE *f, int n) {
+  
+  int j, found = 0;
+  const char *c;
+  mpc_parser_t *p;
+  
+  for (j = 0; j < n; j++) {
+    
+    p = cg->rules[j];
+    if (p->type != MPC_TYPE_APPLY_TO || p->data.apply_to.f != mpcaf_rule) { continue; }
+    
+    if (!found) { fprintf(f, "enum {\n"); }
+    fputs(found ? ",\n  " : "  ", f);
+    found = 1;
+    
+    for (c = cg->prefix; *c; c++) { fputc(toupper((unsigned char)*c), f); }
+    fputs("_RULE_", f);
+    for (c = p->name; *c; c++) { fputc(toupper((unsigned char)*c), f); }
+    fprintf(f, " = %d", (int)(size_t)p->data.apply_to.d);
+  }
+  
+  if (found) { fprintf(f, "\n};\n\n"); }
+}
+
+mpc_err_t *mpc_codegen(FILE *source, FILE *header, const char *prefix, int n, ...) {
+  
+  int j;
+  va_list va;
+  mpc_codegen_t cg;
+  mpc_err_t *e = NULL;
+  char name[256];
+  
+  memset(&cg, 0, sizeof(cg));
+  cg.prefix = prefix;
+  
+  if (!mpc_codegen_is_ident(prefix) || strlen(prefix) > 32) {
+    mpc_codegen_error(&cg, "prefix is not an identifier");
+  }
+  
+  va_start(va, n);
+  for (j = 0; j < n; j++) {
+    cg.rule = va_arg(va, mpc_parser_t*);
+    if (!mpc_codegen_is_ident(cg.rule->name) || strlen(cg.rule->name) > 128) {
+      mpc_codegen_error(&cg, "name is not an identifier");
+    }
+    mpc_codegen_rule(&cg, cg.rule);
+  }
+  va_end(va);
+  
+  for (j = 0; j < n; j++) {
+    mpc_codegen_scan(&cg, cg.rules[j], 1);
+  }
+  
+  /* A first pass with no output checks the grammar and finds every table */
+  if (cg.error == NULL) { mpc_codegen_rules(&cg); }
+  
+  if (cg.error) {
+    e = mpc_err_file("<mpc_codegen>", cg.error);
+    goto done;
+  }
+  
+  if (source) {
+    
+    cg.f = source;
+    cg.ids = 0;
+    cg.depth = 0;
+    
+    fprintf(source, "/*\n** Generated by mpc_codegen. Do not edit.\n*/\n\n");
+    fprintf(source, "#include \"mpc.h\"\n\n");
+    
+    for (j = 0; j < cg.rules_num; j++) {
+      mpc_codegen_rule_name(&cg, j, name, sizeof(name));
+      fprintf(source, "static int %s(mpc_gen_t *g, mpc_val_t **x);\n", name);
+    }
+    fprintf(source, "\n");
+    
+    mpc_codegen_tables(&cg);
+    mpc_codegen_rules(&cg);
+    
+    for (j = 0; j < n; j++) {
+      mpc_codegen_rule_name(&cg, j, name, sizeof(name));
+      fprintf(source, "int %s_parse_%s(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r) {\n",
+        prefix, cg.rules[j]->name);
+      fprintf(source, "  return mpc_gen_parse(c, filename, string, %s, r);\n}\n\n", name);
+      fprintf(source, "int %s_nparse_%s(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r) {\n",
+        prefix, cg.rules[j]->name);
+      fprintf(source, "  return mpc_gen_nparse(c, filename, string, length, %s, r);\n}\n\n", name);
+    }
+  }
+  
+  if (header) {
+    fprintf(header, "/*\n** Generated by mpc_codegen. Do not edit.\n*/\n\n");
+    fprintf(header, "#ifndef %s_parser_h\n#define %s_parser_h\n\n", prefix, prefix);
+    fprintf(header, "#include \"mpc.h\"\n\n");
+    mpc_codegen_rule_ids(&cg, header, n);
+    for (j = 0; j < n; j++) {
+      fprintf(header, "int %s_parse_%s(mpc_context_t *c, const char *filename, const char *string, mpc_result_t *r);\n",
+        prefix, cg.rules[j]->name);
+      fprintf(header, "int %s_nparse_%s(mpc_context_t *c, const char *filename, const char *string, size_t length, mpc_result_t *r);\n",
+        prefix, cg.rules[j]->name);
+    }
+    fprintf(header, "\n#endif\n");
+  }
+  
+done:
+  free(cg.rules);
+  free(cg.classes);
+  free(cg.dfas);
+  free(cg.error);
+  return e;
+}
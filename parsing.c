@@ -1,9 +1,22 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
 #include "mpc.h"
+#include "lispy_parser.h"
 #include "lval_ops.h"
 #include "builtins.h" 
 #include "lenv_ops.h"
+#include "lbin_ops.h"
+#include "lsink_ops.h"
+#include "lreader_ops.h"
+#include "lqueue_ops.h"
+#include "lpool_ops.h"
+#include "lserver_ops.h"
+#include "lfork_ops.h"
 
 #ifdef _WIN32
 #include <string.h>
@@ -27,55 +40,301 @@ void add_history(char* unused){}
 #include <editline/history.h>
 #endif
 
-void lenv_add_builtins(lenv* e)
+/* seconds on a clock that only moves forward, for the timings */
+static double now(void)
 {
-    lenv_add_builtin(e, "list", builtin_list);
-    lenv_add_builtin(e, "head", builtin_head);
-    lenv_add_builtin(e, "tail", builtin_tail);
-    lenv_add_builtin(e, "eval", builtin_eval);
-    lenv_add_builtin(e, "join", builtin_join);
-
-    lenv_add_builtin(e, "+", builtin_add);
-    lenv_add_builtin(e, "-", builtin_sub);
-    lenv_add_builtin(e, "*", builtin_mul);
-    lenv_add_builtin(e, "/", builtin_div);
-
-    lenv_add_builtin(e, "def", builtin_def);
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+/* with -p forms are read on a thread of their own and passed over a queue */
+typedef struct
+{
+    lreader* r;
+    lqueue* q;
+    double parse;
+} read_job;
+
+static void* read_forms(void* arg)
+{
+    read_job* job = arg;
+    lval* x;
+    do
+    {
+        double start = now();
+        x = lreader_next(job->r);
+        job->parse += now() - start;
+
+        // NULL goes through as well, it tells the evaluator to stop
+        lqueue_push(job->q, x);
+    }
+    while (x != NULL);
+    return NULL;
+}
+
+/* evaluate every top level form of a script in order, writing each result
+   to out. Forms are read and evaluated as they arrive, "-" reads stdin */
+static int run_file(lenv* e, lsink* out, char* name, int timing, int pipelined)
+{
+    FILE* f = strcmp(name, "-") == 0 ? stdin : fopen(name, "r");
+    if (f == NULL)
+    {
+        lsink_flush(out);
+        fprintf(stderr, "Could not open file '%s'\n", name);
+        return 1;
+    }
+
+    read_job job = { lreader_new(f, f == stdin ? "<stdin>" : name), NULL, 0 };
+    double eval = 0;
+
+    pthread_t reader;
+    if (pipelined)
+    {
+        job.q = lqueue_new(256);
+        if (pthread_create(&reader, NULL, read_forms, &job) != 0)
+        {
+            lqueue_del(job.q);
+            job.q = NULL;
+        }
+    }
+
+    while (1)
+    {
+        lval* x;
+        if (job.q)
+        {
+            x = lqueue_pop(job.q);
+        }
+        else
+        {
+            double start = now();
+            x = lreader_next(job.r);
+            job.parse += now() - start;
+        }
+
+        if (x == NULL)
+            break;
+
+        double start = now();
+        x = lval_eval(e, x);
+        lval_write(out, x);
+        lsink_putc(out, '\n');
+        lval_del(x);
+
+        // a slow stream should not hold back results that are ready
+        if (f == stdin)
+            lsink_flush(out);
+        eval += now() - start;
+    }
+
+    if (job.q)
+    {
+        pthread_join(reader, NULL);
+        lqueue_del(job.q);
+    }
+
+    // the reader stopped at the first error, after everything before it
+    int failed = job.r->error != NULL;
+    if (failed)
+    {
+        lsink_flush(out);
+        mpc_err_print_to(job.r->error, stderr);
+    }
+
+    lreader_del(job.r);
+    if (f != stdin)
+        fclose(f);
+
+    if (timing)
+    {
+        lsink_flush(out);
+        fprintf(stderr, "%s: parse %.3f ms, eval %.3f ms\n", name, job.parse * 1e3, eval * 1e3);
+    }
+
+    return failed;
 }
 
+static void usage(char* prog)
+{
+    fprintf(stderr,
+            "usage: %s [-i image] [-s image] [-b] [-t] [-p] [-j threads [-q tasks]] [-S socket [-w workers | -P procs]] [file ...]\n"
+            "  -i image  start from an image instead of the builtins\n"
+            "  -s image  write the environment to an image when done\n"
+            "  -b        run scripts without the prompt, stdin if no files are given\n"
+            "  -t        report read and eval times of each script\n"
+            "  -p        read scripts on a second thread while evaluating\n"
+            "  -j n      evaluate large independent arguments on n threads\n"
+            "  -q n      queue up to n tasks per thread before evaluating in place\n"
+            "  -S path   serve requests on a Unix socket, running the files first\n"
+            "  -w n      evaluate requests on n threads, one per core by default\n"
+            "  -P n      evaluate requests in n processes forked once the files have run\n",
+            prog);
+}
 
 int main(int argc, char** argv)
 {
+    char* image = NULL;
+    char* snapshot = NULL;
+    int batch = 0;
+    int timing = 0;
+    int pipelined = 0;
+    int threads = 1;
+    int tasks = 0;
+    char* server = NULL;
+    int workers = 0;
+    int procs = -1;
 
-    /* Create some parsers */
-    mpc_parser_t* Number = mpc_new("number");
-    mpc_parser_t* Symbol = mpc_new("symbol");
-    mpc_parser_t* Sexpr = mpc_new("sexpr");
-    mpc_parser_t* Qexpr = mpc_new("qexpr");
-    mpc_parser_t* Expr = mpc_new("expr");
-    mpc_parser_t* Lispy = mpc_new("lispy");
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i++)
+    {
+        if (strcmp(argv[i], "--") == 0) { i++; break; }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) image = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) snapshot = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0) batch = 1;
+        else if (strcmp(argv[i], "-t") == 0) timing = 1;
+        else if (strcmp(argv[i], "-p") == 0) pipelined = 1;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) tasks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) server = argv[++i];
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) procs = atoi(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
 
-    /* Define them with the following Language*/
-    mpca_lang(MPCA_LANG_DEFAULT,
-            "\
-             number : /-?[0-9]+/ ; \
-             symbol: /[a-zA-Z0-9_+\\-*\\/\\\\=<>!&]+/ ; \
-             sexpr: '(' <expr>* ')';\
-             qexpr: '{' <expr>* '}';\
-             expr : <number> | <symbol> | <sexpr> | <qexpr> ; \
-             lispy : /^/ <expr>* /$/ ; \
-             ",
-             Number, Symbol, Sexpr, Qexpr, Expr, Lispy);
+    /* the files set up one interpreter that every worker process starts
+       from as it was when they were forked */
+    if (server && procs >= 0)
+    {
+        lfork* f = lfork_new(server, procs, threads);
+        if (f == NULL)
+        {
+            perror(server);
+            return 1;
+        }
 
+        for (; i < argc; i++)
+        {
+            lval* x = lfork_prelude(f, argv[i]);
+            int failed = x->type == LVAL_ERR;
+            if (failed)
+                lval_println(x);
+            lval_del(x);
+            if (failed)
+            {
+                lfork_del(f);
+                return 1;
+            }
+        }
 
+        int failed = lfork_run(f);
+        lfork_del(f);
+        return failed;
+    }
 
+    /* every worker has an interpreter of its own, the files set each one up */
+    if (server)
+    {
+        lserver* s = lserver_new(server, workers, threads);
+        if (s == NULL)
+        {
+            perror(server);
+            return 1;
+        }
+
+        for (; i < argc; i++)
+        {
+            lval* x = lserver_prelude(s, argv[i]);
+            int failed = x->type == LVAL_ERR;
+            if (failed)
+                lval_println(x);
+            lval_del(x);
+            if (failed)
+            {
+                lserver_del(s);
+                return 1;
+            }
+        }
+
+        int failed = lserver_run(s);
+        lserver_del(s);
+        return failed;
+    }
+
+    /* any script or a snapshot to write means there is no prompt */
+    int read_stdin = batch && i == argc;
+    if (i < argc || snapshot)
+        batch = 1;
+
+    lenv* e = lenv_new();
+
+    if (image)
+    {
+        lval* x = lbin_load_image(image, e);
+        if (x->type == LVAL_ERR)
+        {
+            lval_println(x);
+            return 1;
+        }
+        lval_del(x);
+    }
+    else
+    {
+        lenv_add_builtins(e);
+    }
+
+    /* one thread needs no pool, everything is evaluated in order */
+    lpool* pool = NULL;
+    if (threads > 1)
+    {
+        pool = lpool_new(threads, tasks);
+        lval_eval_parallel(e, pool, LPOOL_COST);
+    }
+
+    if (batch)
+    {
+        int failed = 0;
+        lsink* out = lsink_file(stdout);
+
+        if (read_stdin)
+            failed |= run_file(e, out, "-", timing, pipelined);
+        for (; i < argc; i++)
+            failed |= run_file(e, out, argv[i], timing, pipelined);
+
+        lsink_del(out);
+
+        if (snapshot)
+        {
+            lval* x = lbin_save_image(snapshot, e);
+            if (x->type == LVAL_ERR)
+            {
+                lval_println(x);
+                failed = 1;
+            }
+            lval_del(x);
+        }
+
+        // futures still in the environment wait on the pool
+        lenv_del(e);
+        if (pool)
+            lpool_del(pool);
+        return failed;
+    }
 
     /* Print Version and Exit Information*/
     puts("Lispy Version 0.0.0.0.1");
     puts("Press Ctrl+c to Exit\n");
 
-    lenv* e = lenv_new();
-    lenv_add_builtins(e);
+    /* Reuse one parse context for every line, the AST lives in it until the next parse */
+    mpc_context_t* ctx = mpc_context_new(MPC_CONTEXT_AST_ARENA);
 
     while(1)
     {
@@ -85,13 +344,11 @@ int main(int argc, char** argv)
         
         // parse the input
         mpc_result_t r;
-        if (mpc_parse("<stdin>", input, Lispy, &r))
+        if (lispy_parse_lispy(ctx, "<stdin>", input, &r))
         {
             lval* x = lval_eval(e, lval_read(r.output));
             lval_println(x);
             lval_del(x);
-
-            mpc_ast_delete(r.output);
         }
         else
         {
@@ -102,13 +359,8 @@ int main(int argc, char** argv)
         free(input);
 
     }
+    mpc_context_delete(ctx);
     lenv_del(e); 
-    /* Undefine and Delete the Parser */
-    mpc_cleanup(6, Number, Symbol, Sexpr, Qexpr, Expr, Lispy);
 
     return 0;
 }
-
-
-
-
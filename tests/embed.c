@@ -0,0 +1,100 @@
+#include "lispy.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the library as a host sees it, through lispy.h alone: an allocator of
+   its own, two interpreters side by side, a C builtin and output caught
+   by a function */
+
+static atomic_long allocs;
+
+static void* count_malloc(size_t n)
+{
+    atomic_fetch_add(&allocs, 1);
+    return malloc(n);
+}
+
+static void* count_realloc(void* p, size_t n)
+{
+    if (p == NULL)
+        atomic_fetch_add(&allocs, 1);
+    return realloc(p, n);
+}
+
+static const lispy_allocator counting = { count_malloc, count_realloc, free };
+
+static int failures;
+
+static void check(int ok, const char* what)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "embed: %s\n", what);
+        failures++;
+    }
+}
+
+/* (twice n) */
+static lispy_value* twice(lispy_env* env, lispy_value* args)
+{
+    (void)env;
+    lispy_value* r;
+    if (lispy_count(args) != 1 || lispy_type(lispy_item(args, 0)) != LISPY_NUMBER)
+        r = lispy_make_error("Function 'twice' takes one number");
+    else
+        r = lispy_make_number(2 * lispy_number(lispy_item(args, 0)));
+    lispy_free(args);
+    return r;
+}
+
+static void collect(void* ctx, const char* p, size_t n)
+{
+    strncat(ctx, p, n);
+}
+
+static long number(lispy* l, const char* s)
+{
+    lispy_value* v = lispy_eval(l, s);
+    long n = lispy_type(v) == LISPY_NUMBER ? lispy_number(v) : -1;
+    lispy_free(v);
+    return n;
+}
+
+int main(void)
+{
+    check(lispy_set_allocator(&counting), "the allocator was not taken before the first lispy");
+
+    lispy* a = lispy_new(1);
+    lispy* b = lispy_new(2);
+    check(atomic_load(&allocs) > 0, "nothing went through the allocator");
+    check(!lispy_set_allocator(&counting), "the allocator was replaced after a lispy was made");
+
+    check(number(a, "(def {x} 20) (+ x 1)") == 21, "a did not evaluate its forms");
+    lispy_value* v = lispy_eval(b, "x");
+    check(lispy_type(v) == LISPY_ERROR, "b sees what a defined");
+    lispy_free(v);
+
+    lispy_register(b, "twice", twice);
+    check(number(b, "(twice 21)") == 42, "b did not call its builtin");
+    v = lispy_eval(a, "(twice 21)");
+    check(lispy_type(v) == LISPY_ERROR, "a sees the builtin of b");
+    lispy_free(v);
+
+    v = lispy_eval(b, "{1 (twice 2) x}");
+    check(lispy_type(v) == LISPY_QEXPR && lispy_count(v) == 3
+          && lispy_type(lispy_item(v, 2)) == LISPY_SYMBOL
+          && strcmp(lispy_text(lispy_item(v, 2)), "x") == 0, "b gave the wrong list");
+    lispy_free(v);
+
+    char out[256] = "";
+    lispy_output(a, collect, out);
+    const char* script = "(+ x 1)\n(head {x y})\n";
+    check(lispy_run(a, "embed", script, strlen(script)) == 0, "the script failed");
+    lispy_del(a);
+    check(strcmp(out, "21\n{x}\n") == 0, "the script wrote something else");
+
+    lispy_del(b);
+    return failures != 0;
+}
@@ -0,0 +1,49 @@
+#include "lfork_ops.h"
+#include "lval_ops.h"
+#include <stdio.h>
+
+/* a prelude reading a file large enough to be parsed in several chunks,
+   each on a thread of its own, while everything goes in the warm heap */
+
+#define ROWS 400000
+
+static int write_file(const char* path, const char* text, int times)
+{
+    FILE* f = fopen(path, "w");
+    if (f == NULL)
+        return 0;
+    for (int i = 0; i < times; i++)
+        fputs(text, f);
+    return fclose(f) == 0;
+}
+
+int main(void)
+{
+    if (!write_file("forkdata.lspy", "1 2\n", ROWS)
+        || !write_file("forkprelude.lspy", "(def {d} (read {forkdata}))\n(fold + 0 d)\n", 1))
+    {
+        fprintf(stderr, "fork_prelude: could not write the files\n");
+        return 1;
+    }
+
+    lfork* f = lfork_new("forkprelude.sock", 1, 1);
+    if (f == NULL)
+    {
+        perror("fork_prelude");
+        return 1;
+    }
+
+    lval* x = lfork_prelude(f, "forkprelude.lspy");
+    int ok = x->type == LVAL_NUM && x->num == 3L * ROWS;
+    if (!ok)
+    {
+        fprintf(stderr, "fork_prelude: expected %ld, got ", 3L * ROWS);
+        lval_println(x);
+    }
+    lval_del(x);
+    lfork_del(f);
+
+    remove("forkdata.lspy");
+    remove("forkprelude.lspy");
+    return !ok;
+}
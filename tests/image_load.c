@@ -0,0 +1,56 @@
+#include "lbin_ops.h"
+#include "lenv_ops.h"
+#include "lval_ops.h"
+#include "builtins.h"
+#include <stdio.h>
+
+/* an image read into an environment that already binds some of its names
+   rebinds them rather than adding a second binding never looked at */
+
+static void define(lenv* e, char* name, long n)
+{
+    lval* k = lval_sym(name);
+    lval* v = lval_num(n);
+    lenv_put(e, k, v);
+    lval_del(k);
+    lval_del(v);
+}
+
+int main(void)
+{
+    lenv* a = lenv_new();
+    lenv_add_builtins(a);
+    define(a, "x", 1);
+    lval* x = lbin_save_image("imageload.lbin", a);
+    int ok = x->type != LVAL_ERR;
+    lval_del(x);
+
+    lenv* b = lenv_new();
+    lenv_add_builtins(b);
+    define(b, "x", 2);
+    define(b, "y", 3);
+    int count = b->count;
+
+    if (ok)
+    {
+        x = lbin_load_image("imageload.lbin", b);
+        ok = x->type != LVAL_ERR;
+        lval_del(x);
+    }
+
+    lval* k = lval_sym("x");
+    lval* v = lenv_get(b, k);
+    ok = ok && v->type == LVAL_NUM && v->num == 1 && b->count == count;
+    if (!ok)
+    {
+        fprintf(stderr, "image_load: %d bindings for %d, x is ", b->count, count);
+        lval_println(v);
+    }
+    lval_del(k);
+    lval_del(v);
+
+    lenv_del(a);
+    lenv_del(b);
+    remove("imageload.lbin");
+    return !ok;
+}